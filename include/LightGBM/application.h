@@ -58,6 +58,9 @@ class Application {
   /*! \brief Main Convert model logic */
   void ConvertModel();
 
+  /*! \brief Main Optimize model logic */
+  void OptimizeModel();
+
   /*! \brief All configs */
   Config config_;
   /*! \brief Training data */
@@ -81,6 +84,8 @@ inline void Application::Run() {
     Predict();
   } else if (config_.task == TaskType::kConvertModel) {
     ConvertModel();
+  } else if (config_.task == TaskType::kOptimizeModel) {
+    OptimizeModel();
   } else {
     InitTrain();
     Train();
@@ -218,6 +218,31 @@ class ArrowChunkedArray {
   template <typename T>
   inline Iterator<T> end() const;
 
+  /**
+   * @brief Copy a range of values into a buffer.
+   * The datatype is resolved once per chunk rather than per value, null values are written as the
+   * missing value of `T`.
+   *
+   * @tparam T The value type of the buffer. May be any primitive type.
+   * @param start The index of the first value to copy.
+   * @param len The number of values to copy, `start + len` must not exceed the length.
+   * @param out The buffer of length `len` to write to.
+   */
+  template <typename T>
+  inline void copy_to(int64_t start, int64_t len, T* out) const;
+
+  /**
+   * @brief Copy the values at a list of indices into a buffer.
+   *
+   * @tparam T The value type of the buffer. May be any primitive type.
+   * @tparam I The index type.
+   * @param indices The indices of the values to copy, in ascending order.
+   * @param n The number of indices.
+   * @param out The buffer of length `n` to write to.
+   */
+  template <typename T, typename I>
+  inline void gather(const I* indices, int64_t n, T* out) const;
+
   template <typename V>
   friend int64_t operator-(const Iterator<V>& a, const Iterator<V>& b);
 };
@@ -171,6 +171,165 @@ struct ArrayIndexAccessor<bool, V> {
   }
 };
 
+/**
+ * @brief Typed access to blocks of values of an Arrow array.
+ *
+ * @tparam T The primitive type of the Arrow array.
+ * @tparam V The value type to convert to.
+ */
+template <typename T, typename V>
+struct ArrayBlockAccessor {
+  static inline V get(const T* data, const uint8_t* validity, int64_t buffer_idx) {
+    if (validity == nullptr || (validity[buffer_idx / 8] & (1 << (buffer_idx % 8)))) {
+      return static_cast<V>(data[buffer_idx]);
+    }
+    return arrow_primitive_missing_value<V>();
+  }
+
+  static void copy(const ArrowArray* array, int64_t start, int64_t len, V* out) {
+    auto data = static_cast<const T*>(array->buffers[1]);
+    auto validity = static_cast<const uint8_t*>(array->buffers[0]);
+    const int64_t first = array->offset + start;
+    if (validity == nullptr) {
+      // plain conversion loop without a dependency on the bitmap
+      for (int64_t i = 0; i < len; ++i) {
+        out[i] = static_cast<V>(data[first + i]);
+      }
+    } else {
+      for (int64_t i = 0; i < len; ++i) {
+        out[i] = get(data, validity, first + i);
+      }
+    }
+  }
+
+  template <typename I>
+  static void gather(const ArrowArray* array, const I* indices, int64_t n, int64_t base, V* out) {
+    auto data = static_cast<const T*>(array->buffers[1]);
+    auto validity = static_cast<const uint8_t*>(array->buffers[0]);
+    for (int64_t i = 0; i < n; ++i) {
+      out[i] = get(data, validity, array->offset + static_cast<int64_t>(indices[i]) - base);
+    }
+  }
+};
+
+template <typename V>
+struct ArrayBlockAccessor<bool, V> {
+  static inline V get(const uint8_t* data, const uint8_t* validity, int64_t buffer_idx) {
+    if (validity == nullptr || (validity[buffer_idx / 8] & (1 << (buffer_idx % 8)))) {
+      return static_cast<V>((data[buffer_idx / 8] >> (buffer_idx % 8)) & 1);
+    }
+    return arrow_primitive_missing_value<V>();
+  }
+
+  static void copy(const ArrowArray* array, int64_t start, int64_t len, V* out) {
+    auto data = static_cast<const uint8_t*>(array->buffers[1]);
+    auto validity = static_cast<const uint8_t*>(array->buffers[0]);
+    for (int64_t i = 0; i < len; ++i) {
+      out[i] = get(data, validity, array->offset + start + i);
+    }
+  }
+
+  template <typename I>
+  static void gather(const ArrowArray* array, const I* indices, int64_t n, int64_t base, V* out) {
+    auto data = static_cast<const uint8_t*>(array->buffers[1]);
+    auto validity = static_cast<const uint8_t*>(array->buffers[0]);
+    for (int64_t i = 0; i < n; ++i) {
+      out[i] = get(data, validity, array->offset + static_cast<int64_t>(indices[i]) - base);
+    }
+  }
+};
+
+template <typename V>
+struct ArrayBlockCopy {
+  const ArrowArray* array;
+  int64_t start;
+  int64_t len;
+  V* out;
+
+  template <typename Accessor>
+  void visit() const { Accessor::copy(array, start, len, out); }
+};
+
+template <typename V, typename I>
+struct ArrayBlockGather {
+  const ArrowArray* array;
+  const I* indices;
+  int64_t n;
+  int64_t base;
+  V* out;
+
+  template <typename Accessor>
+  void visit() const { Accessor::gather(array, indices, n, base, out); }
+};
+
+/**
+ * @brief Call `op->visit<ArrayBlockAccessor<T, V>>()` with the primitive type `T` of an Arrow array.
+ *
+ * @param dtype The Arrow format string describing the datatype of the Arrow array.
+ */
+template <typename V, typename Op>
+void visit_block_accessor(const char* dtype, const Op& op) {
+  switch (dtype[0]) {
+    case 'c':
+      return op.template visit<ArrayBlockAccessor<int8_t, V>>();
+    case 'C':
+      return op.template visit<ArrayBlockAccessor<uint8_t, V>>();
+    case 's':
+      return op.template visit<ArrayBlockAccessor<int16_t, V>>();
+    case 'S':
+      return op.template visit<ArrayBlockAccessor<uint16_t, V>>();
+    case 'i':
+      return op.template visit<ArrayBlockAccessor<int32_t, V>>();
+    case 'I':
+      return op.template visit<ArrayBlockAccessor<uint32_t, V>>();
+    case 'l':
+      return op.template visit<ArrayBlockAccessor<int64_t, V>>();
+    case 'L':
+      return op.template visit<ArrayBlockAccessor<uint64_t, V>>();
+    case 'f':
+      return op.template visit<ArrayBlockAccessor<float, V>>();
+    case 'g':
+      return op.template visit<ArrayBlockAccessor<double, V>>();
+    case 'b':
+      return op.template visit<ArrayBlockAccessor<bool, V>>();
+    default:
+      throw std::invalid_argument("unsupported Arrow datatype");
+  }
+}
+
+template <typename T>
+inline void ArrowChunkedArray::copy_to(int64_t start, int64_t len, T* out) const {
+  auto k = std::distance(chunk_offsets_.begin(),
+                         std::upper_bound(chunk_offsets_.begin(), chunk_offsets_.end(), start)) - 1;
+  while (len > 0) {
+    const int64_t chunk_start = start - chunk_offsets_[k];
+    const int64_t n = std::min(len, chunks_[k]->length - chunk_start);
+    visit_block_accessor<T>(schema_->format, ArrayBlockCopy<T>{chunks_[k], chunk_start, n, out});
+    start += n;
+    len -= n;
+    out += n;
+    ++k;
+  }
+}
+
+template <typename T, typename I>
+inline void ArrowChunkedArray::gather(const I* indices, int64_t n, T* out) const {
+  size_t k = 0;
+  int64_t i = 0;
+  while (i < n) {
+    while (static_cast<int64_t>(indices[i]) >= chunk_offsets_[k + 1]) {
+      ++k;
+    }
+    int64_t j = i;
+    while (j < n && static_cast<int64_t>(indices[j]) < chunk_offsets_[k + 1]) {
+      ++j;
+    }
+    visit_block_accessor<T>(schema_->format,
+                            ArrayBlockGather<T, I>{chunks_[k], indices + i, j - i, chunk_offsets_[k], out + i});
+    i = j;
+  }
+}
+
 template <typename T>
 std::function<T(const ArrowArray*, size_t)> get_index_accessor(const char* dtype) {
   // Mapping obtained from:
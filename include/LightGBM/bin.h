@@ -143,6 +143,26 @@ class BinMapper {
     }
   }
 
+  /*!
+  * \brief Representative value of a numerical bin: the middle of the bin, 0 for the default bin and NaN for the NaN bin
+  * \param bin
+  * \return Feature value standing for every value of this bin
+  */
+  inline double BinToMidValue(uint32_t bin) const {
+    if (missing_type_ == MissingType::NaN && bin == static_cast<uint32_t>(num_bin_ - 1)) {
+      return std::numeric_limits<double>::quiet_NaN();
+    }
+    if (bin == default_bin_) {
+      return 0.0;
+    }
+    const double lower = bin == 0 ? min_val_ : std::max(bin_upper_bound_[bin - 1], min_val_);
+    const double upper = std::min(bin_upper_bound_[bin], max_val_);
+    if (upper < lower) {
+      return lower;
+    }
+    return lower + (upper - lower) / 2.0;
+  }
+
   /*!
   * \brief Maximum categorical value
   * \return Maximum categorical value for categorical features, 0 for numerical features
@@ -172,6 +192,14 @@ class BinMapper {
   */
   inline uint32_t ValueToBin(double value) const;
 
+  /*!
+  * \brief Mapping a batch of feature values into bins, same as calling ValueToBin on each value
+  * \param values Feature values
+  * \param num_values Number of values
+  * \param bins Output, bin of each value
+  */
+  void ValueToBin(const double* values, data_size_t num_values, uint32_t* bins) const;
+
   /*!
   * \brief Get the default bin when value is 0
   * \return default bin
@@ -296,7 +324,48 @@ class Bin {
   */
   virtual void Push(int tid, data_size_t idx, uint32_t value) = 0;
 
+  /*!
+  * \brief Push consecutive records
+  * \param tid Thread id
+  * \param start_idx Index of the first record
+  * \param values Bin values of the records
+  * \param num_values Number of records
+  * \param skip_value Records with this value are not pushed
+  */
+  virtual void PushBins(int tid, data_size_t start_idx, const uint32_t* values, data_size_t num_values,
+                        uint32_t skip_value) {
+    for (data_size_t i = 0; i < num_values; ++i) {
+      if (values[i] != skip_value) {
+        Push(tid, start_idx + i, values[i]);
+      }
+    }
+  }
+
   virtual void CopySubrow(const Bin* full_bin, const data_size_t* used_indices, data_size_t num_used_indices) = 0;
+
+  /*!
+  * \brief Copy records [start, end) of a subset to the same positions of this bin, only dense bins support it.
+  *        Threads can copy disjoint ranges concurrently when the ranges start at even records
+  * \param full_bin Bin of the full data
+  * \param used_indices Indices of the subset records in the full data
+  * \param start Index of the first subset record to copy
+  * \param end Index after the last subset record to copy
+  */
+  virtual void CopySubrowRange(const Bin* full_bin, const data_size_t* used_indices,
+                               data_size_t start, data_size_t end) = 0;
+
+  /*! \brief True for sparse bins, which store only the non-zero records */
+  virtual bool IsSparse() const = 0;
+
+  /*!
+  * \brief Overwrite records of a finished bin in place, FinishLoad is not needed afterwards.
+  *        Not thread-safe, all records of one bin should be replaced by a single thread.
+  * \param row_indices Indices of records to overwrite, should be distinct
+  * \param num_rows Number of records to overwrite
+  * \param values New bin values of the records, zero for the most frequent bin
+  */
+  virtual void ReplaceRows(const data_size_t* row_indices, data_size_t num_rows, const uint32_t* values) = 0;
+
   /*!
   * \brief Get bin iterator of this bin for specific feature
   * \param min_bin min_bin of current used feature
@@ -333,6 +402,13 @@ class Bin {
 
   virtual void ReSize(data_size_t num_data) = 0;
 
+  /*!
+  * \brief Grow to num_data records so that new records can be pushed after FinishLoad,
+  *        bins of the existing records are kept. By default, same as ReSize.
+  * \param num_data Number of data after growing
+  */
+  virtual void ReSizeForAppend(data_size_t num_data) { ReSize(num_data); }
+
   /*!
   * \brief Construct histogram of this feature,
   *        Note: We use ordered_gradients and ordered_hessians to improve cache hit chance
@@ -420,6 +496,27 @@ class Bin {
   virtual void ConstructHistogramInt32(data_size_t start, data_size_t end,
                                        const score_t* ordered_gradients, hist_t* out) const = 0;
 
+  /*!
+  * \brief Construct histograms of two sibling leaves in one pass over the rows of both,
+  *        each leaf accumulates its rows in the same order as ConstructHistogram on its own indices
+  * \param data_indices Used data indices of both leaves, in increasing order
+  * \param leaf_of Leaf of each entry of data_indices, 0 or 1
+  * \param start start index in data_indices
+  * \param end end index in data_indices
+  * \param ordered_gradients Pointer to gradients, the data_indices[i]-th data's gradient is ordered_gradients[i]
+  * \param ordered_hessians Pointer to hessians, the data_indices[i]-th data's hessian is ordered_hessians[i]
+  * \param out Output Result of leaf 0 and leaf 1
+  */
+  virtual void ConstructSiblingHistograms(const data_size_t* data_indices, const uint8_t* leaf_of,
+                                          data_size_t start, data_size_t end,
+                                          const score_t* ordered_gradients, const score_t* ordered_hessians,
+                                          hist_t* const* out) const = 0;
+
+  /*! \brief Same as above, but counts the data in each bin instead of summing constant hessians */
+  virtual void ConstructSiblingHistograms(const data_size_t* data_indices, const uint8_t* leaf_of,
+                                          data_size_t start, data_size_t end,
+                                          const score_t* ordered_gradients, hist_t* const* out) const = 0;
+
   virtual data_size_t Split(uint32_t min_bin, uint32_t max_bin,
                             uint32_t default_bin, uint32_t most_freq_bin,
                             MissingType missing_type, bool default_left,
@@ -620,21 +717,21 @@ inline uint32_t BinMapper::ValueToBin(double value) const {
     }
   }
   if (bin_type_ == BinType::NumericalBin) {
-    // binary search to find bin
-    int l = 0;
-    int r = num_bin_ - 1;
+    // branch-free binary search for the first upper bound not below value
+    int len = num_bin_ - 1;
     if (missing_type_ == MissingType::NaN) {
-      r -= 1;
+      len -= 1;
     }
-    while (l < r) {
-      int m = (r + l - 1) / 2;
-      if (value <= bin_upper_bound_[m]) {
-        r = m;
-      } else {
-        l = m + 1;
-      }
+    if (len <= 0) {
+      return 0;
+    }
+    const double* base = bin_upper_bound_.data();
+    while (len > 1) {
+      const int half = len >> 1;
+      base = (base[half] < value) ? base + half : base;
+      len -= half;
     }
-    return l;
+    return static_cast<uint32_t>(base - bin_upper_bound_.data()) + (*base < value);
   } else {
     int int_value = static_cast<int>(value);
     // convert negative value to NaN bin
@@ -10,6 +10,7 @@
 
 #include <string>
 #include <map>
+#include <memory>
 #include <unordered_map>
 #include <vector>
 
@@ -20,6 +21,7 @@ class Dataset;
 class ObjectiveFunction;
 class Metric;
 struct PredictionEarlyStopInstance;
+class QuantizedTrees;
 
 /*!
 * \brief The interface for Boosting
@@ -54,6 +56,14 @@ class LIGHTGBM_EXPORT Boosting {
   */
   virtual void ShuffleModels(int start_iter, int end_iter) = 0;
 
+  /*!
+  * \brief Reorder and merge the existing models for faster (early-stopped) prediction
+  * \param start_iter The first iteration that will be optimized
+  * \param end_iter The last iteration that will be optimized, <= 0 means the last one
+  * \param merge_tolerance Trees whose leaf outputs differ by at most this value are folded into a constant
+  */
+  virtual void OptimizeModels(int start_iter, int end_iter, double merge_tolerance) = 0;
+
   virtual void ResetTrainingData(const Dataset* train_data, const ObjectiveFunction* objective_function,
                                  const std::vector<const Metric*>& training_metrics) = 0;
 
@@ -123,7 +133,8 @@ class LIGHTGBM_EXPORT Boosting {
   */
   virtual void GetPredictAt(int data_idx, double* result, int64_t* out_len) = 0;
 
-  virtual int NumPredictOneRow(int start_iteration, int num_iteration, bool is_pred_leaf, bool is_pred_contrib) const = 0;
+  virtual int NumPredictOneRow(int start_iteration, int num_iteration, bool is_pred_leaf, bool is_pred_contrib,
+                               bool is_pred_interaction) const = 0;
 
   /*!
   * \brief Prediction for one record, not sigmoid transform
@@ -134,6 +145,16 @@ class LIGHTGBM_EXPORT Boosting {
   virtual void PredictRaw(const double* features, double* output,
                           const PredictionEarlyStopInstance* early_stop) const = 0;
 
+  /*!
+  * \brief Prediction for one record, not sigmoid transform, walking the trees on threshold indices
+  * \param quantized_trees Snapshot of GetQuantizedTrees, nullptr for raw values.
+  *        Boostings without quantized trees ignore it and predict on raw values
+  */
+  virtual void PredictRaw(const double* features, double* output, const PredictionEarlyStopInstance* early_stop,
+                          const QuantizedTrees*) const {
+    PredictRaw(features, output, early_stop);
+  }
+
   virtual void PredictRawByMap(const std::unordered_map<int, double>& features, double* output,
                                const PredictionEarlyStopInstance* early_stop) const = 0;
 
@@ -147,9 +168,76 @@ class LIGHTGBM_EXPORT Boosting {
   virtual void Predict(const double* features, double* output,
                        const PredictionEarlyStopInstance* early_stop) const = 0;
 
+  /*!
+  * \brief Prediction for one record, sigmoid transformation will be used if needed, walking the trees on
+  *        threshold indices
+  * \param quantized_trees Snapshot of GetQuantizedTrees, nullptr for raw values.
+  *        Boostings without quantized trees ignore it and predict on raw values
+  */
+  virtual void Predict(const double* features, double* output, const PredictionEarlyStopInstance* early_stop,
+                       const QuantizedTrees*) const {
+    Predict(features, output, early_stop);
+  }
+
   virtual void PredictByMap(const std::unordered_map<int, double>& features, double* output,
                             const PredictionEarlyStopInstance* early_stop) const = 0;
 
+  /*!
+  * \brief Prediction for a batch of records, not sigmoid transform.
+  *        The trees are applied to all the records in turn, records stopped early are left out of the next trees
+  * \param features Feature values of the records, row-major with MaxFeatureIdx() + 1 values per record
+  * \param num_rows Number of records
+  * \param output Prediction result for the records, row-major
+  * \param early_stop Early stopping instance, its batch criterion is used if it has one
+  */
+  virtual void PredictRawBatch(const double* features, data_size_t num_rows, double* output,
+                               const PredictionEarlyStopInstance* early_stop) const = 0;
+
+  /*!
+  * \brief Prediction for a batch of records, not sigmoid transform, walking the trees on threshold indices
+  * \param quantized_trees Snapshot of GetQuantizedTrees, nullptr for raw values.
+  *        Boostings without quantized trees ignore it and predict on raw values
+  */
+  virtual void PredictRawBatch(const double* features, data_size_t num_rows, double* output,
+                               const PredictionEarlyStopInstance* early_stop, const QuantizedTrees*) const {
+    PredictRawBatch(features, num_rows, output, early_stop);
+  }
+
+  /*!
+  * \brief Prediction for a batch of records, sigmoid transformation will be used if needed
+  * \param features Feature values of the records, row-major with MaxFeatureIdx() + 1 values per record
+  * \param num_rows Number of records
+  * \param output Prediction result for the records, row-major
+  * \param early_stop Early stopping instance, its batch criterion is used if it has one
+  */
+  virtual void PredictBatch(const double* features, data_size_t num_rows, double* output,
+                            const PredictionEarlyStopInstance* early_stop) const = 0;
+
+  /*!
+  * \brief Prediction for a batch of records, sigmoid transformation will be used if needed, walking the trees on
+  *        threshold indices
+  * \param quantized_trees Snapshot of GetQuantizedTrees, nullptr for raw values.
+  *        Boostings without quantized trees ignore it and predict on raw values
+  */
+  virtual void PredictBatch(const double* features, data_size_t num_rows, double* output,
+                            const PredictionEarlyStopInstance* early_stop, const QuantizedTrees*) const {
+    PredictBatch(features, num_rows, output, early_stop);
+  }
+
+  /*!
+  * \brief Convert the raw scores of one record into its prediction, as done by Predict
+  * \param input Raw scores of the record
+  * \param output Prediction of the record
+  */
+  virtual void ConvertOutput(const double* input, double* output) const = 0;
+
+  /*!
+  * \brief Range of the raw score still to be added by the iterations used for prediction, see InitPredict
+  * \param lower Output, lower[i] is the lowest score the iterations from the i-th used one to the last can add
+  * \param upper Output, upper[i] is the highest such score. Both are infinite for linear trees
+  */
+  virtual void GetRemainingScoreBounds(std::vector<double>* lower, std::vector<double>* upper) const = 0;
+
 
   /*!
   * \brief Prediction for one record with leaf index
@@ -159,6 +247,16 @@ class LIGHTGBM_EXPORT Boosting {
   virtual void PredictLeafIndex(
     const double* features, double* output) const = 0;
 
+  /*!
+  * \brief Prediction for one record with leaf index, walking the trees on threshold indices
+  * \param quantized_trees Snapshot of GetQuantizedTrees, nullptr for raw values.
+  *        Boostings without quantized trees ignore it and predict on raw values
+  */
+  virtual void PredictLeafIndex(
+    const double* features, double* output, const QuantizedTrees*) const {
+    PredictLeafIndex(features, output);
+  }
+
   virtual void PredictLeafIndexByMap(
     const std::unordered_map<int, double>& features, double* output) const = 0;
 
@@ -172,6 +270,17 @@ class LIGHTGBM_EXPORT Boosting {
   virtual void PredictContribByMap(const std::unordered_map<int, double>& features,
                                    std::vector<std::unordered_map<int, double>>* output) const = 0;
 
+  /*!
+  * \brief SHAP interaction values for the model's prediction of one record, a row-major
+  *        (num_features + 1) x (num_features + 1) matrix per class whose rows sum to the contributions
+  * \param feature_values Feature value on this record
+  * \param output Prediction result for this record
+  */
+  virtual void PredictInteraction(const double* features, double* output) const = 0;
+
+  virtual void PredictInteractionByMap(const std::unordered_map<int, double>& features,
+                                       std::vector<std::unordered_map<int, double>>* output) const = 0;
+
   /*!
   * \brief Dump model to json format string
   * \param start_iteration The model will be saved start from
@@ -196,6 +305,23 @@ class LIGHTGBM_EXPORT Boosting {
   */
   virtual bool SaveModelToIfElse(int num_iteration, const char* filename) const = 0;
 
+  /*!
+  * \brief Translate model to a standalone C translation unit for batch prediction
+  * \param start_iteration The model will be translated start from
+  * \param num_iteration Number of iterations that want to translate, -1 means translate all
+  * \return C source code of model
+  */
+  virtual std::string ModelToC(int start_iteration, int num_iteration) const = 0;
+
+  /*!
+  * \brief Translate model to a standalone C translation unit and save it to file
+  * \param start_iteration The model will be translated start from
+  * \param num_iteration Number of iterations that want to translate, -1 means translate all
+  * \param filename Filename that want to save to
+  * \return true if succeeded
+  */
+  virtual bool SaveModelToC(int start_iteration, int num_iteration, const char* filename) const = 0;
+
   /*!
   * \brief Save model to file
   * \param start_iteration The model will be saved start from
@@ -282,13 +408,25 @@ class LIGHTGBM_EXPORT Boosting {
   /*! \brief The prediction should be accurate or not. True will disable early stopping for prediction. */
   virtual bool NeedAccuratePrediction() const = 0;
 
+  /*! \brief True if the converted output of the model is the probability of each class */
+  virtual bool IsClassification() const = 0;
+
   /*!
   * \brief Initial work for the prediction
   * \param start_iteration Start index of the iteration to predict
   * \param num_iteration number of used iteration
   * \param is_pred_contrib
+  * \param is_pred_interaction True to predict SHAP interaction values
+  */
+  virtual void InitPredict(int start_iteration, int num_iteration, bool is_pred_contrib,
+                           bool is_pred_interaction) = 0;
+
+  /*!
+  * \brief Trees with quantized thresholds, to map each row to threshold indices once and walk the trees on them.
+  *        The returned snapshot is immutable and stays valid after the model changes, it is rebuilt on the next call
+  * \return nullptr if the trees cannot be quantized, e.g. linear trees, or the boosting has no quantized trees
   */
-  virtual void InitPredict(int start_iteration, int num_iteration, bool is_pred_contrib) = 0;
+  virtual std::shared_ptr<const QuantizedTrees> GetQuantizedTrees() { return nullptr; }
 
   /*!
   * \brief Name of submodel
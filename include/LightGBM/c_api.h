@@ -41,6 +41,7 @@ typedef void* ByteBufferHandle; /*!< \brief Handle of ByteBuffer. */
 #define C_API_PREDICT_RAW_SCORE  (1)  /*!< \brief Predict raw score. */
 #define C_API_PREDICT_LEAF_INDEX (2)  /*!< \brief Predict leaf index. */
 #define C_API_PREDICT_CONTRIB    (3)  /*!< \brief Predict feature contributions (SHAP values). */
+#define C_API_PREDICT_INTERACTION (4)  /*!< \brief Predict SHAP interaction values. */
 
 #define C_API_MATRIX_TYPE_CSR (0)  /*!< \brief CSR sparse matrix type. */
 #define C_API_MATRIX_TYPE_CSC (1)  /*!< \brief CSC sparse matrix type. */
@@ -322,6 +323,128 @@ LIGHTGBM_C_EXPORT int LGBM_DatasetSetWaitForManualFinish(DatasetHandle dataset,
  */
 LIGHTGBM_C_EXPORT int LGBM_DatasetMarkFinished(DatasetHandle dataset);
 
+/*!
+ * \brief Append rows to a finished dataset.
+ * \note
+ * The appended rows are binned with the existing bin mappers into the existing feature groups,
+ * so no sampling, bin finding or feature bundling is done again.
+ * Call ``LGBM_BoosterResetTrainingData`` with the same dataset afterwards to continue training on the enlarged data.
+ * Metadata fields present in the dataset (weights, initial scores, queries) are required for the appended rows,
+ * and the appended rows always start new queries.
+ * \param dataset Handle of a finished dataset
+ * \param data Pointer to the data space
+ * \param data_type Type of ``data`` pointer, can be ``C_API_DTYPE_FLOAT32`` or ``C_API_DTYPE_FLOAT64``
+ * \param nrow Number of rows
+ * \param ncol Number of feature columns
+ * \param label Pointer to array with nrow labels
+ * \param weight Optional pointer to array with nrow weights
+ * \param init_score Optional pointer to array with nrow*nclasses initial scores, in column format
+ * \param query Optional pointer to array with nrow query values
+ * \return 0 when succeed, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_DatasetAppendRows(DatasetHandle dataset,
+                                             const void* data,
+                                             int data_type,
+                                             int32_t nrow,
+                                             int32_t ncol,
+                                             const float* label,
+                                             const float* weight,
+                                             const double* init_score,
+                                             const int32_t* query);
+
+/*!
+ * \brief Append CSR rows to a finished dataset. (See ``LGBM_DatasetAppendRows`` for more details.)
+ * \param dataset Handle of a finished dataset
+ * \param indptr Pointer to row headers
+ * \param indptr_type Type of ``indptr``, can be ``C_API_DTYPE_INT32`` or ``C_API_DTYPE_INT64``
+ * \param indices Pointer to column indices
+ * \param data Pointer to the data space
+ * \param data_type Type of ``data`` pointer, can be ``C_API_DTYPE_FLOAT32`` or ``C_API_DTYPE_FLOAT64``
+ * \param nindptr Number of rows in the matrix + 1
+ * \param nelem Number of nonzero elements in the matrix
+ * \param label Pointer to array with nindptr-1 labels
+ * \param weight Optional pointer to array with nindptr-1 weights
+ * \param init_score Optional pointer to array with (nindptr-1)*nclasses initial scores, in column format
+ * \param query Optional pointer to array with nindptr-1 query values
+ * \return 0 when succeed, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_DatasetAppendRowsByCSR(DatasetHandle dataset,
+                                                  const void* indptr,
+                                                  int indptr_type,
+                                                  const int32_t* indices,
+                                                  const void* data,
+                                                  int data_type,
+                                                  int64_t nindptr,
+                                                  int64_t nelem,
+                                                  const float* label,
+                                                  const float* weight,
+                                                  const double* init_score,
+                                                  const int32_t* query);
+
+/*!
+ * \brief Slide the window of a finished dataset over new rows.
+ * \note
+ * The ``nrow`` oldest rows, by the ``"timestamp"`` field which should be set first with ``LGBM_DatasetSetField``,
+ * are evicted and their slots are overwritten in place by the new rows, binned with the existing bin mappers.
+ * The number of rows of the dataset does not change.
+ * Call ``LGBM_BoosterResetTrainingData`` with the same dataset afterwards to continue training on the new window.
+ * Datasets with queries or positions are not supported.
+ * \param dataset Handle of a finished dataset
+ * \param data Pointer to the data space
+ * \param data_type Type of ``data`` pointer, can be ``C_API_DTYPE_FLOAT32`` or ``C_API_DTYPE_FLOAT64``
+ * \param nrow Number of rows, not more than the number of rows of the dataset
+ * \param ncol Number of feature columns
+ * \param label Pointer to array with nrow labels
+ * \param weight Optional pointer to array with nrow weights, required if the dataset has weights which are not decayed
+ * \param init_score Optional pointer to array with nrow*nclasses initial scores, in column format,
+ *                   required if and only if the dataset has initial scores
+ * \param timestamp Pointer to array with nrow timestamps
+ * \param weight_half_life If positive, weights of all rows are decayed by ``2^(-age / weight_half_life)``,
+ *                         where age is the difference to the newest timestamp (rows without given weight count as 1)
+ * \return 0 when succeed, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_DatasetSlideWindow(DatasetHandle dataset,
+                                              const void* data,
+                                              int data_type,
+                                              int32_t nrow,
+                                              int32_t ncol,
+                                              const float* label,
+                                              const float* weight,
+                                              const double* init_score,
+                                              const double* timestamp,
+                                              double weight_half_life);
+
+/*!
+ * \brief Slide the window of a finished dataset over new CSR rows. (See ``LGBM_DatasetSlideWindow`` for more details.)
+ * \param dataset Handle of a finished dataset
+ * \param indptr Pointer to row headers
+ * \param indptr_type Type of ``indptr``, can be ``C_API_DTYPE_INT32`` or ``C_API_DTYPE_INT64``
+ * \param indices Pointer to column indices
+ * \param data Pointer to the data space
+ * \param data_type Type of ``data`` pointer, can be ``C_API_DTYPE_FLOAT32`` or ``C_API_DTYPE_FLOAT64``
+ * \param nindptr Number of rows in the matrix + 1
+ * \param nelem Number of nonzero elements in the matrix
+ * \param label Pointer to array with nindptr-1 labels
+ * \param weight Optional pointer to array with nindptr-1 weights
+ * \param init_score Optional pointer to array with (nindptr-1)*nclasses initial scores, in column format
+ * \param timestamp Pointer to array with nindptr-1 timestamps
+ * \param weight_half_life If positive, half life of the weight decay by age
+ * \return 0 when succeed, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_DatasetSlideWindowByCSR(DatasetHandle dataset,
+                                                   const void* indptr,
+                                                   int indptr_type,
+                                                   const int32_t* indices,
+                                                   const void* data,
+                                                   int data_type,
+                                                   int64_t nindptr,
+                                                   int64_t nelem,
+                                                   const float* label,
+                                                   const float* weight,
+                                                   const double* init_score,
+                                                   const double* timestamp,
+                                                   double weight_half_life);
+
 /*!
  * \brief Create a dataset from CSR format.
  * \param indptr Pointer to row headers
@@ -711,6 +834,22 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterShuffleModels(BoosterHandle handle,
                                                 int start_iter,
                                                 int end_iter);
 
+/*!
+ * \brief Optimize models for prediction.
+ *        Trees of each class are reordered by decreasing mean output magnitude, so that early stopping exits sooner.
+ *        Trees with the same splits are merged and (near-)constant trees are folded into the first tree of the class.
+ *        With ``merge_tolerance = 0`` the raw predictions with all the trees are unchanged up to rounding.
+ * \param handle Handle of booster
+ * \param start_iter The first iteration that will be optimized
+ * \param end_iter The last iteration that will be optimized, <= 0 means the last available iteration
+ * \param merge_tolerance Trees whose leaf outputs differ by at most this value are folded into a constant
+ * \return 0 when succeed, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_BoosterOptimizeModels(BoosterHandle handle,
+                                                 int start_iter,
+                                                 int end_iter,
+                                                 double merge_tolerance);
+
 /*!
  * \brief Merge model from ``other_handle`` into ``handle``.
  * \param handle Handle of booster, will merge another booster into this one
@@ -948,7 +1087,8 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterGetPredict(BoosterHandle handle,
  *   - ``C_API_PREDICT_NORMAL``: normal prediction, with transform (if needed);
  *   - ``C_API_PREDICT_RAW_SCORE``: raw score;
  *   - ``C_API_PREDICT_LEAF_INDEX``: leaf index;
- *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values)
+ *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values);
+ *   - ``C_API_PREDICT_INTERACTION``: SHAP interaction values, ``(num_feature + 1)^2`` per class
  * \param start_iteration Start index of the iteration to predict
  * \param num_iteration Number of iterations for prediction, <= 0 means no limit
  * \param parameter Other parameters for prediction, e.g. early stopping for prediction
@@ -972,7 +1112,8 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterPredictForFile(BoosterHandle handle,
  *   - ``C_API_PREDICT_NORMAL``: normal prediction, with transform (if needed);
  *   - ``C_API_PREDICT_RAW_SCORE``: raw score;
  *   - ``C_API_PREDICT_LEAF_INDEX``: leaf index;
- *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values)
+ *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values);
+ *   - ``C_API_PREDICT_INTERACTION``: SHAP interaction values, ``(num_feature + 1)^2`` per class
  * \param start_iteration Start index of the iteration to predict
  * \param num_iteration Number of iterations for prediction, <= 0 means no limit
  * \param[out] out_len Length of prediction
@@ -1013,7 +1154,8 @@ LIGHTGBM_C_EXPORT int LGBM_FastConfigFree(FastConfigHandle fastConfig);
  *   - ``C_API_PREDICT_NORMAL``: normal prediction, with transform (if needed);
  *   - ``C_API_PREDICT_RAW_SCORE``: raw score;
  *   - ``C_API_PREDICT_LEAF_INDEX``: leaf index;
- *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values)
+ *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values);
+ *   - ``C_API_PREDICT_INTERACTION``: SHAP interaction values, ``(num_feature + 1)^2`` per class
  * \param start_iteration Start index of the iteration to predict
  * \param num_iteration Number of iterations for prediction, <= 0 means no limit
  * \param parameter Other parameters for prediction, e.g. early stopping for prediction
@@ -1038,10 +1180,14 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterPredictForCSR(BoosterHandle handle,
                                                 double* out_result);
 
 /*!
- * \brief Make sparse prediction for a new dataset in CSR or CSC format. Currently only used for feature contributions.
+ * \brief Make sparse prediction for a new dataset in CSR or CSC format. Currently only used for feature contributions
+ *        and SHAP interaction values.
  * \note
  * The outputs are pre-allocated, as they can vary for each invocation, but the shape should be the same:
- *   - for feature contributions, the shape of sparse matrix will be ``num_class * num_data * (num_feature + 1)``.
+ *   - for feature contributions, the shape of sparse matrix will be ``num_class * num_data * (num_feature + 1)``;
+ *   - for SHAP interaction values, the shape of sparse matrix will be
+ *     ``num_class * num_data * ((num_feature + 1) * (num_feature + 1))``, entry ``(i, j)`` is in column
+ *     ``i * (num_feature + 1) + j``.
  * The output indptr_type for the sparse matrix will be the same as the given input indptr_type.
  * Call ``LGBM_BoosterFreePredictSparse`` to deallocate resources.
  * \param handle Handle of booster
@@ -1053,8 +1199,9 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterPredictForCSR(BoosterHandle handle,
  * \param nindptr Number of entries in ``indptr``
  * \param nelem Number of nonzero elements in the matrix
  * \param num_col_or_row Number of columns for CSR or number of rows for CSC
- * \param predict_type What should be predicted, only feature contributions supported currently
- *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values)
+ * \param predict_type What should be predicted, only feature contributions and interaction values supported currently
+ *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values);
+ *   - ``C_API_PREDICT_INTERACTION``: SHAP interaction values, ``(num_feature + 1)^2`` per class
  * \param start_iteration Start index of the iteration to predict
  * \param num_iteration Number of iterations for prediction, <= 0 means no limit
  * \param parameter Other parameters for prediction, e.g. early stopping for prediction
@@ -1116,7 +1263,8 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterFreePredictSparse(void* indptr, int32_t* indic
  *   - ``C_API_PREDICT_NORMAL``: normal prediction, with transform (if needed);
  *   - ``C_API_PREDICT_RAW_SCORE``: raw score;
  *   - ``C_API_PREDICT_LEAF_INDEX``: leaf index;
- *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values)
+ *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values);
+ *   - ``C_API_PREDICT_INTERACTION``: SHAP interaction values, ``(num_feature + 1)^2`` per class
  * \param start_iteration Start index of the iteration to predict
  * \param num_iteration Number of iterations for prediction, <= 0 means no limit
  * \param parameter Other parameters for prediction, e.g. early stopping for prediction
@@ -1150,7 +1298,8 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterPredictForCSRSingleRow(BoosterHandle handle,
  *   - ``C_API_PREDICT_NORMAL``: normal prediction, with transform (if needed);
  *   - ``C_API_PREDICT_RAW_SCORE``: raw score;
  *   - ``C_API_PREDICT_LEAF_INDEX``: leaf index;
- *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values)
+ *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values);
+ *   - ``C_API_PREDICT_INTERACTION``: SHAP interaction values, ``(num_feature + 1)^2`` per class
  * \param start_iteration Start index of the iteration to predict
  * \param num_iteration Number of iterations for prediction, <= 0 means no limit
  * \param data_type Type of ``data`` pointer, can be ``C_API_DTYPE_FLOAT32`` or ``C_API_DTYPE_FLOAT64``
@@ -1229,7 +1378,8 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterPredictForCSRSingleRowFast(FastConfigHandle fa
  *   - ``C_API_PREDICT_NORMAL``: normal prediction, with transform (if needed);
  *   - ``C_API_PREDICT_RAW_SCORE``: raw score;
  *   - ``C_API_PREDICT_LEAF_INDEX``: leaf index;
- *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values)
+ *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values);
+ *   - ``C_API_PREDICT_INTERACTION``: SHAP interaction values, ``(num_feature + 1)^2`` per class
  * \param start_iteration Start index of the iteration to predict
  * \param num_iteration Number of iteration for prediction, <= 0 means no limit
  * \param parameter Other parameters for prediction, e.g. early stopping for prediction
@@ -1270,7 +1420,8 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterPredictForCSC(BoosterHandle handle,
  *   - ``C_API_PREDICT_NORMAL``: normal prediction, with transform (if needed);
  *   - ``C_API_PREDICT_RAW_SCORE``: raw score;
  *   - ``C_API_PREDICT_LEAF_INDEX``: leaf index;
- *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values)
+ *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values);
+ *   - ``C_API_PREDICT_INTERACTION``: SHAP interaction values, ``(num_feature + 1)^2`` per class
  * \param start_iteration Start index of the iteration to predict
  * \param num_iteration Number of iteration for prediction, <= 0 means no limit
  * \param parameter Other parameters for prediction, e.g. early stopping for prediction
@@ -1308,7 +1459,8 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterPredictForMat(BoosterHandle handle,
  *   - ``C_API_PREDICT_NORMAL``: normal prediction, with transform (if needed);
  *   - ``C_API_PREDICT_RAW_SCORE``: raw score;
  *   - ``C_API_PREDICT_LEAF_INDEX``: leaf index;
- *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values)
+ *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values);
+ *   - ``C_API_PREDICT_INTERACTION``: SHAP interaction values, ``(num_feature + 1)^2`` per class
  * \param start_iteration Start index of the iteration to predict
  * \param num_iteration Number of iteration for prediction, <= 0 means no limit
  * \param parameter Other parameters for prediction, e.g. early stopping for prediction
@@ -1338,7 +1490,8 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterPredictForMatSingleRow(BoosterHandle handle,
  *   - ``C_API_PREDICT_NORMAL``: normal prediction, with transform (if needed);
  *   - ``C_API_PREDICT_RAW_SCORE``: raw score;
  *   - ``C_API_PREDICT_LEAF_INDEX``: leaf index;
- *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values)
+ *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values);
+ *   - ``C_API_PREDICT_INTERACTION``: SHAP interaction values, ``(num_feature + 1)^2`` per class
  * \param start_iteration Start index of the iteration to predict
  * \param num_iteration Number of iterations for prediction, <= 0 means no limit
  * \param data_type Type of ``data`` pointer, can be ``C_API_DTYPE_FLOAT32`` or ``C_API_DTYPE_FLOAT64``
@@ -1397,7 +1550,8 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterPredictForMatSingleRowFast(FastConfigHandle fa
  *   - ``C_API_PREDICT_NORMAL``: normal prediction, with transform (if needed);
  *   - ``C_API_PREDICT_RAW_SCORE``: raw score;
  *   - ``C_API_PREDICT_LEAF_INDEX``: leaf index;
- *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values)
+ *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values);
+ *   - ``C_API_PREDICT_INTERACTION``: SHAP interaction values, ``(num_feature + 1)^2`` per class
  * \param start_iteration Start index of the iteration to predict
  * \param num_iteration Number of iteration for prediction, <= 0 means no limit
  * \param parameter Other parameters for prediction, e.g. early stopping for prediction
@@ -1432,7 +1586,8 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterPredictForMats(BoosterHandle handle,
  *   - ``C_API_PREDICT_NORMAL``: normal prediction, with transform (if needed);
  *   - ``C_API_PREDICT_RAW_SCORE``: raw score;
  *   - ``C_API_PREDICT_LEAF_INDEX``: leaf index;
- *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values)
+ *   - ``C_API_PREDICT_CONTRIB``: feature contributions (SHAP values);
+ *   - ``C_API_PREDICT_INTERACTION``: SHAP interaction values, ``(num_feature + 1)^2`` per class
  * \param start_iteration Start index of the iteration to predict
  * \param num_iteration Number of iteration for prediction, <= 0 means no limit
  * \param parameter Other parameters for prediction, e.g. early stopping for prediction
@@ -1466,6 +1621,19 @@ LIGHTGBM_C_EXPORT int LGBM_BoosterSaveModel(BoosterHandle handle,
                                             int feature_importance_type,
                                             const char* filename);
 
+/*!
+ * \brief Save model as a standalone C translation unit computing raw scores.
+ * \param handle Handle of booster
+ * \param start_iteration Start index of the iteration that should be saved
+ * \param num_iteration Index of the iteration that should be saved, <= 0 means save all
+ * \param filename The name of the file
+ * \return 0 when succeed, -1 when failure happens
+ */
+LIGHTGBM_C_EXPORT int LGBM_BoosterSaveModelToC(BoosterHandle handle,
+                                               int start_iteration,
+                                               int num_iteration,
+                                               const char* filename);
+
 /*!
  * \brief Save model to string.
  * \param handle Handle of booster
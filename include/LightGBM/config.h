@@ -32,7 +32,7 @@ namespace LightGBM {
 
 /*! \brief Types of tasks */
 enum TaskType {
-  kTrain, kPredict, kConvertModel, KRefitTree, kSaveBinary
+  kTrain, kPredict, kConvertModel, KRefitTree, kSaveBinary, kOptimizeModel
 };
 const int kDefaultNumLeaves = 31;
 
@@ -117,12 +117,13 @@ struct Config {
   // [no-save]
   // type = enum
   // default = train
-  // options = train, predict, convert_model, refit
+  // options = train, predict, convert_model, refit, optimize_model
   // alias = task_type
   // desc = ``train``, for training, aliases: ``training``
   // desc = ``predict``, for prediction, aliases: ``prediction``, ``test``
   // desc = ``convert_model``, for converting model file into if-else format, see more information in `Convert Parameters <#convert-parameters>`__
   // desc = ``refit``, for refitting existing models with new data, aliases: ``refit_tree``
+  // desc = ``optimize_model``, for reordering and merging the trees of ``input_model`` so that prediction early stopping exits sooner, the result is saved to ``output_model``
   // desc = ``save_binary``, load train (and validation) data then save dataset to binary file. Typical usage: ``save_binary`` first, then run multiple ``train`` tasks in parallel using the saved binary file
   // desc = **Note**: can be used only in CLI version; for language-specific packages you can use the correspondent functions
   TaskType task = TaskType::kTrain;
@@ -298,6 +299,7 @@ struct Config {
   // alias = hist_pool_size
   // desc = max cache size in MB for historical histogram
   // desc = ``< 0`` means no limit
+  // desc = when the histogram of a split leaf is evicted from the cache, the histograms of its two children are built together, in one pass over the rows of the leaf. This merged pass is used with col-wise histograms and without ``use_quantized_grad``
   double histogram_pool_size = -1.0;
 
   // desc = limit the max depth for tree model. This is used to deal with over-fitting when ``#data`` is small. Tree still grows leaf-wise
@@ -466,12 +468,15 @@ struct Config {
   // check = <=1.0
   // desc = used only in ``goss``
   // desc = the retain ratio of large gradient data
+  // desc = the rows whose ``|gradient * hessian|`` is not smaller than the ``top_rate * num_data``-th largest one over all the rows are kept, ties included
   double top_rate = 0.2;
 
   // check = >=0.0
   // check = <=1.0
   // desc = used only in ``goss``
   // desc = the retain ratio of small gradient data
+  // desc = each of the other rows is kept with the same probability, so that ``other_rate * num_data`` of them are kept on average, and its gradient and hessian are divided by that probability. The number of kept rows varies between iterations, but does not depend on the number of threads
+  // desc = **Note**: earlier versions kept exactly ``other_rate`` of the rows of each thread's block, with a threshold of each block, so models trained with ``goss`` do not reproduce those of earlier versions
   double other_rate = 0.1;
 
   // check = >0
@@ -679,6 +684,21 @@ struct Config {
   // desc = **Note**: if you specify ``monotone_constraints``, constraints will be enforced when choosing the split points, but not when fitting the linear models on leaves
   bool linear_tree = false;
 
+  // type = enum
+  // options = float32, float16, bfloat16, bin
+  // desc = used only with ``linear_tree``
+  // desc = how the raw values of numerical features are kept for fitting and evaluating the linear models
+  // desc = ``float32``, exact values
+  // desc = ``float16``, half precision values, uses half the memory of ``float32``
+  // desc = ``bfloat16``, values with the range of ``float32`` and 8 bits of precision, uses half the memory of ``float32``
+  // desc = ``bin``, no raw values are kept, each value is replaced by the middle of its bin. Uses the least memory but the linear models see binned values
+  std::string linear_raw_type = "float32";
+
+  // desc = used only with ``linear_tree``
+  // desc = store the raw values of a feature with at most ``256`` distinct values as one-byte codes into a table of these values
+  // desc = this is lossless and is decided for each feature when the Dataset is constructed
+  bool linear_raw_dictionary = true;
+
   // alias = max_bins
   // check = >1
   // desc = max number of bins that feature values will be bucketed in
@@ -718,6 +738,33 @@ struct Config {
   // desc = **Note**: disabling this may cause the slow training speed for sparse datasets
   bool enable_bundle = true;
 
+  // check = >0
+  // desc = used only with ``enable_bundle=true``
+  // desc = maximal number of existing bundles tried for each feature when searching for bundles
+  // desc = larger values can pack very wide sparse datasets into fewer bundles, at the cost of a slower Dataset construction
+  int max_bundle_search_groups = 100;
+
+  // desc = used only with ``enable_bundle=true``
+  // desc = path to a ``.json`` bundle plan written by ``output_bundle_plan``, the features are bundled as in this file instead of searching for bundles
+  // desc = features of the plan that are not used in the Dataset are dropped, used features that are missing from the plan are put in their own bundles
+  // desc = a plan with more than one ``multi_val`` bundle, or with a bundle of more than 256 bins for ``device_type=gpu``, is rejected when the Dataset is constructed
+  // desc = **Note**: the plan should come from a Dataset with the same features and Dataset parameters, otherwise the bundles may conflict a lot
+  std::string input_bundle_plan = "";
+
+  // desc = used only with ``enable_bundle=true``
+  // desc = path to a ``.json`` file to write the bundles found for the training Dataset, for reuse with ``input_bundle_plan``
+  std::string output_bundle_plan = "";
+
+  // desc = path to a dataset schema written by ``output_dataset_schema``
+  // desc = the bin mappers, feature bundles and multi-val decisions are loaded from this file, so the data is binned right away, without sampling it, finding bins or searching for bundles
+  // desc = the parameters which decide the bins and the bundles (e.g. ``max_bin``, ``categorical_feature``, ``ignore_column``, ``enable_bundle``) are ignored, they are taken from the schema
+  // desc = **Note**: the data should have the same features as the data the schema was written from
+  std::string input_dataset_schema = "";
+
+  // desc = path to write the schema of the training Dataset to, i.e. its bin mappers, feature bundles and multi-val decisions
+  // desc = Datasets for new data with the same features can be constructed from this file with ``input_dataset_schema``
+  std::string output_dataset_schema = "";
+
   // desc = set this to ``false`` to disable the special handle of missing value
   bool use_missing = true;
 
@@ -888,6 +935,46 @@ struct Config {
   // desc = the threshold of margin in early-stopping prediction
   double pred_early_stop_margin = 10.0;
 
+  // [no-save]
+  // type = enum
+  // options = margin, confidence, top_k
+  // desc = used only in ``prediction`` task and if ``pred_early_stop=true``
+  // desc = criterion for stopping the prediction of a row early, checked every ``pred_early_stop_freq`` iterations
+  // desc = ``margin``, stop when the score (binary) or the gap between the two best classes (multiclass) is above ``pred_early_stop_margin``
+  // desc = ``confidence``, stop when the probability of the most likely class is at least ``pred_early_stop_confidence``. Used only in ``classification`` applications, models of other objectives are rejected
+  // desc = ``top_k``, rows of a batch of ``pred_early_stop_batch_size`` rows are ranked together, a row stops once it provably cannot be among the ``pred_early_stop_top_k`` best rows. Its prediction is then the highest score it could still reach, which keeps it below every row of the top k. Used only for models with one score per row, such as ``ranking`` or ``binary``
+  // desc = rows are predicted in batches, the rows which stop are left out of the remaining trees of their batch
+  std::string pred_early_stop_type = "margin";
+
+  // [no-save]
+  // check = >0.0
+  // check = <1.0
+  // desc = used only in ``prediction`` task and if ``pred_early_stop_type=confidence``
+  // desc = probability of the most likely class above which the prediction of a row stops
+  double pred_early_stop_confidence = 0.99;
+
+  // [no-save]
+  // check = >0
+  // desc = used only in ``prediction`` task and if ``pred_early_stop_type=top_k``
+  // desc = number of best rows of a batch which are always predicted with all the trees
+  // desc = **Note**: the top k is that of each batch of ``pred_early_stop_batch_size`` rows, not that of the whole data or of a query, and no row of a batch with at most ``pred_early_stop_top_k`` rows stops
+  int pred_early_stop_top_k = 10;
+
+  // [no-save]
+  // check = >0
+  // desc = used only in ``prediction`` task and if ``pred_early_stop=true``
+  // desc = maximal number of rows predicted together, each tree is applied to the rows of a batch which are still predicted
+  // desc = batches are made smaller for models with many features, so that a batch holds at most ``2^18`` feature values
+  // desc = with ``pred_early_stop_type=top_k``, it should be larger than ``pred_early_stop_top_k``. Predicting each query in its own call, with batches at least as large as the queries, ranks the rows of each query together
+  int pred_early_stop_batch_size = 256;
+
+  // [no-save]
+  // desc = used only in ``prediction`` task
+  // desc = used only for predicting normal or raw scores and leaf indices
+  // desc = if ``true``, each row is mapped once to the indices of its values among the split thresholds of the model, and the trees are walked on these small integers instead of comparing raw feature values at every node. Predictions are identical, but faster for large ensembles
+  // desc = **Note**: has no effect for linear trees
+  bool pred_quantized_thresholds = false;
+
   // [no-save]
   // alias = predict_result, prediction_result, predict_name, prediction_name, pred_name, name_pred
   // desc = used only in ``prediction`` task
@@ -903,7 +990,9 @@ struct Config {
 
   // [no-save]
   // desc = used only in ``convert_model`` task
-  // desc = only ``cpp`` is supported yet; for conversion model to other languages consider using `m2cgen <https://github.com/BayesWitnesses/m2cgen>`__ utility
+  // desc = ``cpp`` generates if-else C++ code to be compiled into LightGBM itself
+  // desc = ``c`` generates a standalone C translation unit with a stable ABI for batch prediction of raw scores, see comments at the top of the generated file
+  // desc = for conversion model to other languages consider using `m2cgen <https://github.com/BayesWitnesses/m2cgen>`__ utility
   // desc = if ``convert_model_language`` is set and ``task=train``, the model will be also converted
   // desc = **Note**: can be used only in CLI version
   std::string convert_model_language = "";
@@ -915,6 +1004,14 @@ struct Config {
   // desc = **Note**: can be used only in CLI version
   std::string convert_model = "gbdt_prediction.cpp";
 
+  // [no-save]
+  // check = >=0.0
+  // desc = used only in ``optimize_model`` task
+  // desc = trees whose leaf outputs differ by at most this value are folded into a constant
+  // desc = with ``0.0`` only constant trees are folded, so the predictions with all the trees are unchanged up to floating point rounding
+  // desc = **Note**: can be used only in CLI version
+  double optimize_merge_tolerance = 0.0;
+
   #ifndef __NVCC__
   #pragma endregion
 
@@ -1007,6 +1104,11 @@ struct Config {
   // desc = *New in version 4.1.0*
   double lambdarank_position_bias_regularization = 0.0;
 
+  // desc = used only in ``binary``, ``multiclass``, ``multiclassova`` and ``cross_entropy`` applications
+  // desc = set this to ``true`` to compute gradients and Hessians in single precision, with a polynomial approximation of ``exp`` that the compiler can vectorize
+  // desc = gradients and Hessians are stored in single precision anyway, but the single precision scores make the relative error grow with the score, up to about ``1e-5`` for scores around ``40``; scores beyond about ``87 / sigmoid`` are clamped
+  bool objective_fast_math = false;
+
   #ifndef __NVCC__
   #pragma endregion
 
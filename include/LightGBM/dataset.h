@@ -9,6 +9,7 @@
 #include <LightGBM/config.h>
 #include <LightGBM/feature_group.h>
 #include <LightGBM/meta.h>
+#include <LightGBM/raw_column.h>
 #include <LightGBM/train_share_states.h>
 #include <LightGBM/utils/byte_buffer.h>
 #include <LightGBM/utils/openmp_wrapper.h>
@@ -121,6 +122,13 @@ class Metadata {
 
   void SetPosition(const data_size_t* position, data_size_t len);
 
+  /*!
+  * \brief Set timestamps of records, used to evict the oldest records of a sliding window
+  * \param timestamps Timestamps of records, clear timestamps if nullptr
+  * \param len Number of records
+  */
+  void SetTimestamps(const double* timestamps, data_size_t len);
+
   /*!
   * \brief Set initial scores
   * \param init_score Initial scores, this class will manage memory for init_score.
@@ -177,6 +185,15 @@ class Metadata {
     }
   }
 
+  /*!
+  * \brief Set timestamp for one record
+  * \param idx Index of this record
+  * \param value Timestamp of this record
+  */
+  inline void SetTimestampAt(data_size_t idx, double value) {
+    timestamps_[idx] = value;
+  }
+
   /*!
   * \brief Set Query Id for one record
   * \param idx Index of this record
@@ -205,6 +222,13 @@ class Metadata {
     const double* init_scores,
     const int32_t* queries);
 
+  /*!
+  * \brief Grow storage to num_data records so that metadata of appended records can be inserted,
+  *        metadata of the existing records are kept
+  * \param num_data Number of data after growing
+  */
+  void ReSizeForAppend(data_size_t num_data);
+
   /*!
   * \brief Perform any extra operations after all data has been loaded
   */
@@ -233,6 +257,18 @@ class Metadata {
     }
   }
 
+  /*!
+  * \brief Get timestamps, if not exists, will return nullptr
+  * \return Pointer of timestamps
+  */
+  inline const double* timestamps() const {
+    if (!timestamps_.empty()) {
+      return timestamps_.data();
+    } else {
+      return nullptr;
+    }
+  }
+
   /*!
   * \brief Get position IDs, if does not exist then return nullptr
   * \return Pointer of position IDs
@@ -385,6 +421,8 @@ class Metadata {
   std::vector<double> init_score_;
   /*! \brief Queries data */
   std::vector<data_size_t> queries_;
+  /*! \brief Timestamps of records, only kept in memory */
+  std::vector<double> timestamps_;
   /*! \brief mutex for threading safe call */
   std::mutex mutex_;
   bool weight_load_from_file_;
@@ -535,6 +573,37 @@ class Dataset {
     }
   }
 
+  /*!
+  * \brief Reopen a finished dataset to append rows, which are then binned with the existing
+  *        bin mappers into the existing feature groups. Call FinishLoad after pushing them.
+  * \param num_append Number of rows to append
+  * \return Index of the first appended row
+  */
+  LIGHTGBM_EXPORT data_size_t InitAppend(data_size_t num_append);
+
+  /*!
+  * \brief Slide the window of a finished dataset: the oldest rows (by timestamp) are evicted and their slots
+  *        are overwritten in place by the new rows, using the existing bin mappers and feature groups.
+  *        Timestamps of the existing rows should be set by the "timestamp" field first.
+  * \param get_row_fun Function to get the sparse values of a new row
+  * \param num_rows Number of new rows, not more than the number of rows in the dataset
+  * \param labels Labels of the new rows
+  * \param weights Weights of the new rows, or nullptr
+  * \param init_scores Initial scores of the new rows (stored by column), or nullptr
+  * \param timestamps Timestamps of the new rows
+  * \param weight_half_life If positive, the weight of each row is its given weight (1 if not given)
+  *        multiplied by 2^(-age / weight_half_life), where age is measured from the newest timestamp
+  */
+  LIGHTGBM_EXPORT void SlideWindow(const std::function<std::vector<std::pair<int, double>>(int row_idx)>& get_row_fun,
+                                   data_size_t num_rows, const label_t* labels, const label_t* weights,
+                                   const double* init_scores, const double* timestamps, double weight_half_life);
+
+  /*! \brief Number of times the window was slid, used to detect in-place updates */
+  inline int64_t num_window_slides() const { return num_window_slides_; }
+
+  /*! \brief Rows overwritten by the last window slide, in ascending order */
+  inline const std::vector<data_size_t>& window_recycled_rows() const { return window_recycled_rows_; }
+
   LIGHTGBM_EXPORT bool CheckAlign(const Dataset& other) const {
     if (num_features_ != other.num_features_) {
       return false;
@@ -574,7 +643,31 @@ class Dataset {
       if (this->has_raw_) {
         auto feat_ind = numeric_feature_map_[feature_idx];
         if (feat_ind >= 0) {
-          raw_data_[feat_ind][row_idx] = static_cast<float>(value);
+          raw_data_[feat_ind].Set(row_idx, value);
+        }
+      }
+    }
+  }
+
+  /*!
+  * \brief Push consecutive values of one column, the values are binned as a batch
+  * \param tid Thread id
+  * \param start_row Index of the first row
+  * \param col_idx Index of the column in the input data
+  * \param values Values of the rows
+  * \param num_values Number of rows
+  */
+  inline void PushColumn(int tid, data_size_t start_row, int col_idx, const double* values, data_size_t num_values) {
+    if (is_finish_load_ || col_idx >= num_total_features_) { return; }
+    const int feature_idx = used_feature_map_[col_idx];
+    if (feature_idx < 0) { return; }
+    feature_groups_[feature2group_[feature_idx]]->PushColumn(tid, feature2subfeature_[feature_idx], start_row,
+                                                             values, num_values);
+    if (has_raw_) {
+      const int feat_ind = numeric_feature_map_[feature_idx];
+      if (feat_ind >= 0) {
+        for (data_size_t i = 0; i < num_values; ++i) {
+          raw_data_[feat_ind].Set(start_row + i, values[i]);
         }
       }
     }
@@ -600,7 +693,7 @@ class Dataset {
         if (has_raw_) {
           int feat_ind = numeric_feature_map_[feature_idx];
           if (feat_ind >= 0) {
-            raw_data_[feat_ind][row_idx] = static_cast<float>(inner_data.second);
+            raw_data_[feat_ind].Set(row_idx, inner_data.second);
           }
         }
       }
@@ -608,12 +701,45 @@ class Dataset {
     FinishOneRow(tid, row_idx, is_feature_added);
   }
 
+  /*!
+  * \brief Push a sparse row stored as parallel index and value arrays, without building (index, value) pairs
+  * \param is_feature_added Buffer reused across the rows pushed by one thread, all false between calls
+  */
+  template <typename T>
+  inline void PushOneRow(int tid, data_size_t row_idx, const int32_t* indices, const T* values, int64_t num_values,
+                         std::vector<bool>* is_feature_added) {
+    if (is_finish_load_) { return; }
+    const bool need_push_zeros = !feature_need_push_zeros_.empty();
+    if (need_push_zeros && is_feature_added->empty()) {
+      is_feature_added->resize(num_features_, false);
+    }
+    for (int64_t i = 0; i < num_values; ++i) {
+      if (indices[i] >= num_total_features_) { continue; }
+      const int feature_idx = used_feature_map_[indices[i]];
+      if (feature_idx >= 0) {
+        if (need_push_zeros) {
+          (*is_feature_added)[feature_idx] = true;
+        }
+        PushOneData(tid, row_idx, feature2group_[feature_idx], feature_idx, feature2subfeature_[feature_idx],
+                    static_cast<double>(values[i]));
+      }
+    }
+    if (need_push_zeros) {
+      FinishOneRow(tid, row_idx, *is_feature_added);
+      for (int64_t i = 0; i < num_values; ++i) {
+        if (indices[i] < num_total_features_ && used_feature_map_[indices[i]] >= 0) {
+          (*is_feature_added)[used_feature_map_[indices[i]]] = false;
+        }
+      }
+    }
+  }
+
   inline void PushOneData(int tid, data_size_t row_idx, int group, int feature_idx, int sub_feature, double value) {
     feature_groups_[group]->PushData(tid, sub_feature, row_idx, value);
     if (has_raw_) {
       int feat_ind = numeric_feature_map_[feature_idx];
       if (feat_ind >= 0) {
-        raw_data_[feat_ind][row_idx] = static_cast<float>(value);
+        raw_data_[feat_ind].Set(row_idx, value);
       }
     }
   }
@@ -637,6 +763,14 @@ class Dataset {
   inline int Feature2Group(int feature_idx) const {
     return feature2group_[feature_idx];
   }
+  /*! \brief Columns of the input data binned into a feature group */
+  inline std::vector<int> FeatureGroupColumns(int group_idx) const {
+    std::vector<int> columns(group_feature_cnt_[group_idx]);
+    for (int i = 0; i < group_feature_cnt_[group_idx]; ++i) {
+      columns[i] = real_feature_idx_[group_feature_start_[group_idx] + i];
+    }
+    return columns;
+  }
   inline int Feture2SubFeature(int feature_idx) const {
     return feature2subfeature_[feature_idx];
   }
@@ -696,6 +830,12 @@ class Dataset {
    */
   LIGHTGBM_EXPORT void SerializeReference(ByteBuffer* out);
 
+  /*!
+   * \brief Save the Dataset schema (see SerializeReference) to a file, for use with ``input_dataset_schema``
+   * \param filename Filename of the schema
+   */
+  LIGHTGBM_EXPORT void SaveSchema(const char* filename);
+
   LIGHTGBM_EXPORT void DumpTextFile(const char* text_filename);
 
   LIGHTGBM_EXPORT void CopyFeatureMapperFrom(const Dataset* dataset);
@@ -757,6 +897,24 @@ class Dataset {
     }
   }
 
+  /*!
+   * \brief Construct the histograms of two sibling leaves together, reading each feature group once for both.
+   *        The rows of the leaves are merged in increasing order, so every histogram is the same as the one
+   *        of ConstructHistograms on the rows of its leaf
+   * \param left_indices Rows of the first leaf, in increasing order
+   * \param right_indices Rows of the second leaf, in increasing order
+   * \param data_indices Buffer for the merged rows, of size left_cnt + right_cnt
+   * \param leaf_of Buffer for the leaf of each merged row, of size left_cnt + right_cnt
+   */
+  void ConstructSiblingHistograms(const std::vector<int8_t>& is_feature_used,
+                                  const data_size_t* left_indices, data_size_t left_cnt,
+                                  const data_size_t* right_indices, data_size_t right_cnt,
+                                  const score_t* gradients, const score_t* hessians,
+                                  data_size_t* data_indices, uint8_t* leaf_of,
+                                  score_t* ordered_gradients, score_t* ordered_hessians,
+                                  TrainingShareStates* share_state,
+                                  hist_t* left_hist_data, hist_t* right_hist_data) const;
+
   void FixHistogram(int feature_idx, double sum_gradient, double sum_hessian, hist_t* data) const;
 
   template <typename PACKED_HIST_BIN_T, typename PACKED_HIST_ACC_T, int HIST_BITS_BIN, int HIST_BITS_ACC>
@@ -964,17 +1122,18 @@ class Dataset {
       raw_data_.resize(num_numeric_features_);
     }
     for (size_t i = 0; i < raw_data_.size(); ++i) {
-      raw_data_[i].resize(num_rows);
+      raw_data_[i].Resize(num_rows);
     }
     int curr_size = static_cast<int>(raw_data_.size());
     for (int i = curr_size; i < num_numeric_features_; ++i) {
-      raw_data_.push_back(std::vector<float>(num_rows, 0));
+      raw_data_.emplace_back(raw_type_);
+      raw_data_.back().Resize(num_rows);
     }
   }
 
-  /*! \brief Get pointer to raw_data_ feature */
-  inline const float* raw_index(int feat_ind) const {
-    return raw_data_[numeric_feature_map_[feat_ind]].data();
+  /*! \brief Get the raw values of a numerical feature */
+  inline const RawColumn* raw_column(int feat_ind) const {
+    return &raw_data_[numeric_feature_map_[feat_ind]];
   }
 
   inline uint32_t feature_max_bin(const int inner_feature_index) const {
@@ -1000,6 +1159,9 @@ class Dataset {
  private:
   void SerializeHeader(BinaryWriter* serializer);
 
+  /*! \brief Finish the raw values once all rows are pushed: rebuild them from the bins or compress them */
+  void FinishRaw();
+
   size_t GetSerializedHeaderSize();
 
   void CreateCUDAColumnData();
@@ -1042,7 +1204,11 @@ class Dataset {
   bool use_missing_;
   bool zero_as_missing_;
   std::vector<int> feature_need_push_zeros_;
-  std::vector<std::vector<float>> raw_data_;
+  std::vector<RawColumn> raw_data_;
+  /*! \brief How raw_data_ is stored, from linear_raw_type */
+  RawType raw_type_ = RawType::Float32;
+  /*! \brief Whether raw columns with few distinct values are stored as codes, from linear_raw_dictionary */
+  bool raw_dictionary_ = true;
   bool wait_for_manual_finish_;
   int omp_max_threads_ = -1;
   bool has_raw_;
@@ -1059,6 +1225,14 @@ class Dataset {
   #endif  // USE_CUDA
 
   std::string parser_config_str_;
+
+  /*! \brief Rows ordered by timestamp, starting at window_head_ and wrapping around */
+  std::vector<data_size_t> window_order_;
+  data_size_t window_head_ = 0;
+  /*! \brief Weights of rows before decay, empty if weights are not decayed */
+  std::vector<label_t> window_base_weights_;
+  int64_t num_window_slides_ = 0;
+  std::vector<data_size_t> window_recycled_rows_;
 };
 
 }  // namespace LightGBM
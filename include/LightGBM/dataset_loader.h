@@ -63,6 +63,13 @@ class DatasetLoader {
 
   void ConstructBinMappersFromTextData(int rank, int num_machines, const std::vector<std::string>& sample_data, const Parser* parser, Dataset* dataset);
 
+  /*!
+   * \brief Set up the bin mappers and feature groups of dataset from the schema in ``input_dataset_schema``
+   * \param num_total_features Number of features in the data, or -1 if not known
+   * \param dataset Dataset to set up, it keeps its own number of data and label index
+   */
+  void ConstructFromSchema(int num_total_features, Dataset* dataset);
+
   /*! \brief Extract local features from memory */
   void ExtractFeaturesFromMemory(std::vector<std::string>* text_data, const Parser* parser, Dataset* dataset);
 
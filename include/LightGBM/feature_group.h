@@ -12,6 +12,7 @@
 
 #include <cstdint>
 #include <cstdio>
+#include <limits>
 #include <memory>
 #include <vector>
 
@@ -266,6 +267,29 @@ class FeatureGroup {
     }
   }
 
+  /*!
+   * \brief Push consecutive records of one sub-feature, will auto convert values to bins
+   * \param tid Thread id
+   * \param sub_feature_idx Index of the sub-feature
+   * \param start_idx Index of the first record
+   * \param values Feature values of the records
+   * \param num_values Number of records
+   */
+  void PushColumn(int tid, int sub_feature_idx, data_size_t start_idx, const double* values,
+                  data_size_t num_values) {
+    const BinMapper* bin_mapper = bin_mappers_[sub_feature_idx].get();
+    std::vector<uint32_t> bins(num_values);
+    bin_mapper->ValueToBin(values, num_values, bins.data());
+    const uint32_t most_freq_bin = bin_mapper->GetMostFreqBin();
+    const uint32_t skip_bin = std::numeric_limits<uint32_t>::max();
+    const uint32_t offset = (is_multi_val_ ? 1 : bin_offsets_[sub_feature_idx]) - (most_freq_bin == 0 ? 1 : 0);
+    for (data_size_t i = 0; i < num_values; ++i) {
+      bins[i] = bins[i] == most_freq_bin ? skip_bin : bins[i] + offset;
+    }
+    Bin* bin_data = is_multi_val_ ? multi_bin_data_[sub_feature_idx].get() : bin_data_.get();
+    bin_data->PushBins(tid, start_idx, bins.data(), num_values, skip_bin);
+  }
+
   void ReSize(int num_data) {
     if (!is_multi_val_) {
       bin_data_->ReSize(num_data);
@@ -276,6 +300,49 @@ class FeatureGroup {
     }
   }
 
+  void ReSizeForAppend(int num_data) {
+    if (!is_multi_val_) {
+      bin_data_->ReSizeForAppend(num_data);
+    } else {
+      for (int i = 0; i < num_feature_; ++i) {
+        multi_bin_data_[i]->ReSizeForAppend(num_data);
+      }
+    }
+  }
+
+  /*!
+   * \brief Overwrite records in place, will auto convert values to bins
+   * \param row_indices Indices of records to overwrite, should be distinct
+   * \param num_rows Number of records to overwrite
+   * \param values Feature values, value of sub-feature j of the i-th record is values[i * stride + j]
+   * \param stride Distance between the values of two consecutive records
+   */
+  void ReplaceRows(const data_size_t* row_indices, data_size_t num_rows, const double* values, int stride) {
+    std::vector<uint32_t> bins(num_rows, 0);
+    for (int j = 0; j < num_feature_; ++j) {
+      const uint32_t most_freq_bin = bin_mappers_[j]->GetMostFreqBin();
+      for (data_size_t i = 0; i < num_rows; ++i) {
+        uint32_t bin = bin_mappers_[j]->ValueToBin(values[static_cast<size_t>(i) * stride + j]);
+        if (bin == most_freq_bin) {
+          if (is_multi_val_) {
+            bins[i] = 0;
+          }
+          continue;
+        }
+        if (most_freq_bin == 0) {
+          bin -= 1;
+        }
+        bins[i] = is_multi_val_ ? bin + 1 : bin + bin_offsets_[j];
+      }
+      if (is_multi_val_) {
+        multi_bin_data_[j]->ReplaceRows(row_indices, num_rows, bins.data());
+      }
+    }
+    if (!is_multi_val_) {
+      bin_data_->ReplaceRows(row_indices, num_rows, bins.data());
+    }
+  }
+
   inline void CopySubrow(const FeatureGroup* full_feature, const data_size_t* used_indices, data_size_t num_used_indices) {
     if (!is_multi_val_) {
       bin_data_->CopySubrow(full_feature->bin_data_.get(), used_indices, num_used_indices);
@@ -294,6 +361,20 @@ class FeatureGroup {
     }
   }
 
+  /*! \brief Whether a column is stored in a dense bin, whose rows can be copied by ranges with CopySubrowRangeByCol */
+  inline bool IsDenseCol(int fidx) const {
+    return !(is_multi_val_ ? multi_bin_data_[fidx] : bin_data_)->IsSparse();
+  }
+
+  inline void CopySubrowRangeByCol(const FeatureGroup* full_feature, const data_size_t* used_indices,
+                                   data_size_t start, data_size_t end, int fidx) {
+    if (!is_multi_val_) {
+      bin_data_->CopySubrowRange(full_feature->bin_data_.get(), used_indices, start, end);
+    } else {
+      multi_bin_data_[fidx]->CopySubrowRange(full_feature->multi_bin_data_[fidx].get(), used_indices, start, end);
+    }
+  }
+
   void AddFeaturesFrom(const FeatureGroup* other, int group_id) {
     CHECK(is_multi_val_);
     CHECK(other->is_multi_val_);
@@ -60,6 +60,37 @@ class Metric {
   * \brief Whether boosting is done on CUDA
   */
   virtual bool IsCUDAMetric() const { return false; }
+
+  /*!
+  * \brief Whether Eval is computed from a sum of weighted pointwise losses of the scores converted by the objective.
+  *        Such metrics of one dataset can be evaluated together by EvalPointwise
+  */
+  virtual bool IsPointwise() const { return false; }
+
+  /*!
+  * \brief Sum of the weighted pointwise losses of consecutive rows, only for pointwise metrics
+  * \param converted_score Scores converted by the objective, starting at the score of row start
+  * \param start Index of the first row
+  * \param count Number of rows
+  */
+  virtual double SumPointLoss(const double*, data_size_t, data_size_t) const { return 0.0; }
+
+  /*!
+  * \brief Result of Eval from the sum of the pointwise losses of all rows, only for pointwise metrics
+  */
+  virtual std::vector<double> FinishPointLoss(double) const { return std::vector<double>(); }
+
+  /*!
+  * \brief Evaluate pointwise metrics of one dataset in a single pass, each score is converted only once
+  * \param metrics Pointwise metrics initialized on the same data
+  * \param score Current prediction score
+  * \param num_data Number of data
+  * \param objective Objective converting the scores, nullptr to use the raw scores
+  * \return The result of Eval of each metric
+  */
+  LIGHTGBM_EXPORT static std::vector<std::vector<double>> EvalPointwise(const std::vector<const Metric*>& metrics,
+                                                                        const double* score, data_size_t num_data,
+                                                                        const ObjectiveFunction* objective);
 };
 
 /*!
@@ -87,6 +118,32 @@ class DCGCalculator {
     const label_t* label, const double* score,
     data_size_t num_data, std::vector<double>* out);
 
+  /*!
+  * \brief Calculate the DCG score at multi position, reusing the buffer of sorted indices
+  * \param sorted_idx Buffer for the indices sorted by score
+  */
+  static void CalDCG(const std::vector<data_size_t>& ks,
+    const label_t* label, const double* score,
+    data_size_t num_data, std::vector<double>* out, std::vector<data_size_t>* sorted_idx);
+
+  /*!
+  * \brief Sort the top k indices by descending score, only selecting them among the other indices.
+  *        The top k are in the same order as after a stable sort of all indices
+  * \param k Number of top indices to sort
+  * \param score Pointer of score
+  * \param num_data Number of data
+  * \param sorted_idx Output, all indices of which the first min(k, num_data) are sorted
+  */
+  static void SortTopK(data_size_t k, const double* score, data_size_t num_data,
+    std::vector<data_size_t>* sorted_idx);
+
+  /*!
+  * \brief Order of the queries by descending number of rows, to balance the work of dynamic scheduling
+  * \param query_boundaries Query boundaries
+  * \param num_queries Number of queries
+  */
+  static std::vector<data_size_t> QueriesBySize(const data_size_t* query_boundaries, data_size_t num_queries);
+
   /*!
   * \brief Calculate the Max DCG score at position k
   * \param k The position want to eval at
@@ -75,6 +75,9 @@ class ObjectiveFunction {
   /*! \brief The prediction should be accurate or not. True will disable early stopping for prediction. */
   virtual bool NeedAccuratePrediction() const { return true; }
 
+  /*! \brief True if the converted output is the probability of each class */
+  virtual bool IsClassification() const { return false; }
+
   /*! \brief Return the number of positive samples. Return 0 if no binary classification tasks.*/
   virtual data_size_t NumPositiveData() const { return 0; }
 
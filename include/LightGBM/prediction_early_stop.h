@@ -6,9 +6,12 @@
 #define LIGHTGBM_PREDICTION_EARLY_STOP_H_
 
 #include <LightGBM/export.h>
+#include <LightGBM/meta.h>
 
+#include <cstdint>
 #include <string>
 #include <functional>
+#include <vector>
 
 namespace LightGBM {
 
@@ -17,14 +20,30 @@ struct PredictionEarlyStopInstance {
   /// Takes current prediction and number of elements in prediction
   /// @returns true if prediction should stop according to criterion
   using FunctionType = std::function<bool(const double*, int)>;
+  /// Callback function type for early stopping of a batch of rows.
+  /// Takes the predictions of the batch (number of elements per row), the positions of the rows still
+  /// being predicted and their count, and the number of iterations predicted so far.
+  /// Sets stop[j] to 1 if the j-th active row should stop, and may change the predictions of the stopped rows
+  using BatchFunctionType = std::function<void(double*, int, const data_size_t*, data_size_t, int, int8_t*)>;
 
   FunctionType callback_function;  // callback function itself
   int          round_period;       // call callback_function every `runPeriod` iterations
+  /// criterion looking at all the rows of a batch at once, if empty callback_function is called for each row
+  BatchFunctionType batch_callback_function;
 };
 
 struct PredictionEarlyStopConfig {
   int round_period;
   double margin_threshold;
+  /// probability of the most likely class above which a row stops, for the "confidence" type
+  double confidence_threshold;
+  /// number of best rows of a batch that are predicted exactly, for the "top_k" type
+  int top_k;
+  /// converts raw scores into probabilities, for the "confidence" type
+  std::function<void(const double*, double*)> convert_output;
+  /// lowest and highest raw score the iterations from i to the end can still add, for the "top_k" type
+  std::vector<double> remaining_lower;
+  std::vector<double> remaining_upper;
 };
 
 /// Create an early stopping algorithm of type `type`, with given round_period and margin threshold
@@ -0,0 +1,448 @@
+/*!
+ * Copyright (c) 2024 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for
+ * license information.
+ */
+#ifndef LIGHTGBM_RAW_COLUMN_H_
+#define LIGHTGBM_RAW_COLUMN_H_
+
+#include <LightGBM/bin.h>
+#include <LightGBM/meta.h>
+#include <LightGBM/utils/log.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace LightGBM {
+
+/*! \brief How the raw values of a feature are kept for linear trees */
+enum class RawType {
+  Float32,
+  Float16,
+  BFloat16,
+  /*! \brief No raw values are kept, they are rebuilt from the bins */
+  Bin
+};
+
+/*!
+ * \brief Parse the value of the ``linear_raw_type`` parameter
+ */
+inline RawType ParseRawType(const std::string& name) {
+  if (name == std::string("float32")) {
+    return RawType::Float32;
+  } else if (name == std::string("float16")) {
+    return RawType::Float16;
+  } else if (name == std::string("bfloat16")) {
+    return RawType::BFloat16;
+  } else if (name == std::string("bin")) {
+    return RawType::Bin;
+  }
+  Log::Fatal("Unknown linear_raw_type %s", name.c_str());
+  return RawType::Float32;
+}
+
+/*!
+ * \brief Raw values of one numerical feature, used by the linear models of linear trees.
+ *        Values are pushed in the type of the column. Once loaded, a column with few distinct
+ *        values can be compressed into one-byte codes into a table of its values.
+ */
+class RawColumn {
+ public:
+  explicit RawColumn(RawType type = RawType::Float32) : type_(type), storage_(BaseStorage(type)) {}
+
+  /*! \brief Type the values are pushed in */
+  inline RawType type() const { return type_; }
+
+  /*! \brief Number of values */
+  inline data_size_t num_data() const { return num_data_; }
+
+  /*! \brief True if the values are stored as codes into a table of values */
+  inline bool is_dictionary() const { return storage_ == Storage::Code8 || storage_ == Storage::Code16; }
+
+  /*!
+   * \brief Resize the column, a compressed column is expanded first so that it can be pushed to again
+   * \param num_data New number of values
+   */
+  void Resize(data_size_t num_data) {
+    Expand();
+    num_data_ = num_data;
+    if (storage_ == Storage::Float32) {
+      values_.resize(num_data, 0.0f);
+    } else if (storage_ == Storage::Float16 || storage_ == Storage::BFloat16) {
+      // zero is all zero bits in both half types
+      half_values_.resize(num_data, 0);
+    }
+  }
+
+  /*! \brief Set the value of a row, does nothing for RawType::Bin */
+  inline void Set(data_size_t idx, double value) {
+    switch (storage_) {
+      case Storage::Float32:
+        values_[idx] = static_cast<float>(value);
+        break;
+      case Storage::Float16:
+        half_values_[idx] = FloatToHalf(static_cast<float>(value));
+        break;
+      case Storage::BFloat16:
+        half_values_[idx] = FloatToBFloat16(static_cast<float>(value));
+        break;
+      default:
+        break;
+    }
+  }
+
+  /*! \brief Get the value of a row */
+  inline float Get(data_size_t idx) const {
+    switch (storage_) {
+      case Storage::Float32:
+        return values_[idx];
+      case Storage::Float16:
+        return HalfToFloat(half_values_[idx]);
+      case Storage::BFloat16:
+        return BFloat16ToFloat(half_values_[idx]);
+      case Storage::Code8:
+        return dictionary_[codes_[idx]];
+      case Storage::Code16:
+        return dictionary_[wide_codes_[idx]];
+      default:
+        return 0.0f;
+    }
+  }
+
+  /*!
+   * \brief Get the values of some rows
+   * \param rows Row indices
+   * \param cnt Number of rows
+   * \param out Output, values of the rows
+   */
+  void Gather(const data_size_t* rows, data_size_t cnt, double* out) const {
+    switch (storage_) {
+      case Storage::Float32:
+        for (data_size_t i = 0; i < cnt; ++i) {
+          out[i] = values_[rows[i]];
+        }
+        break;
+      case Storage::Float16:
+        for (data_size_t i = 0; i < cnt; ++i) {
+          out[i] = HalfToFloat(half_values_[rows[i]]);
+        }
+        break;
+      case Storage::BFloat16:
+        for (data_size_t i = 0; i < cnt; ++i) {
+          out[i] = BFloat16ToFloat(half_values_[rows[i]]);
+        }
+        break;
+      case Storage::Code8:
+        for (data_size_t i = 0; i < cnt; ++i) {
+          out[i] = dictionary_[codes_[rows[i]]];
+        }
+        break;
+      case Storage::Code16:
+        for (data_size_t i = 0; i < cnt; ++i) {
+          out[i] = dictionary_[wide_codes_[rows[i]]];
+        }
+        break;
+      default:
+        std::fill(out, out + cnt, 0.0);
+        break;
+    }
+  }
+
+  /*! \brief True if any value is NaN */
+  bool ContainsNaN() const {
+    if (is_dictionary()) {
+      for (float value : dictionary_) {
+        if (std::isnan(value)) {
+          return true;
+        }
+      }
+      return false;
+    }
+    for (data_size_t i = 0; i < num_data_; ++i) {
+      if (std::isnan(Get(i))) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /*!
+   * \brief Store the values as one-byte codes if there are at most 256 distinct ones, the values don't change
+   */
+  void Compress() {
+    if (storage_ != Storage::Float32 && storage_ != Storage::Float16 && storage_ != Storage::BFloat16) {
+      return;
+    }
+    // distinct bit patterns, kept sorted, stop as soon as there are too many
+    std::vector<uint32_t> keys;
+    for (data_size_t i = 0; i < num_data_; ++i) {
+      const uint32_t key = Key(i);
+      auto pos = std::lower_bound(keys.begin(), keys.end(), key);
+      if (pos == keys.end() || *pos != key) {
+        if (keys.size() == 256) {
+          return;
+        }
+        keys.insert(pos, key);
+      }
+    }
+    codes_.resize(num_data_);
+    for (data_size_t i = 0; i < num_data_; ++i) {
+      codes_[i] = static_cast<uint8_t>(std::lower_bound(keys.begin(), keys.end(), Key(i)) - keys.begin());
+    }
+    dictionary_.resize(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+      dictionary_[i] = KeyToFloat(keys[i]);
+    }
+    std::vector<float>().swap(values_);
+    std::vector<uint16_t>().swap(half_values_);
+    storage_ = Storage::Code8;
+  }
+
+  /*!
+   * \brief Rebuild the values from the bins, each value is the middle of its bin
+   * \param iterator Iterator over the bins of the feature
+   * \param bin_mapper Bin mapper of the feature
+   * \param num_data Number of rows
+   */
+  void SetFromBins(BinIterator* iterator, const BinMapper& bin_mapper, data_size_t num_data) {
+    num_data_ = num_data;
+    const int num_bin = bin_mapper.num_bin();
+    dictionary_.resize(num_bin);
+    for (int bin = 0; bin < num_bin; ++bin) {
+      dictionary_[bin] = static_cast<float>(bin_mapper.BinToMidValue(bin));
+    }
+    iterator->Reset(0);
+    if (num_bin <= 256) {
+      std::vector<uint16_t>().swap(wide_codes_);
+      codes_.resize(num_data);
+      for (data_size_t i = 0; i < num_data; ++i) {
+        codes_[i] = static_cast<uint8_t>(iterator->Get(i));
+      }
+      storage_ = Storage::Code8;
+    } else {
+      std::vector<uint8_t>().swap(codes_);
+      wide_codes_.resize(num_data);
+      for (data_size_t i = 0; i < num_data; ++i) {
+        wide_codes_[i] = static_cast<uint16_t>(iterator->Get(i));
+      }
+      storage_ = Storage::Code16;
+    }
+  }
+
+  /*! \brief Go back from codes to values of the column type, so that values can be set again */
+  void Expand() {
+    if (!is_dictionary()) {
+      return;
+    }
+    if (type_ != RawType::Bin) {
+      const Storage base = BaseStorage(type_);
+      if (base == Storage::Float32) {
+        values_.resize(num_data_);
+      } else {
+        half_values_.resize(num_data_);
+      }
+      // the table holds the decoded values, so encoding them again is exact
+      for (data_size_t i = 0; i < num_data_; ++i) {
+        const float value = Get(i);
+        if (base == Storage::Float32) {
+          values_[i] = value;
+        } else if (base == Storage::Float16) {
+          half_values_[i] = FloatToHalf(value);
+        } else {
+          half_values_[i] = FloatToBFloat16(value);
+        }
+      }
+    }
+    // values of RawType::Bin columns are rebuilt when the Dataset is finished
+    std::vector<uint8_t>().swap(codes_);
+    std::vector<uint16_t>().swap(wide_codes_);
+    std::vector<float>().swap(dictionary_);
+    storage_ = BaseStorage(type_);
+  }
+
+  /*!
+   * \brief Copy some rows of another column, keeping its storage
+   * \param full Column to copy from
+   * \param used_indices Indices of the rows in full
+   * \param num_used_indices Number of rows
+   */
+  void CopySubrow(const RawColumn& full, const data_size_t* used_indices, data_size_t num_used_indices) {
+    type_ = full.type_;
+    storage_ = full.storage_;
+    num_data_ = num_used_indices;
+    dictionary_ = full.dictionary_;
+    values_.clear();
+    half_values_.clear();
+    codes_.clear();
+    wide_codes_.clear();
+    switch (storage_) {
+      case Storage::Float32:
+        values_.resize(num_used_indices);
+        for (data_size_t i = 0; i < num_used_indices; ++i) {
+          values_[i] = full.values_[used_indices[i]];
+        }
+        break;
+      case Storage::Float16:
+      case Storage::BFloat16:
+        half_values_.resize(num_used_indices);
+        for (data_size_t i = 0; i < num_used_indices; ++i) {
+          half_values_[i] = full.half_values_[used_indices[i]];
+        }
+        break;
+      case Storage::Code8:
+        codes_.resize(num_used_indices);
+        for (data_size_t i = 0; i < num_used_indices; ++i) {
+          codes_[i] = full.codes_[used_indices[i]];
+        }
+        break;
+      case Storage::Code16:
+        wide_codes_.resize(num_used_indices);
+        for (data_size_t i = 0; i < num_used_indices; ++i) {
+          wide_codes_[i] = full.wide_codes_[used_indices[i]];
+        }
+        break;
+      default:
+        break;
+    }
+  }
+
+  /*! \brief Size of the stored values in bytes */
+  size_t SizesInByte() const {
+    return values_.size() * sizeof(float) + half_values_.size() * sizeof(uint16_t) +
+      codes_.size() * sizeof(uint8_t) + wide_codes_.size() * sizeof(uint16_t) + dictionary_.size() * sizeof(float);
+  }
+
+  /*! \brief IEEE half precision value nearest to value, ties to even */
+  static inline uint16_t FloatToHalf(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+    const uint32_t abs_bits = bits & 0x7FFFFFFF;
+    if (abs_bits >= 0x7F800000) {
+      // infinity, or NaN which stays a quiet NaN
+      return sign | 0x7C00 | (abs_bits > 0x7F800000 ? 0x0200 : 0);
+    }
+    if (abs_bits >= 0x477FF000) {
+      // rounds above the largest half, 65504
+      return sign | 0x7C00;
+    }
+    if (abs_bits < 0x38800000) {
+      // subnormal half, in units of 2^-24
+      if (abs_bits <= 0x33000000) {
+        return sign;
+      }
+      const uint32_t mantissa = (abs_bits & 0x7FFFFF) | 0x800000;
+      const uint32_t shift = 126 - (abs_bits >> 23);
+      uint32_t half = mantissa >> shift;
+      const uint32_t rest = mantissa & ((1u << shift) - 1);
+      const uint32_t halfway = 1u << (shift - 1);
+      if (rest > halfway || (rest == halfway && (half & 1))) {
+        ++half;
+      }
+      return sign | static_cast<uint16_t>(half);
+    }
+    uint32_t half = (abs_bits - 0x38000000) >> 13;
+    const uint32_t rest = abs_bits & 0x1FFF;
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) {
+      ++half;
+    }
+    return sign | static_cast<uint16_t>(half);
+  }
+
+  static inline float HalfToFloat(uint16_t half) {
+    const uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+    const uint32_t exponent = (half >> 10) & 0x1F;
+    const uint32_t mantissa = half & 0x3FF;
+    uint32_t bits;
+    if (exponent == 0x1F) {
+      bits = sign | 0x7F800000 | (mantissa << 13);
+    } else if (exponent != 0) {
+      bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    } else {
+      const float value = static_cast<float>(mantissa) * (1.0f / 16777216.0f);
+      return sign ? -value : value;
+    }
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  /*! \brief bfloat16 value nearest to value, ties to even */
+  static inline uint16_t FloatToBFloat16(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    if ((bits & 0x7FFFFFFF) > 0x7F800000) {
+      return static_cast<uint16_t>((bits >> 16) | 0x0040);
+    }
+    return static_cast<uint16_t>((bits + 0x7FFF + ((bits >> 16) & 1)) >> 16);
+  }
+
+  static inline float BFloat16ToFloat(uint16_t half) {
+    const uint32_t bits = static_cast<uint32_t>(half) << 16;
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+ private:
+  enum class Storage {
+    Float32,
+    Float16,
+    BFloat16,
+    Code8,
+    Code16,
+    None
+  };
+
+  static Storage BaseStorage(RawType type) {
+    switch (type) {
+      case RawType::Float32:
+        return Storage::Float32;
+      case RawType::Float16:
+        return Storage::Float16;
+      case RawType::BFloat16:
+        return Storage::BFloat16;
+      default:
+        return Storage::None;
+    }
+  }
+
+  /*! \brief Bit pattern of the stored value of a row */
+  inline uint32_t Key(data_size_t idx) const {
+    if (storage_ == Storage::Float32) {
+      uint32_t bits;
+      std::memcpy(&bits, &values_[idx], sizeof(bits));
+      return bits;
+    }
+    return half_values_[idx];
+  }
+
+  inline float KeyToFloat(uint32_t key) const {
+    if (storage_ == Storage::Float32) {
+      float value;
+      std::memcpy(&value, &key, sizeof(value));
+      return value;
+    } else if (storage_ == Storage::Float16) {
+      return HalfToFloat(static_cast<uint16_t>(key));
+    }
+    return BFloat16ToFloat(static_cast<uint16_t>(key));
+  }
+
+  RawType type_;
+  Storage storage_;
+  data_size_t num_data_ = 0;
+  std::vector<float> values_;
+  std::vector<uint16_t> half_values_;
+  std::vector<uint8_t> codes_;
+  std::vector<uint16_t> wide_codes_;
+  std::vector<float> dictionary_;
+};
+
+}  // namespace LightGBM
+
+#endif  // LIGHTGBM_RAW_COLUMN_H_
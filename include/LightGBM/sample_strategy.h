@@ -60,6 +60,15 @@ class SampleStrategy {
   virtual const data_size_t* sampled_query_indices() const { return nullptr; }
 
  protected:
+  /*!
+  * \brief Cost model for the data of the tree learner, training on a compact copy of the bagged rows
+  *        versus reading the bagged rows of the full data through their indices
+  * \param bag_data_cnt Number of bagged rows
+  * \param num_iterations_per_bag Number of iterations trained on each bag
+  * \return True if copying the bagged rows is expected to move less memory
+  */
+  bool IsSubsetCheaper(data_size_t bag_data_cnt, int num_iterations_per_bag) const;
+
   const Config* config_;
   const Dataset* train_data_;
   const ObjectiveFunction* objective_function_;
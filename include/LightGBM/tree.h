@@ -142,6 +142,17 @@ class Tree {
   inline void PredictContribByMap(const std::unordered_map<int, double>& feature_values,
                                   int num_features, std::unordered_map<int, double>* output);
 
+  /*!
+  * \brief Add the SHAP interaction values of one record to a (num_features + 1) x (num_features + 1) row-major
+  *        matrix. Only the entries off the diagonal are added: output[i * (num_features + 1) + j] is half the change
+  *        of the contribution of feature i when feature j is known. The diagonal follows from PredictContrib
+  */
+  void PredictInteraction(const double* feature_values, int num_features, double* output) const;
+
+  /*! \brief Same as PredictInteraction, for the nonzero entries of the matrix keyed by i * (num_features + 1) + j */
+  void PredictInteractionSparse(const double* feature_values, int num_features,
+                                std::unordered_map<int, double>* output) const;
+
   /*! \brief Get Number of leaves*/
   inline int num_leaves() const { return num_leaves_; }
 
@@ -183,6 +194,18 @@ class Tree {
     return threshold_in_bin_[node_idx];
   }
 
+  /*! \brief Get threshold of a numerical split, or bitset index of a categorical split */
+  inline double threshold(int node_idx) const { return threshold_[node_idx]; }
+
+  inline int8_t decision_type(int node_idx) const { return decision_type_[node_idx]; }
+
+  /*! \brief Get the bitset of categories going to the left child of a categorical split */
+  inline std::vector<uint32_t> categorical_bitset(int node_idx) const {
+    const int cat_idx = static_cast<int>(threshold_[node_idx]);
+    return std::vector<uint32_t>(cat_threshold_.begin() + cat_boundaries_[cat_idx],
+                                 cat_threshold_.begin() + cat_boundaries_[cat_idx + 1]);
+  }
+
   /*! \brief Get the number of data points that fall at or below this node*/
   inline int data_count(int node) const { return node >= 0 ? internal_count_[node] : leaf_count_[~node]; }
 
@@ -245,6 +268,23 @@ class Tree {
     leaf_count_[0] = count;
   }
 
+  /*!
+  * \brief Check whether the other tree routes every row to the same leaf as this one
+  * \param other Tree to compare with
+  */
+  bool HasSameSplits(const Tree& other) const;
+
+  /*!
+  * \brief Add the leaf outputs of a tree with the same splits to this one
+  * \param other Tree with the same splits, see HasSameSplits
+  */
+  void AddLeafOutputs(const Tree& other);
+
+  /*!
+  * \brief Average magnitude of the output, leaves weighted by their training data count
+  */
+  double MeanAbsOutput() const;
+
   /*! \brief Serialize this object to string*/
   std::string ToString() const;
 
@@ -288,6 +328,33 @@ class Tree {
 
   void RecomputeMaxDepth();
 
+  /*! \brief Maximal number of distinct features on the path of a leaf for the fast TreeSHAP tables */
+  static const int kMaxSHAPPathFeatures = 20;
+
+  /*!
+  * \brief Collect the distinct features on the path of each leaf for the fast TreeSHAP, before InitSHAPTables
+  * \return Number of entries of the tables of all leaves, -1 if a path has more than kMaxSHAPPathFeatures features
+  */
+  int64_t InitSHAPPaths();
+
+  /*!
+  * \brief Precompute the weights of each leaf in the contributions of its path features, for every subset of those
+  *        features that a row can follow. PredictContrib then costs O(#leaves * depth) instead of
+  *        O(#leaves * depth^2). The paths are dropped and the recursive TreeSHAP is kept if use_tables is false.
+  *        The interaction tables are dropped as well
+  * \param use_tables False to fall back to the recursive TreeSHAP, e.g. when the tables do not fit in memory
+  */
+  void InitSHAPTables(bool use_tables);
+
+  /*!
+  * \brief Also fill the tables of PredictInteraction, as large as those of InitSHAPTables. Only the interaction
+  *        tables are written, so that PredictContrib can run meanwhile. Nothing is done without contribution tables
+  */
+  void InitSHAPInteractionTables();
+
+  /*! \brief Number of entries of the fast TreeSHAP tables, 0 if the recursive TreeSHAP is used */
+  int64_t num_shap_table_entries() const { return static_cast<int64_t>(shap_tables_.size()); }
+
   int NextLeafId() const { return num_leaves_; }
 
   /*! \brief Get the linear model constant term (bias) of one leaf */
@@ -473,6 +540,47 @@ class Tree {
                      PathElement *parent_unique_path, double parent_zero_fraction,
                      double parent_one_fraction, int parent_feature_index) const;
 
+  /*!
+  * \brief SHAP values from the precomputed tables, same as TreeSHAP from the root.
+  *        For a leaf with value v and distinct path features D with zero fractions z, let s be the features
+  *        whose conditions the row satisfies and K(t) = sum over S in t of |S|!(|D|-|S|-1)!/|D|! * prod_{t \ S} z.
+  *        Then a feature i in s gets v * (1 - z_i) * prod_{D \ s} z * K(s \ {i}), and a feature i not in s gets
+  *        -v * prod_{D \ s} z * K(s)
+  */
+  void FastTreeSHAP(const double *feature_values, double *phi) const;
+
+  /*!
+  * \brief Whether the row goes to the right child of each internal node, in a per-thread buffer that is valid
+  *        until the next call on the same thread
+  */
+  const int8_t* NodeDirections(const double* feature_values) const;
+
+  /*!
+  * \brief Interaction values from the precomputed tables. Knowing feature j scales the leaf by its indicator o_j
+  *        instead of z_j and removes j from the players, so the contributions of the other features in the game
+  *        of D \ {j} are taken with v * (o_j - z_j) / 2 as leaf value, from K2 built like K for |D| - 1 players.
+  *        add(i, j, value) is called for each pair of distinct path features
+  */
+  template <typename ADD>
+  void FastTreeSHAPInteraction(const double* feature_values, ADD add) const;
+
+  /*! \brief Interaction values from TreeSHAP conditioned on each split feature in turn, without tables */
+  template <typename ADD>
+  void ConditionalTreeSHAPInteraction(const double* feature_values, int num_features, ADD add) const;
+
+  /*!
+  * \brief TreeSHAP where condition_feature is known (condition > 0) or unknown (condition < 0) and not a player.
+  *        Unlike TreeSHAP, the path of a node starts at parent_unique_path + unique_depth + 1
+  */
+  void ConditionalTreeSHAP(const double* feature_values, double* phi, int node, int unique_depth,
+                           PathElement* parent_unique_path, double parent_zero_fraction,
+                           double parent_one_fraction, int parent_feature_index, int condition,
+                           int condition_feature, double condition_fraction) const;
+
+  /*! \brief Fill table[t] = K(t) for the subsets t of the features after next, extending coef[size] */
+  static void FillSHAPTable(const double* zero_fractions, const double* weights, int num_features, int next,
+                            uint32_t subset, int size, double* coef, double* table);
+
   /*! \brief Extend our decision path with a fraction of one and zero extensions for TreeSHAP*/
   static void ExtendPath(PathElement *unique_path, int unique_depth,
                          double zero_fraction, double one_fraction, int feature_index);
@@ -536,6 +644,20 @@ class Tree {
 
   double shrinkage_;
   int max_depth_;
+  /*! \brief Fast TreeSHAP, distinct path features of each leaf, [shap_leaf_begin_[leaf], shap_leaf_begin_[leaf + 1]) */
+  std::vector<int> shap_leaf_begin_;
+  std::vector<int> shap_features_;
+  std::vector<double> shap_zero_fractions_;
+  /*! \brief Fast TreeSHAP, nodes on the path of each leaf, with the slot of their feature and the side of the leaf */
+  std::vector<int> shap_node_begin_;
+  std::vector<int> shap_nodes_;
+  std::vector<uint32_t> shap_node_masks_;
+  std::vector<int8_t> shap_node_right_;
+  /*! \brief Fast TreeSHAP, K(t) of the subsets of the path features of each leaf, from shap_table_begin_[leaf] */
+  std::vector<int64_t> shap_table_begin_;
+  std::vector<double> shap_tables_;
+  /*! \brief Fast TreeSHAP, K2(t) of each leaf for the interaction values, same offsets as shap_tables_ */
+  std::vector<double> shap_interaction_tables_;
   /*! \brief Tree has linear model at each leaf */
   bool is_linear_;
   /*! \brief coefficients of linear models on leaves */
@@ -680,8 +802,10 @@ inline int Tree::PredictLeafIndexByMap(const std::unordered_map<int, double>& fe
 
 inline void Tree::PredictContrib(const double* feature_values, int num_features, double* output) {
   output[num_features] += ExpectedValue();
-  // Run the recursion with preallocated space for the unique path data
-  if (num_leaves_ > 1) {
+  if (num_leaves_ > 1 && !shap_tables_.empty()) {
+    FastTreeSHAP(feature_values, output);
+  } else if (num_leaves_ > 1) {
+    // Run the recursion with preallocated space for the unique path data
     CHECK_GE(max_depth_, 0);
     const int max_path_len = max_depth_ + 1;
     std::vector<PathElement> unique_path_data(max_path_len*(max_path_len + 1) / 2);
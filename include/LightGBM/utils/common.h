@@ -599,6 +599,38 @@ inline static void Softmax(const double* input, double* output, int len) {
   }
 }
 
+/*!
+* \brief Single precision exp of an array, in place. A branch-free polynomial approximation (as in Cephes expf)
+*        that the compiler can vectorize, within a few ulp of std::exp. Inputs are clamped to [-87, 88], where the
+*        results are normal floats
+*/
+inline static void FastExp(float* values, int len) {
+  // clamped in a separate pass, the compiler does not if-convert the clamp once its result is reused below
+  for (int i = 0; i < len; ++i) {
+    values[i] = std::min(std::max(values[i], -87.0f), 88.0f);
+  }
+  for (int i = 0; i < len; ++i) {
+    const float x = values[i];
+    // x = n * ln(2) + r, with |r| <= ln(2) / 2. The biased exponent n + 127 is positive, so the conversion
+    // rounds down without a comparison
+    const int32_t biased_n = static_cast<int32_t>(x * 1.44269504088896341f + 127.5f);
+    const float n = static_cast<float>(biased_n - 127);
+    const float r = x - n * 0.693359375f + n * 2.12194440e-4f;
+    float y = 1.9875691500e-4f;
+    y = y * r + 1.3981999507e-3f;
+    y = y * r + 8.3334519073e-3f;
+    y = y * r + 4.1665795894e-2f;
+    y = y * r + 1.6666665459e-1f;
+    y = y * r + 5.0000001201e-1f;
+    y = y * r * r + r + 1.0f;
+    // scale by 2^n through the exponent bits
+    const int32_t bits = biased_n << 23;
+    float scale;
+    std::memcpy(&scale, &bits, sizeof(scale));
+    values[i] = y * scale;
+  }
+}
+
 template<typename T>
 std::vector<const T*> ConstPtrInVectorWrapper(const std::vector<std::unique_ptr<T>>& input) {
   std::vector<const T*> ret;
@@ -842,6 +874,17 @@ inline static bool FindInBitset(const uint32_t* bits, int n, T pos) {
   return (bits[i1] >> i2) & 1;
 }
 
+inline static int PopCount(uint64_t x) {
+#if defined(__POPCNT__) && (defined(__GNUC__) || defined(__clang__))
+  return __builtin_popcountll(x);
+#else
+  x = x - ((x >> 1) & 0x5555555555555555ULL);
+  x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+  x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+  return static_cast<int>((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
 inline static bool CheckDoubleEqualOrdered(double a, double b) {
   double upper = std::nextafter(a, INFINITY);
   return b <= upper;
@@ -1103,8 +1146,12 @@ struct __StringToTHelperFast<T, true> {
 template<typename T, bool is_float>
 struct __StringToTHelper {
   T operator()(const std::string& str) const {
+    return (*this)(str.c_str());
+  }
+
+  T operator()(const char* p) const {
     T ret = 0;
-    LightGBM::Common::Atoi(str.c_str(), &ret);
+    LightGBM::Common::Atoi(p, &ret);
     return ret;
   }
 };
@@ -1119,17 +1166,40 @@ struct __StringToTHelper {
 template<typename T>
 struct __StringToTHelper<T, true> {
   T operator()(const std::string& str) const {
+    return (*this)(str.c_str());
+  }
+
+  T operator()(const char* p) const {
     double tmp;
 
-    const char* end = Common::AtofPrecise(str.c_str(), &tmp);
-    if (end == str.c_str()) {
-        Log::Fatal("Failed to parse double: %s", str.c_str());
+    const char* end = Common::AtofPrecise(p, &tmp);
+    if (end == p) {
+        Log::Fatal("Failed to parse double: %s", p);
     }
 
     return static_cast<T>(tmp);
   }
 };
 
+/*!
+* Parses the tokens of a null-terminated string separated by (runs of) the delimiter in place,
+* with the same precision as ``__StringToTHelper``, without splitting the string into substrings first.
+*/
+template<typename T>
+inline static void __StringToArrayInPlace(const char* p, char delimiter, std::vector<T>* ret) {
+  __StringToTHelper<T, std::is_floating_point<T>::value> helper;
+  while (*p != '\0') {
+    if (*p == delimiter) {
+      ++p;
+      continue;
+    }
+    ret->push_back(helper(p));
+    while (*p != '\0' && *p != delimiter) {
+      ++p;
+    }
+  }
+}
+
 
 /*!
 * \warning Beware that due to internal use of ``Common::Atof`` in ``__StringToTHelperFast``,
@@ -1162,14 +1232,10 @@ inline static std::vector<T> StringToArray(const std::string& str, int n) {
   if (n == 0) {
     return std::vector<T>();
   }
-  std::vector<std::string> strs = LightGBM::Common::Split(str.c_str(), ' ');
-  CHECK_EQ(strs.size(), static_cast<size_t>(n));
   std::vector<T> ret;
-  ret.reserve(strs.size());
-  __StringToTHelper<T, std::is_floating_point<T>::value> helper;
-  for (const auto& s : strs) {
-    ret.push_back(helper(s));
-  }
+  ret.reserve(n);
+  __StringToArrayInPlace(str.c_str(), ' ', &ret);
+  CHECK_EQ(ret.size(), static_cast<size_t>(n));
   return ret;
 }
 
@@ -1180,79 +1246,67 @@ inline static std::vector<T> StringToArray(const std::string& str, int n) {
 */
 template<typename T>
 inline static std::vector<T> StringToArray(const std::string& str, char delimiter) {
-  std::vector<std::string> strs = LightGBM::Common::Split(str.c_str(), delimiter);
   std::vector<T> ret;
-  ret.reserve(strs.size());
-  __StringToTHelper<T, std::is_floating_point<T>::value> helper;
-  for (const auto& s : strs) {
-    ret.push_back(helper(s));
-  }
+  __StringToArrayInPlace(str.c_str(), delimiter, &ret);
   return ret;
 }
 
-/*!
-* Safely formats a value onto a buffer according to a format string and null-terminates it.
-*
-* \note It checks that the full value was written or forcefully aborts.
-*       This safety check serves to prevent incorrect internal API usage.
-*       Correct usage will never incur in this problem:
-*         - The received buffer size shall be sufficient at all times for the input format string and value.
-*/
-template <typename T>
-inline static void format_to_buf(char* buffer, const size_t buf_len, const char* format, const T value) {
-    auto result = fmt::format_to_n(buffer, buf_len, format, value);
-    if (result.size >= buf_len) {
-      Log::Fatal("Numerical conversion failed. Buffer is too small.");
-    }
-    buffer[result.size] = '\0';
-}
-
 template<typename T, bool is_float, bool high_precision>
 struct __TToStringHelper {
-  void operator()(T value, char* buffer, size_t buf_len) const {
-    format_to_buf(buffer, buf_len, "{}", value);
+  void operator()(T value, std::string* out) const {
+    fmt::format_to(std::back_inserter(*out), "{}", value);
   }
 };
 
 template<typename T>
 struct __TToStringHelper<T, true, false> {
-  void operator()(T value, char* buffer, size_t buf_len) const {
-    format_to_buf(buffer, buf_len, "{:g}", value);
+  void operator()(T value, std::string* out) const {
+    fmt::format_to(std::back_inserter(*out), "{:g}", value);
   }
 };
 
 template<typename T>
 struct __TToStringHelper<T, true, true> {
-  void operator()(T value, char* buffer, size_t buf_len) const {
-    format_to_buf(buffer, buf_len, "{:.17g}", value);
+  void operator()(T value, std::string* out) const {
+    fmt::format_to(std::back_inserter(*out), "{:.17g}", value);
   }
 };
 
 /*!
-* Converts an array to a string with with values separated by the space character.
-* This method replaces Common's ``ArrayToString`` and ``ArrayToStringFast`` functionality
-* and is locale-independent.
+* Appends an array to a string with values separated by the space character.
+* Values are formatted directly into the string, so that large models can be
+* serialized without intermediate streams or buffers.
 *
 * \note If ``high_precision_output`` is set to true,
 *       floating point values are output with more digits of precision.
 */
 template<bool high_precision_output = false, typename T>
-inline static std::string ArrayToString(const std::vector<T>& arr, size_t n) {
+inline static void AppendArrayToString(const std::vector<T>& arr, size_t n, std::string* out) {
   if (arr.empty() || n == 0) {
-    return std::string("");
+    return;
   }
+  n = std::min(n, arr.size());
   __TToStringHelper<T, std::is_floating_point<T>::value, high_precision_output> helper;
-  const size_t buf_len = high_precision_output ? 32 : 16;
-  std::vector<char> buffer(buf_len);
-  std::stringstream str_buf;
-  Common::C_stringstream(str_buf);
-  helper(arr[0], buffer.data(), buf_len);
-  str_buf << buffer.data();
-  for (size_t i = 1; i < std::min(n, arr.size()); ++i) {
-    helper(arr[i], buffer.data(), buf_len);
-    str_buf << ' ' << buffer.data();
+  helper(arr[0], out);
+  for (size_t i = 1; i < n; ++i) {
+    out->push_back(' ');
+    helper(arr[i], out);
   }
-  return str_buf.str();
+}
+
+/*!
+* Converts an array to a string with with values separated by the space character.
+* This method replaces Common's ``ArrayToString`` and ``ArrayToStringFast`` functionality
+* and is locale-independent.
+*
+* \note If ``high_precision_output`` is set to true,
+*       floating point values are output with more digits of precision.
+*/
+template<bool high_precision_output = false, typename T>
+inline static std::string ArrayToString(const std::vector<T>& arr, size_t n) {
+  std::string str_buf;
+  AppendArrayToString<high_precision_output>(arr, n, &str_buf);
+  return str_buf;
 }
 
 
@@ -2030,11 +2030,16 @@ class Dataset:
                 "group_column",
                 "header",
                 "ignore_column",
+                "input_bundle_plan",
+                "input_dataset_schema",
                 "is_enable_sparse",
                 "label_column",
+                "linear_raw_dictionary",
+                "linear_raw_type",
                 "linear_tree",
                 "max_bin",
                 "max_bin_by_feature",
+                "max_bundle_search_groups",
                 "min_data_in_bin",
                 "pre_partition",
                 "precise_float_parser",
@@ -4521,6 +4526,45 @@ class Booster:
         )
         return self
 
+    def optimize_models(
+        self,
+        start_iteration: int = 0,
+        end_iteration: int = -1,
+        merge_tolerance: float = 0.0,
+    ) -> "Booster":
+        """Optimize models for faster prediction.
+
+        Trees of each class are reordered by decreasing mean output magnitude,
+        so that prediction early stopping exits sooner.
+        Trees with the same splits are merged and (near-)constant trees are folded into another tree,
+        so the number of iterations can decrease.
+
+        Parameters
+        ----------
+        start_iteration : int, optional (default=0)
+            The first iteration that will be optimized.
+        end_iteration : int, optional (default=-1)
+            The last iteration that will be optimized.
+            If <= 0, means the last available iteration.
+        merge_tolerance : float, optional (default=0.0)
+            Trees whose leaf outputs differ by at most this value are folded into a constant.
+            With 0, the raw predictions with all the trees are unchanged up to floating point rounding.
+
+        Returns
+        -------
+        self : Booster
+            Booster with optimized models.
+        """
+        _safe_call(
+            _LIB.LGBM_BoosterOptimizeModels(
+                self._handle,
+                ctypes.c_int(start_iteration),
+                ctypes.c_int(end_iteration),
+                ctypes.c_double(merge_tolerance),
+            )
+        )
+        return self
+
     def model_from_string(self, model_str: str) -> "Booster":
         """Load Booster from a string.
 
@@ -32,7 +32,8 @@ Application::Application(int argc, char** argv) {
   LoadParameters(argc, argv);
   // set number of threads for openmp
   OMP_SET_NUM_THREADS(config_.num_threads);
-  if (config_.data.size() == 0 && config_.task != TaskType::kConvertModel) {
+  if (config_.data.size() == 0 && config_.task != TaskType::kConvertModel
+      && config_.task != TaskType::kOptimizeModel) {
     Log::Fatal("No training/prediction data, application quit");
   }
 
@@ -92,7 +93,8 @@ void Application::LoadData() {
   PredictFunction predict_fun = nullptr;
   // need to continue training
   if (boosting_->NumberOfTotalModel() > 0 && config_.task != TaskType::KRefitTree) {
-    predictor.reset(new Predictor(boosting_.get(), 0, -1, true, false, false, false, -1, -1));
+    predictor.reset(new Predictor(boosting_.get(), 0, -1, true, false, false, false, false, -1, -1, "margin", -1, -1,
+                                  -1, false));
     predict_fun = predictor->GetPredictFunction();
   }
 
@@ -214,6 +216,8 @@ void Application::Train() {
   // convert model to if-else statement code
   if (config_.convert_model_language == std::string("cpp")) {
     boosting_->SaveModelToIfElse(-1, config_.convert_model.c_str());
+  } else if (config_.convert_model_language == std::string("c")) {
+    boosting_->SaveModelToC(0, -1, config_.convert_model.c_str());
   }
   Log::Info("Finished training");
 }
@@ -221,7 +225,7 @@ void Application::Train() {
 void Application::Predict() {
   if (config_.task == TaskType::KRefitTree) {
     // create predictor
-    Predictor predictor(boosting_.get(), 0, -1, false, true, false, false, 1, 1);
+    Predictor predictor(boosting_.get(), 0, -1, false, true, false, false, false, 1, 1, "margin", 1, 1, 1, false);
     predictor.Predict(config_.data.c_str(), config_.output_result.c_str(), config_.header, config_.predict_disable_shape_check,
                       config_.precise_float_parser);
     TextReader<int> result_reader(config_.output_result.c_str(), false);
@@ -262,9 +266,11 @@ void Application::Predict() {
   } else {
     // create predictor
     Predictor predictor(boosting_.get(), config_.start_iteration_predict, config_.num_iteration_predict, config_.predict_raw_score,
-                        config_.predict_leaf_index, config_.predict_contrib,
+                        config_.predict_leaf_index, config_.predict_contrib, false,
                         config_.pred_early_stop, config_.pred_early_stop_freq,
-                        config_.pred_early_stop_margin);
+                        config_.pred_early_stop_margin, config_.pred_early_stop_type,
+                        config_.pred_early_stop_confidence, config_.pred_early_stop_top_k,
+                        config_.pred_early_stop_batch_size, config_.pred_quantized_thresholds);
     predictor.Predict(config_.data.c_str(),
                       config_.output_result.c_str(), config_.header, config_.predict_disable_shape_check,
                       config_.precise_float_parser);
@@ -281,7 +287,19 @@ void Application::InitPredict() {
 void Application::ConvertModel() {
   boosting_.reset(
     Boosting::CreateBoosting(config_.boosting, config_.input_model.c_str()));
-  boosting_->SaveModelToIfElse(-1, config_.convert_model.c_str());
+  if (config_.convert_model_language == std::string("c")) {
+    boosting_->SaveModelToC(0, -1, config_.convert_model.c_str());
+  } else {
+    boosting_->SaveModelToIfElse(-1, config_.convert_model.c_str());
+  }
+}
+
+void Application::OptimizeModel() {
+  boosting_.reset(
+    Boosting::CreateBoosting(config_.boosting, config_.input_model.c_str()));
+  boosting_->OptimizeModels(0, -1, config_.optimize_merge_tolerance);
+  boosting_->SaveModelToFile(0, -1, config_.saved_feature_importance_type, config_.output_model.c_str());
+  Log::Info("Finished saving the optimized model to %s", config_.output_model.c_str());
 }
 
 
@@ -12,10 +12,12 @@
 #include <LightGBM/utils/openmp_wrapper.h>
 #include <LightGBM/utils/text_reader.h>
 
+#include <algorithm>
 #include <string>
 #include <cstdio>
 #include <cstring>
 #include <functional>
+#include <limits>
 #include <map>
 #include <memory>
 #include <unordered_map>
@@ -37,19 +39,48 @@ class Predictor {
   * \param is_raw_score True if need to predict result with raw score
   * \param predict_leaf_index True to output leaf index instead of prediction score
   * \param predict_contrib True to output feature contributions instead of prediction score
+  * \param predict_interaction True to output SHAP interaction values instead of prediction score
+  * \param early_stop_type Criterion of early stopping: margin, confidence or top_k
+  * \param early_stop_batch_size Maximal number of rows predicted together with early stopping
+  * \param quantized_thresholds True to map each row to threshold indices once before walking the trees
   */
   Predictor(Boosting* boosting, int start_iteration, int num_iteration, bool is_raw_score,
-            bool predict_leaf_index, bool predict_contrib, bool early_stop,
-            int early_stop_freq, double early_stop_margin) {
+            bool predict_leaf_index, bool predict_contrib, bool predict_interaction, bool early_stop,
+            int early_stop_freq, double early_stop_margin, const std::string& early_stop_type,
+            double early_stop_confidence, int early_stop_top_k, int early_stop_batch_size,
+            bool quantized_thresholds) {
+    boosting->InitPredict(start_iteration, num_iteration, predict_contrib, predict_interaction);
+    // the snapshot keeps this predictor on the quantized trees, whatever later predictors of the model use
+    if (quantized_thresholds && !predict_contrib && !predict_interaction) {
+      quantized_trees_ = boosting->GetQuantizedTrees();
+    }
     early_stop_ = CreatePredictionEarlyStopInstance(
         "none", LightGBM::PredictionEarlyStopConfig());
-    if (early_stop && !boosting->NeedAccuratePrediction()) {
+    const bool use_early_stop = early_stop && !boosting->NeedAccuratePrediction();
+    if (use_early_stop) {
       PredictionEarlyStopConfig pred_early_stop_config;
       CHECK_GT(early_stop_freq, 0);
       CHECK_GE(early_stop_margin, 0);
       pred_early_stop_config.margin_threshold = early_stop_margin;
       pred_early_stop_config.round_period = early_stop_freq;
-      if (boosting->NumberOfClasses() == 1) {
+      pred_early_stop_config.confidence_threshold = early_stop_confidence;
+      pred_early_stop_config.top_k = early_stop_top_k;
+      if (early_stop_type == std::string("confidence")) {
+        if (!boosting->IsClassification()) {
+          Log::Fatal("Confidence early stopping of the prediction needs a classification model");
+        }
+        pred_early_stop_config.convert_output = [boosting](const double* input, double* output) {
+          boosting->ConvertOutput(input, output);
+        };
+        early_stop_ = CreatePredictionEarlyStopInstance("confidence", pred_early_stop_config);
+      } else if (early_stop_type == std::string("top_k")) {
+        if (boosting->NumModelPerIteration() != 1) {
+          Log::Fatal("Top-k early stopping of the prediction needs a model with one score per row");
+        }
+        boosting->GetRemainingScoreBounds(&pred_early_stop_config.remaining_lower,
+                                          &pred_early_stop_config.remaining_upper);
+        early_stop_ = CreatePredictionEarlyStopInstance("top_k", pred_early_stop_config);
+      } else if (boosting->NumberOfClasses() == 1) {
         early_stop_ =
             CreatePredictionEarlyStopInstance("binary", pred_early_stop_config);
       } else {
@@ -58,87 +89,96 @@ class Predictor {
       }
     }
 
-    boosting->InitPredict(start_iteration, num_iteration, predict_contrib);
     boosting_ = boosting;
     num_pred_one_row_ = boosting_->NumPredictOneRow(start_iteration,
-        num_iteration, predict_leaf_index, predict_contrib);
+        num_iteration, predict_leaf_index, predict_contrib, predict_interaction);
     num_feature_ = boosting_->MaxFeatureIdx() + 1;
     predict_buf_.resize(
         OMP_NUM_THREADS(),
         std::vector<double, Common::AlignmentAllocator<double, kAlignedSize>>(
             num_feature_, 0.0f));
     const int kFeatureThreshold = 100000;
-    const size_t KSparseThreshold = static_cast<size_t>(0.01 * num_feature_);
+    use_predict_map_ = num_feature_ > kFeatureThreshold;
+    sparse_threshold_ = static_cast<size_t>(0.01 * num_feature_);
+    // a batch has at most early_stop_batch_size rows, and at most kMaxBatchValues feature values
+    const int kMaxBatchValues = 1 << 18;
+    batch_size_ = std::max(1, std::min(early_stop_batch_size, kMaxBatchValues / std::max(num_feature_, 1)));
+    if (use_early_stop && early_stop_type == std::string("top_k") && batch_size_ <= early_stop_top_k) {
+      Log::Warning("Top-k early stopping keeps the %d best rows of each batch of at most %d rows, no row will stop",
+                   early_stop_top_k, batch_size_);
+    }
     if (predict_leaf_index) {
-      predict_fun_ = [=](const std::vector<std::pair<int, double>>& features,
-                         double* output) {
-        int tid = omp_get_thread_num();
-        if (num_feature_ > kFeatureThreshold &&
-            features.size() < KSparseThreshold) {
-          auto buf = CopyToPredictMap(features);
-          boosting_->PredictLeafIndexByMap(buf, output);
-        } else {
-          CopyToPredictBuffer(predict_buf_[tid].data(), features);
-          // get result for leaf index
-          boosting_->PredictLeafIndex(predict_buf_[tid].data(), output);
-          ClearPredictBuffer(predict_buf_[tid].data(), predict_buf_[tid].size(),
-                             features);
-        }
+      predict_buf_fun_ = [=](const double* features, double* output) {
+        // get result for leaf index
+        boosting_->PredictLeafIndex(features, output, quantized_trees_.get());
+      };
+      predict_map_fun_ = [=](const std::unordered_map<int, double>& features, double* output) {
+        boosting_->PredictLeafIndexByMap(features, output);
       };
     } else if (predict_contrib) {
       if (boosting_->IsLinear()) {
         Log::Fatal("Predicting SHAP feature contributions is not implemented for linear trees.");
       }
-      predict_fun_ = [=](const std::vector<std::pair<int, double>>& features,
-                         double* output) {
-        int tid = omp_get_thread_num();
-        CopyToPredictBuffer(predict_buf_[tid].data(), features);
+      predict_buf_fun_ = [=](const double* features, double* output) {
         // get feature importances
-        boosting_->PredictContrib(predict_buf_[tid].data(), output);
-        ClearPredictBuffer(predict_buf_[tid].data(), predict_buf_[tid].size(),
-                           features);
+        boosting_->PredictContrib(features, output);
       };
       predict_sparse_fun_ = [=](const std::vector<std::pair<int, double>>& features,
                                 std::vector<std::unordered_map<int, double>>* output) {
-        auto buf = CopyToPredictMap(features);
+        auto buf = CopyToPredictMap(PairsRowView(features));
         // get sparse feature importances
         boosting_->PredictContribByMap(buf, output);
       };
-
+    } else if (predict_interaction) {
+      if (boosting_->IsLinear()) {
+        Log::Fatal("Predicting SHAP interaction values is not implemented for linear trees.");
+      }
+      // the matrix of each class is indexed by int
+      const int64_t num_cols = num_feature_ + 1;
+      if (num_cols * num_cols * boosting_->NumModelPerIteration() > std::numeric_limits<int32_t>::max()) {
+        Log::Fatal("Too many features (%d) to predict SHAP interaction values.", num_feature_);
+      }
+      predict_buf_fun_ = [=](const double* features, double* output) {
+        boosting_->PredictInteraction(features, output);
+      };
+      predict_sparse_fun_ = [=](const std::vector<std::pair<int, double>>& features,
+                                std::vector<std::unordered_map<int, double>>* output) {
+        auto buf = CopyToPredictMap(PairsRowView(features));
+        boosting_->PredictInteractionByMap(buf, output);
+      };
     } else {
       if (is_raw_score) {
-        predict_fun_ = [=](const std::vector<std::pair<int, double>>& features,
-                           double* output) {
-          int tid = omp_get_thread_num();
-          if (num_feature_ > kFeatureThreshold &&
-              features.size() < KSparseThreshold) {
-            auto buf = CopyToPredictMap(features);
-            boosting_->PredictRawByMap(buf, output, &early_stop_);
-          } else {
-            CopyToPredictBuffer(predict_buf_[tid].data(), features);
-            boosting_->PredictRaw(predict_buf_[tid].data(), output,
-                                  &early_stop_);
-            ClearPredictBuffer(predict_buf_[tid].data(),
-                               predict_buf_[tid].size(), features);
-          }
+        predict_buf_fun_ = [=](const double* features, double* output) {
+          boosting_->PredictRaw(features, output, &early_stop_, quantized_trees_.get());
+        };
+        predict_map_fun_ = [=](const std::unordered_map<int, double>& features, double* output) {
+          boosting_->PredictRawByMap(features, output, &early_stop_);
         };
       } else {
-        predict_fun_ = [=](const std::vector<std::pair<int, double>>& features,
-                           double* output) {
-          int tid = omp_get_thread_num();
-          if (num_feature_ > kFeatureThreshold &&
-              features.size() < KSparseThreshold) {
-            auto buf = CopyToPredictMap(features);
-            boosting_->PredictByMap(buf, output, &early_stop_);
-          } else {
-            CopyToPredictBuffer(predict_buf_[tid].data(), features);
-            boosting_->Predict(predict_buf_[tid].data(), output, &early_stop_);
-            ClearPredictBuffer(predict_buf_[tid].data(),
-                               predict_buf_[tid].size(), features);
-          }
+        predict_buf_fun_ = [=](const double* features, double* output) {
+          boosting_->Predict(features, output, &early_stop_, quantized_trees_.get());
+        };
+        predict_map_fun_ = [=](const std::unordered_map<int, double>& features, double* output) {
+          boosting_->PredictByMap(features, output, &early_stop_);
         };
       }
+      // with early stopping, rows are predicted in batches so that the stopped ones leave the remaining trees
+      if (use_early_stop && !use_predict_map_) {
+        if (is_raw_score) {
+          predict_batch_fun_ = [=](const double* features, data_size_t num_rows, double* output) {
+            boosting_->PredictRawBatch(features, num_rows, output, &early_stop_, quantized_trees_.get());
+          };
+        } else {
+          predict_batch_fun_ = [=](const double* features, data_size_t num_rows, double* output) {
+            boosting_->PredictBatch(features, num_rows, output, &early_stop_, quantized_trees_.get());
+          };
+        }
+        predict_batch_buf_.resize(OMP_NUM_THREADS());
+      }
     }
+    predict_fun_ = [=](const std::vector<std::pair<int, double>>& features, double* output) {
+      PredictRow(features, output);
+    };
   }
 
   /*!
@@ -156,6 +196,70 @@ class Predictor {
     return predict_sparse_fun_;
   }
 
+  /*!
+  * \brief Predict one row read through a row view, the row is scattered into the per-thread buffer in place
+  * \param row Row view providing size(), index(i) and value(i), columns beyond the model features are ignored
+  * \param output Prediction result of the row
+  */
+  template <typename RowView>
+  inline void PredictRow(const RowView& row, double* output) {
+    const size_t num_values = static_cast<size_t>(row.size());
+    if (predict_map_fun_ != nullptr && use_predict_map_ && num_values < sparse_threshold_) {
+      predict_map_fun_(CopyToPredictMap(row), output);
+      return;
+    }
+    auto& buf = predict_buf_[omp_get_thread_num()];
+    double* pred_buf = buf.data();
+    for (size_t i = 0; i < num_values; ++i) {
+      const int idx = row.index(i);
+      if (idx < num_feature_) {
+        pred_buf[idx] = row.value(i);
+      }
+    }
+    predict_buf_fun_(pred_buf, output);
+    if (num_values > buf.size() / 2) {
+      std::memset(pred_buf, 0, sizeof(double) * buf.size());
+    } else {
+      for (size_t i = 0; i < num_values; ++i) {
+        const int idx = row.index(i);
+        if (idx < num_feature_) {
+          pred_buf[idx] = 0.0f;
+        }
+      }
+    }
+  }
+
+  inline void PredictRow(const std::vector<std::pair<int, double>>& features, double* output) {
+    PredictRow(PairsRowView(features), output);
+  }
+
+  /*! \brief True if the rows are better predicted with PredictBatch, in batches of batch_size() rows */
+  inline bool use_batch() const { return predict_batch_fun_ != nullptr; }
+
+  inline data_size_t batch_size() const { return batch_size_; }
+
+  /*! \brief Snapshot of the quantized trees used by this predictor, nullptr if it predicts on raw values */
+  inline const QuantizedTrees* quantized_trees() const { return quantized_trees_.get(); }
+
+  /*!
+  * \brief Predict rows [start, end) of a matrix view together, at most batch_size() of them
+  * \param rows Matrix view, row(i) gives a row view or the (index, value) pairs of the i-th row
+  * \param start First row to predict
+  * \param end End of the rows to predict
+  * \param output Prediction results of the rows, one row after the other
+  */
+  template <typename MatrixView>
+  void PredictBatch(const MatrixView& rows, int64_t start, int64_t end, double* output) {
+    const data_size_t num_rows = static_cast<data_size_t>(end - start);
+    auto& buf = predict_batch_buf_[omp_get_thread_num()];
+    buf.resize(static_cast<size_t>(num_feature_) * batch_size_, 0.0f);
+    for (data_size_t i = 0; i < num_rows; ++i) {
+      ScatterRow(rows.row(start + i), buf.data() + static_cast<size_t>(num_feature_) * i);
+    }
+    predict_batch_fun_(buf.data(), num_rows, output);
+    std::memset(buf.data(), 0, sizeof(double) * num_feature_ * num_rows);
+  }
+
   /*!
   * \brief predicting on data, then saving result to disk
   * \param data_filename Filename of data
@@ -232,6 +336,14 @@ class Predictor {
                           data_size_t, const std::vector<std::string>& lines) {
       std::vector<std::pair<int, double>> oneline_features;
       std::vector<std::string> result_to_write(lines.size());
+      if (use_batch()) {
+        ProcessLinesInBatches(parser_fun, lines, &result_to_write);
+        for (data_size_t i = 0; i < static_cast<data_size_t>(result_to_write.size()); ++i) {
+          writer->Write(result_to_write[i].c_str(), result_to_write[i].size());
+          writer->Write("\n", 1);
+        }
+        return;
+      }
       OMP_INIT_EX();
       #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static) firstprivate(oneline_features)
       for (data_size_t i = 0; i < static_cast<data_size_t>(lines.size()); ++i) {
@@ -256,31 +368,77 @@ class Predictor {
   }
 
  private:
-  void CopyToPredictBuffer(double* pred_buf, const std::vector<std::pair<int, double>>& features) {
-    for (const auto &feature : features) {
-      if (feature.first < num_feature_) {
-        pred_buf[feature.first] = feature.second;
+  /*! \brief Row view over parsed (index, value) pairs */
+  class PairsRowView {
+   public:
+    explicit PairsRowView(const std::vector<std::pair<int, double>>& features) : features_(features) {}
+    inline size_t size() const { return features_.size(); }
+    inline int index(size_t i) const { return features_[i].first; }
+    inline double value(size_t i) const { return features_[i].second; }
+
+   private:
+    const std::vector<std::pair<int, double>>& features_;
+  };
+
+  /*! \brief Rows parsed as (index, value) pairs */
+  class ParsedRowsView {
+   public:
+    explicit ParsedRowsView(const std::vector<std::vector<std::pair<int, double>>>& rows) : rows_(rows) {}
+    inline const std::vector<std::pair<int, double>>& row(int64_t row_idx) const { return rows_[row_idx]; }
+
+   private:
+    const std::vector<std::vector<std::pair<int, double>>>& rows_;
+  };
+
+  /*! \brief Parse lines of a data file and predict them in batches */
+  void ProcessLinesInBatches(
+      const std::function<void(const char*, std::vector<std::pair<int, double>>*)>& parser_fun,
+      const std::vector<std::string>& lines, std::vector<std::string>* result_to_write) {
+    const data_size_t num_lines = static_cast<data_size_t>(lines.size());
+    std::vector<std::vector<std::pair<int, double>>> features(num_lines);
+    const data_size_t num_batches = (num_lines + batch_size_ - 1) / batch_size_;
+    OMP_INIT_EX();
+    #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static)
+    for (data_size_t batch = 0; batch < num_batches; ++batch) {
+      OMP_LOOP_EX_BEGIN();
+      const data_size_t start = batch * batch_size_;
+      const data_size_t end = std::min(start + batch_size_, num_lines);
+      for (data_size_t i = start; i < end; ++i) {
+        parser_fun(lines[i].c_str(), &features[i]);
       }
+      std::vector<double> result(static_cast<size_t>(num_pred_one_row_) * (end - start));
+      PredictBatch(ParsedRowsView(features), start, end, result.data());
+      for (data_size_t i = start; i < end; ++i) {
+        const size_t row_start = static_cast<size_t>(num_pred_one_row_) * (i - start);
+        (*result_to_write)[i] = Common::Join<double>(result, row_start, row_start + num_pred_one_row_, "\t");
+        std::vector<std::pair<int, double>>().swap(features[i]);
+      }
+      OMP_LOOP_EX_END();
     }
+    OMP_THROW_EX();
   }
 
-  void ClearPredictBuffer(double* pred_buf, size_t buf_size, const std::vector<std::pair<int, double>>& features) {
-    if (features.size() > static_cast<size_t>(buf_size / 2)) {
-      std::memset(pred_buf, 0, sizeof(double)*(buf_size));
-    } else {
-      for (const auto &feature : features) {
-        if (feature.first < num_feature_) {
-          pred_buf[feature.first] = 0.0f;
-        }
+  template <typename RowView>
+  inline void ScatterRow(const RowView& row, double* pred_buf) const {
+    const size_t num_values = static_cast<size_t>(row.size());
+    for (size_t i = 0; i < num_values; ++i) {
+      const int idx = row.index(i);
+      if (idx < num_feature_) {
+        pred_buf[idx] = row.value(i);
       }
     }
   }
 
-  std::unordered_map<int, double> CopyToPredictMap(const std::vector<std::pair<int, double>>& features) {
+  inline void ScatterRow(const std::vector<std::pair<int, double>>& features, double* pred_buf) const {
+    ScatterRow(PairsRowView(features), pred_buf);
+  }
+
+  template <typename RowView>
+  std::unordered_map<int, double> CopyToPredictMap(const RowView& row) const {
     std::unordered_map<int, double> buf;
-    for (const auto &feature : features) {
-      if (feature.first < num_feature_) {
-        buf[feature.first] = feature.second;
+    for (size_t i = 0; i < static_cast<size_t>(row.size()); ++i) {
+      if (row.index(i) < num_feature_) {
+        buf[row.index(i)] = row.value(i);
       }
     }
     return buf;
@@ -288,9 +446,21 @@ class Predictor {
 
   /*! \brief Boosting model */
   const Boosting* boosting_;
+  /*! \brief Trees with quantized thresholds taken when this predictor was created, nullptr for raw values */
+  std::shared_ptr<const QuantizedTrees> quantized_trees_;
   /*! \brief function for prediction */
   PredictFunction predict_fun_;
   PredictSparseFunction predict_sparse_fun_;
+  /*! \brief Prediction on a dense feature buffer */
+  std::function<void(const double*, double*)> predict_buf_fun_;
+  /*! \brief Prediction on a feature map, used for very sparse rows of wide models */
+  std::function<void(const std::unordered_map<int, double>&, double*)> predict_map_fun_;
+  bool use_predict_map_;
+  size_t sparse_threshold_;
+  /*! \brief Prediction on the dense feature buffer of a batch of rows, only set with early stopping */
+  std::function<void(const double*, data_size_t, double*)> predict_batch_fun_;
+  data_size_t batch_size_;
+  std::vector<std::vector<double, Common::AlignmentAllocator<double, kAlignedSize>>> predict_batch_buf_;
   PredictionEarlyStopInstance early_stop_;
   int num_feature_;
   int num_pred_one_row_;
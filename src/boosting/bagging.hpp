@@ -180,13 +180,10 @@ class BaggingSampleStrategy : public SampleStrategy {
         bagging_rands_.emplace_back(config_->bagging_seed + i);
       }
 
-      double average_bag_rate =
-          (static_cast<double>(bag_data_cnt_) / num_data_) / config_->bagging_freq;
       is_use_subset_ = false;
       if (config_->device_type != std::string("cuda")) {
         const int group_threshold_usesubset = 100;
-        const double average_bag_rate_threshold = 0.5;
-        if (average_bag_rate <= average_bag_rate_threshold
+        if (IsSubsetCheaper(bag_data_cnt_, config_->bagging_freq)
             && (train_data_->num_feature_groups() < group_threshold_usesubset)) {
           if (tmp_subset_ == nullptr || is_change_dataset) {
             tmp_subset_.reset(new Dataset(bag_data_cnt_));
@@ -12,8 +12,13 @@
 #include <LightGBM/utils/openmp_wrapper.h>
 #include <LightGBM/sample_strategy.h>
 
+#include <algorithm>
 #include <chrono>
+#include <cstring>
 #include <ctime>
+#include <functional>
+#include <limits>
+#include <numeric>
 #include <queue>
 #include <sstream>
 
@@ -129,6 +134,7 @@ void GBDT::Init(const Config* config, const Dataset* train_data, const Objective
   #endif  // USE_CUDA
 
   num_data_ = train_data_->num_data();
+  num_window_slides_ = train_data_->num_window_slides();
 
   // get max feature index
   max_feature_idx_ = train_data_->num_total_features() - 1;
@@ -443,6 +449,7 @@ bool GBDT::TrainOneIter(const score_t* gradients, const score_t* hessians) {
       for (int cur_tree_id = 0; cur_tree_id < num_tree_per_iteration_; ++cur_tree_id) {
         models_.pop_back();
       }
+      ResetQuantizedTrees();
     }
     return true;
   }
@@ -466,9 +473,122 @@ void GBDT::RollbackOneIter() {
   for (int cur_tree_id = 0; cur_tree_id < num_tree_per_iteration_; ++cur_tree_id) {
     models_.pop_back();
   }
+  ResetQuantizedTrees();
   --iter_;
 }
 
+void GBDT::OptimizeModels(int start_iter, int end_iter, double merge_tolerance) {
+  if (average_output_) {
+    Log::Fatal("Cannot optimize the models of an averaged ensemble, it would change the predictions");
+  }
+  if (merge_tolerance < 0.0) {
+    Log::Fatal("merge_tolerance should be non-negative, got %f", merge_tolerance);
+  }
+  const int total_iter = static_cast<int>(models_.size()) / num_tree_per_iteration_;
+  start_iter = std::max(0, start_iter);
+  if (end_iter <= 0) {
+    end_iter = total_iter;
+  }
+  end_iter = std::min(total_iter, end_iter);
+  if (end_iter <= start_iter) {
+    return;
+  }
+  ResetQuantizedTrees();
+  auto split_key = [](const Tree& tree) {
+    size_t key = std::hash<int>()(tree.num_leaves());
+    if (tree.num_leaves() > 1) {
+      key = key * 31 + std::hash<int>()(tree.split_feature(0));
+      key = key * 31 + std::hash<double>()(tree.threshold(0));
+    }
+    return key;
+  };
+  // trees of each class, in the order they will be predicted
+  std::vector<std::vector<std::unique_ptr<Tree>>> class_models(num_tree_per_iteration_);
+  int num_optimized_iter = 0;
+  for (int k = 0; k < num_tree_per_iteration_; ++k) {
+    std::vector<std::unique_ptr<Tree>>& trees = class_models[k];
+    std::unordered_map<size_t, std::vector<size_t>> trees_by_key;
+    double constant = 0.0;
+    for (int i = start_iter; i < end_iter; ++i) {
+      std::unique_ptr<Tree> tree = std::move(models_[i * num_tree_per_iteration_ + k]);
+      if (!tree->is_linear()) {
+        const double lower = tree->GetLowerBoundValue();
+        const double upper = tree->GetUpperBoundValue();
+        if (upper - lower <= merge_tolerance) {
+          constant += lower + (upper - lower) / 2.0;
+          continue;
+        }
+        std::vector<size_t>& same_key = trees_by_key[split_key(*tree)];
+        bool merged = false;
+        for (size_t j : same_key) {
+          if (trees[j]->HasSameSplits(*tree)) {
+            trees[j]->AddLeafOutputs(*tree);
+            merged = true;
+            break;
+          }
+        }
+        if (merged) {
+          continue;
+        }
+        same_key.push_back(trees.size());
+      }
+      trees.push_back(std::move(tree));
+    }
+    std::vector<double> magnitudes(trees.size());
+    for (size_t j = 0; j < trees.size(); ++j) {
+      magnitudes[j] = trees[j]->MeanAbsOutput();
+    }
+    std::vector<size_t> order(trees.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&magnitudes](size_t a, size_t b) { return magnitudes[a] > magnitudes[b]; });
+    std::vector<std::unique_ptr<Tree>> sorted_trees(trees.size());
+    for (size_t j = 0; j < order.size(); ++j) {
+      sorted_trees[j] = std::move(trees[order[j]]);
+    }
+    trees = std::move(sorted_trees);
+    if (trees.empty()) {
+      std::unique_ptr<Tree> new_tree(new Tree(2, false, false));
+      new_tree->AsConstantTree(constant);
+      trees.push_back(std::move(new_tree));
+    } else if (constant != 0.0) {
+      trees[0]->AddBias(constant);
+    }
+    num_optimized_iter = std::max(num_optimized_iter, static_cast<int>(trees.size()));
+  }
+  // classes with fewer trees are padded with zero trees to keep whole iterations
+  for (int k = 0; k < num_tree_per_iteration_; ++k) {
+    while (static_cast<int>(class_models[k].size()) < num_optimized_iter) {
+      std::unique_ptr<Tree> new_tree(new Tree(2, false, false));
+      new_tree->AsConstantTree(0);
+      class_models[k].push_back(std::move(new_tree));
+    }
+  }
+  auto original_models = std::move(models_);
+  models_ = std::vector<std::unique_ptr<Tree>>();
+  models_.reserve(static_cast<size_t>(total_iter - (end_iter - start_iter) + num_optimized_iter)
+                  * num_tree_per_iteration_);
+  for (int i = 0; i < start_iter * num_tree_per_iteration_; ++i) {
+    models_.push_back(std::move(original_models[i]));
+  }
+  for (int i = 0; i < num_optimized_iter; ++i) {
+    for (int k = 0; k < num_tree_per_iteration_; ++k) {
+      models_.push_back(std::move(class_models[k][i]));
+    }
+  }
+  for (size_t i = static_cast<size_t>(end_iter) * num_tree_per_iteration_; i < original_models.size(); ++i) {
+    models_.push_back(std::move(original_models[i]));
+  }
+  const int new_total_iter = static_cast<int>(models_.size()) / num_tree_per_iteration_;
+  Log::Info("Optimized %d iterations into %d", end_iter - start_iter, num_optimized_iter);
+  if (new_total_iter != total_iter) {
+    // the iterations no longer match the training ones, they can only be extended, as for a loaded model
+    num_init_iteration_ = new_total_iter;
+    iter_ = 0;
+  }
+  num_iteration_for_pred_ = new_total_iter;
+}
+
 bool GBDT::EvalAndCheckEarlyStopping() {
   bool is_met_early_stopping = false;
   // print message for metric
@@ -484,6 +604,7 @@ bool GBDT::EvalAndCheckEarlyStopping() {
     for (int i = 0; i < early_stopping_round_ * num_tree_per_iteration_; ++i) {
       models_.pop_back();
     }
+    ResetQuantizedTrees();
   }
   return is_met_early_stopping;
 }
@@ -548,6 +669,32 @@ std::vector<double> GBDT::EvalOneMetric(const Metric* metric, const double* scor
   #endif  // USE_CUDA
 }
 
+std::vector<std::vector<double>> GBDT::EvalMetrics(const std::vector<const Metric*>& metrics, const double* score,
+                                                   const data_size_t num_data) const {
+  std::vector<std::vector<double>> results(metrics.size());
+  std::vector<const Metric*> pointwise_metrics;
+  std::vector<size_t> pointwise_idx;
+  const bool can_fuse = !boosting_on_gpu_ &&
+    (objective_function_ == nullptr || objective_function_->NumModelPerIteration() == 1);
+  for (size_t i = 0; i < metrics.size(); ++i) {
+    if (can_fuse && metrics[i]->IsPointwise() && !metrics[i]->IsCUDAMetric()) {
+      pointwise_metrics.push_back(metrics[i]);
+      pointwise_idx.push_back(i);
+    } else {
+      results[i] = EvalOneMetric(metrics[i], score, num_data);
+    }
+  }
+  if (pointwise_metrics.size() == 1) {
+    results[pointwise_idx[0]] = EvalOneMetric(pointwise_metrics[0], score, num_data);
+  } else if (pointwise_metrics.size() > 1) {
+    auto pointwise_results = Metric::EvalPointwise(pointwise_metrics, score, num_data, objective_function_);
+    for (size_t i = 0; i < pointwise_idx.size(); ++i) {
+      results[pointwise_idx[i]] = std::move(pointwise_results[i]);
+    }
+  }
+  return results;
+}
+
 std::string GBDT::OutputMetric(int iter) {
   bool need_output = (iter % config_->metric_freq) == 0;
   std::string ret = "";
@@ -555,9 +702,10 @@ std::string GBDT::OutputMetric(int iter) {
   std::vector<std::pair<size_t, size_t>> meet_early_stopping_pairs;
   // print training metric
   if (need_output) {
-    for (auto& sub_metric : training_metrics_) {
-      auto name = sub_metric->GetName();
-      auto scores = EvalOneMetric(sub_metric, train_score_updater_->score(), train_score_updater_->num_data());
+    auto train_scores = EvalMetrics(training_metrics_, train_score_updater_->score(), train_score_updater_->num_data());
+    for (size_t j = 0; j < training_metrics_.size(); ++j) {
+      auto name = training_metrics_[j]->GetName();
+      const auto& scores = train_scores[j];
       for (size_t k = 0; k < name.size(); ++k) {
         std::stringstream tmp_buf;
         tmp_buf << "Iteration:" << iter
@@ -573,8 +721,10 @@ std::string GBDT::OutputMetric(int iter) {
   // print validation metric
   if (need_output || early_stopping_round_ > 0) {
     for (size_t i = 0; i < valid_metrics_.size(); ++i) {
+      auto valid_scores = EvalMetrics(valid_metrics_[i], valid_score_updater_[i]->score(),
+                                      valid_score_updater_[i]->num_data());
       for (size_t j = 0; j < valid_metrics_[i].size(); ++j) {
-        auto test_scores = EvalOneMetric(valid_metrics_[i][j], valid_score_updater_[i]->score(), valid_score_updater_[i]->num_data());
+        const auto& test_scores = valid_scores[j];
         auto name = valid_metrics_[i][j]->GetName();
         for (size_t k = 0; k < name.size(); ++k) {
           std::stringstream tmp_buf;
@@ -612,20 +762,17 @@ std::string GBDT::OutputMetric(int iter) {
 std::vector<double> GBDT::GetEvalAt(int data_idx) const {
   CHECK(data_idx >= 0 && data_idx <= static_cast<int>(valid_score_updater_.size()));
   std::vector<double> ret;
+  std::vector<std::vector<double>> results;
   if (data_idx == 0) {
-    for (auto& sub_metric : training_metrics_) {
-      auto scores = EvalOneMetric(sub_metric, train_score_updater_->score(), train_score_updater_->num_data());
-      for (auto score : scores) {
-        ret.push_back(score);
-      }
-    }
+    results = EvalMetrics(training_metrics_, train_score_updater_->score(), train_score_updater_->num_data());
   } else {
     auto used_idx = data_idx - 1;
-    for (size_t j = 0; j < valid_metrics_[used_idx].size(); ++j) {
-      auto test_scores = EvalOneMetric(valid_metrics_[used_idx][j], valid_score_updater_[used_idx]->score(), valid_score_updater_[used_idx]->num_data());
-      for (auto score : test_scores) {
-        ret.push_back(score);
-      }
+    results = EvalMetrics(valid_metrics_[used_idx], valid_score_updater_[used_idx]->score(),
+                          valid_score_updater_[used_idx]->num_data());
+  }
+  for (const auto& scores : results) {
+    for (auto score : scores) {
+      ret.push_back(score);
     }
   }
   return ret;
@@ -662,6 +809,125 @@ void GBDT::PredictContribByMap(const std::unordered_map<int, double>& features,
   }
 }
 
+void GBDT::PredictInteraction(const double* features, double* output) const {
+  const int num_features = max_feature_idx_ + 1;
+  const int64_t num_cols = num_features + 1;
+  std::memset(output, 0, sizeof(double) * num_tree_per_iteration_ * num_cols * num_cols);
+  std::vector<double> contrib(num_cols);
+  const int end_iteration_for_pred = start_iteration_for_pred_ + num_iteration_for_pred_;
+  for (int k = 0; k < num_tree_per_iteration_; ++k) {
+    double* matrix = output + k * num_cols * num_cols;
+    std::fill(contrib.begin(), contrib.end(), 0.0);
+    for (int i = start_iteration_for_pred_; i < end_iteration_for_pred; ++i) {
+      Tree* tree = models_[i * num_tree_per_iteration_ + k].get();
+      tree->PredictContrib(features, num_features, contrib.data());
+      tree->PredictInteraction(features, num_features, matrix);
+    }
+    // the main effect is what the interactions leave of the contribution
+    for (int i = 0; i < num_features; ++i) {
+      double* row = matrix + i * num_cols;
+      double interactions = 0.0;
+      for (int j = 0; j < num_features; ++j) {
+        interactions += row[j];
+      }
+      row[i] = contrib[i] - interactions;
+    }
+    matrix[num_features * num_cols + num_features] = contrib[num_features];
+  }
+}
+
+void GBDT::PredictInteractionByMap(const std::unordered_map<int, double>& features,
+                                   std::vector<std::unordered_map<int, double>>* output) const {
+  const int num_features = max_feature_idx_ + 1;
+  const int num_cols = num_features + 1;
+  // the trees are walked on a dense row, the output matrix is kept sparse
+  std::vector<double> dense_features(num_features, 0.0);
+  for (const auto& feature : features) {
+    if (feature.first < num_features) {
+      dense_features[feature.first] = feature.second;
+    }
+  }
+  std::vector<double> contrib(num_cols);
+  std::vector<double> interactions(num_features);
+  const int end_iteration_for_pred = start_iteration_for_pred_ + num_iteration_for_pred_;
+  for (int k = 0; k < num_tree_per_iteration_; ++k) {
+    std::unordered_map<int, double>* matrix = &((*output)[k]);
+    std::fill(contrib.begin(), contrib.end(), 0.0);
+    for (int i = start_iteration_for_pred_; i < end_iteration_for_pred; ++i) {
+      Tree* tree = models_[i * num_tree_per_iteration_ + k].get();
+      tree->PredictContrib(dense_features.data(), num_features, contrib.data());
+      tree->PredictInteractionSparse(dense_features.data(), num_features, matrix);
+    }
+    std::fill(interactions.begin(), interactions.end(), 0.0);
+    for (const auto& entry : *matrix) {
+      interactions[entry.first / num_cols] += entry.second;
+    }
+    for (int i = 0; i < num_features; ++i) {
+      if (contrib[i] != interactions[i]) {
+        (*matrix)[i * num_cols + i] = contrib[i] - interactions[i];
+      }
+    }
+    (*matrix)[num_features * num_cols + num_features] = contrib[num_features];
+  }
+}
+
+void GBDT::ConvertOutput(const double* input, double* output) const {
+  if (objective_function_ != nullptr) {
+    objective_function_->ConvertOutput(input, output);
+  } else if (output != input) {
+    std::memcpy(output, input, sizeof(double) * num_tree_per_iteration_);
+  }
+}
+
+void GBDT::GetRemainingScoreBounds(std::vector<double>* lower, std::vector<double>* upper) const {
+  lower->assign(num_iteration_for_pred_ + 1, 0.0);
+  upper->assign(num_iteration_for_pred_ + 1, 0.0);
+  for (int i = num_iteration_for_pred_ - 1; i >= 0; --i) {
+    double iter_lower = std::numeric_limits<double>::infinity();
+    double iter_upper = -std::numeric_limits<double>::infinity();
+    for (int k = 0; k < num_tree_per_iteration_; ++k) {
+      const Tree* tree = models_[(start_iteration_for_pred_ + i) * num_tree_per_iteration_ + k].get();
+      if (tree->is_linear()) {
+        iter_lower = -std::numeric_limits<double>::infinity();
+        iter_upper = std::numeric_limits<double>::infinity();
+        break;
+      }
+      double tree_lower = tree->LeafOutput(0);
+      double tree_upper = tree_lower;
+      for (int leaf = 1; leaf < tree->num_leaves(); ++leaf) {
+        tree_lower = std::min(tree_lower, tree->LeafOutput(leaf));
+        tree_upper = std::max(tree_upper, tree->LeafOutput(leaf));
+      }
+      // the trees of one iteration add to different classes, the range is the widest of them
+      iter_lower = std::min(iter_lower, tree_lower);
+      iter_upper = std::max(iter_upper, tree_upper);
+    }
+    (*lower)[i] = (*lower)[i + 1] + iter_lower;
+    (*upper)[i] = (*upper)[i + 1] + iter_upper;
+  }
+}
+
+data_size_t GBDT::StopRowsEarly(const PredictionEarlyStopInstance* early_stop, int iteration, double* output,
+                                data_size_t* active, data_size_t num_active, std::vector<int8_t>* stop) const {
+  stop->assign(num_active, 0);
+  if (early_stop->batch_callback_function != nullptr) {
+    early_stop->batch_callback_function(output, num_tree_per_iteration_, active, num_active, iteration,
+                                        stop->data());
+  } else {
+    for (data_size_t j = 0; j < num_active; ++j) {
+      (*stop)[j] = early_stop->callback_function(output + static_cast<size_t>(num_tree_per_iteration_) * active[j],
+                                                 num_tree_per_iteration_);
+    }
+  }
+  data_size_t num_kept = 0;
+  for (data_size_t j = 0; j < num_active; ++j) {
+    if (!(*stop)[j]) {
+      active[num_kept++] = active[j];
+    }
+  }
+  return num_kept;
+}
+
 void GBDT::GetPredictAt(int data_idx, double* out_result, int64_t* out_len) {
   CHECK(data_idx >= 0 && data_idx <= static_cast<int>(valid_score_updater_.size()));
 
@@ -752,30 +1018,63 @@ void GBDT::ResetTrainingData(const Dataset* train_data, const ObjectiveFunction*
   tree_learner_->ResetBoostingOnGPU(boosting_on_gpu_);
   #endif  // USE_CUDA
 
-  if (train_data != train_data_) {
+  // rows may have been appended to the current training data with Dataset::InitAppend,
+  // or overwritten in place with Dataset::SlideWindow
+  const bool is_data_appended = train_data == train_data_ && train_data->num_data() != num_data_;
+  const bool is_window_slid = train_data == train_data_ && train_data->num_window_slides() != num_window_slides_;
+  if (train_data != train_data_ || is_data_appended || is_window_slid) {
+    const bool is_single_slide = train_data->num_window_slides() == num_window_slides_ + 1;
     train_data_ = train_data;
     data_sample_strategy_->UpdateTrainingData(train_data);
-    // not same training data, need reset score and others
-    // create score tracker
-    #ifdef USE_CUDA
-    if (config_->device_type == std::string("cuda")) {
-      train_score_updater_.reset(new CUDAScoreUpdater(train_data_, num_tree_per_iteration_, boosting_on_gpu_));
+    const bool can_rescore_rows = config_->device_type != std::string("cuda") && config_->boosting != std::string("rf");
+    if (can_rescore_rows && is_window_slid && !is_data_appended && is_single_slide) {
+      // only the rows recycled by the last slide changed, score them again from scratch
+      const std::vector<data_size_t>& recycled_rows = train_data_->window_recycled_rows();
+      const data_size_t num_recycled = static_cast<data_size_t>(recycled_rows.size());
+      train_score_updater_->ResetScoreAt(recycled_rows.data(), num_recycled, num_tree_per_iteration_);
+      for (int i = 0; i < iter_; ++i) {
+        for (int cur_tree_id = 0; cur_tree_id < num_tree_per_iteration_; ++cur_tree_id) {
+          auto curr_tree = (i + num_init_iteration_) * num_tree_per_iteration_ + cur_tree_id;
+          train_score_updater_->AddScore(models_[curr_tree].get(), recycled_rows.data(), num_recycled, cur_tree_id);
+        }
+      }
+    } else if (can_rescore_rows && is_data_appended && !is_window_slid) {
+      // bins and scores of the existing rows are unchanged, only score the appended rows
+      const data_size_t num_old_data = num_data_;
+      train_score_updater_->ReSizeForAppend(num_tree_per_iteration_);
+      std::vector<data_size_t> appended_indices(train_data_->num_data() - num_old_data);
+      std::iota(appended_indices.begin(), appended_indices.end(), num_old_data);
+      const data_size_t num_appended = static_cast<data_size_t>(appended_indices.size());
+      for (int i = 0; i < iter_; ++i) {
+        for (int cur_tree_id = 0; cur_tree_id < num_tree_per_iteration_; ++cur_tree_id) {
+          auto curr_tree = (i + num_init_iteration_) * num_tree_per_iteration_ + cur_tree_id;
+          train_score_updater_->AddScore(models_[curr_tree].get(), appended_indices.data(), num_appended, cur_tree_id);
+        }
+      }
     } else {
-    #endif  // USE_CUDA
-      train_score_updater_.reset(new ScoreUpdater(train_data_, num_tree_per_iteration_));
-    #ifdef USE_CUDA
-    }
-    #endif  // USE_CUDA
+      // not same training data, need reset score and others
+      // create score tracker
+      #ifdef USE_CUDA
+      if (config_->device_type == std::string("cuda")) {
+        train_score_updater_.reset(new CUDAScoreUpdater(train_data_, num_tree_per_iteration_, boosting_on_gpu_));
+      } else {
+      #endif  // USE_CUDA
+        train_score_updater_.reset(new ScoreUpdater(train_data_, num_tree_per_iteration_));
+      #ifdef USE_CUDA
+      }
+      #endif  // USE_CUDA
 
-    // update score
-    for (int i = 0; i < iter_; ++i) {
-      for (int cur_tree_id = 0; cur_tree_id < num_tree_per_iteration_; ++cur_tree_id) {
-        auto curr_tree = (i + num_init_iteration_) * num_tree_per_iteration_ + cur_tree_id;
-        train_score_updater_->AddScore(models_[curr_tree].get(), cur_tree_id);
+      // update score
+      for (int i = 0; i < iter_; ++i) {
+        for (int cur_tree_id = 0; cur_tree_id < num_tree_per_iteration_; ++cur_tree_id) {
+          auto curr_tree = (i + num_init_iteration_) * num_tree_per_iteration_ + cur_tree_id;
+          train_score_updater_->AddScore(models_[curr_tree].get(), cur_tree_id);
+        }
       }
     }
 
     num_data_ = train_data_->num_data();
+    num_window_slides_ = train_data_->num_window_slides();
 
     ResetGradientBuffers();
 
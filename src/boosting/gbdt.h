@@ -15,6 +15,7 @@
 
 #include <string>
 #include <algorithm>
+#include <atomic>
 #include <cstdio>
 #include <fstream>
 #include <map>
@@ -26,6 +27,7 @@
 #include <set>
 
 #include "cuda/cuda_score_updater.hpp"
+#include "quantized_trees.hpp"
 #include "score_updater.hpp"
 
 namespace LightGBM {
@@ -79,6 +81,7 @@ class GBDT : public GBDTBase {
       models_.push_back(std::move(new_tree));
     }
     num_init_iteration_ = static_cast<int>(models_.size()) / num_tree_per_iteration_;
+    ResetQuantizedTrees();
     // push model in current object
     for (const auto& tree : original_models) {
       auto new_tree = std::unique_ptr<Tree>(new Tree(*(tree.get())));
@@ -95,6 +98,7 @@ class GBDT : public GBDTBase {
     }
     end_iter = std::min(total_iter, end_iter);
     auto original_models = std::move(models_);
+    ResetQuantizedTrees();
     std::vector<int> indices(total_iter);
     for (int i = 0; i < total_iter; ++i) {
       indices[i] = i;
@@ -114,6 +118,13 @@ class GBDT : public GBDTBase {
     }
   }
 
+  /*!
+  * \brief Reorder the trees of each class by decreasing mean output magnitude, so that early stopping exits sooner,
+  *        merge the trees with the same splits and fold the (near-)constant trees into the first tree of the class.
+  *        Raw predictions with all the trees are unchanged up to floating point rounding when merge_tolerance is 0.
+  */
+  void OptimizeModels(int start_iter, int end_iter, double merge_tolerance) override;
+
   /*!
   * \brief Reset the training data
   * \param train_data New Training data
@@ -235,6 +246,10 @@ class GBDT : public GBDTBase {
     }
   }
 
+  bool IsClassification() const override {
+    return objective_function_ != nullptr && objective_function_->IsClassification();
+  }
+
   /*!
   * \brief Get evaluation result at data_idx data
   * \param data_idx 0: training data, 1: 1st validation data
@@ -279,7 +294,8 @@ class GBDT : public GBDTBase {
   * \param is_pred_contrib True if predicting feature contribution
   * \return number of prediction
   */
-  inline int NumPredictOneRow(int start_iteration, int num_iteration, bool is_pred_leaf, bool is_pred_contrib) const override {
+  inline int NumPredictOneRow(int start_iteration, int num_iteration, bool is_pred_leaf, bool is_pred_contrib,
+                              bool is_pred_interaction) const override {
     int num_pred_in_one_row = num_class_;
     if (is_pred_leaf) {
       int max_iteration = GetCurrentIteration();
@@ -292,23 +308,59 @@ class GBDT : public GBDTBase {
       }
     } else if (is_pred_contrib) {
       num_pred_in_one_row = num_tree_per_iteration_ * (max_feature_idx_ + 2);  // +1 for 0-based indexing, +1 for baseline
+    } else if (is_pred_interaction) {
+      num_pred_in_one_row = num_tree_per_iteration_ * (max_feature_idx_ + 2) * (max_feature_idx_ + 2);
     }
     return num_pred_in_one_row;
   }
 
-  void PredictRaw(const double* features, double* output,
-                  const PredictionEarlyStopInstance* earlyStop) const override;
+  void PredictRaw(const double* features, double* output, const PredictionEarlyStopInstance* earlyStop) const override {
+    PredictRaw(features, output, earlyStop, nullptr);
+  }
+
+  void PredictRaw(const double* features, double* output, const PredictionEarlyStopInstance* earlyStop,
+                  const QuantizedTrees* quantized_trees) const override;
 
   void PredictRawByMap(const std::unordered_map<int, double>& features, double* output,
                        const PredictionEarlyStopInstance* early_stop) const override;
 
-  void Predict(const double* features, double* output,
-               const PredictionEarlyStopInstance* earlyStop) const override;
+  void Predict(const double* features, double* output, const PredictionEarlyStopInstance* earlyStop) const override {
+    Predict(features, output, earlyStop, nullptr);
+  }
+
+  void Predict(const double* features, double* output, const PredictionEarlyStopInstance* earlyStop,
+               const QuantizedTrees* quantized_trees) const override;
 
   void PredictByMap(const std::unordered_map<int, double>& features, double* output,
                     const PredictionEarlyStopInstance* early_stop) const override;
 
-  void PredictLeafIndex(const double* features, double* output) const override;
+  void PredictRawBatch(const double* features, data_size_t num_rows, double* output,
+                       const PredictionEarlyStopInstance* early_stop) const override {
+    PredictRawBatch(features, num_rows, output, early_stop, nullptr);
+  }
+
+  void PredictRawBatch(const double* features, data_size_t num_rows, double* output,
+                       const PredictionEarlyStopInstance* early_stop,
+                       const QuantizedTrees* quantized_trees) const override;
+
+  void PredictBatch(const double* features, data_size_t num_rows, double* output,
+                    const PredictionEarlyStopInstance* early_stop) const override {
+    PredictBatch(features, num_rows, output, early_stop, nullptr);
+  }
+
+  void PredictBatch(const double* features, data_size_t num_rows, double* output,
+                    const PredictionEarlyStopInstance* early_stop,
+                    const QuantizedTrees* quantized_trees) const override;
+
+  void ConvertOutput(const double* input, double* output) const override;
+
+  void GetRemainingScoreBounds(std::vector<double>* lower, std::vector<double>* upper) const override;
+
+  void PredictLeafIndex(const double* features, double* output) const override {
+    PredictLeafIndex(features, output, nullptr);
+  }
+
+  void PredictLeafIndex(const double* features, double* output, const QuantizedTrees* quantized_trees) const override;
 
   void PredictLeafIndexByMap(const std::unordered_map<int, double>& features, double* output) const override;
 
@@ -317,6 +369,11 @@ class GBDT : public GBDTBase {
   void PredictContribByMap(const std::unordered_map<int, double>& features,
                            std::vector<std::unordered_map<int, double>>* output) const override;
 
+  void PredictInteraction(const double* features, double* output) const override;
+
+  void PredictInteractionByMap(const std::unordered_map<int, double>& features,
+                               std::vector<std::unordered_map<int, double>>* output) const override;
+
   /*!
   * \brief Dump model to json format string
   * \param start_iteration The model will be saved start from
@@ -342,6 +399,23 @@ class GBDT : public GBDTBase {
   */
   bool SaveModelToIfElse(int num_iteration, const char* filename) const override;
 
+  /*!
+  * \brief Translate model to a standalone C translation unit for batch prediction
+  * \param start_iteration The model will be translated start from
+  * \param num_iteration Number of iterations that want to translate, -1 means translate all
+  * \return C source code of model
+  */
+  std::string ModelToC(int start_iteration, int num_iteration) const override;
+
+  /*!
+  * \brief Translate model to a standalone C translation unit and save it to file
+  * \param start_iteration The model will be translated start from
+  * \param num_iteration Number of iterations that want to translate, -1 means translate all
+  * \param filename Filename that want to save to
+  * \return true if succeeded
+  */
+  bool SaveModelToC(int start_iteration, int num_iteration, const char* filename) const override;
+
   /*!
   * \brief Save model to file
   * \param start_iteration The model will be saved start from
@@ -363,6 +437,17 @@ class GBDT : public GBDTBase {
   */
   std::string SaveModelToString(int start_iteration, int num_iterations, int feature_importance_type) const override;
 
+  /*!
+  * \brief Save model to string in pieces: the header, one piece per tree and the footer.
+  *        Trees are serialized in parallel and the model string is the concatenation of the pieces.
+  * \param start_iteration The model will be saved start from
+  * \param num_iterations Number of model that want to save, -1 means save all
+  * \param feature_importance_type Type of feature importance, 0: split, 1: gain
+  * \return Pieces of the model string
+  */
+  std::vector<std::string> SaveModelToStringPieces(int start_iteration, int num_iterations,
+                                                   int feature_importance_type) const;
+
   /*!
   * \brief Restore from a serialized buffer
   */
@@ -424,7 +509,8 @@ class GBDT : public GBDTBase {
   */
   inline int NumberOfClasses() const override { return num_class_; }
 
-  inline void InitPredict(int start_iteration, int num_iteration, bool is_pred_contrib) override {
+  inline void InitPredict(int start_iteration, int num_iteration, bool is_pred_contrib,
+                          bool is_pred_interaction) override {
     num_iteration_for_pred_ = static_cast<int>(models_.size()) / num_tree_per_iteration_;
     start_iteration = std::max(start_iteration, 0);
     start_iteration = std::min(start_iteration, num_iteration_for_pred_);
@@ -435,18 +521,100 @@ class GBDT : public GBDTBase {
     }
     start_iteration_for_pred_ = start_iteration;
 
-    if (is_pred_contrib && !models_initialized_) {
+    // the interaction values also use the contribution tables
+    if ((is_pred_contrib || is_pred_interaction) && !models_initialized_.load(std::memory_order_acquire)) {
       std::lock_guard<std::mutex> lock(instance_mutex_);
-      if (models_initialized_)
-        return;
-
-      #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static)
-      for (int i = 0; i < static_cast<int>(models_.size()); ++i) {
-        models_[i]->RecomputeMaxDepth();
+      if (!models_initialized_.load(std::memory_order_relaxed)) {
+        const int num_models = static_cast<int>(models_.size());
+        std::vector<int64_t> shap_table_sizes(num_models);
+        #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static)
+        for (int i = 0; i < num_models; ++i) {
+          models_[i]->RecomputeMaxDepth();
+          shap_table_sizes[i] = models_[i]->InitSHAPPaths();
+        }
+        // trees are given fast TreeSHAP tables in order while they fit in the budget, the others keep the recursion
+        std::vector<char> use_shap_tables(num_models, 0);
+        int64_t shap_table_budget = kMaxSHAPTableSize;
+        int num_recursive_trees = 0;
+        for (int i = 0; i < num_models; ++i) {
+          if (shap_table_sizes[i] >= 0 && shap_table_sizes[i] <= shap_table_budget) {
+            use_shap_tables[i] = 1;
+            shap_table_budget -= shap_table_sizes[i];
+          } else {
+            ++num_recursive_trees;
+          }
+        }
+        if (num_recursive_trees > 0) {
+          Log::Info("Using the recursive TreeSHAP for %d trees, their tables would exceed the memory budget",
+                    num_recursive_trees);
+        }
+        #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(dynamic)
+        for (int i = 0; i < num_models; ++i) {
+          models_[i]->InitSHAPTables(use_shap_tables[i] != 0);
+        }
+        models_initialized_.store(true, std::memory_order_release);
+      }
+    }
+    // the interaction tables are added next to the contribution tables, which concurrent predictions may be reading
+    if (is_pred_interaction && !interaction_tables_initialized_.load(std::memory_order_acquire)) {
+      std::lock_guard<std::mutex> lock(instance_mutex_);
+      if (!interaction_tables_initialized_.load(std::memory_order_relaxed)) {
+        const int num_models = static_cast<int>(models_.size());
+        // the budget left by the contribution tables, in order of the trees as well
+        int64_t shap_table_budget = kMaxSHAPTableSize;
+        for (int i = 0; i < num_models; ++i) {
+          shap_table_budget -= models_[i]->num_shap_table_entries();
+        }
+        std::vector<char> use_interaction_tables(num_models, 0);
+        int num_conditioned_trees = 0;
+        for (int i = 0; i < num_models; ++i) {
+          const int64_t shap_table_size = models_[i]->num_shap_table_entries();
+          if (shap_table_size > 0 && shap_table_size <= shap_table_budget) {
+            use_interaction_tables[i] = 1;
+            shap_table_budget -= shap_table_size;
+          } else if (shap_table_size > 0) {
+            ++num_conditioned_trees;
+          }
+        }
+        if (num_conditioned_trees > 0) {
+          Log::Info("Using the conditioned TreeSHAP for the interaction values of %d trees, their tables would "
+                    "exceed the memory budget", num_conditioned_trees);
+        }
+        #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(dynamic)
+        for (int i = 0; i < num_models; ++i) {
+          if (use_interaction_tables[i]) {
+            models_[i]->InitSHAPInteractionTables();
+          }
+        }
+        interaction_tables_initialized_.store(true, std::memory_order_release);
       }
+    }
+  }
 
-      models_initialized_ = true;
+  std::shared_ptr<const QuantizedTrees> GetQuantizedTrees() override {
+    // the published snapshot is read without the lock, it is only built under it
+    std::shared_ptr<const QuantizedTrees> trees = std::atomic_load(&quantized_trees_);
+    if (trees != nullptr && trees->num_trees() == static_cast<int>(models_.size())) {
+      return trees;
+    }
+    std::lock_guard<std::mutex> lock(instance_mutex_);
+    trees = std::atomic_load(&quantized_trees_);
+    if (trees == nullptr || trees->num_trees() != static_cast<int>(models_.size())) {
+      std::shared_ptr<QuantizedTrees> new_trees(
+        new QuantizedTrees(models_, 0, static_cast<int>(models_.size()), max_feature_idx_ + 1));
+      if (!new_trees->is_supported()) {
+        Log::Warning("Cannot quantize thresholds of linear trees, predicting on raw feature values");
+        return nullptr;
+      }
+      trees = std::move(new_trees);
+      std::atomic_store(&quantized_trees_, trees);
     }
+    return trees;
+  }
+
+  /*! \brief Drop the quantized trees after the tree list is restructured, they are rebuilt on the next use */
+  void ResetQuantizedTrees() {
+    std::atomic_store(&quantized_trees_, std::shared_ptr<const QuantizedTrees>());
   }
 
   inline double GetLeafValue(int tree_idx, int leaf_idx) const override {
@@ -506,6 +674,13 @@ class GBDT : public GBDTBase {
   */
   virtual std::vector<double> EvalOneMetric(const Metric* metric, const double* score, const data_size_t num_data) const;
 
+  /*!
+  * \brief eval results for the metrics of one dataset, pointwise metrics on host scores share one pass
+  *        that converts each score only once
+  */
+  std::vector<std::vector<double>> EvalMetrics(const std::vector<const Metric*>& metrics, const double* score,
+                                               const data_size_t num_data) const;
+
   /*!
   * \brief Print metric result of current iteration
   * \param iter Current iteration
@@ -520,6 +695,19 @@ class GBDT : public GBDTBase {
   */
   void ResetGradientBuffers();
 
+  /*!
+  * \brief Check the early stopping of the active rows of a batch prediction, and compact the stopped rows out
+  * \param early_stop Early stopping instance
+  * \param iteration Number of iterations predicted so far
+  * \param output Predictions of the batch
+  * \param active Positions of the active rows in the batch, the rows left active are moved to its front
+  * \param num_active Number of active rows
+  * \param stop Buffer for the stopped flags
+  * \return Number of rows left active
+  */
+  data_size_t StopRowsEarly(const PredictionEarlyStopInstance* early_stop, int iteration, double* output,
+                            data_size_t* active, data_size_t num_active, std::vector<int8_t>* stop) const;
+
   /*! \brief current iteration */
   int iter_;
   /*! \brief Pointer to training data */
@@ -558,10 +746,23 @@ class GBDT : public GBDTBase {
   int max_feature_idx_;
   /*! \brief Parser config file content */
   std::string parser_config_str_ = "";
-  /*! \brief Are the models initialized (passed RecomputeMaxDepth phase) */
-  bool models_initialized_ = false;
+  /*!
+  * \brief Are the models initialized (passed RecomputeMaxDepth phase, with the fast TreeSHAP tables). Set once
+  *        under instance_mutex_, with release order so that the predictions reading it without the lock see the tables
+  */
+  std::atomic<bool> models_initialized_{false};
+  /*! \brief Do the fast TreeSHAP tables include those of the interaction values, published like models_initialized_ */
+  std::atomic<bool> interaction_tables_initialized_{false};
+  /*! \brief Maximal number of entries of the fast TreeSHAP tables of all trees, 256 MB */
+  static const int64_t kMaxSHAPTableSize = static_cast<int64_t>(1) << 25;
   /*! \brief Mutex for exclusive models initialization */
   std::mutex instance_mutex_;
+  /*!
+  * \brief Trees with quantized thresholds shared with the predictors, built by GetQuantizedTrees.
+  *        It is never modified once built, the methods restructuring models_ only drop this reference.
+  *        Always read and replaced with std::atomic_load and std::atomic_store
+  */
+  std::shared_ptr<const QuantizedTrees> quantized_trees_;
 
 #ifdef USE_CUDA
   /*! \brief First order derivative of training data */
@@ -593,6 +794,8 @@ class GBDT : public GBDTBase {
 
   /*! \brief Number of training data */
   data_size_t num_data_;
+  /*! \brief Number of window slides of the training data when it was bound */
+  int64_t num_window_slides_ = 0;
   /*! \brief Number of trees per iterations */
   int num_tree_per_iteration_;
   /*! \brief Number of class */
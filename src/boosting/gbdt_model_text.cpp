@@ -8,11 +8,16 @@
 #include <LightGBM/utils/array_args.h>
 #include <LightGBM/utils/common.h>
 
+#include <algorithm>
+#include <cmath>
+#include <iterator>
 #include <string>
 #include <sstream>
+#include <type_traits>
 #include <vector>
 
 #include "gbdt.h"
+#include "quantized_trees.hpp"
 
 namespace LightGBM {
 
@@ -174,7 +179,9 @@ std::string GBDT::ModelToIfElse(int num_iteration) const {
   pred_str_buf << "\t\t" << "}" << '\n';
   pred_str_buf << "\t" << "}" << '\n';
 
-  str_buf << "void GBDT::PredictRaw(const double* features, double *output, const PredictionEarlyStopInstance* early_stop) const {" << '\n';
+  // the generated trees do not use the quantized thresholds
+  str_buf << "void GBDT::PredictRaw(const double* features, double *output, const PredictionEarlyStopInstance* early_stop, "
+          << "const QuantizedTrees*) const {" << '\n';
   str_buf << pred_str_buf.str();
   str_buf << "}" << '\n';
   str_buf << '\n';
@@ -212,8 +219,9 @@ std::string GBDT::ModelToIfElse(int num_iteration) const {
   str_buf << '\n';
 
   // Predict
-  str_buf << "void GBDT::Predict(const double* features, double *output, const PredictionEarlyStopInstance* early_stop) const {" << '\n';
-  str_buf << "\t" << "PredictRaw(features, output, early_stop);" << '\n';
+  str_buf << "void GBDT::Predict(const double* features, double *output, const PredictionEarlyStopInstance* early_stop, "
+          << "const QuantizedTrees*) const {" << '\n';
+  str_buf << "\t" << "PredictRaw(features, output, early_stop, nullptr);" << '\n';
   str_buf << "\t" << "if (average_output_) {" << '\n';
   str_buf << "\t\t" << "for (int k = 0; k < num_tree_per_iteration_; ++k) {" << '\n';
   str_buf << "\t\t\t" << "output[k] /= num_iteration_for_pred_;" << '\n';
@@ -240,6 +248,53 @@ std::string GBDT::ModelToIfElse(int num_iteration) const {
   str_buf << '\n';
 
 
+  // PredictRawBatch
+  str_buf << "void GBDT::PredictRawBatch(const double* features, data_size_t num_rows, double* output, "
+          << "const PredictionEarlyStopInstance* early_stop, const QuantizedTrees*) const {" << '\n';
+  str_buf << "\t" << "const int num_features = max_feature_idx_ + 1;" << '\n';
+  str_buf << "\t" << "std::memset(output, 0, sizeof(double) * num_tree_per_iteration_ * num_rows);" << '\n';
+  str_buf << "\t" << "std::vector<data_size_t> active(num_rows);" << '\n';
+  str_buf << "\t" << "for (data_size_t r = 0; r < num_rows; ++r) {" << '\n';
+  str_buf << "\t\t" << "active[r] = r;" << '\n';
+  str_buf << "\t" << "}" << '\n';
+  str_buf << "\t" << "data_size_t num_active = num_rows;" << '\n';
+  str_buf << "\t" << "std::vector<int8_t> stop;" << '\n';
+  str_buf << "\t" << "int early_stop_round_counter = 0;" << '\n';
+  str_buf << "\t" << "for (int i = 0; i < num_iteration_for_pred_ && num_active > 0; ++i) {" << '\n';
+  str_buf << "\t\t" << "for (int k = 0; k < num_tree_per_iteration_; ++k) {" << '\n';
+  str_buf << "\t\t\t" << "for (data_size_t j = 0; j < num_active; ++j) {" << '\n';
+  str_buf << "\t\t\t\t" << "output[num_tree_per_iteration_ * active[j] + k] += "
+          << "(*PredictTreePtr[i * num_tree_per_iteration_ + k])(features + num_features * active[j]);" << '\n';
+  str_buf << "\t\t\t" << "}" << '\n';
+  str_buf << "\t\t" << "}" << '\n';
+  str_buf << "\t\t" << "++early_stop_round_counter;" << '\n';
+  str_buf << "\t\t" << "if (early_stop->round_period == early_stop_round_counter) {" << '\n';
+  str_buf << "\t\t\t" << "num_active = StopRowsEarly(early_stop, i + 1, output, active.data(), num_active, &stop);"
+          << '\n';
+  str_buf << "\t\t\t" << "early_stop_round_counter = 0;" << '\n';
+  str_buf << "\t\t" << "}" << '\n';
+  str_buf << "\t" << "}" << '\n';
+  str_buf << "}" << '\n';
+  str_buf << '\n';
+
+  // PredictBatch
+  str_buf << "void GBDT::PredictBatch(const double* features, data_size_t num_rows, double* output, "
+          << "const PredictionEarlyStopInstance* early_stop, const QuantizedTrees*) const {" << '\n';
+  str_buf << "\t" << "PredictRawBatch(features, num_rows, output, early_stop, nullptr);" << '\n';
+  str_buf << "\t" << "for (data_size_t r = 0; r < num_rows; ++r) {" << '\n';
+  str_buf << "\t\t" << "double* row_output = output + num_tree_per_iteration_ * r;" << '\n';
+  str_buf << "\t\t" << "if (average_output_) {" << '\n';
+  str_buf << "\t\t\t" << "for (int k = 0; k < num_tree_per_iteration_; ++k) {" << '\n';
+  str_buf << "\t\t\t\t" << "row_output[k] /= num_iteration_for_pred_;" << '\n';
+  str_buf << "\t\t\t" << "}" << '\n';
+  str_buf << "\t\t" << "}" << '\n';
+  str_buf << "\t\t" << "if (objective_function_ != nullptr) {" << '\n';
+  str_buf << "\t\t\t" << "objective_function_->ConvertOutput(row_output, row_output);" << '\n';
+  str_buf << "\t\t" << "}" << '\n';
+  str_buf << "\t" << "}" << '\n';
+  str_buf << "}" << '\n';
+  str_buf << '\n';
+
   // PredictLeafIndex
   for (int i = 0; i < num_used_model; ++i) {
     str_buf << models_[i]->ToIfElse(i, true) << '\n';
@@ -254,7 +309,7 @@ std::string GBDT::ModelToIfElse(int num_iteration) const {
   }
   str_buf << " };" << '\n' << '\n';
 
-  str_buf << "void GBDT::PredictLeafIndex(const double* features, double *output) const {" << '\n';
+  str_buf << "void GBDT::PredictLeafIndex(const double* features, double *output, const QuantizedTrees*) const {" << '\n';
   str_buf << "\t" << "int total_tree = num_iteration_for_pred_ * num_tree_per_iteration_;" << '\n';
   str_buf << "\t" << "for (int i = 0; i < total_tree; ++i) {" << '\n';
   str_buf << "\t\t" << "output[i] = (*PredictTreeLeafPtr[i])(features);" << '\n';
@@ -308,7 +363,272 @@ bool GBDT::SaveModelToIfElse(int num_iteration, const char* filename) const {
   return static_cast<bool>(output_file);
 }
 
-std::string GBDT::SaveModelToString(int start_iteration, int num_iteration, int feature_importance_type) const {
+namespace {
+
+void AppendCValue(int64_t value, std::string* out) {
+  fmt::format_to(std::back_inserter(*out), "{}", value);
+}
+
+/*! \brief Append a double as a C literal that parses back to exactly the same value */
+void AppendCValue(double value, std::string* out) {
+  if (std::isnan(value)) {
+    out->append("NAN");
+  } else if (std::isinf(value)) {
+    out->append(value > 0 ? "HUGE_VAL" : "(-HUGE_VAL)");
+  } else {
+    fmt::format_to(std::back_inserter(*out), "{:.17g}", value);
+  }
+}
+
+template <typename T>
+void AppendCArray(const char* type, const char* name, const std::vector<T>& values, std::string* out) {
+  typedef typename std::conditional<std::is_floating_point<T>::value, double, int64_t>::type ValueType;
+  fmt::format_to(std::back_inserter(*out), "static const {} {}[] = {{", type, name);
+  // C does not allow empty arrays
+  if (values.empty()) {
+    out->append("0");
+  }
+  for (size_t i = 0; i < values.size(); ++i) {
+    out->append(i % 8 == 0 ? "\n  " : " ");
+    AppendCValue(static_cast<ValueType>(values[i]), out);
+    if (i + 1 < values.size()) {
+      out->push_back(',');
+    }
+  }
+  out->append("\n};\n\n");
+}
+
+}  // namespace
+
+std::string GBDT::ModelToC(int start_iteration, int num_iteration) const {
+  int num_used_model = static_cast<int>(models_.size());
+  int total_iteration = num_used_model / num_tree_per_iteration_;
+  start_iteration = std::max(start_iteration, 0);
+  start_iteration = std::min(start_iteration, total_iteration);
+  if (num_iteration > 0) {
+    int end_iteration = start_iteration + num_iteration;
+    num_used_model = std::min(end_iteration * num_tree_per_iteration_, num_used_model);
+  }
+  const int start_model = start_iteration * num_tree_per_iteration_;
+  const int num_features = max_feature_idx_ + 1;
+  const QuantizedTrees trees(models_, start_model, std::max(num_used_model, start_model), num_features);
+  if (!trees.is_supported()) {
+    Log::Fatal("Cannot convert linear trees to C code");
+  }
+
+  // split the flattened nodes into tables, leaves of all trees are numbered globally
+  const std::vector<QuantizedTrees::Node>& nodes = trees.nodes();
+  std::vector<int32_t> node_slot(nodes.size());
+  std::vector<uint32_t> node_threshold(nodes.size());
+  std::vector<uint8_t> node_flags(nodes.size());
+  std::vector<int32_t> children(nodes.size() * 2);
+  std::vector<int32_t> tree_roots(trees.tree_roots());
+  std::vector<double> leaf_values;
+  for (int i = 0; i < trees.num_trees(); ++i) {
+    const Tree* tree = models_[start_model + i].get();
+    const int32_t leaf_base = static_cast<int32_t>(leaf_values.size());
+    for (int32_t node = trees.tree_node_offsets()[i]; node < trees.tree_node_offsets()[i + 1]; ++node) {
+      node_slot[node] = nodes[node].slot;
+      node_threshold[node] = nodes[node].threshold;
+      node_flags[node] = nodes[node].flags;
+      for (int j = 0; j < 2; ++j) {
+        const int32_t child = nodes[node].children[j];
+        children[2 * node + j] = child >= 0 ? child : ~(leaf_base + ~child);
+      }
+    }
+    if (tree_roots[i] < 0) {
+      tree_roots[i] = ~leaf_base;
+    }
+    for (int leaf = 0; leaf < tree->num_leaves(); ++leaf) {
+      leaf_values.push_back(tree->LeafOutput(leaf));
+    }
+  }
+
+  const int num_numerical = trees.num_numerical();
+  const int num_categorical = trees.num_categorical();
+  // keep the per-block scratch of the batch entry point around 16KB
+  const int row_scratch_bytes = num_numerical * 3 + num_categorical * 4;
+  const int block_rows = std::max(1, std::min(64, 16384 / std::max(row_scratch_bytes, 1)));
+
+  std::string out;
+  out.append(
+    "/*\n"
+    " * Generated by LightGBM: standalone C99 translation unit computing raw scores.\n"
+    " *\n"
+    " * Stable ABI, all symbols are prefixed with LGBM_MODEL_PREFIX (lgbm_model_ by default):\n"
+    " *   int  abi_version(void);\n"
+    " *   int  num_features(void);\n"
+    " *   int  num_outputs(void);\n"
+    " *   void predict_raw(const double* row, double* out);\n"
+    " *   void predict_raw_batch(const double* data, int64_t nrow, double* out);\n"
+    " * Input rows are dense and row-major with num_features() columns, missing values are NaN.\n"
+    " * Each row gets num_outputs() raw scores, bit-identical to LightGBM's raw score prediction.\n"
+    " * Do not compile with -ffast-math, it breaks the NaN handling.\n"
+    " */\n"
+    "#include <math.h>\n"
+    "#include <stdint.h>\n"
+    "\n"
+    "#ifndef LGBM_MODEL_PREFIX\n"
+    "#define LGBM_MODEL_PREFIX lgbm_model_\n"
+    "#endif\n"
+    "#ifndef LGBM_MODEL_EXPORT\n"
+    "#define LGBM_MODEL_EXPORT\n"
+    "#endif\n"
+    "#define LGBM_MODEL_CONCAT_(a, b) a##b\n"
+    "#define LGBM_MODEL_CONCAT(a, b) LGBM_MODEL_CONCAT_(a, b)\n"
+    "#define LGBM_MODEL_API(name) LGBM_MODEL_CONCAT(LGBM_MODEL_PREFIX, name)\n"
+    "\n"
+    "#define LGBM_ABI_VERSION 1\n");
+  fmt::format_to(std::back_inserter(out), "#define LGBM_NUM_FEATURES {}\n", num_features);
+  fmt::format_to(std::back_inserter(out), "#define LGBM_NUM_OUTPUTS {}\n", num_tree_per_iteration_);
+  fmt::format_to(std::back_inserter(out), "#define LGBM_NUM_TREES {}\n", tree_roots.size());
+  fmt::format_to(std::back_inserter(out), "#define LGBM_NUM_NUMERICAL {}\n", num_numerical);
+  fmt::format_to(std::back_inserter(out), "#define LGBM_NUM_CATEGORICAL {}\n", num_categorical);
+  fmt::format_to(std::back_inserter(out), "#define LGBM_NUMERICAL_STRIDE {}\n", std::max(num_numerical, 1));
+  fmt::format_to(std::back_inserter(out), "#define LGBM_CATEGORICAL_STRIDE {}\n", std::max(num_categorical, 1));
+  fmt::format_to(std::back_inserter(out), "#define LGBM_BLOCK_ROWS {}\n", block_rows);
+  fmt::format_to(std::back_inserter(out), "#define LGBM_ZERO_THRESHOLD {:.17g}\n", kZeroThreshold);
+  fmt::format_to(std::back_inserter(out), "#define LGBM_MISSING_ZERO {}\n#define LGBM_MISSING_NAN {}\n",
+                 static_cast<int>(QuantizedTrees::kMissingZero), static_cast<int>(QuantizedTrees::kMissingNaN));
+  fmt::format_to(std::back_inserter(out), "#define LGBM_DEFAULT_LEFT {}\n#define LGBM_CATEGORICAL {}\n",
+                 static_cast<int>(QuantizedTrees::kDefaultLeft), static_cast<int>(QuantizedTrees::kCategorical));
+  out.append("\n");
+  // threshold indices fit in 16 bits unless a feature has more than 65535 distinct thresholds
+  const bool wide_bins = trees.max_num_thresholds() > 65535;
+  out.append(wide_bins ? "typedef uint32_t lgbm_bin_t;\n\n" : "typedef uint16_t lgbm_bin_t;\n\n");
+
+  AppendCArray("int32_t", "lgbm_numerical_feature", trees.numerical_features(), &out);
+  AppendCArray("uint32_t", "lgbm_threshold_offset", trees.threshold_offsets(), &out);
+  AppendCArray("double", "lgbm_thresholds", trees.thresholds(), &out);
+  AppendCArray("int32_t", "lgbm_categorical_feature", trees.categorical_features(), &out);
+  if (num_categorical > 0) {
+    AppendCArray("int32_t", "lgbm_node_cat_split", trees.node_cat_split(), &out);
+    AppendCArray("uint32_t", "lgbm_cat_offset", trees.cat_offsets(), &out);
+    AppendCArray("uint32_t", "lgbm_cat_bitset", trees.cat_bitsets(), &out);
+  }
+  AppendCArray("int32_t", "lgbm_node_slot", node_slot, &out);
+  AppendCArray("lgbm_bin_t", "lgbm_node_threshold", node_threshold, &out);
+  AppendCArray("uint8_t", "lgbm_node_flags", node_flags, &out);
+  AppendCArray("int32_t", "lgbm_children", children, &out);
+  AppendCArray("double", "lgbm_leaf_value", leaf_values, &out);
+  AppendCArray("int32_t", "lgbm_tree_root", tree_roots, &out);
+
+  out.append(
+    "/* bins[i] counts the thresholds of numerical feature i below its value, so that \"value <= threshold\"\n"
+    "   becomes \"bin <= threshold index\"; missing[i] flags zero (bit 0) and NaN (bit 1) values */\n"
+    "static void lgbm_quantize_row(const double* row, lgbm_bin_t* bins, uint8_t* missing, int32_t* cats) {\n"
+    "  for (int i = 0; i < LGBM_NUM_NUMERICAL; ++i) {\n"
+    "    const double raw = row[lgbm_numerical_feature[i]];\n"
+    "    const int is_nan = isnan(raw) != 0;\n"
+    "    const double value = is_nan ? 0.0 : raw;\n"
+    "    const double* first = lgbm_thresholds + lgbm_threshold_offset[i];\n"
+    "    const double* base = first;\n"
+    "    uint32_t len = lgbm_threshold_offset[i + 1] - lgbm_threshold_offset[i];\n"
+    "    while (len > 1) {\n"
+    "      const uint32_t half = len >> 1;\n"
+    "      base = (base[half] < value) ? base + half : base;\n"
+    "      len -= half;\n"
+    "    }\n"
+    "    bins[i] = (lgbm_bin_t)((base - first) + (*base < value));\n"
+    "    missing[i] = (uint8_t)((value >= -LGBM_ZERO_THRESHOLD && value <= LGBM_ZERO_THRESHOLD) | (is_nan << 1));\n"
+    "  }\n"
+    "  for (int i = 0; i < LGBM_NUM_CATEGORICAL; ++i) {\n"
+    "    const double raw = row[lgbm_categorical_feature[i]];\n"
+    "    cats[i] = isnan(raw) ? -1 : (int32_t)raw;\n"
+    "  }\n"
+    "}\n"
+    "\n"
+    "static double lgbm_tree_output(int32_t node, const lgbm_bin_t* bins, const uint8_t* missing,\n"
+    "                               const int32_t* cats) {\n"
+    "  (void)cats;\n"
+    "  while (node >= 0) {\n"
+    "    const uint8_t flags = lgbm_node_flags[node];\n"
+    "    const int32_t slot = lgbm_node_slot[node];\n"
+    "    const lgbm_bin_t threshold = lgbm_node_threshold[node];\n"
+    "    int go_right;\n");
+  // only models with categorical splits pay for the branch
+  if (num_categorical > 0) {
+    out.append(
+      "    if (flags & LGBM_CATEGORICAL) {\n"
+      "      const int32_t value = cats[slot];\n"
+      "      const int32_t cat_idx = lgbm_node_cat_split[node];\n"
+      "      const uint32_t begin = lgbm_cat_offset[cat_idx];\n"
+      "      const uint32_t size = lgbm_cat_offset[cat_idx + 1] - begin;\n"
+      "      go_right = value < 0 || (uint32_t)(value >> 5) >= size\n"
+      "                 || !((lgbm_cat_bitset[begin + (value >> 5)] >> (value & 31)) & 1u);\n"
+      "      node = lgbm_children[2 * node + go_right];\n"
+      "      continue;\n"
+      "    }\n");
+  }
+  out.append(
+    "    {\n"
+    "      const int is_missing = (missing[slot] & flags) != 0;\n"
+    "      const int default_right = !(flags & LGBM_DEFAULT_LEFT);\n"
+    "      go_right = (is_missing & default_right) | (!is_missing & (bins[slot] > threshold));\n"
+    "    }\n"
+    "    node = lgbm_children[2 * node + go_right];\n"
+    "  }\n"
+    "  return lgbm_leaf_value[~node];\n"
+    "}\n"
+    "\n"
+    "#ifdef __cplusplus\n"
+    "extern \"C\" {\n"
+    "#endif\n"
+    "\n"
+    "LGBM_MODEL_EXPORT int LGBM_MODEL_API(abi_version)(void) { return LGBM_ABI_VERSION; }\n"
+    "\n"
+    "LGBM_MODEL_EXPORT int LGBM_MODEL_API(num_features)(void) { return LGBM_NUM_FEATURES; }\n"
+    "\n"
+    "LGBM_MODEL_EXPORT int LGBM_MODEL_API(num_outputs)(void) { return LGBM_NUM_OUTPUTS; }\n"
+    "\n"
+    "LGBM_MODEL_EXPORT void LGBM_MODEL_API(predict_raw_batch)(const double* data, int64_t nrow, double* out) {\n"
+    "  lgbm_bin_t bins[LGBM_BLOCK_ROWS * LGBM_NUMERICAL_STRIDE];\n"
+    "  uint8_t missing[LGBM_BLOCK_ROWS * LGBM_NUMERICAL_STRIDE];\n"
+    "  int32_t cats[LGBM_BLOCK_ROWS * LGBM_CATEGORICAL_STRIDE];\n"
+    "  for (int64_t start = 0; start < nrow; start += LGBM_BLOCK_ROWS) {\n"
+    "    const int cnt = (int)(nrow - start < LGBM_BLOCK_ROWS ? nrow - start : LGBM_BLOCK_ROWS);\n"
+    "    double* block_out = out + start * LGBM_NUM_OUTPUTS;\n"
+    "    for (int r = 0; r < cnt; ++r) {\n"
+    "      lgbm_quantize_row(data + (start + r) * LGBM_NUM_FEATURES, bins + r * LGBM_NUMERICAL_STRIDE,\n"
+    "                        missing + r * LGBM_NUMERICAL_STRIDE, cats + r * LGBM_CATEGORICAL_STRIDE);\n"
+    "    }\n"
+    "    for (int i = 0; i < cnt * LGBM_NUM_OUTPUTS; ++i) {\n"
+    "      block_out[i] = 0.0;\n"
+    "    }\n"
+    "    /* trees in the outer loop keep their nodes in cache for the whole block,\n"
+    "       the scores of each row are still accumulated in tree order */\n"
+    "    for (int t = 0; t < LGBM_NUM_TREES; ++t) {\n"
+    "      const int k = t % LGBM_NUM_OUTPUTS;\n"
+    "      const int32_t root = lgbm_tree_root[t];\n"
+    "      for (int r = 0; r < cnt; ++r) {\n"
+    "        block_out[r * LGBM_NUM_OUTPUTS + k] += lgbm_tree_output(root, bins + r * LGBM_NUMERICAL_STRIDE,\n"
+    "          missing + r * LGBM_NUMERICAL_STRIDE, cats + r * LGBM_CATEGORICAL_STRIDE);\n"
+    "      }\n"
+    "    }\n"
+    "  }\n"
+    "}\n"
+    "\n"
+    "LGBM_MODEL_EXPORT void LGBM_MODEL_API(predict_raw)(const double* row, double* out) {\n"
+    "  LGBM_MODEL_API(predict_raw_batch)(row, 1, out);\n"
+    "}\n"
+    "\n"
+    "#ifdef __cplusplus\n"
+    "}  /* extern \"C\" */\n"
+    "#endif\n");
+  return out;
+}
+
+bool GBDT::SaveModelToC(int start_iteration, int num_iteration, const char* filename) const {
+  /*! \brief File to write models */
+  std::ofstream output_file(filename, std::ios::out | std::ios::binary);
+  output_file << ModelToC(start_iteration, num_iteration);
+  output_file.close();
+
+  return static_cast<bool>(output_file);
+}
+
+std::vector<std::string> GBDT::SaveModelToStringPieces(int start_iteration, int num_iteration,
+                                                       int feature_importance_type) const {
   std::stringstream ss;
   Common::C_stringstream(ss);
 
@@ -351,24 +671,25 @@ std::string GBDT::SaveModelToString(int start_iteration, int num_iteration, int
 
   int start_model = start_iteration * num_tree_per_iteration_;
 
-  std::vector<std::string> tree_strs(num_used_model - start_model);
-  std::vector<size_t> tree_sizes(num_used_model - start_model);
-  // output tree models
-  #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static)
-  for (int i = start_model; i < num_used_model; ++i) {
-    const int idx = i - start_model;
-    tree_strs[idx] = "Tree=" + std::to_string(idx) + '\n';
-    tree_strs[idx] += models_[i]->ToString() + '\n';
-    tree_sizes[idx] = tree_strs[idx].size();
+  const int num_saved_model = std::max(num_used_model - start_model, 0);
+  // pieces are the header, one per tree and the footer
+  std::vector<std::string> pieces(num_saved_model + 2);
+  std::vector<size_t> tree_sizes(num_saved_model);
+  // output tree models, each into its own buffer
+  #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(dynamic, 64)
+  for (int idx = 0; idx < num_saved_model; ++idx) {
+    std::string& tree_str = pieces[idx + 1];
+    tree_str = "Tree=" + std::to_string(idx) + '\n';
+    tree_str += models_[start_model + idx]->ToString();
+    tree_str += '\n';
+    tree_sizes[idx] = tree_str.size();
   }
 
   ss << "tree_sizes=" << CommonC::Join(tree_sizes, " ") << '\n';
   ss << '\n';
+  pieces[0] = ss.str();
+  ss.str("");
 
-  for (int i = 0; i < num_used_model - start_model; ++i) {
-    ss << tree_strs[i];
-    tree_strs[i].clear();
-  }
   ss << "end of trees" << "\n";
   std::vector<double> feature_importances = FeatureImportance(
       num_iteration, feature_importance_type);
@@ -404,7 +725,23 @@ std::string GBDT::SaveModelToString(int start_iteration, int num_iteration, int
     ss << parser_config_str_ << "\n";
     ss << "end of parser" << '\n';
   }
-  return ss.str();
+  pieces.back() = ss.str();
+  return pieces;
+}
+
+std::string GBDT::SaveModelToString(int start_iteration, int num_iteration, int feature_importance_type) const {
+  std::vector<std::string> pieces = SaveModelToStringPieces(start_iteration, num_iteration, feature_importance_type);
+  size_t total_size = 0;
+  for (const auto& piece : pieces) {
+    total_size += piece.size();
+  }
+  std::string model_str;
+  model_str.reserve(total_size);
+  for (auto& piece : pieces) {
+    model_str += piece;
+    std::string().swap(piece);
+  }
+  return model_str;
 }
 
 bool GBDT::SaveModelToFile(int start_iteration, int num_iteration, int feature_importance_type, const char* filename) const {
@@ -413,14 +750,19 @@ bool GBDT::SaveModelToFile(int start_iteration, int num_iteration, int feature_i
   if (!writer->Init()) {
     Log::Fatal("Model file %s is not available for writes", filename);
   }
-  std::string str_to_write = SaveModelToString(start_iteration, num_iteration, feature_importance_type);
-  auto size = writer->Write(str_to_write.c_str(), str_to_write.size());
+  // write the pieces one by one instead of concatenating the whole model first
+  std::vector<std::string> pieces = SaveModelToStringPieces(start_iteration, num_iteration, feature_importance_type);
+  size_t size = 0;
+  for (const auto& piece : pieces) {
+    size += writer->Write(piece.c_str(), piece.size());
+  }
   return size > 0;
 }
 
 bool GBDT::LoadModelFromString(const char* buffer, size_t len) {
   // use serialized string to restore this object
   models_.clear();
+  ResetQuantizedTrees();
   auto c_str = buffer;
   auto p = c_str;
   auto end = p + len;
@@ -569,6 +911,8 @@ bool GBDT::LoadModelFromString(const char* buffer, size_t len) {
       OMP_LOOP_EX_END();
     }
     OMP_THROW_EX();
+    // continue after the trees instead of scanning them line by line again
+    p = std::min(p + tree_boundaries[num_trees], end);
   }
   num_iteration_for_pred_ = static_cast<int>(models_.size()) / num_tree_per_iteration_;
   num_init_iteration_ = num_iteration_for_pred_;
@@ -6,19 +6,76 @@
 #include <LightGBM/prediction_early_stop.h>
 #include <LightGBM/utils/openmp_wrapper.h>
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <vector>
+
 #include "gbdt.h"
 
 namespace LightGBM {
 
-void GBDT::PredictRaw(const double* features, double* output, const PredictionEarlyStopInstance* early_stop) const {
+namespace {
+
+/*! \brief Per-thread buffers of a row mapped to threshold indices */
+struct QuantizedRow {
+  std::vector<uint32_t> bins;
+  std::vector<uint8_t> missing;
+  std::vector<int> cats;
+
+  inline void Quantize(const QuantizedTrees& trees, const double* features) {
+    bins.resize(trees.num_numerical());
+    missing.resize(trees.num_numerical());
+    cats.resize(trees.num_categorical());
+    trees.QuantizeRow(features, bins.data(), missing.data(), cats.data());
+  }
+
+  inline int GetLeaf(const QuantizedTrees& trees, int tree_idx) const {
+    return trees.GetLeaf(tree_idx, bins.data(), missing.data(), cats.data());
+  }
+};
+
+QuantizedRow* GetQuantizedRowBuffer() {
+  static thread_local QuantizedRow row;
+  return &row;
+}
+
+std::vector<QuantizedRow>* GetQuantizedBatchBuffer() {
+  static thread_local std::vector<QuantizedRow> rows;
+  return &rows;
+}
+
+/*! \brief The snapshot if it has all the trees to predict, e.g. not taken before more trees were trained */
+inline const QuantizedTrees* CoveringQuantizedTrees(const QuantizedTrees* trees, int end_model) {
+  return trees != nullptr && trees->num_trees() >= end_model ? trees : nullptr;
+}
+
+}  // namespace
+
+void GBDT::PredictRaw(const double* features, double* output, const PredictionEarlyStopInstance* early_stop,
+                      const QuantizedTrees* quantized_trees) const {
   int early_stop_round_counter = 0;
   // set zero
   std::memset(output, 0, sizeof(double) * num_tree_per_iteration_);
   const int end_iteration_for_pred = start_iteration_for_pred_ + num_iteration_for_pred_;
+  quantized_trees = CoveringQuantizedTrees(quantized_trees, end_iteration_for_pred * num_tree_per_iteration_);
+  QuantizedRow* quantized_row = nullptr;
+  if (quantized_trees != nullptr) {
+    quantized_row = GetQuantizedRowBuffer();
+    quantized_row->Quantize(*quantized_trees, features);
+  }
   for (int i = start_iteration_for_pred_; i < end_iteration_for_pred; ++i) {
     // predict all the trees for one iteration
-    for (int k = 0; k < num_tree_per_iteration_; ++k) {
-      output[k] += models_[i * num_tree_per_iteration_ + k]->Predict(features);
+    if (quantized_row != nullptr) {
+      for (int k = 0; k < num_tree_per_iteration_; ++k) {
+        const int tree_idx = i * num_tree_per_iteration_ + k;
+        output[k] += models_[tree_idx]->LeafOutput(quantized_row->GetLeaf(*quantized_trees, tree_idx));
+      }
+    } else {
+      for (int k = 0; k < num_tree_per_iteration_; ++k) {
+        output[k] += models_[i * num_tree_per_iteration_ + k]->Predict(features);
+      }
     }
     // check early stopping
     ++early_stop_round_counter;
@@ -52,8 +109,9 @@ void GBDT::PredictRawByMap(const std::unordered_map<int, double>& features, doub
   }
 }
 
-void GBDT::Predict(const double* features, double* output, const PredictionEarlyStopInstance* early_stop) const {
-  PredictRaw(features, output, early_stop);
+void GBDT::Predict(const double* features, double* output, const PredictionEarlyStopInstance* early_stop,
+                   const QuantizedTrees* quantized_trees) const {
+  PredictRaw(features, output, early_stop, quantized_trees);
   if (average_output_) {
     for (int k = 0; k < num_tree_per_iteration_; ++k) {
       output[k] /= num_iteration_for_pred_;
@@ -76,9 +134,88 @@ void GBDT::PredictByMap(const std::unordered_map<int, double>& features, double*
   }
 }
 
-void GBDT::PredictLeafIndex(const double* features, double* output) const {
+void GBDT::PredictRawBatch(const double* features, data_size_t num_rows, double* output,
+                           const PredictionEarlyStopInstance* early_stop,
+                           const QuantizedTrees* quantized_trees) const {
+  const int num_features = max_feature_idx_ + 1;
+  std::memset(output, 0, sizeof(double) * num_tree_per_iteration_ * num_rows);
+  const int end_iteration_for_pred = start_iteration_for_pred_ + num_iteration_for_pred_;
+  quantized_trees = CoveringQuantizedTrees(quantized_trees, end_iteration_for_pred * num_tree_per_iteration_);
+  std::vector<QuantizedRow>* quantized_rows = nullptr;
+  if (quantized_trees != nullptr) {
+    quantized_rows = GetQuantizedBatchBuffer();
+    if (static_cast<data_size_t>(quantized_rows->size()) < num_rows) {
+      quantized_rows->resize(num_rows);
+    }
+    for (data_size_t r = 0; r < num_rows; ++r) {
+      (*quantized_rows)[r].Quantize(*quantized_trees, features + static_cast<size_t>(num_features) * r);
+    }
+  }
+  // positions of the rows still predicted, the stopped ones are compacted out
+  std::vector<data_size_t> active(num_rows);
+  std::iota(active.begin(), active.end(), 0);
+  data_size_t num_active = num_rows;
+  std::vector<int8_t> stop;
+  int early_stop_round_counter = 0;
+  for (int i = start_iteration_for_pred_; i < end_iteration_for_pred && num_active > 0; ++i) {
+    // each tree is applied to all the active rows before moving to the next one
+    for (int k = 0; k < num_tree_per_iteration_; ++k) {
+      const int tree_idx = i * num_tree_per_iteration_ + k;
+      const Tree* tree = models_[tree_idx].get();
+      double* output_k = output + k;
+      if (quantized_rows != nullptr) {
+        for (data_size_t j = 0; j < num_active; ++j) {
+          const data_size_t r = active[j];
+          output_k[static_cast<size_t>(num_tree_per_iteration_) * r] +=
+            tree->LeafOutput((*quantized_rows)[r].GetLeaf(*quantized_trees, tree_idx));
+        }
+      } else {
+        for (data_size_t j = 0; j < num_active; ++j) {
+          const data_size_t r = active[j];
+          output_k[static_cast<size_t>(num_tree_per_iteration_) * r] +=
+            tree->Predict(features + static_cast<size_t>(num_features) * r);
+        }
+      }
+    }
+    // check early stopping
+    ++early_stop_round_counter;
+    if (early_stop->round_period == early_stop_round_counter) {
+      num_active = StopRowsEarly(early_stop, i + 1 - start_iteration_for_pred_, output, active.data(), num_active,
+                                 &stop);
+      early_stop_round_counter = 0;
+    }
+  }
+}
+
+void GBDT::PredictBatch(const double* features, data_size_t num_rows, double* output,
+                        const PredictionEarlyStopInstance* early_stop,
+                        const QuantizedTrees* quantized_trees) const {
+  PredictRawBatch(features, num_rows, output, early_stop, quantized_trees);
+  for (data_size_t r = 0; r < num_rows; ++r) {
+    double* row_output = output + static_cast<size_t>(num_tree_per_iteration_) * r;
+    if (average_output_) {
+      for (int k = 0; k < num_tree_per_iteration_; ++k) {
+        row_output[k] /= num_iteration_for_pred_;
+      }
+    }
+    if (objective_function_ != nullptr) {
+      objective_function_->ConvertOutput(row_output, row_output);
+    }
+  }
+}
+
+void GBDT::PredictLeafIndex(const double* features, double* output, const QuantizedTrees* quantized_trees) const {
   int start_tree = start_iteration_for_pred_ * num_tree_per_iteration_;
   int num_trees = num_iteration_for_pred_ * num_tree_per_iteration_;
+  quantized_trees = CoveringQuantizedTrees(quantized_trees, start_tree + num_trees);
+  if (quantized_trees != nullptr) {
+    QuantizedRow* quantized_row = GetQuantizedRowBuffer();
+    quantized_row->Quantize(*quantized_trees, features);
+    for (int i = 0; i < num_trees; ++i) {
+      output[i] = quantized_row->GetLeaf(*quantized_trees, start_tree + i);
+    }
+    return;
+  }
   const auto* models_ptr = models_.data() + start_tree;
   for (int i = 0; i < num_trees; ++i) {
     output[i] = models_ptr[i]->PredictLeafIndex(features);
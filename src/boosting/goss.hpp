@@ -6,10 +6,11 @@
 #ifndef LIGHTGBM_BOOSTING_GOSS_HPP_
 #define LIGHTGBM_BOOSTING_GOSS_HPP_
 
-#include <LightGBM/utils/array_args.h>
 #include <LightGBM/sample_strategy.h>
 
 #include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <string>
 #include <vector>
 
@@ -31,6 +32,14 @@ class GOSSStrategy : public SampleStrategy {
     bag_data_cnt_ = num_data_;
     // not subsample for first iterations
     if (iter < static_cast<int>(1.0f / config_->learning_rate)) { return; }
+    const data_size_t top_k = std::max(1, static_cast<data_size_t>(num_data_ * config_->top_rate));
+    const data_size_t other_k = static_cast<data_size_t>(num_data_ * config_->other_rate);
+    data_size_t num_top = 0;
+    threshold_ = FindTopKThreshold(top_k, gradients, hessians, &num_top);
+    // the other rows are kept with the same probability whatever the thread count, the random numbers of a row
+    // only depend on its 1024-row block
+    other_prob_ = num_top < num_data_ ? std::min(1.0, other_k / static_cast<double>(num_data_ - num_top)) : 1.0;
+    multiply_ = other_prob_ > 0.0 ? static_cast<score_t>(1.0 / other_prob_) : 1.0f;
     auto left_cnt = bagging_runner_.Run<true>(
         num_data_,
         [=](int, data_size_t cur_start, data_size_t cur_cnt, data_size_t* left,
@@ -97,9 +106,10 @@ class GOSSStrategy : public SampleStrategy {
       bagging_rands_.emplace_back(config_->bagging_seed + i);
     }
     is_use_subset_ = false;
-    if (config_->top_rate + config_->other_rate <= 0.5) {
-      auto bag_data_cnt = static_cast<data_size_t>((config_->top_rate + config_->other_rate) * num_data_);
-      bag_data_cnt = std::max(1, bag_data_cnt);
+    auto bag_data_cnt = static_cast<data_size_t>((config_->top_rate + config_->other_rate) * num_data_);
+    bag_data_cnt = std::max(1, bag_data_cnt);
+    // GOSS samples again every iteration
+    if (IsSubsetCheaper(bag_data_cnt, 1)) {
       tmp_subset_.reset(new Dataset(bag_data_cnt));
       tmp_subset_->CopyFeatureMapperFrom(train_data_);
       is_use_subset_ = true;
@@ -113,56 +123,117 @@ class GOSSStrategy : public SampleStrategy {
   }
 
  private:
+  /*! \brief Number of bits of the keys resolved by each radix select pass, from the highest ones */
+  static const int kRadixBits = 11;
+  static const int kNumRadixBins = 1 << kRadixBits;
+
+  /*!
+  * \brief Find the top_k-th largest |g * h| of all rows, by radix select on the bits of the non-negative floats.
+  *        Every pass histograms one digit of the keys with per-thread counts, so the threshold is exact and
+  *        does not depend on the number of threads
+  * \param top_k Rank of the threshold, from the largest
+  * \param num_top Output, number of rows not smaller than the threshold
+  * \return The threshold
+  */
+  score_t FindTopKThreshold(data_size_t top_k, const score_t* gradients, const score_t* hessians,
+                            data_size_t* num_top) {
+    Common::FunctionTimer fun_timer("GOSS::FindTopKThreshold", global_timer);
+    sample_keys_.resize(num_data_);
+    thread_radix_counts_.resize(static_cast<size_t>(OMP_NUM_THREADS()) * kNumRadixBins);
+    uint32_t prefix = 0;
+    uint32_t prefix_mask = 0;
+    data_size_t rank = top_k;
+    data_size_t num_not_smaller = 0;
+    for (int shift = 32 - kRadixBits; shift > -kRadixBits; shift -= kRadixBits) {
+      const int digit_shift = std::max(shift, 0);
+      const uint32_t digit_mask = (1u << (kRadixBits + std::min(shift, 0))) - 1;
+      const int num_blocks = Threading::For<data_size_t>(0, num_data_, 1024,
+          [=](int block, data_size_t start, data_size_t end) {
+        data_size_t* counts = thread_radix_counts_.data() + static_cast<size_t>(block) * kNumRadixBins;
+        std::fill(counts, counts + kNumRadixBins, 0);
+        if (prefix_mask == 0) {
+          // the keys are computed with the first digit
+          for (data_size_t i = start; i < end; ++i) {
+            score_t grad = 0.0f;
+            for (int cur_tree_id = 0; cur_tree_id < num_tree_per_iteration_; ++cur_tree_id) {
+              size_t idx = static_cast<size_t>(cur_tree_id) * num_data_ + i;
+              grad += std::fabs(gradients[idx] * hessians[idx]);
+            }
+            uint32_t key;
+            std::memcpy(&key, &grad, sizeof(key));
+            sample_keys_[i] = key;
+            ++counts[(key >> digit_shift) & digit_mask];
+          }
+        } else {
+          for (data_size_t i = start; i < end; ++i) {
+            const uint32_t key = sample_keys_[i];
+            if ((key & prefix_mask) == prefix) {
+              ++counts[(key >> digit_shift) & digit_mask];
+            }
+          }
+        }
+      });
+      for (int block = 1; block < num_blocks; ++block) {
+        const data_size_t* counts = thread_radix_counts_.data() + static_cast<size_t>(block) * kNumRadixBins;
+        for (int bin = 0; bin < kNumRadixBins; ++bin) {
+          thread_radix_counts_[bin] += counts[bin];
+        }
+      }
+      // the digit of the rank-th largest key among the keys with the prefix
+      int bin = static_cast<int>(digit_mask);
+      while (bin > 0 && thread_radix_counts_[bin] < rank) {
+        rank -= thread_radix_counts_[bin];
+        num_not_smaller += thread_radix_counts_[bin];
+        --bin;
+      }
+      prefix |= static_cast<uint32_t>(bin) << digit_shift;
+      prefix_mask |= digit_mask << digit_shift;
+      if (prefix_mask == ~0u) {
+        num_not_smaller += thread_radix_counts_[bin];
+      }
+    }
+    *num_top = num_not_smaller;
+    score_t threshold;
+    std::memcpy(&threshold, &prefix, sizeof(threshold));
+    return threshold;
+  }
+
   data_size_t Helper(data_size_t start, data_size_t cnt, data_size_t* buffer, score_t* gradients, score_t* hessians) {
     if (cnt <= 0) {
       return 0;
     }
-    std::vector<score_t> tmp_gradients(cnt, 0.0f);
-    for (data_size_t i = 0; i < cnt; ++i) {
-      for (int cur_tree_id = 0; cur_tree_id < num_tree_per_iteration_; ++cur_tree_id) {
-        size_t idx = static_cast<size_t>(cur_tree_id) * num_data_ + start + i;
-        tmp_gradients[i] += std::fabs(gradients[idx] * hessians[idx]);
-      }
-    }
-    data_size_t top_k = static_cast<data_size_t>(cnt * config_->top_rate);
-    data_size_t other_k = static_cast<data_size_t>(cnt * config_->other_rate);
-    top_k = std::max(1, top_k);
-    ArrayArgs<score_t>::ArgMaxAtK(&tmp_gradients, 0, static_cast<int>(tmp_gradients.size()), top_k - 1);
-    score_t threshold = tmp_gradients[top_k - 1];
-
-    score_t multiply = static_cast<score_t>(cnt - top_k) / other_k;
     data_size_t cur_left_cnt = 0;
     data_size_t cur_right_pos = cnt;
-    data_size_t big_weight_cnt = 0;
     for (data_size_t i = 0; i < cnt; ++i) {
       auto cur_idx = start + i;
-      score_t grad = 0.0f;
-      for (int cur_tree_id = 0; cur_tree_id < num_tree_per_iteration_; ++cur_tree_id) {
-        size_t idx = static_cast<size_t>(cur_tree_id) * num_data_ + cur_idx;
-        grad += std::fabs(gradients[idx] * hessians[idx]);
-      }
-      if (grad >= threshold) {
+      score_t grad;
+      std::memcpy(&grad, &sample_keys_[cur_idx], sizeof(grad));
+      if (grad >= threshold_) {
         buffer[cur_left_cnt++] = cur_idx;
-        ++big_weight_cnt;
-      } else {
-        data_size_t sampled = cur_left_cnt - big_weight_cnt;
-        data_size_t rest_need = other_k - sampled;
-        data_size_t rest_all = (cnt - i) - (top_k - big_weight_cnt);
-        double prob = (rest_need) / static_cast<double>(rest_all);
-        if (bagging_rands_[cur_idx / bagging_rand_block_].NextFloat() < prob) {
-          buffer[cur_left_cnt++] = cur_idx;
-          for (int cur_tree_id = 0; cur_tree_id < num_tree_per_iteration_; ++cur_tree_id) {
-            size_t idx = static_cast<size_t>(cur_tree_id) * num_data_ + cur_idx;
-            gradients[idx] *= multiply;
-            hessians[idx] *= multiply;
-          }
-        } else {
-          buffer[--cur_right_pos] = cur_idx;
+      } else if (bagging_rands_[cur_idx / bagging_rand_block_].NextFloat() < other_prob_) {
+        buffer[cur_left_cnt++] = cur_idx;
+        for (int cur_tree_id = 0; cur_tree_id < num_tree_per_iteration_; ++cur_tree_id) {
+          size_t idx = static_cast<size_t>(cur_tree_id) * num_data_ + cur_idx;
+          gradients[idx] *= multiply_;
+          hessians[idx] *= multiply_;
         }
+      } else {
+        buffer[--cur_right_pos] = cur_idx;
       }
     }
     return cur_left_cnt;
   }
+
+  /*! \brief Bits of |g * h| of each row, summed over the trees of an iteration, reused across iterations */
+  std::vector<uint32_t> sample_keys_;
+  /*! \brief Per-thread radix histograms, reused across iterations */
+  std::vector<data_size_t> thread_radix_counts_;
+  /*! \brief Rows with a |g * h| not smaller than the threshold are always kept */
+  score_t threshold_ = 0.0f;
+  /*! \brief Probability to keep each of the other rows */
+  double other_prob_ = 0.0;
+  /*! \brief Weight of the kept other rows */
+  score_t multiply_ = 1.0f;
 };
 
 }  // namespace LightGBM
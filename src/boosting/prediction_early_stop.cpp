@@ -18,7 +18,8 @@ PredictionEarlyStopInstance CreateNone(const PredictionEarlyStopConfig&) {
     [](const double*, int) {
     return false;
   },
-    std::numeric_limits<int>::max()  // make sure the lambda is almost never called
+    std::numeric_limits<int>::max(),  // make sure the lambda is almost never called
+    nullptr
   };
 }
 
@@ -47,7 +48,8 @@ PredictionEarlyStopInstance CreateMulticlass(const PredictionEarlyStopConfig& co
 
     return false;
   },
-    config.round_period
+    config.round_period,
+    nullptr
   };
 }
 
@@ -68,10 +70,87 @@ PredictionEarlyStopInstance CreateBinary(const PredictionEarlyStopConfig& config
 
     return false;
   },
-    config.round_period
+    config.round_period,
+    nullptr
   };
 }
 
+PredictionEarlyStopInstance CreateConfidence(const PredictionEarlyStopConfig& config) {
+  const double confidence_threshold = config.confidence_threshold;
+  const auto convert_output = config.convert_output;
+  if (convert_output == nullptr) {
+    Log::Fatal("Confidence early stopping needs a conversion of raw scores into probabilities");
+  }
+
+  return PredictionEarlyStopInstance{
+    [confidence_threshold, convert_output](const double* pred, int sz) {
+    // per-thread scratch, the criterion is checked for every row
+    static thread_local std::vector<double> prob;
+    prob.resize(static_cast<size_t>(sz));
+    convert_output(pred, prob.data());
+    double confidence;
+    if (sz == 1) {
+      confidence = std::max(prob[0], 1.0 - prob[0]);
+    } else {
+      confidence = *std::max_element(prob.begin(), prob.end());
+    }
+    return confidence >= confidence_threshold;
+  },
+    config.round_period,
+    nullptr
+  };
+}
+
+PredictionEarlyStopInstance CreateTopK(const PredictionEarlyStopConfig& config) {
+  const data_size_t top_k = config.top_k;
+  const std::vector<double> remaining_lower = config.remaining_lower;
+  const std::vector<double> remaining_upper = config.remaining_upper;
+  if (remaining_lower.empty() || remaining_lower.size() != remaining_upper.size()) {
+    Log::Fatal("Top-k early stopping needs the range of the scores of the remaining iterations");
+  }
+
+  PredictionEarlyStopInstance instance{
+    [](const double*, int) {
+    // a single row always belongs to its own top k
+    return false;
+  },
+    config.round_period,
+    nullptr
+  };
+  // a row stops once even its highest possible final score is below the lowest possible final score of k other
+  // rows: it cannot enter the top k anymore. Its prediction becomes that highest possible score, so that it still
+  // ranks below every row of the top k
+  instance.batch_callback_function = [top_k, remaining_lower, remaining_upper](
+      double* pred, int sz, const data_size_t* active, data_size_t num_active, int iteration, int8_t* stop) {
+    if (sz != 1) {
+      Log::Fatal("Top-k early stopping needs predictions to be of length one");
+    }
+    if (num_active <= top_k) {
+      return;
+    }
+    const size_t pos = std::min(static_cast<size_t>(iteration), remaining_lower.size() - 1);
+    const double lower = remaining_lower[pos];
+    const double upper = remaining_upper[pos];
+    if (!std::isfinite(lower) || !std::isfinite(upper)) {
+      return;
+    }
+    std::vector<double> scores(num_active);
+    for (data_size_t j = 0; j < num_active; ++j) {
+      scores[j] = pred[active[j]];
+    }
+    std::nth_element(scores.begin(), scores.begin() + (top_k - 1), scores.end(), std::greater<double>());
+    const double kth_lower = scores[top_k - 1] + lower;
+    for (data_size_t j = 0; j < num_active; ++j) {
+      const double highest = pred[active[j]] + upper;
+      if (highest < kth_lower) {
+        pred[active[j]] = highest;
+        stop[j] = 1;
+      }
+    }
+  };
+  return instance;
+}
+
 PredictionEarlyStopInstance CreatePredictionEarlyStopInstance(const std::string& type,
                                                               const PredictionEarlyStopConfig& config) {
   if (type == "none") {
@@ -80,6 +159,10 @@ PredictionEarlyStopInstance CreatePredictionEarlyStopInstance(const std::string&
     return CreateMulticlass(config);
   } else if (type == "binary") {
     return CreateBinary(config);
+  } else if (type == "confidence") {
+    return CreateConfidence(config);
+  } else if (type == "top_k") {
+    return CreateTopK(config);
   } else {
     Log::Fatal("Unknown early stopping type: %s", type.c_str());
   }
@@ -0,0 +1,247 @@
+/*!
+ * Copyright (c) 2024 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+#ifndef LIGHTGBM_BOOSTING_QUANTIZED_TREES_HPP_
+#define LIGHTGBM_BOOSTING_QUANTIZED_TREES_HPP_
+
+#include <LightGBM/meta.h>
+#include <LightGBM/tree.h>
+#include <LightGBM/utils/common.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+namespace LightGBM {
+
+/*!
+* \brief Trees flattened into shared node tables for threshold-quantized inference.
+*        The numerical thresholds of each feature are collected into a sorted unique set, a row is mapped once
+*        to the index of each of its values in that set, and every node then compares small integers,
+*        like NumericalDecisionInner does during training. Leaves are stored as ~leaf like in Tree.
+*/
+class QuantizedTrees {
+ public:
+  /*! \brief Node flags, the missing types share the bits of the per-row missing flags */
+  enum {
+    kMissingZero = 1,
+    kMissingNaN = 2,
+    kDefaultLeft = 4,
+    kCategorical = 8
+  };
+
+  struct Node {
+    /*! \brief Numerical or categorical slot of the split feature */
+    int32_t slot;
+    /*! \brief Index of the threshold among the sorted thresholds of the feature */
+    uint32_t threshold;
+    uint8_t flags;
+    /*! \brief Left and right child */
+    int32_t children[2];
+  };
+
+  /*!
+  * \brief Constructor
+  * \param models All trees of the model
+  * \param start_model Index of the first tree to flatten
+  * \param end_model Index after the last tree to flatten
+  * \param num_features Number of features of the model
+  */
+  QuantizedTrees(const std::vector<std::unique_ptr<Tree>>& models, int start_model, int end_model,
+                 int num_features) {
+    std::vector<std::vector<double>> feature_thresholds(num_features);
+    std::vector<bool> is_categorical(num_features, false);
+    for (int i = start_model; i < end_model; ++i) {
+      const Tree* tree = models[i].get();
+      if (tree->is_linear()) {
+        is_supported_ = false;
+        return;
+      }
+      for (int node = 0; node < tree->num_leaves() - 1; ++node) {
+        if (tree->IsNumericalSplit(node)) {
+          feature_thresholds[tree->split_feature(node)].push_back(tree->threshold(node));
+        } else {
+          is_categorical[tree->split_feature(node)] = true;
+        }
+      }
+    }
+    std::vector<int32_t> numerical_slot(num_features, -1);
+    std::vector<int32_t> categorical_slot(num_features, -1);
+    threshold_offsets_.push_back(0);
+    for (int f = 0; f < num_features; ++f) {
+      std::vector<double>& feature_threshold = feature_thresholds[f];
+      if (!feature_threshold.empty()) {
+        std::sort(feature_threshold.begin(), feature_threshold.end());
+        feature_threshold.erase(std::unique(feature_threshold.begin(), feature_threshold.end()),
+                                feature_threshold.end());
+        max_num_thresholds_ = std::max(max_num_thresholds_, feature_threshold.size());
+        numerical_slot[f] = static_cast<int32_t>(numerical_features_.size());
+        numerical_features_.push_back(f);
+        thresholds_.insert(thresholds_.end(), feature_threshold.begin(), feature_threshold.end());
+        threshold_offsets_.push_back(static_cast<uint32_t>(thresholds_.size()));
+      }
+      if (is_categorical[f]) {
+        categorical_slot[f] = static_cast<int32_t>(categorical_features_.size());
+        categorical_features_.push_back(f);
+      }
+    }
+
+    cat_offsets_.push_back(0);
+    tree_node_offsets_.push_back(0);
+    for (int i = start_model; i < end_model; ++i) {
+      const Tree* tree = models[i].get();
+      const int32_t node_base = static_cast<int32_t>(nodes_.size());
+      tree_roots_.push_back(tree->num_leaves() > 1 ? node_base : ~0);
+      for (int node = 0; node < tree->num_leaves() - 1; ++node) {
+        const int feature = tree->split_feature(node);
+        const int8_t decision_type = tree->decision_type(node);
+        Node flat;
+        flat.threshold = 0;
+        flat.flags = 0;
+        if (tree->IsNumericalSplit(node)) {
+          const std::vector<double>& feature_threshold = feature_thresholds[feature];
+          flat.slot = numerical_slot[feature];
+          flat.threshold = static_cast<uint32_t>(
+            std::lower_bound(feature_threshold.begin(), feature_threshold.end(), tree->threshold(node))
+            - feature_threshold.begin());
+          const int8_t missing_type = Tree::GetMissingType(decision_type);
+          if (missing_type == MissingType::Zero) {
+            flat.flags |= kMissingZero;
+          } else if (missing_type == MissingType::NaN) {
+            flat.flags |= kMissingNaN;
+          }
+          if (Tree::GetDecisionType(decision_type, kDefaultLeftMask)) {
+            flat.flags |= kDefaultLeft;
+          }
+        } else {
+          flat.slot = categorical_slot[feature];
+          flat.flags |= kCategorical;
+          const std::vector<uint32_t> bitset = tree->categorical_bitset(node);
+          node_cat_split_.resize(nodes_.size() + 1, -1);
+          node_cat_split_.back() = static_cast<int32_t>(cat_offsets_.size() - 1);
+          cat_bitsets_.insert(cat_bitsets_.end(), bitset.begin(), bitset.end());
+          cat_offsets_.push_back(static_cast<uint32_t>(cat_bitsets_.size()));
+        }
+        const int left = tree->left_child(node);
+        const int right = tree->right_child(node);
+        flat.children[0] = left >= 0 ? node_base + left : left;
+        flat.children[1] = right >= 0 ? node_base + right : right;
+        nodes_.push_back(flat);
+      }
+      tree_node_offsets_.push_back(static_cast<int32_t>(nodes_.size()));
+    }
+    if (!node_cat_split_.empty()) {
+      node_cat_split_.resize(nodes_.size(), -1);
+    }
+    is_supported_ = true;
+  }
+
+  /*! \brief False if the trees cannot be quantized, e.g. linear trees */
+  inline bool is_supported() const { return is_supported_; }
+
+  inline int num_trees() const { return static_cast<int>(tree_roots_.size()); }
+
+  inline int num_numerical() const { return static_cast<int>(numerical_features_.size()); }
+
+  inline int num_categorical() const { return static_cast<int>(categorical_features_.size()); }
+
+  /*! \brief Largest number of distinct thresholds of one numerical feature */
+  inline size_t max_num_thresholds() const { return max_num_thresholds_; }
+
+  /*!
+  * \brief Map a row to threshold indices once, for all trees
+  * \param row Dense feature values of the row
+  * \param bins Output, number of thresholds below the value of each numerical slot
+  * \param missing Output, kMissingZero / kMissingNaN flags of each numerical slot
+  * \param cats Output, integer value of each categorical slot, -1 for NaN
+  */
+  inline void QuantizeRow(const double* row, uint32_t* bins, uint8_t* missing, int* cats) const {
+    for (int i = 0; i < num_numerical(); ++i) {
+      const double raw = row[numerical_features_[i]];
+      const bool is_nan = std::isnan(raw);
+      // NaN is compared as zero unless the node handles NaN as missing
+      const double value = is_nan ? 0.0 : raw;
+      const double* first = thresholds_.data() + threshold_offsets_[i];
+      const double* base = first;
+      uint32_t len = threshold_offsets_[i + 1] - threshold_offsets_[i];
+      // branch-free lower bound
+      while (len > 1) {
+        const uint32_t half = len >> 1;
+        base = (base[half] < value) ? base + half : base;
+        len -= half;
+      }
+      bins[i] = static_cast<uint32_t>((base - first) + (*base < value));
+      missing[i] = static_cast<uint8_t>((Tree::IsZero(value) ? kMissingZero : 0) | (is_nan ? kMissingNaN : 0));
+    }
+    for (int i = 0; i < num_categorical(); ++i) {
+      const double raw = row[categorical_features_[i]];
+      cats[i] = std::isnan(raw) ? -1 : static_cast<int>(raw);
+    }
+  }
+
+  /*!
+  * \brief Get the leaf of a quantized row, same as Tree::GetLeaf on the raw row
+  * \param tree_idx Index of the tree, relative to start_model
+  */
+  inline int GetLeaf(int tree_idx, const uint32_t* bins, const uint8_t* missing, const int* cats) const {
+    int node = tree_roots_[tree_idx];
+    while (node >= 0) {
+      const Node& flat = nodes_[node];
+      int go_right;
+      if (flat.flags & kCategorical) {
+        const int value = cats[flat.slot];
+        const int cat_idx = node_cat_split_[node];
+        const int num_words = static_cast<int>(cat_offsets_[cat_idx + 1] - cat_offsets_[cat_idx]);
+        go_right = value < 0 || !Common::FindInBitset(cat_bitsets_.data() + cat_offsets_[cat_idx], num_words, value);
+      } else {
+        const int is_missing = (missing[flat.slot] & flat.flags) != 0;
+        go_right = is_missing ? !(flat.flags & kDefaultLeft) : bins[flat.slot] > flat.threshold;
+      }
+      node = flat.children[go_right];
+    }
+    return ~node;
+  }
+
+  inline const std::vector<int>& numerical_features() const { return numerical_features_; }
+
+  inline const std::vector<uint32_t>& threshold_offsets() const { return threshold_offsets_; }
+
+  inline const std::vector<double>& thresholds() const { return thresholds_; }
+
+  inline const std::vector<int>& categorical_features() const { return categorical_features_; }
+
+  inline const std::vector<Node>& nodes() const { return nodes_; }
+
+  /*! \brief Categorical split index of each node, -1 for numerical nodes, empty without categorical splits */
+  inline const std::vector<int32_t>& node_cat_split() const { return node_cat_split_; }
+
+  inline const std::vector<uint32_t>& cat_offsets() const { return cat_offsets_; }
+
+  inline const std::vector<uint32_t>& cat_bitsets() const { return cat_bitsets_; }
+
+  /*! \brief Root of each tree, ~0 for trees with a single leaf */
+  inline const std::vector<int32_t>& tree_roots() const { return tree_roots_; }
+
+  /*! \brief Nodes of tree i are [tree_node_offsets()[i], tree_node_offsets()[i + 1]) */
+  inline const std::vector<int32_t>& tree_node_offsets() const { return tree_node_offsets_; }
+
+ private:
+  bool is_supported_ = false;
+  size_t max_num_thresholds_ = 0;
+  std::vector<int> numerical_features_;
+  std::vector<uint32_t> threshold_offsets_;
+  std::vector<double> thresholds_;
+  std::vector<int> categorical_features_;
+  std::vector<Node> nodes_;
+  std::vector<int32_t> node_cat_split_;
+  std::vector<uint32_t> cat_offsets_;
+  std::vector<uint32_t> cat_bitsets_;
+  std::vector<int32_t> tree_roots_;
+  std::vector<int32_t> tree_node_offsets_;
+};
+
+}  // namespace LightGBM
+
+#endif  // LIGHTGBM_BOOSTING_QUANTIZED_TREES_HPP_
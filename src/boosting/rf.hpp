@@ -199,6 +199,7 @@ class RF : public GBDT {
     for (int cur_tree_id = 0; cur_tree_id < num_tree_per_iteration_; ++cur_tree_id) {
       models_.pop_back();
     }
+    ResetQuantizedTrees();
     --iter_;
   }
 
@@ -7,6 +7,9 @@
 #include "goss.hpp"
 #include "bagging.hpp"
 
+#include <algorithm>
+#include <cmath>
+
 namespace LightGBM {
 
 SampleStrategy* SampleStrategy::CreateSampleStrategy(
@@ -21,4 +24,21 @@ SampleStrategy* SampleStrategy::CreateSampleStrategy(
   }
 }
 
+bool SampleStrategy::IsSubsetCheaper(data_size_t bag_data_cnt, int num_iterations_per_bag) const {
+  if (bag_data_cnt >= num_data_) {
+    return false;
+  }
+  const double rate = static_cast<double>(bag_data_cnt) / num_data_;
+  // fraction of the cache lines of an 8-bit column that hold at least one bagged row
+  const double touched = 1.0 - std::pow(1.0 - rate, 64.0);
+  // histogram passes over the bagged rows of a tree, only the smaller child of a split is constructed
+  const double passes = 1.0 + 0.5 * std::log2(static_cast<double>(std::max(config_->num_leaves, 2)));
+  const double num_trees = static_cast<double>(num_tree_per_iteration_) * num_iterations_per_bag;
+  // bytes moved per byte of a full column: through the indices every pass reads the touched lines,
+  // while the subset is gathered once per bag and then read densely
+  const double index_cost = num_trees * passes * touched;
+  const double subset_cost = touched + 2.0 * rate + num_trees * passes * rate;
+  return subset_cost < index_cost;
+}
+
 }  // namespace LightGBM
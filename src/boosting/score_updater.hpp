@@ -11,6 +11,7 @@
 #include <LightGBM/tree_learner.h>
 #include <LightGBM/utils/openmp_wrapper.h>
 
+#include <algorithm>
 #include <cstring>
 #include <vector>
 
@@ -49,6 +50,49 @@ class ScoreUpdater {
   virtual ~ScoreUpdater() {
   }
 
+  /*!
+  * \brief Grow scores after rows were appended to the bound data set, scores of the existing rows are kept
+  *        and the appended rows start from their initial scores (or zero)
+  * \param num_tree_per_iteration Number of trees per iteration
+  */
+  virtual inline void ReSizeForAppend(int num_tree_per_iteration) {
+    const data_size_t num_old_data = num_data_;
+    num_data_ = data_->num_data();
+    std::vector<double, Common::AlignmentAllocator<double, kAlignedSize>> old_score;
+    old_score.swap(score_);
+    score_.resize(static_cast<size_t>(num_data_) * num_tree_per_iteration, 0.0f);
+    const double* init_score = data_->metadata().init_score();
+    has_init_score_ = init_score != nullptr;
+#pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static)
+    for (int k = 0; k < num_tree_per_iteration; ++k) {
+      const size_t old_offset = static_cast<size_t>(num_old_data) * k;
+      const size_t offset = static_cast<size_t>(num_data_) * k;
+      std::copy(old_score.begin() + old_offset, old_score.begin() + old_offset + num_old_data,
+                score_.begin() + offset);
+      if (has_init_score_) {
+        std::copy(init_score + offset + num_old_data, init_score + offset + num_data_,
+                  score_.begin() + offset + num_old_data);
+      }
+    }
+  }
+
+  /*!
+  * \brief Reset scores of rows which were overwritten in the bound data set to their initial scores (or zero)
+  * \param data_indices Indices of the overwritten rows
+  * \param data_cnt Number of the overwritten rows
+  * \param num_tree_per_iteration Number of trees per iteration
+  */
+  virtual inline void ResetScoreAt(const data_size_t* data_indices, data_size_t data_cnt, int num_tree_per_iteration) {
+    const double* init_score = data_->metadata().init_score();
+    for (int k = 0; k < num_tree_per_iteration; ++k) {
+      const size_t offset = static_cast<size_t>(num_data_) * k;
+#pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static, 512) if (data_cnt >= 1024)
+      for (data_size_t i = 0; i < data_cnt; ++i) {
+        score_[offset + data_indices[i]] = init_score != nullptr ? init_score[offset + data_indices[i]] : 0.0f;
+      }
+    }
+  }
+
   inline bool has_init_score() const { return has_init_score_; }
 
   virtual inline void AddScore(double val, int cur_tree_id) {
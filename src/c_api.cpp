@@ -21,6 +21,7 @@
 #include <LightGBM/utils/threading.h>
 
 #include <string>
+#include <cmath>
 #include <cstdio>
 #include <cstdint>
 #include <functional>
@@ -59,42 +60,220 @@ yamc::shared_lock<yamc::alternate::shared_mutex> lock(&mtx);
 
 const int PREDICTOR_TYPES = 4;
 
+/*!
+* \brief View of one dense row in the caller's buffer, values are converted on read.
+*        Like in the sparse representation of the row, values within kZeroThreshold of zero read as zero
+*/
+template <typename T>
+class DenseRowView {
+ public:
+  DenseRowView(const T* data, int num_col, int64_t stride) : data_(data), num_col_(num_col), stride_(stride) {}
+  inline int64_t size() const { return num_col_; }
+  inline int index(int64_t i) const { return static_cast<int>(i); }
+  inline double raw_value(int64_t i) const { return static_cast<double>(data_[stride_ * i]); }
+  inline double value(int64_t i) const {
+    const double val = raw_value(i);
+    return (std::fabs(val) > kZeroThreshold || std::isnan(val)) ? val : 0.0;
+  }
+
+ private:
+  const T* data_;
+  int num_col_;
+  int64_t stride_;
+};
+
+/*! \brief View of one sparse row given by parallel index and value arrays in the caller's buffer */
+template <typename T>
+class SparseRowView {
+ public:
+  SparseRowView(const int32_t* indices, const T* data, int64_t num_values)
+    : indices_(indices), data_(data), num_values_(num_values) {}
+  inline int64_t size() const { return num_values_; }
+  inline int index(int64_t i) const { return indices_[i]; }
+  inline double value(int64_t i) const { return static_cast<double>(data_[i]); }
+  inline const int32_t* indices() const { return indices_; }
+  inline const T* data() const { return data_; }
+
+ private:
+  const int32_t* indices_;
+  const T* data_;
+  int64_t num_values_;
+};
+
+/*! \brief Dense matrix in row-major or column-major layout, row(i) does not allocate */
+template <typename T>
+class DenseMatrixView {
+ public:
+  DenseMatrixView(const void* data, int num_row, int num_col, int is_row_major)
+    : data_(reinterpret_cast<const T*>(data)), num_col_(num_col),
+      row_stride_(is_row_major ? num_col : 1), col_stride_(is_row_major ? 1 : num_row) {}
+  inline DenseRowView<T> row(int64_t row_idx) const {
+    return DenseRowView<T>(data_ + row_stride_ * row_idx, num_col_, col_stride_);
+  }
+  inline bool is_row_major() const { return col_stride_ == 1; }
+  /*! \brief Start of a column, its values are contiguous only for column-major matrices */
+  inline const T* column(int col_idx) const { return data_ + col_stride_ * col_idx; }
+
+ private:
+  const T* data_;
+  int num_col_;
+  int64_t row_stride_;
+  int64_t col_stride_;
+};
+
+/*! \brief Dense matrix given as an array of pointers to individual rows */
+template <typename T>
+class DenseRowsView {
+ public:
+  DenseRowsView(const void** data, int num_col) : data_(data), num_col_(num_col) {}
+  inline DenseRowView<T> row(int64_t row_idx) const {
+    return DenseRowView<T>(reinterpret_cast<const T*>(data_[row_idx]), num_col_, 1);
+  }
+
+ private:
+  const void** data_;
+  int num_col_;
+};
+
+/*! \brief CSR matrix, row(i) does not allocate */
+template <typename T, typename INDPTR_T>
+class CSRMatrixView {
+ public:
+  CSRMatrixView(const void* indptr, const int32_t* indices, const void* data)
+    : indptr_(reinterpret_cast<const INDPTR_T*>(indptr)), indices_(indices), data_(reinterpret_cast<const T*>(data)) {}
+  inline SparseRowView<T> row(int64_t row_idx) const {
+    const int64_t start = static_cast<int64_t>(indptr_[row_idx]);
+    const int64_t end = static_cast<int64_t>(indptr_[row_idx + 1]);
+    return SparseRowView<T>(indices_ + start, data_ + start, end - start);
+  }
+
+ private:
+  const INDPTR_T* indptr_;
+  const int32_t* indices_;
+  const T* data_;
+};
+
+/*! \brief Adapts a function building each row as (index, value) pairs, for layouts without a row view */
+class RowFunctionView {
+ public:
+  explicit RowFunctionView(const std::function<std::vector<std::pair<int, double>>(int row_idx)>& get_row_fun)
+    : get_row_fun_(get_row_fun) {}
+  inline std::vector<std::pair<int, double>> row(int64_t row_idx) const {
+    return get_row_fun_(static_cast<int>(row_idx));
+  }
+
+ private:
+  const std::function<std::vector<std::pair<int, double>>(int row_idx)>& get_row_fun_;
+};
+
+/*!
+* \brief Call visitor->Visit(rows) once with the typed view of a dense matrix
+*/
+template <typename Visitor>
+void VisitDenseMatrix(const void* data, int data_type, int num_row, int num_col, int is_row_major, Visitor* visitor) {
+  if (data_type == C_API_DTYPE_FLOAT32) {
+    visitor->Visit(DenseMatrixView<float>(data, num_row, num_col, is_row_major));
+  } else if (data_type == C_API_DTYPE_FLOAT64) {
+    visitor->Visit(DenseMatrixView<double>(data, num_row, num_col, is_row_major));
+  } else {
+    Log::Fatal("Unknown data type in VisitDenseMatrix");
+  }
+}
+
+/*!
+* \brief Call visitor->Visit(rows) once with the typed view of an array of dense rows
+*/
+template <typename Visitor>
+void VisitDenseRows(const void** data, int data_type, int num_col, Visitor* visitor) {
+  if (data_type == C_API_DTYPE_FLOAT32) {
+    visitor->Visit(DenseRowsView<float>(data, num_col));
+  } else if (data_type == C_API_DTYPE_FLOAT64) {
+    visitor->Visit(DenseRowsView<double>(data, num_col));
+  } else {
+    Log::Fatal("Unknown data type in VisitDenseRows");
+  }
+}
+
+/*!
+* \brief Call visitor->Visit(rows) once with the typed view of a CSR matrix
+*/
+template <typename Visitor>
+void VisitCSRMatrix(const void* indptr, int indptr_type, const int32_t* indices, const void* data, int data_type,
+                    Visitor* visitor) {
+  if (data_type == C_API_DTYPE_FLOAT32) {
+    if (indptr_type == C_API_DTYPE_INT32) {
+      visitor->Visit(CSRMatrixView<float, int32_t>(indptr, indices, data));
+      return;
+    } else if (indptr_type == C_API_DTYPE_INT64) {
+      visitor->Visit(CSRMatrixView<float, int64_t>(indptr, indices, data));
+      return;
+    }
+  } else if (data_type == C_API_DTYPE_FLOAT64) {
+    if (indptr_type == C_API_DTYPE_INT32) {
+      visitor->Visit(CSRMatrixView<double, int32_t>(indptr, indices, data));
+      return;
+    } else if (indptr_type == C_API_DTYPE_INT64) {
+      visitor->Visit(CSRMatrixView<double, int64_t>(indptr, indices, data));
+      return;
+    }
+  }
+  Log::Fatal("Unknown data type in VisitCSRMatrix");
+}
+
 // Single row predictor to abstract away caching logic
 class SingleRowPredictorInner {
  public:
-  PredictFunction predict_function;
   int64_t num_pred_in_one_row;
 
   SingleRowPredictorInner(int predict_type, Boosting* boosting, const Config& config, int start_iter, int num_iter) {
     bool is_predict_leaf = false;
     bool is_raw_score = false;
     bool predict_contrib = false;
+    bool predict_interaction = false;
     if (predict_type == C_API_PREDICT_LEAF_INDEX) {
       is_predict_leaf = true;
     } else if (predict_type == C_API_PREDICT_RAW_SCORE) {
       is_raw_score = true;
     } else if (predict_type == C_API_PREDICT_CONTRIB) {
       predict_contrib = true;
+    } else if (predict_type == C_API_PREDICT_INTERACTION) {
+      predict_interaction = true;
     }
     early_stop_ = config.pred_early_stop;
     early_stop_freq_ = config.pred_early_stop_freq;
     early_stop_margin_ = config.pred_early_stop_margin;
+    early_stop_type_ = config.pred_early_stop_type;
+    early_stop_confidence_ = config.pred_early_stop_confidence;
+    early_stop_top_k_ = config.pred_early_stop_top_k;
+    quantized_thresholds_ = config.pred_quantized_thresholds;
     iter_ = num_iter;
     predictor_.reset(new Predictor(boosting, start_iter, iter_, is_raw_score, is_predict_leaf, predict_contrib,
-                                   early_stop_, early_stop_freq_, early_stop_margin_));
-    num_pred_in_one_row = boosting->NumPredictOneRow(start_iter, iter_, is_predict_leaf, predict_contrib);
-    predict_function = predictor_->GetPredictFunction();
+                                   predict_interaction,
+                                   early_stop_, early_stop_freq_, early_stop_margin_, early_stop_type_,
+                                   early_stop_confidence_, early_stop_top_k_, config.pred_early_stop_batch_size,
+                                   quantized_thresholds_));
+    num_pred_in_one_row = boosting->NumPredictOneRow(start_iter, iter_, is_predict_leaf, predict_contrib,
+                                                     predict_interaction);
     num_total_model_ = boosting->NumberOfTotalModel();
   }
 
   ~SingleRowPredictorInner() {}
 
+  Predictor* predictor() const { return predictor_.get(); }
+
   bool IsPredictorEqual(const Config& config, int iter, Boosting* boosting) {
     return early_stop_ == config.pred_early_stop &&
       early_stop_freq_ == config.pred_early_stop_freq &&
       early_stop_margin_ == config.pred_early_stop_margin &&
+      early_stop_type_ == config.pred_early_stop_type &&
+      early_stop_confidence_ == config.pred_early_stop_confidence &&
+      early_stop_top_k_ == config.pred_early_stop_top_k &&
+      quantized_thresholds_ == config.pred_quantized_thresholds &&
       iter_ == iter &&
-      num_total_model_ == boosting->NumberOfTotalModel();
+      num_total_model_ == boosting->NumberOfTotalModel() &&
+      // a restructured model gets new quantized trees, the snapshot of the predictor is then stale
+      (predictor_->quantized_trees() == nullptr ||
+       predictor_->quantized_trees() == boosting->GetQuantizedTrees().get());
   }
 
  private:
@@ -102,6 +281,10 @@ class SingleRowPredictorInner {
   bool early_stop_;
   int early_stop_freq_;
   double early_stop_margin_;
+  std::string early_stop_type_;
+  double early_stop_confidence_;
+  int early_stop_top_k_;
+  bool quantized_thresholds_;
   int iter_;
   int num_total_model_;
 };
@@ -130,13 +313,12 @@ struct SingleRowPredictor {
     }
   }
 
-  void Predict(std::function<std::vector<std::pair<int, double>>(int row_idx)> get_row_fun,
-               double* out_result, int64_t* out_len) const {
+  template <typename RowView>
+  void Predict(const RowView& row, double* out_result, int64_t* out_len) const {
     UNIQUE_LOCK(single_row_predictor_mutex)
     yamc::shared_lock<yamc::alternate::shared_mutex> booster_shared_lock(booster_mutex);
 
-    auto one_row = get_row_fun(0);
-    single_row_predictor_inner.predict_function(one_row, out_result);
+    single_row_predictor_inner.predictor()->PredictRow(row, out_result);
 
     *out_len = single_row_predictor_inner.num_pred_in_one_row;
   }
@@ -180,6 +362,8 @@ class Booster {
     boosting_.reset(Boosting::CreateBoosting(config_.boosting, nullptr));
 
     train_data_ = train_data;
+    train_num_data_ = train_data_->num_data();
+    train_num_window_slides_ = train_data_->num_window_slides();
     CreateObjectiveAndMetrics();
     // initialize the boosting
     if (config_.tree_learner == std::string("feature")) {
@@ -226,9 +410,13 @@ class Booster {
   }
 
   void ResetTrainingData(const Dataset* train_data) {
-    if (train_data != train_data_) {
+    // the same Dataset may have been enlarged by appending rows, or updated in place by sliding its window
+    if (train_data != train_data_ || train_data->num_data() != train_num_data_ ||
+        train_data->num_window_slides() != train_num_window_slides_) {
       UNIQUE_LOCK(mutex_)
       train_data_ = train_data;
+      train_num_data_ = train_data_->num_data();
+      train_num_window_slides_ = train_data_->num_window_slides();
       CreateObjectiveAndMetrics();
       // reset the boosting
       boosting_->ResetTrainingData(train_data_,
@@ -301,6 +489,21 @@ class Booster {
       Log::Fatal(
           "Cannot change enable_bundle after constructed Dataset handle.");
     }
+    if (new_param.count("max_bundle_search_groups") &&
+        new_config.max_bundle_search_groups != old_config.max_bundle_search_groups) {
+      Log::Fatal(
+          "Cannot change max_bundle_search_groups after constructed Dataset handle.");
+    }
+    if (new_param.count("input_bundle_plan") &&
+        new_config.input_bundle_plan != old_config.input_bundle_plan) {
+      Log::Fatal(
+          "Cannot change input_bundle_plan after constructed Dataset handle.");
+    }
+    if (new_param.count("input_dataset_schema") &&
+        new_config.input_dataset_schema != old_config.input_dataset_schema) {
+      Log::Fatal(
+          "Cannot change input_dataset_schema after constructed Dataset handle.");
+    }
     if (new_param.count("header") && new_config.header != old_config.header) {
       Log::Fatal("Cannot change header after constructed Dataset handle.");
     }
@@ -345,6 +548,13 @@ class Booster {
     if (new_param.count("linear_tree") && new_config.linear_tree != old_config.linear_tree) {
       Log::Fatal("Cannot change linear_tree after constructed Dataset handle.");
     }
+    if (new_param.count("linear_raw_type") && new_config.linear_raw_type != old_config.linear_raw_type) {
+      Log::Fatal("Cannot change linear_raw_type after constructed Dataset handle.");
+    }
+    if (new_param.count("linear_raw_dictionary") &&
+        new_config.linear_raw_dictionary != old_config.linear_raw_dictionary) {
+      Log::Fatal("Cannot change linear_raw_dictionary after constructed Dataset handle.");
+    }
     if (new_param.count("precise_float_parser") &&
         new_config.precise_float_parser != old_config.precise_float_parser) {
       Log::Fatal("Cannot change precise_float_parser after constructed Dataset handle.");
@@ -443,8 +653,8 @@ class Booster {
       &mutex_, parameters, data_type, num_cols, predict_type, boosting_.get(), start_iteration, num_iteration));
   }
 
-  void PredictSingleRow(int predict_type, int ncol,
-               std::function<std::vector<std::pair<int, double>>(int row_idx)> get_row_fun,
+  template <typename RowView>
+  void PredictSingleRow(int predict_type, int ncol, const RowView& row,
                const Config& config,
                double* out_result, int64_t* out_len) const {
     if (!config.predict_disable_shape_check && ncol != boosting_->MaxFeatureIdx() + 1) {
@@ -453,9 +663,7 @@ class Booster {
     }
     UNIQUE_LOCK(mutex_)
     const auto& single_row_predictor = single_row_predictor_[predict_type];
-    auto one_row = get_row_fun(0);
-    auto pred_wrt_ptr = out_result;
-    single_row_predictor->predict_function(one_row, pred_wrt_ptr);
+    single_row_predictor->predictor()->PredictRow(row, out_result);
 
     *out_len = single_row_predictor->num_pred_in_one_row;
   }
@@ -468,42 +676,77 @@ class Booster {
     bool is_predict_leaf = false;
     bool is_raw_score = false;
     bool predict_contrib = false;
+    bool predict_interaction = false;
     if (predict_type == C_API_PREDICT_LEAF_INDEX) {
       is_predict_leaf = true;
     } else if (predict_type == C_API_PREDICT_RAW_SCORE) {
       is_raw_score = true;
     } else if (predict_type == C_API_PREDICT_CONTRIB) {
       predict_contrib = true;
+    } else if (predict_type == C_API_PREDICT_INTERACTION) {
+      predict_interaction = true;
     } else {
       is_raw_score = false;
     }
 
     return std::make_shared<Predictor>(boosting_.get(), start_iteration, num_iteration, is_raw_score, is_predict_leaf, predict_contrib,
-                        config.pred_early_stop, config.pred_early_stop_freq, config.pred_early_stop_margin);
+                        predict_interaction,
+                        config.pred_early_stop, config.pred_early_stop_freq, config.pred_early_stop_margin,
+                        config.pred_early_stop_type, config.pred_early_stop_confidence,
+                        config.pred_early_stop_top_k, config.pred_early_stop_batch_size,
+                        config.pred_quantized_thresholds);
   }
 
   void Predict(int start_iteration, int num_iteration, int predict_type, int nrow, int ncol,
                std::function<std::vector<std::pair<int, double>>(int row_idx)> get_row_fun,
                const Config& config,
                double* out_result, int64_t* out_len) const {
+    PredictRows(start_iteration, num_iteration, predict_type, nrow, ncol, RowFunctionView(get_row_fun), config,
+                out_result, out_len);
+  }
+
+  /*!
+  * \brief Predict the rows of a matrix view, row(i) of the view is passed to Predictor::PredictRow
+  */
+  template <typename MatrixView>
+  void PredictRows(int start_iteration, int num_iteration, int predict_type, int nrow, int ncol,
+                   const MatrixView& rows, const Config& config,
+                   double* out_result, int64_t* out_len) const {
     SHARED_LOCK(mutex_);
     auto predictor = CreatePredictor(start_iteration, num_iteration, predict_type, ncol, config);
     bool is_predict_leaf = false;
     bool predict_contrib = false;
+    bool predict_interaction = false;
     if (predict_type == C_API_PREDICT_LEAF_INDEX) {
       is_predict_leaf = true;
     } else if (predict_type == C_API_PREDICT_CONTRIB) {
       predict_contrib = true;
+    } else if (predict_type == C_API_PREDICT_INTERACTION) {
+      predict_interaction = true;
     }
-    int64_t num_pred_in_one_row = boosting_->NumPredictOneRow(start_iteration, num_iteration, is_predict_leaf, predict_contrib);
-    auto pred_fun = predictor->GetPredictFunction();
+    int64_t num_pred_in_one_row = boosting_->NumPredictOneRow(start_iteration, num_iteration, is_predict_leaf,
+                                                              predict_contrib, predict_interaction);
     OMP_INIT_EX();
+    if (predictor->use_batch()) {
+      const int batch_size = predictor->batch_size();
+      const int num_batches = (nrow + batch_size - 1) / batch_size;
+      #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static)
+      for (int batch = 0; batch < num_batches; ++batch) {
+        OMP_LOOP_EX_BEGIN();
+        const int start = batch * batch_size;
+        const int end = std::min(start + batch_size, nrow);
+        predictor->PredictBatch(rows, start, end, out_result + static_cast<size_t>(num_pred_in_one_row) * start);
+        OMP_LOOP_EX_END();
+      }
+      OMP_THROW_EX();
+      *out_len = num_pred_in_one_row * nrow;
+      return;
+    }
     #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static)
     for (int i = 0; i < nrow; ++i) {
       OMP_LOOP_EX_BEGIN();
-      auto one_row = get_row_fun(i);
       auto pred_wrt_ptr = out_result + static_cast<size_t>(num_pred_in_one_row) * i;
-      pred_fun(one_row, pred_wrt_ptr);
+      predictor->PredictRow(rows.row(i), pred_wrt_ptr);
       OMP_LOOP_EX_END();
     }
     OMP_THROW_EX();
@@ -656,6 +899,10 @@ class Booster {
     bool is_col_ptr_int32 = false;
     bool is_data_float32 = false;
     int num_output_cols = ncol + 1;
+    if (predict_type == C_API_PREDICT_INTERACTION) {
+      // column i * (ncol + 1) + j of the flattened interaction matrix
+      num_output_cols = (ncol + 1) * (ncol + 1);
+    }
     int col_ptr_size = (num_output_cols + 1) * num_matrices;
     if (col_ptr_type == C_API_DTYPE_INT32) {
       *out_col_ptr = new int32_t[col_ptr_size];
@@ -759,17 +1006,24 @@ class Booster {
     bool is_predict_leaf = false;
     bool is_raw_score = false;
     bool predict_contrib = false;
+    bool predict_interaction = false;
     if (predict_type == C_API_PREDICT_LEAF_INDEX) {
       is_predict_leaf = true;
     } else if (predict_type == C_API_PREDICT_RAW_SCORE) {
       is_raw_score = true;
     } else if (predict_type == C_API_PREDICT_CONTRIB) {
       predict_contrib = true;
+    } else if (predict_type == C_API_PREDICT_INTERACTION) {
+      predict_interaction = true;
     } else {
       is_raw_score = false;
     }
     Predictor predictor(boosting_.get(), start_iteration, num_iteration, is_raw_score, is_predict_leaf, predict_contrib,
-                        config.pred_early_stop, config.pred_early_stop_freq, config.pred_early_stop_margin);
+                        predict_interaction,
+                        config.pred_early_stop, config.pred_early_stop_freq, config.pred_early_stop_margin,
+                        config.pred_early_stop_type, config.pred_early_stop_confidence,
+                        config.pred_early_stop_top_k, config.pred_early_stop_batch_size,
+                        config.pred_quantized_thresholds);
     bool bool_data_has_header = data_has_header > 0 ? true : false;
     predictor.Predict(data_filename, result_filename, bool_data_has_header, config.predict_disable_shape_check,
                       config.precise_float_parser);
@@ -783,6 +1037,12 @@ class Booster {
     boosting_->SaveModelToFile(start_iteration, num_iteration, feature_importance_type, filename);
   }
 
+  void SaveModelToC(int start_iteration, int num_iteration, const char* filename) const {
+    if (!boosting_->SaveModelToC(start_iteration, num_iteration, filename)) {
+      Log::Fatal("Failed to write C code to %s", filename);
+    }
+  }
+
   void LoadModelFromString(const char* model_str) {
     size_t len = std::strlen(model_str);
     boosting_->LoadModelFromString(model_str, len);
@@ -829,6 +1089,11 @@ class Booster {
     boosting_->ShuffleModels(start_iter, end_iter);
   }
 
+  void OptimizeModels(int start_iter, int end_iter, double merge_tolerance) {
+    UNIQUE_LOCK(mutex_)
+    boosting_->OptimizeModels(start_iter, end_iter, merge_tolerance);
+  }
+
   int GetEvalCounts() const {
     SHARED_LOCK(mutex_)
     int ret = 0;
@@ -874,6 +1139,10 @@ class Booster {
 
  private:
   const Dataset* train_data_;
+  /*! \brief Number of training data when train_data_ was set, rows can be appended to it afterwards */
+  data_size_t train_num_data_ = 0;
+  /*! \brief Number of window slides of train_data_ when it was set */
+  int64_t train_num_window_slides_ = 0;
   std::unique_ptr<Boosting> boosting_;
   std::unique_ptr<SingleRowPredictorInner> single_row_predictor_[PREDICTOR_TYPES];
 
@@ -889,11 +1158,196 @@ class Booster {
   mutable yamc::alternate::shared_mutex mutex_;
 };
 
+/*! \brief Predicts all rows of a matrix view with Booster::PredictRows */
+struct PredictRowsVisitor {
+  const Booster* booster;
+  int start_iteration;
+  int num_iteration;
+  int predict_type;
+  int nrow;
+  int ncol;
+  const Config* config;
+  double* out_result;
+  int64_t* out_len;
+
+  template <typename MatrixView>
+  void Visit(const MatrixView& rows) const {
+    booster->PredictRows(start_iteration, num_iteration, predict_type, nrow, ncol, rows, *config, out_result, out_len);
+  }
+};
+
+/*! \brief Predicts the first row of a matrix view with the cached single row predictor of a Booster */
+struct PredictSingleRowVisitor {
+  const Booster* booster;
+  int predict_type;
+  int ncol;
+  const Config* config;
+  double* out_result;
+  int64_t* out_len;
+
+  template <typename MatrixView>
+  void Visit(const MatrixView& rows) const {
+    booster->PredictSingleRow(predict_type, ncol, rows.row(0), *config, out_result, out_len);
+  }
+};
+
+/*! \brief Predicts the first row of a matrix view with a SingleRowPredictor */
+struct FastPredictVisitor {
+  const SingleRowPredictor* single_row_predictor;
+  double* out_result;
+  int64_t* out_len;
+
+  template <typename MatrixView>
+  void Visit(const MatrixView& rows) const {
+    single_row_predictor->Predict(rows.row(0), out_result, out_len);
+  }
+};
+
+template <typename T>
+inline void PushRowView(Dataset* dataset, int tid, data_size_t row_idx, const DenseRowView<T>& row,
+                        std::vector<bool>*) {
+  const int64_t num_col = std::min<int64_t>(row.size(), dataset->num_total_features());
+  for (int64_t i = 0; i < num_col; ++i) {
+    dataset->PushOneValue(tid, row_idx, static_cast<size_t>(i), row.raw_value(i));
+  }
+}
+
+template <typename T>
+inline void PushRowView(Dataset* dataset, int tid, data_size_t row_idx, const SparseRowView<T>& row,
+                        std::vector<bool>* is_feature_added) {
+  dataset->PushOneRow(tid, row_idx, row.indices(), row.data(), row.size(), is_feature_added);
+}
+
+/*! \brief Pushes rows [0, nrow) of a matrix view to a Dataset starting at start_row */
+struct PushRowsVisitor {
+  Dataset* dataset;
+  data_size_t start_row;
+  int32_t nrow;
+  /*! \brief Added to the OpenMP thread id, to keep the ids of concurrent external threads apart */
+  int tid_offset;
+
+  template <typename MatrixView>
+  void Visit(const MatrixView& rows) const {
+    std::vector<bool> is_feature_added;
+    OMP_INIT_EX();
+    #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static) firstprivate(is_feature_added)
+    for (int i = 0; i < nrow; ++i) {
+      OMP_LOOP_EX_BEGIN();
+      const int tid = omp_get_thread_num() + tid_offset;
+      PushRowView(dataset, tid, start_row + i, rows.row(i), &is_feature_added);
+      OMP_LOOP_EX_END();
+    }
+    OMP_THROW_EX();
+  }
+};
+
+/*!
+* \brief Push whole columns in blocks of rows. The loop runs in parallel over feature groups, so that the bins
+*        of a group are only written by one thread. reader.Read(col_idx, start, len, buffer) returns the values
+*        of the rows [start, start + len) of a column, either copied to buffer or pointing into the caller's data
+*/
+template <typename ColumnReader>
+void PushColumnsByGroup(Dataset* dataset, data_size_t start_row, data_size_t num_rows, const ColumnReader& reader) {
+  const data_size_t block_size = 65536;
+  OMP_INIT_EX();
+  #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(dynamic)
+  for (int group = 0; group < dataset->num_feature_groups(); ++group) {
+    OMP_LOOP_EX_BEGIN();
+    const int tid = omp_get_thread_num();
+    std::vector<double> buffer(std::min(block_size, num_rows));
+    for (int col_idx : dataset->FeatureGroupColumns(group)) {
+      for (data_size_t start = 0; start < num_rows; start += block_size) {
+        const data_size_t len = std::min(block_size, num_rows - start);
+        dataset->PushColumn(tid, start_row + start, col_idx, reader.Read(col_idx, start, len, buffer.data()), len);
+      }
+    }
+    OMP_LOOP_EX_END();
+  }
+  OMP_THROW_EX();
+}
+
+/*! \brief Reads the columns of a column-major matrix, float64 columns are passed on without a copy */
+template <typename T>
+struct DenseColumnReader {
+  const DenseMatrixView<T>* matrix;
+
+  inline const double* Read(int col_idx, data_size_t start, data_size_t len, double* buffer) const {
+    const T* column = matrix->column(col_idx) + start;
+    for (data_size_t i = 0; i < len; ++i) {
+      buffer[i] = static_cast<double>(column[i]);
+    }
+    return buffer;
+  }
+};
+
+template <>
+inline const double* DenseColumnReader<double>::Read(int col_idx, data_size_t start, data_size_t,
+                                                     double*) const {
+  return matrix->column(col_idx) + start;
+}
+
+/*! \brief Reads the columns of an Arrow table */
+struct ArrowColumnReader {
+  const ArrowTable* table;
+
+  inline const double* Read(int col_idx, data_size_t start, data_size_t len, double* buffer) const {
+    table->get_column(col_idx).copy_to(start, len, buffer);
+    return buffer;
+  }
+};
+
+/*!
+* \brief Pushes the rows of a dense matrix, the layout decides the traversal: row-major matrices are pushed row
+*        by row in parallel, column-major matrices are streamed column by column into the bins of each group
+*/
+struct PushMatrixVisitor {
+  Dataset* dataset;
+  data_size_t start_row;
+  int32_t nrow;
+
+  template <typename T>
+  void Visit(const DenseMatrixView<T>& matrix) const {
+    if (matrix.is_row_major()) {
+      PushRowsVisitor visitor = {dataset, start_row, nrow, 0};
+      visitor.Visit(matrix);
+    } else {
+      DenseColumnReader<T> reader = {&matrix};
+      PushColumnsByGroup(dataset, start_row, nrow, reader);
+    }
+  }
+};
+
+/*! \brief Collects the non-zero values of sampled rows of a matrix view, per column */
+struct SampleRowsVisitor {
+  /*! \brief Pairs of (index of the sample, row in the matrix view) */
+  const std::vector<std::pair<int, int>>* samples;
+  int64_t num_col;
+  std::vector<std::vector<double>>* sample_values;
+  std::vector<std::vector<int>>* sample_idx;
+
+  template <typename MatrixView>
+  void Visit(const MatrixView& rows) const {
+    for (const auto& sample : *samples) {
+      const auto row = rows.row(sample.second);
+      for (int64_t k = 0; k < row.size(); ++k) {
+        const int col = row.index(k);
+        const double value = row.value(k);
+        CHECK_LT(col, num_col);
+        if (std::fabs(value) > kZeroThreshold || std::isnan(value)) {
+          (*sample_values)[col].emplace_back(value);
+          (*sample_idx)[col].emplace_back(sample.first);
+        }
+      }
+    }
+  }
+};
+
 }  // namespace LightGBM
 
 // explicitly declare symbols from LightGBM namespace
 using LightGBM::AllgatherFunction;
 using LightGBM::ArrowChunkedArray;
+using LightGBM::ArrowColumnReader;
 using LightGBM::ArrowTable;
 using LightGBM::Booster;
 using LightGBM::Common::CheckElementsIntervalClosed;
@@ -904,13 +1358,24 @@ using LightGBM::Config;
 using LightGBM::data_size_t;
 using LightGBM::Dataset;
 using LightGBM::DatasetLoader;
+using LightGBM::FastPredictVisitor;
 using LightGBM::kZeroThreshold;
 using LightGBM::LGBM_APIHandleException;
 using LightGBM::Log;
+using LightGBM::Metadata;
 using LightGBM::Network;
+using LightGBM::PredictRowsVisitor;
+using LightGBM::PredictSingleRowVisitor;
+using LightGBM::PushColumnsByGroup;
+using LightGBM::PushMatrixVisitor;
+using LightGBM::PushRowsVisitor;
 using LightGBM::Random;
 using LightGBM::ReduceScatterFunction;
+using LightGBM::SampleRowsVisitor;
 using LightGBM::SingleRowPredictor;
+using LightGBM::VisitCSRMatrix;
+using LightGBM::VisitDenseMatrix;
+using LightGBM::VisitDenseRows;
 
 // some help functions used to convert data
 
@@ -920,9 +1385,6 @@ RowFunctionFromDenseMatric(const void* data, int num_row, int num_col, int data_
 std::function<std::vector<std::pair<int, double>>(int row_idx)>
 RowPairFunctionFromDenseMatric(const void* data, int num_row, int num_col, int data_type, int is_row_major);
 
-std::function<std::vector<std::pair<int, double>>(int row_idx)>
-RowPairFunctionFromDenseRows(const void** data, int num_col, int data_type);
-
 template<typename T>
 std::function<std::vector<std::pair<int, double>>(T idx)>
 RowFunctionFromCSR(const void* indptr, int indptr_type, const int32_t* indices,
@@ -972,6 +1434,10 @@ int LGBM_RegisterLogCallback(void (*callback)(const char*)) {
 }
 
 static inline int SampleCount(int32_t total_nrow, const Config& config) {
+  if (!config.input_dataset_schema.empty()) {
+    // the bins come from the schema, no need to sample
+    return 0;
+  }
   return static_cast<int>(total_nrow < config.bin_construct_sample_cnt ? total_nrow : config.bin_construct_sample_cnt);
 }
 
@@ -1133,20 +1599,11 @@ int LGBM_DatasetPushRows(DatasetHandle dataset,
                          int32_t start_row) {
   API_BEGIN();
   auto p_dataset = reinterpret_cast<Dataset*>(dataset);
-  auto get_row_fun = RowFunctionFromDenseMatric(data, nrow, ncol, data_type, 1);
   if (p_dataset->has_raw()) {
     p_dataset->ResizeRaw(p_dataset->num_numeric_features() + nrow);
   }
-  OMP_INIT_EX();
-  #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static)
-  for (int i = 0; i < nrow; ++i) {
-    OMP_LOOP_EX_BEGIN();
-    const int tid = omp_get_thread_num();
-    auto one_row = get_row_fun(i);
-    p_dataset->PushOneRow(tid, start_row + i, one_row);
-    OMP_LOOP_EX_END();
-  }
-  OMP_THROW_EX();
+  PushRowsVisitor visitor = {p_dataset, start_row, nrow, 0};
+  VisitDenseMatrix(data, data_type, nrow, ncol, 1, &visitor);
   if (!p_dataset->wait_for_manual_finish() && (start_row + nrow == p_dataset->num_data())) {
     p_dataset->FinishLoad();
   }
@@ -1172,24 +1629,15 @@ int LGBM_DatasetPushRowsWithMetadata(DatasetHandle dataset,
     Log::Fatal("data cannot be null.");
   }
   auto p_dataset = reinterpret_cast<Dataset*>(dataset);
-  auto get_row_fun = RowFunctionFromDenseMatric(data, nrow, ncol, data_type, 1);
   if (p_dataset->has_raw()) {
     p_dataset->ResizeRaw(p_dataset->num_numeric_features() + nrow);
   }
 
   const int max_omp_threads = p_dataset->omp_max_threads() > 0 ? p_dataset->omp_max_threads() : OMP_NUM_THREADS();
 
-  OMP_INIT_EX();
-#pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static)
-  for (int i = 0; i < nrow; ++i) {
-    OMP_LOOP_EX_BEGIN();
-    // convert internal thread id to be unique based on external thread id
-    const int internal_tid = omp_get_thread_num() + (max_omp_threads * tid);
-    auto one_row = get_row_fun(i);
-    p_dataset->PushOneRow(internal_tid, start_row + i, one_row);
-    OMP_LOOP_EX_END();
-  }
-  OMP_THROW_EX();
+  // convert internal thread id to be unique based on external thread id
+  PushRowsVisitor visitor = {p_dataset, start_row, nrow, max_omp_threads * tid};
+  VisitDenseMatrix(data, data_type, nrow, ncol, 1, &visitor);
 
   p_dataset->InsertMetadataAt(start_row, nrow, labels, weights, init_scores, queries);
 
@@ -1206,26 +1654,17 @@ int LGBM_DatasetPushRowsByCSR(DatasetHandle dataset,
                               const void* data,
                               int data_type,
                               int64_t nindptr,
-                              int64_t nelem,
+                              int64_t,
                               int64_t,
                               int64_t start_row) {
   API_BEGIN();
   auto p_dataset = reinterpret_cast<Dataset*>(dataset);
-  auto get_row_fun = RowFunctionFromCSR<int>(indptr, indptr_type, indices, data, data_type, nindptr, nelem);
   int32_t nrow = static_cast<int32_t>(nindptr - 1);
   if (p_dataset->has_raw()) {
     p_dataset->ResizeRaw(p_dataset->num_numeric_features() + nrow);
   }
-  OMP_INIT_EX();
-  #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static)
-  for (int i = 0; i < nrow; ++i) {
-    OMP_LOOP_EX_BEGIN();
-    const int tid = omp_get_thread_num();
-    auto one_row = get_row_fun(i);
-    p_dataset->PushOneRow(tid, static_cast<data_size_t>(start_row + i), one_row);
-    OMP_LOOP_EX_END();
-  }
-  OMP_THROW_EX();
+  PushRowsVisitor visitor = {p_dataset, static_cast<data_size_t>(start_row), nrow, 0};
+  VisitCSRMatrix(indptr, indptr_type, indices, data, data_type, &visitor);
   if (!p_dataset->wait_for_manual_finish() && (start_row + nrow == static_cast<int64_t>(p_dataset->num_data()))) {
     p_dataset->FinishLoad();
   }
@@ -1239,7 +1678,7 @@ int LGBM_DatasetPushRowsByCSRWithMetadata(DatasetHandle dataset,
                                           const void* data,
                                           int data_type,
                                           int64_t nindptr,
-                                          int64_t nelem,
+                                          int64_t,
                                           int64_t start_row,
                                           const float* labels,
                                           const float* weights,
@@ -1254,7 +1693,6 @@ int LGBM_DatasetPushRowsByCSRWithMetadata(DatasetHandle dataset,
     Log::Fatal("data cannot be null.");
   }
   auto p_dataset = reinterpret_cast<Dataset*>(dataset);
-  auto get_row_fun = RowFunctionFromCSR<int>(indptr, indptr_type, indices, data, data_type, nindptr, nelem);
   int32_t nrow = static_cast<int32_t>(nindptr - 1);
   if (p_dataset->has_raw()) {
     p_dataset->ResizeRaw(p_dataset->num_numeric_features() + nrow);
@@ -1262,17 +1700,9 @@ int LGBM_DatasetPushRowsByCSRWithMetadata(DatasetHandle dataset,
 
   const int max_omp_threads = p_dataset->omp_max_threads() > 0 ? p_dataset->omp_max_threads() : OMP_NUM_THREADS();
 
-  OMP_INIT_EX();
-#pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static)
-  for (int i = 0; i < nrow; ++i) {
-    OMP_LOOP_EX_BEGIN();
-    // convert internal thread id to be unique based on external thread id
-    const int internal_tid = omp_get_thread_num() + (max_omp_threads * tid);
-    auto one_row = get_row_fun(i);
-    p_dataset->PushOneRow(internal_tid, static_cast<data_size_t>(start_row + i), one_row);
-    OMP_LOOP_EX_END();
-  }
-  OMP_THROW_EX();
+  // convert internal thread id to be unique based on external thread id
+  PushRowsVisitor visitor = {p_dataset, static_cast<data_size_t>(start_row), nrow, max_omp_threads * tid};
+  VisitCSRMatrix(indptr, indptr_type, indices, data, data_type, &visitor);
 
   p_dataset->InsertMetadataAt(static_cast<int32_t>(start_row), nrow, labels, weights, init_scores, queries);
 
@@ -1296,6 +1726,132 @@ int LGBM_DatasetMarkFinished(DatasetHandle dataset) {
   API_END();
 }
 
+static void CheckAppendMetadata(const Dataset* dataset,
+                                const float* label,
+                                const float* weight,
+                                const double* init_score,
+                                const int32_t* query) {
+  const Metadata& metadata = dataset->metadata();
+  if (label == nullptr) {
+    Log::Fatal("label cannot be null when appending rows.");
+  }
+  if ((metadata.weights() != nullptr) != (weight != nullptr)) {
+    Log::Fatal("weight should be provided when appending rows if and only if the Dataset has weights.");
+  }
+  if ((metadata.init_score() != nullptr) != (init_score != nullptr)) {
+    Log::Fatal("init_score should be provided when appending rows if and only if the Dataset has initial scores.");
+  }
+  if ((metadata.query_boundaries() != nullptr) != (query != nullptr)) {
+    Log::Fatal("query should be provided when appending rows if and only if the Dataset has queries.");
+  }
+}
+
+int LGBM_DatasetAppendRows(DatasetHandle dataset,
+                           const void* data,
+                           int data_type,
+                           int32_t nrow,
+                           int32_t ncol,
+                           const float* label,
+                           const float* weight,
+                           const double* init_score,
+                           const int32_t* query) {
+  API_BEGIN();
+#ifdef LABEL_T_USE_DOUBLE
+  Log::Fatal("Don't support LABEL_T_USE_DOUBLE");
+#endif
+  if (!data) {
+    Log::Fatal("data cannot be null.");
+  }
+  auto p_dataset = reinterpret_cast<Dataset*>(dataset);
+  CheckAppendMetadata(p_dataset, label, weight, init_score, query);
+  const data_size_t start_row = p_dataset->InitAppend(nrow);
+  PushRowsVisitor visitor = {p_dataset, start_row, nrow, 0};
+  VisitDenseMatrix(data, data_type, nrow, ncol, 1, &visitor);
+  p_dataset->InsertMetadataAt(start_row, nrow, label, weight, init_score, query);
+  p_dataset->FinishLoad();
+  API_END();
+}
+
+int LGBM_DatasetAppendRowsByCSR(DatasetHandle dataset,
+                                const void* indptr,
+                                int indptr_type,
+                                const int32_t* indices,
+                                const void* data,
+                                int data_type,
+                                int64_t nindptr,
+                                int64_t,
+                                const float* label,
+                                const float* weight,
+                                const double* init_score,
+                                const int32_t* query) {
+  API_BEGIN();
+#ifdef LABEL_T_USE_DOUBLE
+  Log::Fatal("Don't support LABEL_T_USE_DOUBLE");
+#endif
+  if (!data) {
+    Log::Fatal("data cannot be null.");
+  }
+  auto p_dataset = reinterpret_cast<Dataset*>(dataset);
+  CheckAppendMetadata(p_dataset, label, weight, init_score, query);
+  int32_t nrow = static_cast<int32_t>(nindptr - 1);
+  const data_size_t start_row = p_dataset->InitAppend(nrow);
+  PushRowsVisitor visitor = {p_dataset, start_row, nrow, 0};
+  VisitCSRMatrix(indptr, indptr_type, indices, data, data_type, &visitor);
+  p_dataset->InsertMetadataAt(start_row, nrow, label, weight, init_score, query);
+  p_dataset->FinishLoad();
+  API_END();
+}
+
+int LGBM_DatasetSlideWindow(DatasetHandle dataset,
+                            const void* data,
+                            int data_type,
+                            int32_t nrow,
+                            int32_t ncol,
+                            const float* label,
+                            const float* weight,
+                            const double* init_score,
+                            const double* timestamp,
+                            double weight_half_life) {
+  API_BEGIN();
+#ifdef LABEL_T_USE_DOUBLE
+  Log::Fatal("Don't support LABEL_T_USE_DOUBLE");
+#endif
+  if (!data) {
+    Log::Fatal("data cannot be null.");
+  }
+  auto p_dataset = reinterpret_cast<Dataset*>(dataset);
+  auto get_row_fun = RowPairFunctionFromDenseMatric(data, nrow, ncol, data_type, 1);
+  p_dataset->SlideWindow(get_row_fun, nrow, label, weight, init_score, timestamp, weight_half_life);
+  API_END();
+}
+
+int LGBM_DatasetSlideWindowByCSR(DatasetHandle dataset,
+                                 const void* indptr,
+                                 int indptr_type,
+                                 const int32_t* indices,
+                                 const void* data,
+                                 int data_type,
+                                 int64_t nindptr,
+                                 int64_t nelem,
+                                 const float* label,
+                                 const float* weight,
+                                 const double* init_score,
+                                 const double* timestamp,
+                                 double weight_half_life) {
+  API_BEGIN();
+#ifdef LABEL_T_USE_DOUBLE
+  Log::Fatal("Don't support LABEL_T_USE_DOUBLE");
+#endif
+  if (!data) {
+    Log::Fatal("data cannot be null.");
+  }
+  auto p_dataset = reinterpret_cast<Dataset*>(dataset);
+  auto get_row_fun = RowFunctionFromCSR<int>(indptr, indptr_type, indices, data, data_type, nindptr, nelem);
+  p_dataset->SlideWindow(get_row_fun, static_cast<data_size_t>(nindptr - 1), label, weight, init_score, timestamp,
+                         weight_half_life);
+  API_END();
+}
+
 int LGBM_DatasetCreateFromMat(const void* data,
                               int data_type,
                               int32_t nrow,
@@ -1335,11 +1891,6 @@ int LGBM_DatasetCreateFromMats(int32_t nmat,
     total_nrow += nrow[j];
   }
 
-  std::vector<std::function<std::vector<double>(int row_idx)>> get_row_fun;
-  for (int j = 0; j < nmat; ++j) {
-    get_row_fun.push_back(RowFunctionFromDenseMatric(data[j], nrow[j], ncol, data_type, is_row_major[j]));
-  }
-
   if (reference == nullptr) {
     // sample data first
     auto sample_indices = CreateSampleIndices(total_nrow, config);
@@ -1347,6 +1898,8 @@ int LGBM_DatasetCreateFromMats(int32_t nmat,
     std::vector<std::vector<double>> sample_values(ncol);
     std::vector<std::vector<int>> sample_idx(ncol);
 
+    // samples of each matrix, as (index of the sample, row in the matrix)
+    std::vector<std::vector<std::pair<int, int>>> mat_samples(nmat);
     int offset = 0;
     int j = 0;
     for (size_t i = 0; i < sample_indices.size(); ++i) {
@@ -1355,14 +1908,11 @@ int LGBM_DatasetCreateFromMats(int32_t nmat,
         offset += nrow[j];
         ++j;
       }
-
-      auto row = get_row_fun[j](static_cast<int>(idx - offset));
-      for (size_t k = 0; k < row.size(); ++k) {
-        if (std::fabs(row[k]) > kZeroThreshold || std::isnan(row[k])) {
-          sample_values[k].emplace_back(row[k]);
-          sample_idx[k].emplace_back(static_cast<int>(i));
-        }
-      }
+      mat_samples[j].emplace_back(static_cast<int>(i), static_cast<int>(idx - offset));
+    }
+    for (j = 0; j < nmat; ++j) {
+      SampleRowsVisitor visitor = {&mat_samples[j], ncol, &sample_values, &sample_idx};
+      VisitDenseMatrix(data[j], data_type, nrow[j], ncol, is_row_major[j], &visitor);
     }
     DatasetLoader loader(config, nullptr, 1, nullptr);
     ret.reset(loader.ConstructFromSampleData(Vector2Ptr<double>(&sample_values).data(),
@@ -1382,16 +1932,8 @@ int LGBM_DatasetCreateFromMats(int32_t nmat,
   }
   int32_t start_row = 0;
   for (int j = 0; j < nmat; ++j) {
-    OMP_INIT_EX();
-    #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static)
-    for (int i = 0; i < nrow[j]; ++i) {
-      OMP_LOOP_EX_BEGIN();
-      const int tid = omp_get_thread_num();
-      auto one_row = get_row_fun[j](i);
-      ret->PushOneRow(tid, start_row + i, one_row);
-      OMP_LOOP_EX_END();
-    }
-    OMP_THROW_EX();
+    PushMatrixVisitor visitor = {ret.get(), start_row, nrow[j]};
+    VisitDenseMatrix(data[j], data_type, nrow[j], ncol, is_row_major[j], &visitor);
 
     start_row += nrow[j];
   }
@@ -1406,7 +1948,7 @@ int LGBM_DatasetCreateFromCSR(const void* indptr,
                               const void* data,
                               int data_type,
                               int64_t nindptr,
-                              int64_t nelem,
+                              int64_t,
                               int64_t num_col,
                               const char* parameters,
                               const DatasetHandle reference,
@@ -1422,7 +1964,6 @@ int LGBM_DatasetCreateFromCSR(const void* indptr,
   config.Set(param);
   OMP_SET_NUM_THREADS(config.num_threads);
   std::unique_ptr<Dataset> ret;
-  auto get_row_fun = RowFunctionFromCSR<int>(indptr, indptr_type, indices, data, data_type, nindptr, nelem);
   int32_t nrow = static_cast<int32_t>(nindptr - 1);
   if (reference == nullptr) {
     // sample data first
@@ -1430,17 +1971,13 @@ int LGBM_DatasetCreateFromCSR(const void* indptr,
     int sample_cnt = static_cast<int>(sample_indices.size());
     std::vector<std::vector<double>> sample_values(num_col);
     std::vector<std::vector<int>> sample_idx(num_col);
+    std::vector<std::pair<int, int>> samples;
+    samples.reserve(sample_indices.size());
     for (size_t i = 0; i < sample_indices.size(); ++i) {
-      auto idx = sample_indices[i];
-      auto row = get_row_fun(static_cast<int>(idx));
-      for (std::pair<int, double>& inner_data : row) {
-        CHECK_LT(inner_data.first, num_col);
-        if (std::fabs(inner_data.second) > kZeroThreshold || std::isnan(inner_data.second)) {
-          sample_values[inner_data.first].emplace_back(inner_data.second);
-          sample_idx[inner_data.first].emplace_back(static_cast<int>(i));
-        }
-      }
+      samples.emplace_back(static_cast<int>(i), static_cast<int>(sample_indices[i]));
     }
+    SampleRowsVisitor visitor = {&samples, num_col, &sample_values, &sample_idx};
+    VisitCSRMatrix(indptr, indptr_type, indices, data, data_type, &visitor);
     DatasetLoader loader(config, nullptr, 1, nullptr);
     ret.reset(loader.ConstructFromSampleData(Vector2Ptr<double>(&sample_values).data(),
                                              Vector2Ptr<int>(&sample_idx).data(),
@@ -1457,16 +1994,8 @@ int LGBM_DatasetCreateFromCSR(const void* indptr,
       ret->ResizeRaw(nrow);
     }
   }
-  OMP_INIT_EX();
-  #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static)
-  for (int i = 0; i < static_cast<int>(nindptr - 1); ++i) {
-    OMP_LOOP_EX_BEGIN();
-    const int tid = omp_get_thread_num();
-    auto one_row = get_row_fun(i);
-    ret->PushOneRow(tid, i, one_row);
-    OMP_LOOP_EX_END();
-  }
-  OMP_THROW_EX();
+  PushRowsVisitor visitor = {ret.get(), 0, nrow, 0};
+  VisitCSRMatrix(indptr, indptr_type, indices, data, data_type, &visitor);
   ret->FinishLoad();
   *out = ret.release();
   API_END();
@@ -1667,19 +2196,15 @@ int LGBM_DatasetCreateFromArrow(int64_t n_chunks,
       sample_values[j].reserve(sample_indices.size());
       sample_idx[j].reserve(sample_indices.size());
 
-      // The chunks are iterated over in the inner loop as columns can be treated independently.
-      int last_idx = 0;
-      int i = 0;
-      auto it = table.get_column(j).begin<double>();
-      for (auto idx : sample_indices) {
-        std::advance(it, idx - last_idx);
-        auto v = *it;
+      // The sampled values of each chunk are converted in one pass, as columns can be treated independently.
+      std::vector<double> values(sample_indices.size());
+      table.get_column(j).gather(sample_indices.data(), static_cast<int64_t>(sample_indices.size()), values.data());
+      for (int i = 0; i < sample_count; ++i) {
+        const double v = values[i];
         if (std::fabs(v) > kZeroThreshold || std::isnan(v)) {
           sample_values[j].emplace_back(v);
           sample_idx[j].emplace_back(i);
         }
-        last_idx = idx;
-        i++;
       }
       OMP_LOOP_EX_END();
     }
@@ -1703,20 +2228,9 @@ int LGBM_DatasetCreateFromArrow(int64_t n_chunks,
   }
 
   // After sampling and properly initializing all bins, we can add our data to the dataset. Here,
-  // we parallelize across rows.
-  OMP_INIT_EX();
-  #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static)
-  for (int64_t j = 0; j < table.get_num_columns(); ++j) {
-    OMP_LOOP_EX_BEGIN();
-    const int tid = omp_get_thread_num();
-    data_size_t idx = 0;
-    auto column = table.get_column(j);
-    for (auto it = column.begin<double>(), end = column.end<double>(); it != end; ++it) {
-      ret->PushOneValue(tid, idx++, j, *it);
-    }
-    OMP_LOOP_EX_END();
-  }
-  OMP_THROW_EX();
+  // we parallelize across feature groups and bin each column in blocks converted from the Arrow buffers.
+  ArrowColumnReader reader = {&table};
+  PushColumnsByGroup(ret.get(), 0, static_cast<data_size_t>(table.get_num_rows()), reader);
 
   ret->FinishLoad();
   *out = ret.release();
@@ -2000,6 +2514,13 @@ int LGBM_BoosterShuffleModels(BoosterHandle handle, int start_iter, int end_iter
   API_END();
 }
 
+int LGBM_BoosterOptimizeModels(BoosterHandle handle, int start_iter, int end_iter, double merge_tolerance) {
+  API_BEGIN();
+  Booster* ref_booster = reinterpret_cast<Booster*>(handle);
+  ref_booster->OptimizeModels(start_iter, end_iter, merge_tolerance);
+  API_END();
+}
+
 int LGBM_BoosterMerge(BoosterHandle handle,
                       BoosterHandle other_handle) {
   API_BEGIN();
@@ -2220,7 +2741,8 @@ int LGBM_BoosterCalcNumPredict(BoosterHandle handle,
   API_BEGIN();
   Booster* ref_booster = reinterpret_cast<Booster*>(handle);
   *out_len = static_cast<int64_t>(num_row) * ref_booster->GetBoosting()->NumPredictOneRow(start_iteration,
-    num_iteration, predict_type == C_API_PREDICT_LEAF_INDEX, predict_type == C_API_PREDICT_CONTRIB);
+    num_iteration, predict_type == C_API_PREDICT_LEAF_INDEX, predict_type == C_API_PREDICT_CONTRIB,
+    predict_type == C_API_PREDICT_INTERACTION);
   API_END();
 }
 
@@ -2243,7 +2765,7 @@ int LGBM_BoosterPredictForCSR(BoosterHandle handle,
                               const void* data,
                               int data_type,
                               int64_t nindptr,
-                              int64_t nelem,
+                              int64_t,
                               int64_t num_col,
                               int predict_type,
                               int start_iteration,
@@ -2262,10 +2784,10 @@ int LGBM_BoosterPredictForCSR(BoosterHandle handle,
   config.Set(param);
   OMP_SET_NUM_THREADS(config.num_threads);
   Booster* ref_booster = reinterpret_cast<Booster*>(handle);
-  auto get_row_fun = RowFunctionFromCSR<int>(indptr, indptr_type, indices, data, data_type, nindptr, nelem);
   int nrow = static_cast<int>(nindptr - 1);
-  ref_booster->Predict(start_iteration, num_iteration, predict_type, nrow, static_cast<int>(num_col), get_row_fun,
-                       config, out_result, out_len);
+  PredictRowsVisitor visitor = {ref_booster, start_iteration, num_iteration, predict_type, nrow,
+                                static_cast<int>(num_col), &config, out_result, out_len};
+  VisitCSRMatrix(indptr, indptr_type, indices, data, data_type, &visitor);
   API_END();
 }
 
@@ -2359,8 +2881,8 @@ int LGBM_BoosterPredictForCSRSingleRow(BoosterHandle handle,
                                        const int32_t* indices,
                                        const void* data,
                                        int data_type,
-                                       int64_t nindptr,
-                                       int64_t nelem,
+                                       int64_t,
+                                       int64_t,
                                        int64_t num_col,
                                        int predict_type,
                                        int start_iteration,
@@ -2379,9 +2901,10 @@ int LGBM_BoosterPredictForCSRSingleRow(BoosterHandle handle,
   config.Set(param);
   OMP_SET_NUM_THREADS(config.num_threads);
   Booster* ref_booster = reinterpret_cast<Booster*>(handle);
-  auto get_row_fun = RowFunctionFromCSR<int>(indptr, indptr_type, indices, data, data_type, nindptr, nelem);
   ref_booster->SetSingleRowPredictorInner(start_iteration, num_iteration, predict_type, config);
-  ref_booster->PredictSingleRow(predict_type, static_cast<int32_t>(num_col), get_row_fun, config, out_result, out_len);
+  PredictSingleRowVisitor visitor = {ref_booster, predict_type, static_cast<int>(num_col), &config,
+                                     out_result, out_len};
+  VisitCSRMatrix(indptr, indptr_type, indices, data, data_type, &visitor);
   API_END();
 }
 
@@ -2416,14 +2939,14 @@ int LGBM_BoosterPredictForCSRSingleRowFast(FastConfigHandle fastConfig_handle,
                                            const int indptr_type,
                                            const int32_t* indices,
                                            const void* data,
-                                           const int64_t nindptr,
-                                           const int64_t nelem,
+                                           const int64_t,
+                                           const int64_t,
                                            int64_t* out_len,
                                            double* out_result) {
   API_BEGIN();
   SingleRowPredictor *single_row_predictor = reinterpret_cast<SingleRowPredictor*>(fastConfig_handle);
-  auto get_row_fun = RowFunctionFromCSR<int>(indptr, indptr_type, indices, data, single_row_predictor->data_type, nindptr, nelem);
-  single_row_predictor->Predict(get_row_fun, out_result, out_len);
+  FastPredictVisitor visitor = {single_row_predictor, out_result, out_len};
+  VisitCSRMatrix(indptr, indptr_type, indices, data, single_row_predictor->data_type, &visitor);
   API_END();
 }
 
@@ -2514,9 +3037,9 @@ int LGBM_BoosterPredictForMat(BoosterHandle handle,
   config.Set(param);
   OMP_SET_NUM_THREADS(config.num_threads);
   Booster* ref_booster = reinterpret_cast<Booster*>(handle);
-  auto get_row_fun = RowPairFunctionFromDenseMatric(data, nrow, ncol, data_type, is_row_major);
-  ref_booster->Predict(start_iteration, num_iteration, predict_type, nrow, ncol, get_row_fun,
-                       config, out_result, out_len);
+  PredictRowsVisitor visitor = {ref_booster, start_iteration, num_iteration, predict_type, nrow, ncol,
+                                &config, out_result, out_len};
+  VisitDenseMatrix(data, data_type, nrow, ncol, is_row_major, &visitor);
   API_END();
 }
 
@@ -2537,9 +3060,9 @@ int LGBM_BoosterPredictForMatSingleRow(BoosterHandle handle,
   config.Set(param);
   OMP_SET_NUM_THREADS(config.num_threads);
   Booster* ref_booster = reinterpret_cast<Booster*>(handle);
-  auto get_row_fun = RowPairFunctionFromDenseMatric(data, 1, ncol, data_type, is_row_major);
   ref_booster->SetSingleRowPredictorInner(start_iteration, num_iteration, predict_type, config);
-  ref_booster->PredictSingleRow(predict_type, ncol, get_row_fun, config, out_result, out_len);
+  PredictSingleRowVisitor visitor = {ref_booster, predict_type, ncol, &config, out_result, out_len};
+  VisitDenseMatrix(data, data_type, 1, ncol, is_row_major, &visitor);
   API_END();
 }
 
@@ -2570,8 +3093,8 @@ int LGBM_BoosterPredictForMatSingleRowFast(FastConfigHandle fastConfig_handle,
   API_BEGIN();
   SingleRowPredictor *single_row_predictor = reinterpret_cast<SingleRowPredictor*>(fastConfig_handle);
   // Single row in row-major format:
-  auto get_row_fun = RowPairFunctionFromDenseMatric(data, 1, single_row_predictor->num_cols, single_row_predictor->data_type, 1);
-  single_row_predictor->Predict(get_row_fun, out_result, out_len);
+  FastPredictVisitor visitor = {single_row_predictor, out_result, out_len};
+  VisitDenseMatrix(data, single_row_predictor->data_type, 1, single_row_predictor->num_cols, 1, &visitor);
   API_END();
 }
 
@@ -2593,8 +3116,9 @@ int LGBM_BoosterPredictForMats(BoosterHandle handle,
   config.Set(param);
   OMP_SET_NUM_THREADS(config.num_threads);
   Booster* ref_booster = reinterpret_cast<Booster*>(handle);
-  auto get_row_fun = RowPairFunctionFromDenseRows(data, ncol, data_type);
-  ref_booster->Predict(start_iteration, num_iteration, predict_type, nrow, ncol, get_row_fun, config, out_result, out_len);
+  PredictRowsVisitor visitor = {ref_booster, start_iteration, num_iteration, predict_type, nrow, ncol,
+                                &config, out_result, out_len};
+  VisitDenseRows(data, data_type, ncol, &visitor);
   API_END();
 }
 
@@ -2661,6 +3185,16 @@ int LGBM_BoosterSaveModel(BoosterHandle handle,
   API_END();
 }
 
+int LGBM_BoosterSaveModelToC(BoosterHandle handle,
+                             int start_iteration,
+                             int num_iteration,
+                             const char* filename) {
+  API_BEGIN();
+  Booster* ref_booster = reinterpret_cast<Booster*>(handle);
+  ref_booster->SaveModelToC(start_iteration, num_iteration, filename);
+  API_END();
+}
+
 int LGBM_BoosterSaveModelToString(BoosterHandle handle,
                                   int start_iteration,
                                   int num_iteration,
@@ -2854,23 +3388,6 @@ RowPairFunctionFromDenseMatric(const void* data, int num_row, int num_col, int d
   return nullptr;
 }
 
-// data is array of pointers to individual rows
-std::function<std::vector<std::pair<int, double>>(int row_idx)>
-RowPairFunctionFromDenseRows(const void** data, int num_col, int data_type) {
-  return [=](int row_idx) {
-    auto inner_function = RowFunctionFromDenseMatric(data[row_idx], 1, num_col, data_type, /* is_row_major */ true);
-    auto raw_values = inner_function(0);
-    std::vector<std::pair<int, double>> ret;
-    ret.reserve(raw_values.size());
-    for (int i = 0; i < static_cast<int>(raw_values.size()); ++i) {
-      if (std::fabs(raw_values[i]) > kZeroThreshold || std::isnan(raw_values[i])) {
-        ret.emplace_back(i, raw_values[i]);
-      }
-    }
-    return ret;
-  };
-}
-
 template<typename T, typename T1, typename T2>
 std::function<std::vector<std::pair<int, double>>(T idx)>
 RowFunctionFromCSR_helper(const void* indptr, const int32_t* indices, const void* data) {
@@ -505,6 +505,53 @@ namespace LightGBM {
     }
   }
 
+  void BinMapper::ValueToBin(const double* values, data_size_t num_values, uint32_t* bins) const {
+    int num_search = num_bin_ - 1;
+    if (missing_type_ == MissingType::NaN) {
+      num_search -= 1;
+    }
+    if (bin_type_ != BinType::NumericalBin || num_search <= 0) {
+      for (data_size_t i = 0; i < num_values; ++i) {
+        bins[i] = ValueToBin(values[i]);
+      }
+      return;
+    }
+    // The number of search steps only depends on num_search, so a block of values is searched in lockstep:
+    // the steps of different values are independent, which hides the latency of the loads and lets the
+    // compiler vectorize the inner loops.
+    const int kBlockSize = 64;
+    const double* upper_bounds = bin_upper_bound_.data();
+    const uint32_t nan_bin = missing_type_ == MissingType::NaN ? static_cast<uint32_t>(num_bin_ - 1) : 0;
+    double block_values[kBlockSize];
+    int block_bins[kBlockSize];
+    for (data_size_t start = 0; start < num_values; start += kBlockSize) {
+      const int cnt = static_cast<int>(std::min<data_size_t>(kBlockSize, num_values - start));
+      for (int i = 0; i < cnt; ++i) {
+        const double value = values[start + i];
+        block_values[i] = std::isnan(value) ? 0.0 : value;
+        block_bins[i] = 0;
+      }
+      int len = num_search;
+      while (len > 1) {
+        const int half = len >> 1;
+        for (int i = 0; i < cnt; ++i) {
+          block_bins[i] += (upper_bounds[block_bins[i] + half] < block_values[i]) ? half : 0;
+        }
+        len -= half;
+      }
+      for (int i = 0; i < cnt; ++i) {
+        bins[start + i] = static_cast<uint32_t>(block_bins[i] + (upper_bounds[block_bins[i]] < block_values[i]));
+      }
+      if (nan_bin > 0) {
+        for (int i = 0; i < cnt; ++i) {
+          if (std::isnan(values[start + i])) {
+            bins[start + i] = nan_bin;
+          }
+        }
+      }
+    }
+  }
+
   void BinMapper::CopyTo(char * buffer) const {
     std::memcpy(buffer, &num_bin_, sizeof(num_bin_));
     buffer += VirtualFileWriter::AlignedSize(sizeof(num_bin_));
@@ -172,6 +172,8 @@ void GetTaskType(const std::unordered_map<std::string, std::string>& params, Tas
       *task = TaskType::kPredict;
     } else if (value == std::string("convert_model")) {
       *task = TaskType::kConvertModel;
+    } else if (value == std::string("optimize_model")) {
+      *task = TaskType::kOptimizeModel;
     } else if (value == std::string("refit") || value == std::string("refit_tree")) {
       *task = TaskType::KRefitTree;
     } else if (value == std::string("save_binary")) {
@@ -259,6 +259,8 @@ const std::unordered_set<std::string>& Config::parameter_set() {
   "quant_train_renew_leaf",
   "stochastic_rounding",
   "linear_tree",
+  "linear_raw_type",
+  "linear_raw_dictionary",
   "max_bin",
   "max_bin_by_feature",
   "min_data_in_bin",
@@ -266,6 +268,11 @@ const std::unordered_set<std::string>& Config::parameter_set() {
   "data_random_seed",
   "is_enable_sparse",
   "enable_bundle",
+  "max_bundle_search_groups",
+  "input_bundle_plan",
+  "output_bundle_plan",
+  "input_dataset_schema",
+  "output_dataset_schema",
   "use_missing",
   "zero_as_missing",
   "feature_pre_filter",
@@ -290,9 +297,15 @@ const std::unordered_set<std::string>& Config::parameter_set() {
   "pred_early_stop",
   "pred_early_stop_freq",
   "pred_early_stop_margin",
+  "pred_early_stop_type",
+  "pred_early_stop_confidence",
+  "pred_early_stop_top_k",
+  "pred_early_stop_batch_size",
+  "pred_quantized_thresholds",
   "output_result",
   "convert_model_language",
   "convert_model",
+  "optimize_merge_tolerance",
   "objective_seed",
   "num_class",
   "is_unbalance",
@@ -308,6 +321,7 @@ const std::unordered_set<std::string>& Config::parameter_set() {
   "lambdarank_norm",
   "label_gain",
   "lambdarank_position_bias_regularization",
+  "objective_fast_math",
   "metric",
   "metric_freq",
   "is_provide_training_metric",
@@ -518,6 +532,10 @@ void Config::GetMembersFromString(const std::unordered_map<std::string, std::str
 
   GetBool(params, "linear_tree", &linear_tree);
 
+  GetString(params, "linear_raw_type", &linear_raw_type);
+
+  GetBool(params, "linear_raw_dictionary", &linear_raw_dictionary);
+
   GetInt(params, "max_bin", &max_bin);
   CHECK_GT(max_bin, 1);
 
@@ -537,6 +555,17 @@ void Config::GetMembersFromString(const std::unordered_map<std::string, std::str
 
   GetBool(params, "enable_bundle", &enable_bundle);
 
+  GetInt(params, "max_bundle_search_groups", &max_bundle_search_groups);
+  CHECK_GT(max_bundle_search_groups, 0);
+
+  GetString(params, "input_bundle_plan", &input_bundle_plan);
+
+  GetString(params, "output_bundle_plan", &output_bundle_plan);
+
+  GetString(params, "input_dataset_schema", &input_dataset_schema);
+
+  GetString(params, "output_dataset_schema", &output_dataset_schema);
+
   GetBool(params, "use_missing", &use_missing);
 
   GetBool(params, "zero_as_missing", &zero_as_missing);
@@ -585,12 +614,29 @@ void Config::GetMembersFromString(const std::unordered_map<std::string, std::str
 
   GetDouble(params, "pred_early_stop_margin", &pred_early_stop_margin);
 
+  GetString(params, "pred_early_stop_type", &pred_early_stop_type);
+
+  GetDouble(params, "pred_early_stop_confidence", &pred_early_stop_confidence);
+  CHECK_GT(pred_early_stop_confidence, 0.0);
+  CHECK_LT(pred_early_stop_confidence, 1.0);
+
+  GetInt(params, "pred_early_stop_top_k", &pred_early_stop_top_k);
+  CHECK_GT(pred_early_stop_top_k, 0);
+
+  GetInt(params, "pred_early_stop_batch_size", &pred_early_stop_batch_size);
+  CHECK_GT(pred_early_stop_batch_size, 0);
+
+  GetBool(params, "pred_quantized_thresholds", &pred_quantized_thresholds);
+
   GetString(params, "output_result", &output_result);
 
   GetString(params, "convert_model_language", &convert_model_language);
 
   GetString(params, "convert_model", &convert_model);
 
+  GetDouble(params, "optimize_merge_tolerance", &optimize_merge_tolerance);
+  CHECK_GE(optimize_merge_tolerance, 0.0);
+
   GetInt(params, "objective_seed", &objective_seed);
 
   GetInt(params, "num_class", &num_class);
@@ -633,6 +679,8 @@ void Config::GetMembersFromString(const std::unordered_map<std::string, std::str
   GetDouble(params, "lambdarank_position_bias_regularization", &lambdarank_position_bias_regularization);
   CHECK_GE(lambdarank_position_bias_regularization, 0.0);
 
+  GetBool(params, "objective_fast_math", &objective_fast_math);
+
   GetInt(params, "metric_freq", &metric_freq);
   CHECK_GT(metric_freq, 0);
 
@@ -742,6 +790,8 @@ std::string Config::SaveMembersToString() const {
   str_buf << "[quant_train_renew_leaf: " << quant_train_renew_leaf << "]\n";
   str_buf << "[stochastic_rounding: " << stochastic_rounding << "]\n";
   str_buf << "[linear_tree: " << linear_tree << "]\n";
+  str_buf << "[linear_raw_type: " << linear_raw_type << "]\n";
+  str_buf << "[linear_raw_dictionary: " << linear_raw_dictionary << "]\n";
   str_buf << "[max_bin: " << max_bin << "]\n";
   str_buf << "[max_bin_by_feature: " << Common::Join(max_bin_by_feature, ",") << "]\n";
   str_buf << "[min_data_in_bin: " << min_data_in_bin << "]\n";
@@ -749,6 +799,11 @@ std::string Config::SaveMembersToString() const {
   str_buf << "[data_random_seed: " << data_random_seed << "]\n";
   str_buf << "[is_enable_sparse: " << is_enable_sparse << "]\n";
   str_buf << "[enable_bundle: " << enable_bundle << "]\n";
+  str_buf << "[max_bundle_search_groups: " << max_bundle_search_groups << "]\n";
+  str_buf << "[input_bundle_plan: " << input_bundle_plan << "]\n";
+  str_buf << "[output_bundle_plan: " << output_bundle_plan << "]\n";
+  str_buf << "[input_dataset_schema: " << input_dataset_schema << "]\n";
+  str_buf << "[output_dataset_schema: " << output_dataset_schema << "]\n";
   str_buf << "[use_missing: " << use_missing << "]\n";
   str_buf << "[zero_as_missing: " << zero_as_missing << "]\n";
   str_buf << "[feature_pre_filter: " << feature_pre_filter << "]\n";
@@ -778,6 +833,7 @@ std::string Config::SaveMembersToString() const {
   str_buf << "[lambdarank_norm: " << lambdarank_norm << "]\n";
   str_buf << "[label_gain: " << Common::Join(label_gain, ",") << "]\n";
   str_buf << "[lambdarank_position_bias_regularization: " << lambdarank_position_bias_regularization << "]\n";
+  str_buf << "[objective_fast_math: " << objective_fast_math << "]\n";
   str_buf << "[eval_at: " << Common::Join(eval_at, ",") << "]\n";
   str_buf << "[multi_error_top_k: " << multi_error_top_k << "]\n";
   str_buf << "[auc_mu_weights: " << Common::Join(auc_mu_weights, ",") << "]\n";
@@ -872,6 +928,8 @@ const std::unordered_map<std::string, std::vector<std::string>>& Config::paramet
     {"quant_train_renew_leaf", {}},
     {"stochastic_rounding", {}},
     {"linear_tree", {"linear_trees"}},
+    {"linear_raw_type", {}},
+    {"linear_raw_dictionary", {}},
     {"max_bin", {"max_bins"}},
     {"max_bin_by_feature", {}},
     {"min_data_in_bin", {}},
@@ -879,6 +937,11 @@ const std::unordered_map<std::string, std::vector<std::string>>& Config::paramet
     {"data_random_seed", {"data_seed"}},
     {"is_enable_sparse", {"is_sparse", "enable_sparse", "sparse"}},
     {"enable_bundle", {"is_enable_bundle", "bundle"}},
+    {"max_bundle_search_groups", {}},
+    {"input_bundle_plan", {}},
+    {"output_bundle_plan", {}},
+    {"input_dataset_schema", {}},
+    {"output_dataset_schema", {}},
     {"use_missing", {}},
     {"zero_as_missing", {}},
     {"feature_pre_filter", {}},
@@ -903,9 +966,15 @@ const std::unordered_map<std::string, std::vector<std::string>>& Config::paramet
     {"pred_early_stop", {}},
     {"pred_early_stop_freq", {}},
     {"pred_early_stop_margin", {}},
+    {"pred_early_stop_type", {}},
+    {"pred_early_stop_confidence", {}},
+    {"pred_early_stop_top_k", {}},
+    {"pred_early_stop_batch_size", {}},
+    {"pred_quantized_thresholds", {}},
     {"output_result", {"predict_result", "prediction_result", "predict_name", "prediction_name", "pred_name", "name_pred"}},
     {"convert_model_language", {}},
     {"convert_model", {"convert_model_file"}},
+    {"optimize_merge_tolerance", {}},
     {"objective_seed", {}},
     {"num_class", {"num_classes"}},
     {"is_unbalance", {"unbalance", "unbalanced_sets"}},
@@ -921,6 +990,7 @@ const std::unordered_map<std::string, std::vector<std::string>>& Config::paramet
     {"lambdarank_norm", {}},
     {"label_gain", {}},
     {"lambdarank_position_bias_regularization", {}},
+    {"objective_fast_math", {}},
     {"metric", {"metrics", "metric_types"}},
     {"metric_freq", {"output_freq"}},
     {"is_provide_training_metric", {"training_metric", "is_training_metric", "train_metric"}},
@@ -1018,6 +1088,8 @@ const std::unordered_map<std::string, std::string>& Config::ParameterTypes() {
     {"quant_train_renew_leaf", "bool"},
     {"stochastic_rounding", "bool"},
     {"linear_tree", "bool"},
+    {"linear_raw_type", "string"},
+    {"linear_raw_dictionary", "bool"},
     {"max_bin", "int"},
     {"max_bin_by_feature", "vector<int>"},
     {"min_data_in_bin", "int"},
@@ -1025,6 +1097,11 @@ const std::unordered_map<std::string, std::string>& Config::ParameterTypes() {
     {"data_random_seed", "int"},
     {"is_enable_sparse", "bool"},
     {"enable_bundle", "bool"},
+    {"max_bundle_search_groups", "int"},
+    {"input_bundle_plan", "string"},
+    {"output_bundle_plan", "string"},
+    {"input_dataset_schema", "string"},
+    {"output_dataset_schema", "string"},
     {"use_missing", "bool"},
     {"zero_as_missing", "bool"},
     {"feature_pre_filter", "bool"},
@@ -1049,9 +1126,15 @@ const std::unordered_map<std::string, std::string>& Config::ParameterTypes() {
     {"pred_early_stop", "bool"},
     {"pred_early_stop_freq", "int"},
     {"pred_early_stop_margin", "double"},
+    {"pred_early_stop_type", "string"},
+    {"pred_early_stop_confidence", "double"},
+    {"pred_early_stop_top_k", "int"},
+    {"pred_early_stop_batch_size", "int"},
+    {"pred_quantized_thresholds", "bool"},
     {"output_result", "string"},
     {"convert_model_language", "string"},
     {"convert_model", "string"},
+    {"optimize_merge_tolerance", "double"},
     {"objective_seed", "int"},
     {"num_class", "int"},
     {"is_unbalance", "bool"},
@@ -1067,6 +1150,7 @@ const std::unordered_map<std::string, std::string>& Config::ParameterTypes() {
     {"lambdarank_norm", "bool"},
     {"label_gain", "vector<double>"},
     {"lambdarank_position_bias_regularization", "double"},
+    {"objective_fast_math", "bool"},
     {"metric", "vector<string>"},
     {"metric_freq", "int"},
     {"is_provide_training_metric", "bool"},
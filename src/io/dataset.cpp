@@ -8,17 +8,25 @@
 #include <LightGBM/feature_group.h>
 #include <LightGBM/cuda/vector_cudahost.h>
 #include <LightGBM/utils/array_args.h>
+#include <LightGBM/utils/json11.h>
 #include <LightGBM/utils/openmp_wrapper.h>
 #include <LightGBM/utils/threading.h>
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <cstdio>
+#include <fstream>
 #include <limits>
+#include <numeric>
+#include <set>
 #include <sstream>
 #include <unordered_map>
 
 namespace LightGBM {
 
+using json11_internal_lightgbm::Json;
+
 const int Dataset::kSerializedReferenceVersionLength = 2;
 const char* Dataset::serialized_reference_version = "v1";
 
@@ -57,13 +65,24 @@ std::vector<std::vector<int>> OneFeaturePerGroup(const std::vector<int>& used_fe
   return features_in_group;
 }
 
-int GetConflictCount(const std::vector<bool>& mark, const int* indices,
+int GetConflictCount(const std::vector<uint64_t>& mark, const int* indices,
                      int num_indices, data_size_t max_cnt) {
   int ret = 0;
   for (int i = 0; i < num_indices; ++i) {
-    if (mark[indices[i]]) {
-      ++ret;
+    ret += static_cast<int>((mark[indices[i] >> 6] >> (indices[i] & 63)) & 1);
+    if (ret > max_cnt) {
+      return -1;
     }
+  }
+  return ret;
+}
+
+// same as above, with the marks of the feature itself over the words [word_begin, word_end)
+int GetConflictCount(const std::vector<uint64_t>& mark, const std::vector<uint64_t>& feature_mark,
+                     int word_begin, int word_end, data_size_t max_cnt) {
+  int ret = 0;
+  for (int i = word_begin; i < word_end; ++i) {
+    ret += Common::PopCount(mark[i] & feature_mark[i]);
     if (ret > max_cnt) {
       return -1;
     }
@@ -71,11 +90,19 @@ int GetConflictCount(const std::vector<bool>& mark, const int* indices,
   return ret;
 }
 
-void MarkUsed(std::vector<bool>* mark, const int* indices,
+void MarkUsed(std::vector<uint64_t>* mark, const int* indices,
               data_size_t num_indices) {
   auto& ref_mark = *mark;
   for (int i = 0; i < num_indices; ++i) {
-    ref_mark[indices[i]] = true;
+    ref_mark[indices[i] >> 6] |= uint64_t(1) << (indices[i] & 63);
+  }
+}
+
+void ClearUsed(std::vector<uint64_t>* mark, const int* indices,
+               data_size_t num_indices) {
+  auto& ref_mark = *mark;
+  for (int i = 0; i < num_indices; ++i) {
+    ref_mark[indices[i] >> 6] = 0;
   }
 }
 
@@ -108,67 +135,158 @@ std::vector<std::vector<int>> FindGroups(
     const std::vector<std::unique_ptr<BinMapper>>& bin_mappers,
     const std::vector<int>& find_order, int** sample_indices,
     const int* num_per_col, int num_sample_col, data_size_t total_sample_cnt,
-    data_size_t num_data, bool is_use_gpu, bool is_sparse,
+    data_size_t num_data, bool is_use_gpu, bool is_sparse, int max_search_group,
     std::vector<int8_t>* multi_val_group) {
-  const int max_search_group = 100;
   const int max_bin_per_group = 256;
   const data_size_t single_val_max_conflict_cnt =
       static_cast<data_size_t>(total_sample_cnt / 10000);
+  const int num_words = static_cast<int>((total_sample_cnt + 63) / 64);
+  const int num_threads = OMP_NUM_THREADS();
   multi_val_group->clear();
 
   Random rand(num_data);
   std::vector<std::vector<int>> features_in_group;
-  std::vector<std::vector<bool>> conflict_marks;
+  std::vector<std::vector<uint64_t>> conflict_marks;
   std::vector<data_size_t> group_used_row_cnt;
   std::vector<data_size_t> group_total_data_cnt;
   std::vector<int> group_num_bin;
+  // groups ordered by total data count, the fullest ones are the only ones that can be unavailable
+  std::set<std::pair<data_size_t, int>> groups_by_total_cnt;
+  std::vector<int> available_groups;
+  std::vector<int> full_groups;
+  std::vector<int> search_groups;
+  std::vector<data_size_t> search_cnt;
+  std::vector<uint64_t> feature_mark(num_words, 0);
+  int word_begin = 0, word_end = 0;
+  bool use_feature_mark = false;
+  // features with more sampled rows than words in their range are compared word by word
+  auto prepare_feature = [&](int fidx) {
+    const int* indices = sample_indices[fidx];
+    const int num_indices = num_per_col[fidx];
+    use_feature_mark = false;
+    if (num_indices > 0) {
+      const auto range = std::minmax_element(indices, indices + num_indices);
+      word_begin = *range.first >> 6;
+      word_end = (*range.second >> 6) + 1;
+      use_feature_mark = num_indices > word_end - word_begin;
+      if (use_feature_mark) {
+        MarkUsed(&feature_mark, indices, num_indices);
+      }
+    }
+  };
+  auto release_feature = [&](int fidx) {
+    if (use_feature_mark) {
+      ClearUsed(&feature_mark, sample_indices[fidx], num_per_col[fidx]);
+    }
+  };
+  auto conflict_count = [&](const std::vector<uint64_t>& mark, int fidx, data_size_t max_cnt) {
+    return use_feature_mark
+        ? GetConflictCount(mark, feature_mark, word_begin, word_end, max_cnt)
+        : GetConflictCount(mark, sample_indices[fidx], num_per_col[fidx], max_cnt);
+  };
 
   // first round: fill the single val group
   for (auto fidx : find_order) {
     bool is_filtered_feature = fidx >= num_sample_col;
     const data_size_t cur_non_zero_cnt =
         is_filtered_feature ? 0 : num_per_col[fidx];
-    std::vector<int> available_groups;
-    for (int gid = 0; gid < static_cast<int>(features_in_group.size()); ++gid) {
-      auto cur_num_bin = group_num_bin[gid] + bin_mappers[fidx]->num_bin() +
-                         (bin_mappers[fidx]->GetMostFreqBin() == 0 ? -1 : 0);
-      if (group_total_data_cnt[gid] + cur_non_zero_cnt <=
-          total_sample_cnt + single_val_max_conflict_cnt) {
-        if (!is_use_gpu || cur_num_bin <= max_bin_per_group) {
-          available_groups.push_back(gid);
-        }
+    const int num_group = static_cast<int>(features_in_group.size());
+    const data_size_t max_total_data_cnt = total_sample_cnt + single_val_max_conflict_cnt - cur_non_zero_cnt;
+    full_groups.clear();
+    bool use_full_groups = !is_use_gpu;
+    for (auto it = groups_by_total_cnt.rbegin(); use_full_groups && it != groups_by_total_cnt.rend()
+         && it->first > max_total_data_cnt; ++it) {
+      full_groups.push_back(it->second);
+      use_full_groups = static_cast<int>(full_groups.size()) * 8 <= num_group;
+    }
+    int num_available = num_group;
+    if (use_full_groups) {
+      std::sort(full_groups.begin(), full_groups.end());
+      num_available -= static_cast<int>(full_groups.size());
+    } else {
+      const int feature_num_bin = bin_mappers[fidx]->num_bin() + (bin_mappers[fidx]->GetMostFreqBin() == 0 ? -1 : 0);
+      available_groups.resize(num_group);
+      num_available = 0;
+      for (int gid = 0; gid < num_group; ++gid) {
+        available_groups[num_available] = gid;
+        num_available += group_total_data_cnt[gid] <= max_total_data_cnt
+                         && (!is_use_gpu || group_num_bin[gid] + feature_num_bin <= max_bin_per_group);
       }
     }
-    std::vector<int> search_groups;
-    if (!available_groups.empty()) {
-      int last = static_cast<int>(available_groups.size()) - 1;
+    // gid of the pos-th available group, the available groups are all the others than the full ones
+    auto available_group = [&](int pos) {
+      if (!use_full_groups) {
+        return available_groups[pos];
+      }
+      int gid = pos;
+      for (int num_full = 0;;) {
+        const int cnt = static_cast<int>(std::upper_bound(full_groups.begin(), full_groups.end(), gid)
+                                         - full_groups.begin());
+        if (cnt == num_full) {
+          return gid;
+        }
+        num_full = cnt;
+        gid = pos + cnt;
+      }
+    };
+    search_groups.clear();
+    if (num_available > 0) {
+      int last = num_available - 1;
       auto indices = rand.Sample(last, std::min(last, max_search_group - 1));
       // always push the last group
-      search_groups.push_back(available_groups.back());
+      search_groups.push_back(available_group(last));
       for (auto idx : indices) {
-        search_groups.push_back(available_groups[idx]);
+        search_groups.push_back(available_group(idx));
       }
     }
     int best_gid = -1;
     int best_conflict_cnt = -1;
-    for (auto gid : search_groups) {
+    if (!is_filtered_feature) {
+      prepare_feature(fidx);
+    }
+    // the candidates are counted in parallel batches, the first one that fits in search order wins
+    const int64_t cost_per_group = use_feature_mark ? word_end - word_begin : cur_non_zero_cnt;
+    const int batch_size = cost_per_group >= 4096 ? num_threads : 1;
+    search_cnt.resize(batch_size);
+    const int num_search = static_cast<int>(search_groups.size());
+    auto count_candidate = [&](int i) {
+      const int gid = search_groups[i];
       const data_size_t rest_max_cnt = single_val_max_conflict_cnt -
                                        group_total_data_cnt[gid] +
                                        group_used_row_cnt[gid];
-      const data_size_t cnt =
-          is_filtered_feature
-              ? 0
-              : GetConflictCount(conflict_marks[gid], sample_indices[fidx],
-                                 num_per_col[fidx], rest_max_cnt);
-      if (cnt >= 0 && cnt <= rest_max_cnt && cnt <= cur_non_zero_cnt / 2) {
-        best_gid = gid;
-        best_conflict_cnt = cnt;
-        break;
+      return is_filtered_feature ? 0 : conflict_count(conflict_marks[gid], fidx, rest_max_cnt);
+    };
+    for (int start = 0; start < num_search && best_gid < 0; start += batch_size) {
+      const int end = std::min(num_search, start + batch_size);
+      if (end - start > 1) {
+        #pragma omp parallel for schedule(static, 1) num_threads(num_threads)
+        for (int i = start; i < end; ++i) {
+          search_cnt[i - start] = count_candidate(i);
+        }
+      } else {
+        search_cnt[0] = count_candidate(start);
+      }
+      for (int i = start; i < end; ++i) {
+        const int gid = search_groups[i];
+        const data_size_t rest_max_cnt = single_val_max_conflict_cnt -
+                                         group_total_data_cnt[gid] +
+                                         group_used_row_cnt[gid];
+        const data_size_t cnt = search_cnt[i - start];
+        if (cnt >= 0 && cnt <= rest_max_cnt && cnt <= cur_non_zero_cnt / 2) {
+          best_gid = gid;
+          best_conflict_cnt = cnt;
+          break;
+        }
       }
     }
+    if (!is_filtered_feature) {
+      release_feature(fidx);
+    }
     if (best_gid >= 0) {
       features_in_group[best_gid].push_back(fidx);
+      groups_by_total_cnt.erase(std::make_pair(group_total_data_cnt[best_gid], best_gid));
       group_total_data_cnt[best_gid] += cur_non_zero_cnt;
+      groups_by_total_cnt.emplace(group_total_data_cnt[best_gid], best_gid);
       group_used_row_cnt[best_gid] += cur_non_zero_cnt - best_conflict_cnt;
       if (!is_filtered_feature) {
         MarkUsed(&conflict_marks[best_gid], sample_indices[fidx],
@@ -180,12 +298,13 @@ std::vector<std::vector<int>> FindGroups(
     } else {
       features_in_group.emplace_back();
       features_in_group.back().push_back(fidx);
-      conflict_marks.emplace_back(total_sample_cnt, false);
+      conflict_marks.emplace_back(num_words, 0);
       if (!is_filtered_feature) {
         MarkUsed(&(conflict_marks.back()), sample_indices[fidx],
                  num_per_col[fidx]);
       }
       group_total_data_cnt.emplace_back(cur_non_zero_cnt);
+      groups_by_total_cnt.emplace(cur_non_zero_cnt, num_group);
       group_used_row_cnt.emplace_back(cur_non_zero_cnt);
       group_num_bin.push_back(
           1 + bin_mappers[fidx]->num_bin() +
@@ -198,7 +317,7 @@ std::vector<std::vector<int>> FindGroups(
   }
   std::vector<int> second_round_features;
   std::vector<std::vector<int>> features_in_group2;
-  std::vector<std::vector<bool>> conflict_marks2;
+  std::vector<std::vector<uint64_t>> conflict_marks2;
 
   const double dense_threshold = 0.4;
   for (int gid = 0; gid < static_cast<int>(features_in_group.size()); ++gid) {
@@ -219,16 +338,16 @@ std::vector<std::vector<int>> FindGroups(
   multi_val_group->resize(features_in_group.size(), false);
   if (!second_round_features.empty()) {
     features_in_group.emplace_back();
-    conflict_marks.emplace_back(total_sample_cnt, false);
+    conflict_marks.emplace_back(num_words, 0);
     bool is_multi_val = is_use_gpu ? true : false;
     int conflict_cnt = 0;
     for (auto fidx : second_round_features) {
       features_in_group.back().push_back(fidx);
       if (!is_multi_val) {
         const int rest_max_cnt = single_val_max_conflict_cnt - conflict_cnt;
-        const auto cnt =
-            GetConflictCount(conflict_marks.back(), sample_indices[fidx],
-                             num_per_col[fidx], rest_max_cnt);
+        prepare_feature(fidx);
+        const auto cnt = conflict_count(conflict_marks.back(), fidx, rest_max_cnt);
+        release_feature(fidx);
         conflict_cnt += cnt;
         if (cnt < 0 || conflict_cnt > single_val_max_conflict_cnt) {
           is_multi_val = true;
@@ -248,7 +367,8 @@ std::vector<std::vector<int>> FastFeatureBundling(
     int** sample_indices, double** sample_values, const int* num_per_col,
     int num_sample_col, data_size_t total_sample_cnt,
     const std::vector<int>& used_features, data_size_t num_data,
-    bool is_use_gpu, bool is_sparse, std::vector<int8_t>* multi_val_group) {
+    bool is_use_gpu, bool is_sparse, int max_search_group,
+    std::vector<int8_t>* multi_val_group) {
   Common::FunctionTimer fun_timer("Dataset::FastFeatureBundling", global_timer);
   std::vector<size_t> feature_non_zero_cnt;
   feature_non_zero_cnt.reserve(used_features.size());
@@ -299,11 +419,11 @@ std::vector<std::vector<int>> FastFeatureBundling(
   auto features_in_group =
       FindGroups(bin_mappers, used_features, sample_indices,
                  tmp_num_per_col.data(), num_sample_col, total_sample_cnt,
-                 num_data, is_use_gpu, is_sparse, &group_is_multi_val);
+                 num_data, is_use_gpu, is_sparse, max_search_group, &group_is_multi_val);
   auto group2 =
       FindGroups(bin_mappers, feature_order_by_cnt, sample_indices,
                  tmp_num_per_col.data(), num_sample_col, total_sample_cnt,
-                 num_data, is_use_gpu, is_sparse, &group_is_multi_val2);
+                 num_data, is_use_gpu, is_sparse, max_search_group, &group_is_multi_val2);
 
   if (features_in_group.size() > group2.size()) {
     features_in_group = group2;
@@ -322,6 +442,100 @@ std::vector<std::vector<int>> FastFeatureBundling(
   return features_in_group;
 }
 
+std::vector<std::vector<int>> LoadBundlePlan(const std::string& filename,
+                                             const std::vector<std::unique_ptr<BinMapper>>& bin_mappers,
+                                             const std::vector<int>& used_features,
+                                             int num_total_features, bool is_use_gpu, bool is_sparse,
+                                             std::vector<int8_t>* multi_val_group) {
+  // same limit as FindGroups
+  const int max_bin_per_group = 256;
+  std::ifstream plan_stream(filename.c_str());
+  if (plan_stream.fail()) {
+    Log::Fatal("Could not open bundle plan %s", filename.c_str());
+  }
+  std::stringstream buffer;
+  buffer << plan_stream.rdbuf();
+  std::string err;
+  const Json plan = Json::parse(buffer.str(), &err);
+  if (!err.empty() || !plan["bundles"].is_array()) {
+    Log::Fatal("Bundle plan %s is not valid: %s", filename.c_str(), err.c_str());
+  }
+  if (plan["num_total_features"].int_value() != num_total_features) {
+    Log::Fatal("Bundle plan %s is for %d features, but the Dataset has %d features",
+               filename.c_str(), plan["num_total_features"].int_value(), num_total_features);
+  }
+  std::vector<int8_t> is_used(num_total_features, 0);
+  for (int fidx : used_features) {
+    is_used[fidx] = 1;
+  }
+  std::vector<int8_t> is_planned(num_total_features, 0);
+  std::vector<std::vector<int>> features_in_group;
+  multi_val_group->clear();
+  int num_multi_val = 0;
+  for (const Json& bundle : plan["bundles"].array_items()) {
+    if (bundle["multi_val"].bool_value() && ++num_multi_val > 1) {
+      Log::Fatal("Bundle plan %s has more than one multi_val bundle", filename.c_str());
+    }
+    std::vector<int> features;
+    for (const Json& feature : bundle["features"].array_items()) {
+      const int fidx = feature.int_value();
+      if (fidx < 0 || fidx >= num_total_features || is_planned[fidx]) {
+        Log::Fatal("Bundle plan %s has an invalid or repeated feature %d", filename.c_str(), fidx);
+      }
+      is_planned[fidx] = 1;
+      if (is_used[fidx]) {
+        features.push_back(fidx);
+      }
+    }
+    if (!features.empty()) {
+      const bool is_multi_val = is_sparse && bundle["multi_val"].bool_value();
+      if (is_use_gpu && !is_multi_val && features.size() > 1) {
+        int num_bin = 1;
+        for (int fidx : features) {
+          num_bin += bin_mappers[fidx]->num_bin() + (bin_mappers[fidx]->GetMostFreqBin() == 0 ? -1 : 0);
+        }
+        if (num_bin > max_bin_per_group) {
+          Log::Fatal("Bundle plan %s has a bundle of %d bins with features %s, the GPU allows at most %d bins "
+                     "per bundle", filename.c_str(), num_bin, Common::Join(features, ",").c_str(),
+                     max_bin_per_group);
+        }
+      }
+      features_in_group.push_back(std::move(features));
+      multi_val_group->push_back(is_multi_val);
+    }
+  }
+  int num_unplanned = 0;
+  for (int fidx : used_features) {
+    if (!is_planned[fidx]) {
+      features_in_group.emplace_back(1, fidx);
+      multi_val_group->push_back(false);
+      ++num_unplanned;
+    }
+  }
+  if (num_unplanned > 0) {
+    Log::Warning("%d used features are not in bundle plan %s, they are not bundled", num_unplanned, filename.c_str());
+  }
+  return features_in_group;
+}
+
+void SaveBundlePlan(const std::string& filename, const std::vector<std::vector<int>>& features_in_group,
+                    const std::vector<int8_t>& multi_val_group, int num_total_features) {
+  std::stringstream str_buf;
+  str_buf << "{\"num_total_features\":" << num_total_features << ",\n\"bundles\":[";
+  for (size_t i = 0; i < features_in_group.size(); ++i) {
+    str_buf << (i > 0 ? ",\n" : "\n") << "{\"features\":[" << Common::Join(features_in_group[i], ",")
+            << "],\"multi_val\":" << (multi_val_group[i] ? "true" : "false") << "}";
+  }
+  str_buf << "\n]}\n";
+  const std::string plan = str_buf.str();
+  auto writer = VirtualFileWriter::Make(filename);
+  if (!writer->Init()) {
+    Log::Fatal("Cannot write bundle plan to %s", filename.c_str());
+  }
+  writer->Write(plan.c_str(), plan.size());
+  Log::Info("Saved the plan of %d bundles to %s", static_cast<int>(features_in_group.size()), filename.c_str());
+}
+
 void Dataset::Construct(std::vector<std::unique_ptr<BinMapper>>* bin_mappers,
                         int num_total_features,
                         const std::vector<std::vector<double>>& forced_bins,
@@ -361,11 +575,19 @@ void Dataset::Construct(std::vector<std::unique_ptr<BinMapper>>* bin_mappers,
   std::vector<int8_t> group_is_multi_val(used_features.size(), 0);
   if (io_config.enable_bundle && !used_features.empty()) {
     bool lgbm_is_gpu_used = io_config.device_type == std::string("gpu") || io_config.device_type == std::string("cuda");
-    features_in_group = FastFeatureBundling(
-        *bin_mappers, sample_non_zero_indices, sample_values, num_per_col,
-        num_sample_col, static_cast<data_size_t>(total_sample_cnt),
-        used_features, num_data_, lgbm_is_gpu_used,
-        is_sparse, &group_is_multi_val);
+    if (!io_config.input_bundle_plan.empty()) {
+      features_in_group = LoadBundlePlan(io_config.input_bundle_plan, *bin_mappers, used_features,
+                                         num_total_features_, lgbm_is_gpu_used, is_sparse, &group_is_multi_val);
+    } else {
+      features_in_group = FastFeatureBundling(
+          *bin_mappers, sample_non_zero_indices, sample_values, num_per_col,
+          num_sample_col, static_cast<data_size_t>(total_sample_cnt),
+          used_features, num_data_, lgbm_is_gpu_used,
+          is_sparse, io_config.max_bundle_search_groups, &group_is_multi_val);
+    }
+    if (!io_config.output_bundle_plan.empty()) {
+      SaveBundlePlan(io_config.output_bundle_plan, features_in_group, group_is_multi_val, num_total_features_);
+    }
   }
 
   num_features_ = 0;
@@ -428,6 +650,8 @@ void Dataset::Construct(std::vector<std::unique_ptr<BinMapper>>* bin_mappers,
   if (io_config.linear_tree) {
     has_raw_ = true;
   }
+  raw_type_ = ParseRawType(io_config.linear_raw_type);
+  raw_dictionary_ = io_config.linear_raw_dictionary;
   numeric_feature_map_ = std::vector<int>(num_features_, -1);
   num_numeric_features_ = 0;
   for (int i = 0; i < num_features_; ++i) {
@@ -449,6 +673,9 @@ void Dataset::FinishLoad() {
       feature_groups_[i]->FinishLoad();
     }
   }
+  if (has_raw_) {
+    FinishRaw();
+  }
   metadata_.FinishLoad();
 
   #ifdef USE_CUDA
@@ -462,6 +689,34 @@ void Dataset::FinishLoad() {
   is_finish_load_ = true;
 }
 
+void Dataset::FinishRaw() {
+  if (raw_type_ != RawType::Bin && !raw_dictionary_) {
+    return;
+  }
+  OMP_INIT_EX();
+  #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(dynamic)
+  for (int i = 0; i < num_features_; ++i) {
+    OMP_LOOP_EX_BEGIN();
+    const int feat_ind = numeric_feature_map_[i];
+    if (feat_ind >= 0) {
+      if (raw_type_ == RawType::Bin) {
+        std::unique_ptr<BinIterator> iterator(FeatureIterator(i));
+        raw_data_[feat_ind].SetFromBins(iterator.get(), *FeatureBinMapper(i), num_data_);
+      } else {
+        raw_data_[feat_ind].Compress();
+      }
+    }
+    OMP_LOOP_EX_END();
+  }
+  OMP_THROW_EX();
+  size_t raw_size = 0;
+  for (const auto& column : raw_data_) {
+    raw_size += column.SizesInByte();
+  }
+  Log::Debug("Raw values of %d numerical features use %.2f MB", num_numeric_features_,
+             static_cast<double>(raw_size) / 1024.0 / 1024.0);
+}
+
 void PushDataToMultiValBin(
     data_size_t num_data, const std::vector<uint32_t> most_freq_bins,
     const std::vector<uint32_t> offsets,
@@ -746,6 +1001,8 @@ void Dataset::CopyFeatureMapperFrom(const Dataset* dataset) {
   num_features_ = dataset->num_features_;
   num_groups_ = dataset->num_groups_;
   has_raw_ = dataset->has_raw();
+  raw_type_ = dataset->raw_type_;
+  raw_dictionary_ = dataset->raw_dictionary_;
   // copy feature bin mapper data
   for (int i = 0; i < num_groups_; ++i) {
     feature_groups_.emplace_back(
@@ -783,6 +1040,8 @@ void Dataset::CreateValid(const Dataset* dataset) {
   feature2group_.clear();
   feature2subfeature_.clear();
   has_raw_ = dataset->has_raw();
+  raw_type_ = dataset->raw_type_;
+  raw_dictionary_ = dataset->raw_dictionary_;
   numeric_feature_map_ = dataset->numeric_feature_map_;
   num_numeric_features_ = dataset->num_numeric_features_;
   // copy feature bin mapper data
@@ -833,6 +1092,196 @@ void Dataset::ReSize(data_size_t num_data) {
   }
 }
 
+data_size_t Dataset::InitAppend(data_size_t num_append) {
+  if (!is_finish_load_) {
+    Log::Fatal("Cannot append rows to a Dataset which is not finished yet");
+  }
+  if (num_append <= 0) {
+    Log::Fatal("Number of appended rows should be positive, got %d", num_append);
+  }
+  if (static_cast<int64_t>(num_data_) + num_append > std::numeric_limits<data_size_t>::max()) {
+    Log::Fatal("Too many rows after appending %d rows to a Dataset with %d rows", num_append, num_data_);
+  }
+  const data_size_t start_row = num_data_;
+  num_data_ += num_append;
+  OMP_INIT_EX();
+#pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static)
+  for (int group = 0; group < num_groups_; ++group) {
+    OMP_LOOP_EX_BEGIN();
+    feature_groups_[group]->ReSizeForAppend(num_data_);
+    OMP_LOOP_EX_END();
+  }
+  OMP_THROW_EX();
+  metadata_.ReSizeForAppend(num_data_);
+  if (has_raw_) {
+    ResizeRaw(num_data_);
+  }
+  is_finish_load_ = false;
+  return start_row;
+}
+
+void Dataset::SlideWindow(const std::function<std::vector<std::pair<int, double>>(int row_idx)>& get_row_fun,
+                          data_size_t num_rows, const label_t* labels, const label_t* weights,
+                          const double* init_scores, const double* timestamps, double weight_half_life) {
+  if (!is_finish_load_) {
+    Log::Fatal("Cannot slide the window of a Dataset which is not finished yet");
+  }
+  if (num_rows <= 0 || num_rows > num_data_) {
+    Log::Fatal("Number of new rows should be in [1, %d], got %d", num_data_, num_rows);
+  }
+  if (metadata_.timestamps() == nullptr) {
+    Log::Fatal("Timestamps should be set before sliding the window of a Dataset");
+  }
+  if (metadata_.query_boundaries() != nullptr || metadata_.positions() != nullptr) {
+    Log::Fatal("Sliding the window of a Dataset with queries or positions is not supported");
+  }
+  if (labels == nullptr || timestamps == nullptr) {
+    Log::Fatal("Labels and timestamps of the new rows are required");
+  }
+  if ((weights != nullptr) != (metadata_.weights() != nullptr) && weight_half_life <= 0.0f) {
+    Log::Fatal("Weights of the new rows should be given if and only if the Dataset has weights");
+  }
+  if ((init_scores != nullptr) != (metadata_.init_score() != nullptr)) {
+    Log::Fatal("Initial scores of the new rows should be given if and only if the Dataset has initial scores");
+  }
+  const double* row_timestamps = metadata_.timestamps();
+  if (static_cast<data_size_t>(window_order_.size()) != num_data_) {
+    window_order_.resize(num_data_);
+    std::iota(window_order_.begin(), window_order_.end(), 0);
+    std::stable_sort(window_order_.begin(), window_order_.end(), [row_timestamps](data_size_t a, data_size_t b) {
+      return row_timestamps[a] < row_timestamps[b];
+    });
+    window_head_ = 0;
+  }
+  // the oldest slots are recycled for the new rows in timestamp order, so they become the newest ones
+  std::vector<data_size_t> new_order(num_rows);
+  std::iota(new_order.begin(), new_order.end(), 0);
+  std::stable_sort(new_order.begin(), new_order.end(), [timestamps](data_size_t a, data_size_t b) {
+    return timestamps[a] < timestamps[b];
+  });
+  std::vector<data_size_t> slots(num_rows);
+  for (data_size_t i = 0; i < num_rows; ++i) {
+    slots[i] = window_order_[(static_cast<int64_t>(window_head_) + i) % num_data_];
+  }
+  window_head_ = static_cast<data_size_t>((static_cast<int64_t>(window_head_) + num_rows) % num_data_);
+  double newest_kept = -std::numeric_limits<double>::infinity();
+  if (num_rows < num_data_) {
+    const int64_t pos = (static_cast<int64_t>(window_head_) + num_data_ - num_rows - 1) % num_data_;
+    newest_kept = row_timestamps[window_order_[pos]];
+  }
+  const bool keeps_order = timestamps[new_order[0]] >= newest_kept;
+
+  // dense values of the new rows by inner feature index, in slot order
+  std::vector<double> values(static_cast<size_t>(num_rows) * num_features_, 0.0f);
+  OMP_INIT_EX();
+#pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static)
+  for (data_size_t i = 0; i < num_rows; ++i) {
+    OMP_LOOP_EX_BEGIN();
+    const auto one_row = get_row_fun(new_order[i]);
+    double* row_values = values.data() + static_cast<size_t>(i) * num_features_;
+    for (const auto& inner_data : one_row) {
+      if (inner_data.first >= 0 && inner_data.first < num_total_features_) {
+        const int feature_idx = used_feature_map_[inner_data.first];
+        if (feature_idx >= 0) {
+          row_values[feature_idx] = inner_data.second;
+        }
+      }
+    }
+    OMP_LOOP_EX_END();
+  }
+  OMP_THROW_EX();
+#pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(dynamic)
+  for (int group = 0; group < num_groups_; ++group) {
+    OMP_LOOP_EX_BEGIN();
+    feature_groups_[group]->ReplaceRows(slots.data(), num_rows, values.data() + group_feature_start_[group],
+                                        num_features_);
+    OMP_LOOP_EX_END();
+  }
+  OMP_THROW_EX();
+  if (has_raw_) {
+#pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static)
+    for (int i = 0; i < num_features_; ++i) {
+      const int feat_ind = numeric_feature_map_[i];
+      if (feat_ind >= 0) {
+        raw_data_[feat_ind].Expand();
+        for (data_size_t j = 0; j < num_rows; ++j) {
+          raw_data_[feat_ind].Set(slots[j], values[static_cast<size_t>(j) * num_features_ + i]);
+        }
+      }
+    }
+    FinishRaw();
+  }
+
+  // metadata
+  const int num_class = metadata_.num_init_score_classes();
+  std::vector<double> row_init_score(num_class);
+  for (data_size_t i = 0; i < num_rows; ++i) {
+    const data_size_t src = new_order[i];
+    metadata_.SetLabelAt(slots[i], labels[src]);
+    metadata_.SetTimestampAt(slots[i], timestamps[src]);
+    if (init_scores != nullptr) {
+      for (int k = 0; k < num_class; ++k) {
+        row_init_score[k] = init_scores[static_cast<size_t>(k) * num_rows + src];
+      }
+      metadata_.SetInitScoreAt(slots[i], row_init_score.data());
+    }
+  }
+  if (weight_half_life > 0.0f && window_base_weights_.empty()) {
+    const label_t* cur_weights = metadata_.weights();
+    if (cur_weights != nullptr) {
+      window_base_weights_.assign(cur_weights, cur_weights + num_data_);
+    } else {
+      window_base_weights_.assign(num_data_, 1.0f);
+    }
+  }
+  if (!window_base_weights_.empty()) {
+    // rows appended since the last slide keep their given weights as base weights
+    const label_t* cur_weights = metadata_.weights();
+    for (data_size_t i = static_cast<data_size_t>(window_base_weights_.size()); i < num_data_; ++i) {
+      window_base_weights_.push_back(cur_weights[i]);
+    }
+    for (data_size_t i = 0; i < num_rows; ++i) {
+      window_base_weights_[slots[i]] = weights != nullptr ? weights[new_order[i]] : 1.0f;
+    }
+  }
+  if (metadata_.weights() != nullptr) {
+    for (data_size_t i = 0; i < num_rows; ++i) {
+      metadata_.SetWeightAt(slots[i], window_base_weights_.empty() ? weights[new_order[i]]
+                                                                   : window_base_weights_[slots[i]]);
+    }
+  }
+  if (!keeps_order) {
+    // new rows are older than some kept rows, restore the timestamp order of the whole window
+    std::rotate(window_order_.begin(), window_order_.begin() + window_head_, window_order_.end());
+    window_head_ = 0;
+    std::stable_sort(window_order_.begin(), window_order_.end(), [row_timestamps](data_size_t a, data_size_t b) {
+      return row_timestamps[a] < row_timestamps[b];
+    });
+  }
+  if (weight_half_life > 0.0f) {
+    const int64_t pos = (static_cast<int64_t>(window_head_) + num_data_ - 1) % num_data_;
+    const double newest = row_timestamps[window_order_[pos]];
+    std::vector<label_t> decayed_weights(num_data_);
+#pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static)
+    for (data_size_t i = 0; i < num_data_; ++i) {
+      decayed_weights[i] = static_cast<label_t>(
+          window_base_weights_[i] * std::exp2(-(newest - row_timestamps[i]) / weight_half_life));
+    }
+    metadata_.SetWeights(decayed_weights.data(), num_data_);
+  }
+
+  // sorted, so that bin iterators can walk the recycled rows forward
+  std::sort(slots.begin(), slots.end());
+  window_recycled_rows_ = std::move(slots);
+  ++num_window_slides_;
+  #ifdef USE_CUDA
+  if (device_type_ == std::string("cuda")) {
+    CreateCUDAColumnData();
+    metadata_.CreateCUDAMetadata(gpu_device_id_);
+  }
+  #endif  // USE_CUDA
+}
+
 void Dataset::CopySubrow(const Dataset* fullset,
                          const data_size_t* used_indices,
                          data_size_t num_used_indices, bool need_meta_data) {
@@ -853,16 +1302,41 @@ void Dataset::CopySubrow(const Dataset* fullset,
       subfeature_ids.emplace_back(-1);
     }
   }
-  int num_copy_tasks = static_cast<int>(group_ids.size());
+  // dense columns are gathered in row blocks, all columns of a block are copied before the next block,
+  // so the threads share the indices of the block in cache and large subsets use every thread
+  const data_size_t kCopyBlockSize = 1 << 16;
+  std::vector<int> task_columns;
+  std::vector<data_size_t> task_starts;
+  for (int i = 0; i < static_cast<int>(group_ids.size()); ++i) {
+    if (!feature_groups_[group_ids[i]]->IsDenseCol(subfeature_ids[i])) {
+      task_columns.push_back(i);
+      task_starts.push_back(-1);
+    }
+  }
+  for (data_size_t start = 0; start < num_used_indices; start += kCopyBlockSize) {
+    for (int i = 0; i < static_cast<int>(group_ids.size()); ++i) {
+      if (feature_groups_[group_ids[i]]->IsDenseCol(subfeature_ids[i])) {
+        task_columns.push_back(i);
+        task_starts.push_back(start);
+      }
+    }
+  }
+  int num_copy_tasks = static_cast<int>(task_columns.size());
 
   OMP_INIT_EX();
   #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(dynamic)
   for (int task_id = 0; task_id < num_copy_tasks; ++task_id) {
     OMP_LOOP_EX_BEGIN();
-    int group = group_ids[task_id];
-    int subfeature = subfeature_ids[task_id];
-    feature_groups_[group]->CopySubrowByCol(fullset->feature_groups_[group].get(),
-                                            used_indices, num_used_indices, subfeature);
+    int group = group_ids[task_columns[task_id]];
+    int subfeature = subfeature_ids[task_columns[task_id]];
+    const data_size_t start = task_starts[task_id];
+    if (start < 0) {
+      feature_groups_[group]->CopySubrowByCol(fullset->feature_groups_[group].get(),
+                                              used_indices, num_used_indices, subfeature);
+    } else {
+      feature_groups_[group]->CopySubrowRangeByCol(fullset->feature_groups_[group].get(), used_indices, start,
+                                                   std::min(start + kCopyBlockSize, num_used_indices), subfeature);
+    }
     OMP_LOOP_EX_END();
   }
   OMP_THROW_EX();
@@ -874,12 +1348,10 @@ void Dataset::CopySubrow(const Dataset* fullset,
   numeric_feature_map_ = fullset->numeric_feature_map_;
   num_numeric_features_ = fullset->num_numeric_features_;
   if (has_raw_) {
-    ResizeRaw(num_used_indices);
+    raw_data_.resize(num_numeric_features_);
 #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static)
-    for (int i = 0; i < num_used_indices; ++i) {
-      for (int j = 0; j < num_numeric_features_; ++j) {
-        raw_data_[j][i] = fullset->raw_data_[j][used_indices[i]];
-      }
+    for (int j = 0; j < num_numeric_features_; ++j) {
+      raw_data_[j].CopySubrow(fullset->raw_data_[j], used_indices, num_used_indices);
     }
   }
   // update CUDA storage for column data and metadata
@@ -929,6 +1401,7 @@ bool Dataset::SetFloatField(const char* field_name, const float* field_data,
     Log::Fatal("Don't support LABEL_T_USE_DOUBLE");
 #else
     metadata_.SetWeights(field_data, num_element);
+    window_base_weights_.clear();
 #endif
   } else {
     return false;
@@ -942,6 +1415,9 @@ bool Dataset::SetDoubleField(const char* field_name, const double* field_data,
   name = Common::Trim(name);
   if (name == std::string("init_score")) {
     metadata_.SetInitScore(field_data, num_element);
+  } else if (name == std::string("timestamp")) {
+    metadata_.SetTimestamps(field_data, num_element);
+    window_order_.clear();
   } else {
     return false;
   }
@@ -993,6 +1469,9 @@ bool Dataset::GetDoubleField(const char* field_name, data_size_t* out_len,
   if (name == std::string("init_score")) {
     *out_ptr = metadata_.init_score();
     *out_len = static_cast<data_size_t>(metadata_.num_init_score());
+  } else if (name == std::string("timestamp")) {
+    *out_ptr = metadata_.timestamps();
+    *out_len = metadata_.timestamps() != nullptr ? num_data_ : 0;
   } else {
     return false;
   }
@@ -1066,7 +1545,8 @@ void Dataset::SaveBinaryFile(const char* bin_filename) {
         for (int j = 0; j < num_features_; ++j) {
           int feat_ind = numeric_feature_map_[j];
           if (feat_ind > -1) {
-            writer->Write(&raw_data_[feat_ind][i], sizeof(float));
+            const float value = raw_data_[feat_ind].Get(i);
+            writer->Write(&value, sizeof(float));
           }
         }
       }
@@ -1105,6 +1585,17 @@ void Dataset::SerializeReference(ByteBuffer* buffer) {
   }
 }
 
+void Dataset::SaveSchema(const char* filename) {
+  ByteBuffer buffer;
+  SerializeReference(&buffer);
+  auto writer = VirtualFileWriter::Make(filename);
+  if (!writer->Init()) {
+    Log::Fatal("Cannot write dataset schema to %s", filename);
+  }
+  writer->Write(buffer.Data(), buffer.GetSize());
+  Log::Info("Saved dataset schema to %s", filename);
+}
+
 size_t Dataset::GetSerializedHeaderSize() {
   size_t size_of_header =
     VirtualFileWriter::AlignedSize(sizeof(num_data_)) +
@@ -1485,6 +1976,111 @@ template void Dataset::ConstructHistogramsInner<false, true, true, 32>(CONSTRUCT
 
 template void Dataset::ConstructHistogramsInner<false, false, true, 32>(CONSTRUCT_HISTOGRAMS_INNER_PARMA) const;
 
+void Dataset::ConstructSiblingHistograms(const std::vector<int8_t>& is_feature_used,
+                                         const data_size_t* left_indices, data_size_t left_cnt,
+                                         const data_size_t* right_indices, data_size_t right_cnt,
+                                         const score_t* gradients, const score_t* hessians,
+                                         data_size_t* data_indices, uint8_t* leaf_of,
+                                         score_t* ordered_gradients, score_t* ordered_hessians,
+                                         TrainingShareStates* share_state,
+                                         hist_t* left_hist_data, hist_t* right_hist_data) const {
+  std::vector<int> used_dense_group;
+  int multi_val_group_id = -1;
+  if (share_state->is_col_wise) {
+    for (int group = 0; group < num_groups_; ++group) {
+      const auto f_start = is_feature_used.begin() + group_feature_start_[group];
+      if (std::none_of(f_start, f_start + group_feature_cnt_[group], [](int8_t used) { return used != 0; })) {
+        continue;
+      }
+      if (feature_groups_[group]->is_multi_val_) {
+        multi_val_group_id = group;
+      } else {
+        used_dense_group.push_back(group);
+      }
+    }
+  }
+  // row-wise histograms have no merged pass, build the leaves one by one
+  if (used_dense_group.empty() || left_cnt <= 0 || right_cnt <= 0) {
+    ConstructHistograms<false, 0>(is_feature_used, left_indices, left_cnt, gradients, hessians,
+                                  ordered_gradients, ordered_hessians, share_state, left_hist_data);
+    ConstructHistograms<false, 0>(is_feature_used, right_indices, right_cnt, gradients, hessians,
+                                  ordered_gradients, ordered_hessians, share_state, right_hist_data);
+    return;
+  }
+  Common::FunctionTimer fun_time("Dataset::ConstructSiblingHistograms", global_timer);
+  const bool use_hessian = !share_state->is_constant_hessian;
+  const data_size_t num_data = left_cnt + right_cnt;
+  const data_size_t block_size = 4096;
+  const int num_blocks = static_cast<int>((num_data + block_size - 1) / block_size);
+#pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static) if (num_blocks > 1)
+  for (int block = 0; block < num_blocks; ++block) {
+    const data_size_t start = block * block_size;
+    const data_size_t end = std::min(num_data, start + block_size);
+    // number of left rows among the first start merged rows
+    data_size_t lo = std::max(0, start - right_cnt);
+    data_size_t hi = std::min(start, left_cnt);
+    while (lo < hi) {
+      const data_size_t mid = lo + (hi - lo) / 2;
+      if (left_indices[mid] < right_indices[start - mid - 1]) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    data_size_t left_pos = lo;
+    data_size_t right_pos = start - lo;
+    for (data_size_t i = start; i < end; ++i) {
+      const data_size_t left_row = left_pos < left_cnt ? left_indices[left_pos] : num_data_;
+      const data_size_t right_row = right_pos < right_cnt ? right_indices[right_pos] : num_data_;
+      const uint8_t is_right = right_row < left_row;
+      const data_size_t row = is_right ? right_row : left_row;
+      data_indices[i] = row;
+      leaf_of[i] = is_right;
+      ordered_gradients[i] = gradients[row];
+      if (use_hessian) {
+        ordered_hessians[i] = hessians[row];
+      }
+      left_pos += 1 - is_right;
+      right_pos += is_right;
+    }
+  }
+  const int num_used_dense_group = static_cast<int>(used_dense_group.size());
+  OMP_INIT_EX();
+#pragma omp parallel for schedule(static) num_threads(share_state->num_threads)
+  for (int gi = 0; gi < num_used_dense_group; ++gi) {
+    OMP_LOOP_EX_BEGIN();
+    const int group = used_dense_group[gi];
+    const int num_bin = feature_groups_[group]->num_total_bin_;
+    hist_t* const out[2] = {left_hist_data + group_bin_boundaries_[group] * 2,
+                            right_hist_data + group_bin_boundaries_[group] * 2};
+    for (hist_t* data_ptr : out) {
+      std::memset(reinterpret_cast<void*>(data_ptr), 0, num_bin * kHistEntrySize);
+    }
+    if (use_hessian) {
+      feature_groups_[group]->bin_data_->ConstructSiblingHistograms(
+          data_indices, leaf_of, 0, num_data, ordered_gradients, ordered_hessians, out);
+    } else {
+      feature_groups_[group]->bin_data_->ConstructSiblingHistograms(
+          data_indices, leaf_of, 0, num_data, ordered_gradients, out);
+      for (hist_t* data_ptr : out) {
+        auto cnt_dst = reinterpret_cast<hist_cnt_t*>(data_ptr + 1);
+        for (int i = 0; i < num_bin * 2; i += 2) {
+          data_ptr[i + 1] = static_cast<double>(cnt_dst[i]) * hessians[0];
+        }
+      }
+    }
+    OMP_LOOP_EX_END();
+  }
+  OMP_THROW_EX();
+  if (multi_val_group_id >= 0) {
+    const uint64_t offset = group_bin_boundaries_[multi_val_group_id] * 2;
+    ConstructHistogramsMultiVal<true, false, false, 0>(left_indices, left_cnt, gradients, hessians,
+                                                       share_state, left_hist_data + offset);
+    ConstructHistogramsMultiVal<true, false, false, 0>(right_indices, right_cnt, gradients, hessians,
+                                                       share_state, right_hist_data + offset);
+  }
+}
+
 void Dataset::FixHistogram(int feature_idx, double sum_gradient,
                            double sum_hessian, hist_t* data) const {
   const int group = feature2group_[feature_idx];
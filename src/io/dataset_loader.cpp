@@ -230,13 +230,16 @@ Dataset* DatasetLoader::LoadFromFile(const char* filename, int rank, int num_mac
       // read data to memory
       auto text_data = LoadTextDataToMemory(filename, dataset->metadata_, rank, num_machines, &num_global_data, &used_data_indices);
       dataset->num_data_ = static_cast<data_size_t>(text_data.size());
-      // sample data
-      auto sample_data = SampleTextDataFromMemory(text_data);
-      CheckSampleSize(sample_data.size(),
-                      static_cast<size_t>(dataset->num_data_));
-      // construct feature bin mappers & clear sample data
-      ConstructBinMappersFromTextData(rank, num_machines, sample_data, parser.get(), dataset.get());
-      std::vector<std::string>().swap(sample_data);
+      if (!config_.input_dataset_schema.empty()) {
+        ConstructFromSchema(parser->NumFeatures(), dataset.get());
+      } else {
+        // sample data
+        auto sample_data = SampleTextDataFromMemory(text_data);
+        CheckSampleSize(sample_data.size(),
+                        static_cast<size_t>(dataset->num_data_));
+        // construct feature bin mappers & clear sample data
+        ConstructBinMappersFromTextData(rank, num_machines, sample_data, parser.get(), dataset.get());
+      }
       if (dataset->has_raw()) {
         dataset->ResizeRaw(dataset->num_data_);
       }
@@ -253,10 +256,15 @@ Dataset* DatasetLoader::LoadFromFile(const char* filename, int rank, int num_mac
       } else {
         dataset->num_data_ = num_global_data;
       }
-      CheckSampleSize(sample_data.size(),
-                      static_cast<size_t>(dataset->num_data_));
-      // construct feature bin mappers & clear sample data
-      ConstructBinMappersFromTextData(rank, num_machines, sample_data, parser.get(), dataset.get());
+      if (!config_.input_dataset_schema.empty()) {
+        ConstructFromSchema(parser->NumFeatures(), dataset.get());
+      } else {
+        CheckSampleSize(sample_data.size(),
+                        static_cast<size_t>(dataset->num_data_));
+        // construct feature bin mappers
+        ConstructBinMappersFromTextData(rank, num_machines, sample_data, parser.get(), dataset.get());
+      }
+      // clear sample data
       std::vector<std::string>().swap(sample_data);
       if (dataset->has_raw()) {
         dataset->ResizeRaw(dataset->num_data_);
@@ -579,11 +587,12 @@ Dataset* DatasetLoader::LoadFromBinFile(const char* data_filename, const char* b
       for (int j = 0; j < dataset->num_features(); ++j) {
         int feat_ind = dataset->numeric_feature_map_[j];
         if (feat_ind >= 0) {
-          dataset->raw_data_[feat_ind][i] = tmp_ptr_raw_row[feat_ind];
+          dataset->raw_data_[feat_ind].Set(i, tmp_ptr_raw_row[feat_ind]);
         }
       }
       mem_ptr += row_size;
     }
+    dataset->FinishRaw();
   }
 
   dataset->is_finish_load_ = true;
@@ -597,6 +606,14 @@ Dataset* DatasetLoader::ConstructFromSampleData(double** sample_values,
                                                 size_t total_sample_size,
                                                 data_size_t num_local_data,
                                                 int64_t num_dist_data) {
+  if (!config_.input_dataset_schema.empty()) {
+    auto dataset = std::unique_ptr<Dataset>(new Dataset(num_local_data));
+    ConstructFromSchema(num_col, dataset.get());
+    if (dataset->has_raw()) {
+      dataset->ResizeRaw(num_local_data);
+    }
+    return dataset.release();
+  }
   CheckSampleSize(total_sample_size, static_cast<size_t>(num_dist_data));
   int num_total_features = num_col;
   if (Network::num_machines() > 1) {
@@ -748,6 +765,9 @@ Dataset* DatasetLoader::ConstructFromSampleData(double** sample_values,
     dataset->ResizeRaw(num_local_data);
   }
   dataset->set_feature_names(feature_names_);
+  if (!config_.output_dataset_schema.empty()) {
+    dataset->SaveSchema(config_.output_dataset_schema.c_str());
+  }
   return dataset.release();
 }
 
@@ -776,6 +796,8 @@ void DatasetLoader::LoadHeaderFromMemory(Dataset* dataset, const char* buffer) {
   dataset->zero_as_missing_ = *(reinterpret_cast<const bool*>(mem_ptr));
   mem_ptr += VirtualFileWriter::AlignedSize(sizeof(dataset->zero_as_missing_));
   dataset->has_raw_ = *(reinterpret_cast<const bool*>(mem_ptr));
+  dataset->raw_type_ = ParseRawType(config_.linear_raw_type);
+  dataset->raw_dictionary_ = config_.linear_raw_dictionary;
 
   mem_ptr += VirtualFileWriter::AlignedSize(sizeof(dataset->has_raw_));
   const int* tmp_feature_map = reinterpret_cast<const int*>(mem_ptr);
@@ -1253,12 +1275,64 @@ void DatasetLoader::ConstructBinMappersFromTextData(int rank, int num_machines,
   if (dataset->has_raw()) {
     dataset->ResizeRaw(static_cast<int>(sample_data.size()));
   }
+  if (!config_.output_dataset_schema.empty()) {
+    dataset->SaveSchema(config_.output_dataset_schema.c_str());
+  }
 
   auto t2 = std::chrono::high_resolution_clock::now();
   Log::Info("Construct bin mappers from text data time %.2f seconds",
             std::chrono::duration<double, std::milli>(t2 - t1) * 1e-3);
 }
 
+void DatasetLoader::ConstructFromSchema(int num_total_features, Dataset* dataset) {
+  auto t1 = std::chrono::high_resolution_clock::now();
+  const std::string& filename = config_.input_dataset_schema;
+  auto reader = VirtualFileReader::Make(filename);
+  if (!reader->Init()) {
+    Log::Fatal("Could not read dataset schema %s", filename.c_str());
+  }
+  std::vector<char> buffer;
+  const size_t chunk_size = 1 << 20;
+  size_t read_cnt = 0;
+  do {
+    buffer.resize(read_cnt + chunk_size);
+    read_cnt += reader->Read(buffer.data() + read_cnt, chunk_size);
+  } while (read_cnt == buffer.size());
+  buffer.resize(read_cnt);
+  // only the bin mappers and feature groups are needed, so keep the loaded bins as small as possible
+  std::unique_ptr<Dataset> schema(LoadFromSerializedReference(buffer.data(), buffer.size(), 1, 0));
+  std::vector<char>().swap(buffer);
+
+  if (num_total_features > schema->num_total_features_) {
+    Log::Fatal("The data has %d features, but the dataset schema %s has only %d features",
+               num_total_features, filename.c_str(), schema->num_total_features_);
+  }
+  if (!feature_names_.empty() && feature_names_ != schema->feature_names_) {
+    Log::Fatal("Feature names of the data do not match the dataset schema %s", filename.c_str());
+  }
+  const int label_idx = dataset->label_idx_;
+  dataset->CopyFeatureMapperFrom(schema.get());
+  dataset->label_idx_ = label_idx;
+  dataset->max_bin_by_feature_ = schema->max_bin_by_feature_;
+  dataset->numeric_feature_map_ = schema->numeric_feature_map_;
+  dataset->num_numeric_features_ = schema->num_numeric_features_;
+  dataset->feature_need_push_zeros_.clear();
+  for (int i = 0; i < dataset->num_features_; ++i) {
+    const BinMapper* bin_mapper = dataset->FeatureBinMapper(i);
+    if (bin_mapper->GetDefaultBin() != bin_mapper->GetMostFreqBin()) {
+      dataset->feature_need_push_zeros_.push_back(i);
+    }
+  }
+  dataset->has_raw_ = store_raw_;
+  dataset->device_type_ = config_.device_type;
+  dataset->gpu_device_id_ = config_.gpu_device_id;
+  feature_names_ = dataset->feature_names_;
+
+  auto t2 = std::chrono::high_resolution_clock::now();
+  Log::Info("Construct bin mappers from dataset schema %s time %.2f seconds", filename.c_str(),
+            std::chrono::duration<double, std::milli>(t2 - t1) * 1e-3);
+}
+
 /*! \brief Extract local features from memory */
 void DatasetLoader::ExtractFeaturesFromMemory(std::vector<std::string>* text_data, const Parser* parser, Dataset* dataset) {
   std::vector<std::pair<int, double>> oneline_features;
@@ -1307,7 +1381,7 @@ void DatasetLoader::ExtractFeaturesFromMemory(std::vector<std::string>* text_dat
         for (size_t j = 0; j < feature_row.size(); ++j) {
           int feat_ind = dataset->numeric_feature_map_[j];
           if (feat_ind >= 0) {
-            dataset->raw_data_[feat_ind][i] = feature_row[j];
+            dataset->raw_data_[feat_ind].Set(i, feature_row[j]);
           }
         }
       }
@@ -1365,7 +1439,7 @@ void DatasetLoader::ExtractFeaturesFromMemory(std::vector<std::string>* text_dat
         for (size_t j = 0; j < feature_row.size(); ++j) {
           int feat_ind = dataset->numeric_feature_map_[j];
           if (feat_ind >= 0) {
-            dataset->raw_data_[feat_ind][i] = feature_row[j];
+            dataset->raw_data_[feat_ind].Set(i, feature_row[j]);
           }
         }
       }
@@ -1437,7 +1511,7 @@ void DatasetLoader::ExtractFeaturesFromFile(const char* filename, const Parser*
         for (size_t j = 0; j < feature_row.size(); ++j) {
           int feat_ind = dataset->numeric_feature_map_[j];
           if (feat_ind >= 0) {
-            dataset->raw_data_[feat_ind][i] = feature_row[j];
+            dataset->raw_data_[feat_ind].Set(i, feature_row[j]);
           }
         }
       }
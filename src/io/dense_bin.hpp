@@ -81,6 +81,15 @@ class DenseBin : public Bin {
     }
   }
 
+  void PushBins(int tid, data_size_t start_idx, const uint32_t* values, data_size_t num_values,
+                uint32_t skip_value) override {
+    for (data_size_t i = 0; i < num_values; ++i) {
+      if (values[i] != skip_value) {
+        DenseBin::Push(tid, start_idx + i, values[i]);
+      }
+    }
+  }
+
   void ReSize(data_size_t num_data) override {
     if (num_data_ != num_data) {
       num_data_ = num_data;
@@ -92,6 +101,14 @@ class DenseBin : public Bin {
     }
   }
 
+  void ReSizeForAppend(data_size_t num_data) override {
+    ReSize(num_data);
+    if (IS_4BIT) {
+      // odd records are buffered until FinishLoad, existing ones are already merged into data_
+      buf_.assign((num_data_ + 1) / 2, static_cast<uint8_t>(0));
+    }
+  }
+
   BinIterator* GetIterator(uint32_t min_bin, uint32_t max_bin,
                            uint32_t most_freq_bin) const override;
 
@@ -170,6 +187,50 @@ class DenseBin : public Bin {
         nullptr, start, end, ordered_gradients, nullptr, out);
   }
 
+  template <bool USE_HESSIAN>
+  void ConstructSiblingHistogramsInner(const data_size_t* data_indices, const uint8_t* leaf_of,
+                                       data_size_t start, data_size_t end,
+                                       const score_t* ordered_gradients,
+                                       const score_t* ordered_hessians,
+                                       hist_t* const* out) const {
+    data_size_t i = start;
+    const data_size_t pf_offset = 64 / sizeof(VAL_T);
+    const data_size_t pf_end = end - pf_offset;
+    for (; i < end; ++i) {
+      if (i < pf_end) {
+        const auto pf_idx = data_indices[i + pf_offset];
+        if (IS_4BIT) {
+          PREFETCH_T0(data_.data() + (pf_idx >> 1));
+        } else {
+          PREFETCH_T0(data_.data() + pf_idx);
+        }
+      }
+      hist_t* grad = out[leaf_of[i]];
+      const auto ti = static_cast<uint32_t>(data(data_indices[i])) << 1;
+      grad[ti] += ordered_gradients[i];
+      if (USE_HESSIAN) {
+        grad[ti + 1] += ordered_hessians[i];
+      } else {
+        ++reinterpret_cast<hist_cnt_t*>(grad + 1)[ti];
+      }
+    }
+  }
+
+  void ConstructSiblingHistograms(const data_size_t* data_indices, const uint8_t* leaf_of,
+                                  data_size_t start, data_size_t end,
+                                  const score_t* ordered_gradients, const score_t* ordered_hessians,
+                                  hist_t* const* out) const override {
+    ConstructSiblingHistogramsInner<true>(data_indices, leaf_of, start, end,
+                                          ordered_gradients, ordered_hessians, out);
+  }
+
+  void ConstructSiblingHistograms(const data_size_t* data_indices, const uint8_t* leaf_of,
+                                  data_size_t start, data_size_t end,
+                                  const score_t* ordered_gradients, hist_t* const* out) const override {
+    ConstructSiblingHistogramsInner<false>(data_indices, leaf_of, start, end,
+                                           ordered_gradients, nullptr, out);
+  }
+
 
   template <bool USE_INDICES, bool USE_PREFETCH, bool USE_HESSIAN, typename PACKED_HIST_T, int HIST_BITS>
   void ConstructHistogramIntInner(const data_size_t* data_indices,
@@ -556,6 +617,20 @@ class DenseBin : public Bin {
     }
   }
 
+  void ReplaceRows(const data_size_t* row_indices, data_size_t num_rows,
+                   const uint32_t* values) override {
+    for (data_size_t i = 0; i < num_rows; ++i) {
+      const data_size_t idx = row_indices[i];
+      if (IS_4BIT) {
+        const int i1 = idx >> 1;
+        const int i2 = (idx & 1) << 2;
+        data_[i1] = static_cast<VAL_T>((data_[i1] & ~(0xf << i2)) | (values[i] << i2));
+      } else {
+        data_[idx] = static_cast<VAL_T>(values[i]);
+      }
+    }
+  }
+
   inline VAL_T data(data_size_t idx) const {
     if (IS_4BIT) {
       return (data_[idx >> 1] >> ((idx & 1) << 2)) & 0xf;
@@ -566,10 +641,15 @@ class DenseBin : public Bin {
 
   void CopySubrow(const Bin* full_bin, const data_size_t* used_indices,
                   data_size_t num_used_indices) override {
+    CopySubrowRange(full_bin, used_indices, 0, num_used_indices);
+  }
+
+  void CopySubrowRange(const Bin* full_bin, const data_size_t* used_indices,
+                       data_size_t start, data_size_t end) override {
     auto other_bin = dynamic_cast<const DenseBin<VAL_T, IS_4BIT>*>(full_bin);
     if (IS_4BIT) {
-      const data_size_t rest = num_used_indices & 1;
-      for (int i = 0; i < num_used_indices - rest; i += 2) {
+      const data_size_t rest = (end - start) & 1;
+      for (data_size_t i = start; i < end - rest; i += 2) {
         data_size_t idx = used_indices[i];
         const auto bin1 = static_cast<uint8_t>(
             (other_bin->data_[idx >> 1] >> ((idx & 1) << 2)) & 0xf);
@@ -580,17 +660,19 @@ class DenseBin : public Bin {
         data_[i1] = (bin1 | (bin2 << 4));
       }
       if (rest) {
-        data_size_t idx = used_indices[num_used_indices - 1];
-        data_[num_used_indices >> 1] =
+        data_size_t idx = used_indices[end - 1];
+        data_[(end - 1) >> 1] =
             (other_bin->data_[idx >> 1] >> ((idx & 1) << 2)) & 0xf;
       }
     } else {
-      for (int i = 0; i < num_used_indices; ++i) {
+      for (data_size_t i = start; i < end; ++i) {
         data_[i] = other_bin->data_[used_indices[i]];
       }
     }
   }
 
+  bool IsSparse() const override { return false; }
+
   void SaveBinaryToFile(BinaryWriter* writer) const override {
     writer->AlignedWrite(data_.data(), sizeof(VAL_T) * data_.size());
   }
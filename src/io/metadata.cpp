@@ -5,6 +5,7 @@
 #include <LightGBM/dataset.h>
 #include <LightGBM/utils/common.h>
 
+#include <algorithm>
 #include <set>
 #include <string>
 #include <vector>
@@ -501,6 +502,19 @@ void Metadata::SetWeights(const ArrowChunkedArray& array) {
   SetWeightsFromIterator(array.begin<label_t>(), array.end<label_t>());
 }
 
+void Metadata::SetTimestamps(const double* timestamps, data_size_t len) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  // save to nullptr
+  if (timestamps == nullptr || len == 0) {
+    timestamps_.clear();
+    return;
+  }
+  if (num_data_ != len) {
+    Log::Fatal("Length of timestamps (%d) differs from the length of #data (%d)", len, num_data_);
+  }
+  timestamps_.assign(timestamps, timestamps + len);
+}
+
 void Metadata::InsertWeights(const label_t* weights, data_size_t start_index, data_size_t len) {
   if (!weights) {
     Log::Fatal("Passed null weights");
@@ -776,6 +790,50 @@ void Metadata::InsertAt(data_size_t start_index,
   }
 }
 
+void Metadata::ReSizeForAppend(data_size_t num_data) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (num_data < num_data_) {
+    Log::Fatal("Cannot shrink metadata when appending data");
+  }
+  if (!positions_.empty()) {
+    Log::Fatal("Appending data to dataset with positions is not supported");
+  }
+  const data_size_t num_old_data = num_data_;
+  num_data_ = num_data;
+  label_.resize(num_data_, 0.0f);
+  if (!weights_.empty()) {
+    weights_.resize(num_data_, 0.0f);
+    num_weights_ = num_data_;
+  }
+  if (!init_score_.empty()) {
+    // initial scores are stored by column, so each class is moved to its new offset
+    const int nclasses = static_cast<int>(num_init_score_ / num_old_data);
+    std::vector<double> old_init_score;
+    old_init_score.swap(init_score_);
+    num_init_score_ = static_cast<int64_t>(num_data_) * nclasses;
+    init_score_.resize(num_init_score_, 0.0f);
+    for (int k = 0; k < nclasses; ++k) {
+      std::copy(old_init_score.begin() + static_cast<size_t>(k) * num_old_data,
+                old_init_score.begin() + static_cast<size_t>(k + 1) * num_old_data,
+                init_score_.begin() + static_cast<size_t>(k) * num_data_);
+    }
+  }
+  if (!timestamps_.empty()) {
+    // appended records count as the newest ones of a sliding window
+    const double newest = *std::max_element(timestamps_.begin(), timestamps_.end());
+    timestamps_.resize(num_data_, newest);
+  }
+  if (!query_boundaries_.empty()) {
+    // rebuild query ids of the existing records, they are negative so they never
+    // merge with the query ids of the appended records
+    queries_.resize(num_data_, 0);
+    for (data_size_t i = 0; i < num_queries_; ++i) {
+      std::fill(queries_.begin() + query_boundaries_[i], queries_.begin() + query_boundaries_[i + 1], -(i + 1));
+    }
+    query_load_from_file_ = false;
+  }
+}
+
 void Metadata::FinishLoad() {
   CalculateQueryBoundaries();
 }
@@ -74,7 +74,7 @@ class SparseBin : public Bin {
  public:
   friend class SparseBinIterator<VAL_T>;
 
-  explicit SparseBin(data_size_t num_data) : num_data_(num_data) {
+  explicit SparseBin(data_size_t num_data) : num_data_(num_data), num_vals_(0) {
     int num_threads = OMP_NUM_THREADS();
     push_buffers_.resize(num_threads);
   }
@@ -96,6 +96,17 @@ class SparseBin : public Bin {
     }
   }
 
+  void PushBins(int tid, data_size_t start_idx, const uint32_t* values, data_size_t num_values,
+                uint32_t skip_value) override {
+    auto& push_buffer = push_buffers_[tid];
+    for (data_size_t i = 0; i < num_values; ++i) {
+      const auto cur_bin = static_cast<VAL_T>(values[i]);
+      if (values[i] != skip_value && cur_bin != 0) {
+        push_buffer.emplace_back(start_idx + i, cur_bin);
+      }
+    }
+  }
+
   BinIterator* GetIterator(uint32_t min_bin, uint32_t max_bin,
                            uint32_t most_freq_bin) const override;
 
@@ -203,6 +214,60 @@ class SparseBin : public Bin {
   }
 #undef ACC_GH
 
+  template <bool USE_HESSIAN>
+  void ConstructSiblingHistogramsInner(const data_size_t* data_indices, const uint8_t* leaf_of,
+                                       data_size_t start, data_size_t end,
+                                       const score_t* ordered_gradients,
+                                       const score_t* ordered_hessians,
+                                       hist_t* const* out) const {
+    data_size_t i_delta, cur_pos;
+    InitIndex(data_indices[start], &i_delta, &cur_pos);
+    data_size_t i = start;
+    for (;;) {
+      if (cur_pos < data_indices[i]) {
+        cur_pos += deltas_[++i_delta];
+        if (i_delta >= num_vals_) {
+          break;
+        }
+      } else if (cur_pos > data_indices[i]) {
+        if (++i >= end) {
+          break;
+        }
+      } else {
+        hist_t* grad = out[leaf_of[i]];
+        const uint32_t ti = static_cast<uint32_t>(vals_[i_delta]) << 1;
+        grad[ti] += ordered_gradients[i];
+        if (USE_HESSIAN) {
+          grad[ti + 1] += ordered_hessians[i];
+        } else {
+          ++reinterpret_cast<hist_cnt_t*>(grad + 1)[ti];
+        }
+        if (++i >= end) {
+          break;
+        }
+        cur_pos += deltas_[++i_delta];
+        if (i_delta >= num_vals_) {
+          break;
+        }
+      }
+    }
+  }
+
+  void ConstructSiblingHistograms(const data_size_t* data_indices, const uint8_t* leaf_of,
+                                  data_size_t start, data_size_t end,
+                                  const score_t* ordered_gradients, const score_t* ordered_hessians,
+                                  hist_t* const* out) const override {
+    ConstructSiblingHistogramsInner<true>(data_indices, leaf_of, start, end,
+                                          ordered_gradients, ordered_hessians, out);
+  }
+
+  void ConstructSiblingHistograms(const data_size_t* data_indices, const uint8_t* leaf_of,
+                                  data_size_t start, data_size_t end,
+                                  const score_t* ordered_gradients, hist_t* const* out) const override {
+    ConstructSiblingHistogramsInner<false>(data_indices, leaf_of, start, end,
+                                           ordered_gradients, nullptr, out);
+  }
+
   template <bool USE_HESSIAN, typename PACKED_HIST_T, typename GRAD_HIST_T, typename HESS_HIST_T, int HIST_BITS>
   void ConstructIntHistogramInner(data_size_t start, data_size_t end,
                           const score_t* ordered_gradients_and_hessians,
@@ -603,7 +668,7 @@ class SparseBin : public Bin {
     }
     std::vector<std::pair<data_size_t, VAL_T>>& idx_val_pairs =
         push_buffers_[0];
-    idx_val_pairs.reserve(pair_cnt);
+    idx_val_pairs.reserve(pair_cnt + num_vals_);
 
     for (size_t i = 1; i < push_buffers_.size(); ++i) {
       idx_val_pairs.insert(idx_val_pairs.end(), push_buffers_[i].begin(),
@@ -611,13 +676,67 @@ class SparseBin : public Bin {
       push_buffers_[i].clear();
       push_buffers_[i].shrink_to_fit();
     }
+    auto cmp = [](const std::pair<data_size_t, VAL_T>& a,
+                  const std::pair<data_size_t, VAL_T>& b) {
+      return a.first < b.first;
+    };
     // sort by data index
-    std::sort(idx_val_pairs.begin(), idx_val_pairs.end(),
+    std::sort(idx_val_pairs.begin(), idx_val_pairs.end(), cmp);
+    // records pushed after a previous FinishLoad are merged with the loaded ones
+    if (num_vals_ > 0) {
+      const size_t num_pushed = idx_val_pairs.size();
+      data_size_t i_delta = -1;
+      data_size_t cur_pos = 0;
+      while (NextNonzero(&i_delta, &cur_pos)) {
+        if (vals_[i_delta] > 0) {
+          idx_val_pairs.emplace_back(cur_pos, vals_[i_delta]);
+        }
+      }
+      std::inplace_merge(idx_val_pairs.begin(), idx_val_pairs.begin() + num_pushed,
+                         idx_val_pairs.end(), cmp);
+    }
+    // load delta array
+    LoadFromPair(idx_val_pairs);
+    idx_val_pairs.clear();
+    idx_val_pairs.shrink_to_fit();
+  }
+
+  void ReplaceRows(const data_size_t* row_indices, data_size_t num_rows,
+                   const uint32_t* values) override {
+    std::vector<std::pair<data_size_t, VAL_T>> replaced(num_rows);
+    for (data_size_t i = 0; i < num_rows; ++i) {
+      replaced[i] = std::make_pair(row_indices[i], static_cast<VAL_T>(values[i]));
+    }
+    std::sort(replaced.begin(), replaced.end(),
               [](const std::pair<data_size_t, VAL_T>& a,
                  const std::pair<data_size_t, VAL_T>& b) {
                 return a.first < b.first;
               });
-    // load delta array
+    // merge the loaded records with the replaced ones, dropping overwritten and zero records
+    std::vector<std::pair<data_size_t, VAL_T>> idx_val_pairs;
+    idx_val_pairs.reserve(num_vals_ + num_rows);
+    size_t j = 0;
+    data_size_t i_delta = -1;
+    data_size_t cur_pos = 0;
+    while (NextNonzero(&i_delta, &cur_pos)) {
+      while (j < replaced.size() && replaced[j].first < cur_pos) {
+        if (replaced[j].second > 0) {
+          idx_val_pairs.push_back(replaced[j]);
+        }
+        ++j;
+      }
+      if (j < replaced.size() && replaced[j].first == cur_pos) {
+        continue;
+      }
+      if (vals_[i_delta] > 0) {
+        idx_val_pairs.emplace_back(cur_pos, vals_[i_delta]);
+      }
+    }
+    for (; j < replaced.size(); ++j) {
+      if (replaced[j].second > 0) {
+        idx_val_pairs.push_back(replaced[j]);
+      }
+    }
     LoadFromPair(idx_val_pairs);
   }
 
@@ -742,6 +861,12 @@ class SparseBin : public Bin {
     }
   }
 
+  void CopySubrowRange(const Bin*, const data_size_t*, data_size_t, data_size_t) override {
+    Log::Fatal("Cannot copy a range of rows into a sparse bin");
+  }
+
+  bool IsSparse() const override { return true; }
+
   void CopySubrow(const Bin* full_bin, const data_size_t* used_indices,
                   data_size_t num_used_indices) override {
     auto other_bin = dynamic_cast<const SparseBin<VAL_T>*>(full_bin);
@@ -8,8 +8,11 @@
 #include <LightGBM/utils/common.h>
 #include <LightGBM/utils/threading.h>
 
+#include <algorithm>
+#include <cmath>
 #include <functional>
 #include <iomanip>
+#include <iterator>
 #include <sstream>
 
 namespace LightGBM {
@@ -133,9 +136,9 @@ int Tree::SplitCategorical(int leaf, int feature, int real_feature, const uint32
     double add_score = leaf_const_[node];                                     \
     bool nan_found = false;                                                   \
     const double* coeff_ptr = leaf_coeff_[node].data();                       \
-    const float** data_ptr = feat_ptr[node].data();                           \
+    const RawColumn** data_ptr = feat_ptr[node].data();                       \
     for (size_t j = 0; j < leaf_features_inner_[node].size(); ++j) {          \
-       float feat_val = data_ptr[j][(data_idx)];                              \
+       float feat_val = data_ptr[j]->Get((data_idx));                         \
        if (std::isnan(feat_val)) {                                            \
           nan_found = true;                                                   \
           break;                                                              \
@@ -169,10 +172,10 @@ void Tree::AddPredictionToScore(const Dataset* data, data_size_t num_data, doubl
     max_bins[i] = bin_mapper->num_bin() - 1;
   }
   if (is_linear_) {
-    std::vector<std::vector<const float*>> feat_ptr(num_leaves_);
+    std::vector<std::vector<const RawColumn*>> feat_ptr(num_leaves_);
     for (int leaf_num = 0; leaf_num < num_leaves_; ++leaf_num) {
       for (int feat : leaf_features_inner_[leaf_num]) {
-        feat_ptr[leaf_num].push_back(data->raw_index(feat));
+        feat_ptr[leaf_num].push_back(data->raw_column(feat));
       }
     }
     if (num_cat_ > 0) {
@@ -250,10 +253,10 @@ void Tree::AddPredictionToScore(const Dataset* data,
     max_bins[i] = bin_mapper->num_bin() - 1;
   }
   if (is_linear_) {
-    std::vector<std::vector<const float*>> feat_ptr(num_leaves_);
+    std::vector<std::vector<const RawColumn*>> feat_ptr(num_leaves_);
     for (int leaf_num = 0; leaf_num < num_leaves_; ++leaf_num) {
       for (int feat : leaf_features_inner_[leaf_num]) {
-        feat_ptr[leaf_num].push_back(data->raw_index(feat));
+        feat_ptr[leaf_num].push_back(data->raw_column(feat));
       }
     }
     if (num_cat_ > 0) {
@@ -337,75 +340,79 @@ double Tree::GetLowerBoundValue() const {
 }
 
 std::string Tree::ToString() const {
-  std::stringstream str_buf;
-  Common::C_stringstream(str_buf);
-
-  using CommonC::ArrayToString;
-
-  str_buf << "num_leaves=" << num_leaves_ << '\n';
-  str_buf << "num_cat=" << num_cat_ << '\n';
-  str_buf << "split_feature="
-    << ArrayToString(split_feature_, num_leaves_ - 1) << '\n';
-  str_buf << "split_gain="
-    << ArrayToString(split_gain_, num_leaves_ - 1) << '\n';
-  str_buf << "threshold="
-    << ArrayToString<true>(threshold_, num_leaves_ - 1) << '\n';
-  str_buf << "decision_type="
-    << ArrayToString(Common::ArrayCast<int8_t, int>(decision_type_), num_leaves_ - 1) << '\n';
-  str_buf << "left_child="
-    << ArrayToString(left_child_, num_leaves_ - 1) << '\n';
-  str_buf << "right_child="
-    << ArrayToString(right_child_, num_leaves_ - 1) << '\n';
-  str_buf << "leaf_value="
-    << ArrayToString<true>(leaf_value_, num_leaves_) << '\n';
-  str_buf << "leaf_weight="
-    << ArrayToString<true>(leaf_weight_, num_leaves_) << '\n';
-  str_buf << "leaf_count="
-    << ArrayToString(leaf_count_, num_leaves_) << '\n';
-  str_buf << "internal_value="
-    << ArrayToString(internal_value_, num_leaves_ - 1) << '\n';
-  str_buf << "internal_weight="
-    << ArrayToString(internal_weight_, num_leaves_ - 1) << '\n';
-  str_buf << "internal_count="
-    << ArrayToString(internal_count_, num_leaves_ - 1) << '\n';
+  using CommonC::AppendArrayToString;
+
+  // about 16 numbers are written per leaf, reserve once and format them in place
+  std::string str_buf;
+  str_buf.reserve(256 + static_cast<size_t>(num_leaves_) * (is_linear_ ? 320 : 224));
+  auto out = std::back_inserter(str_buf);
+
+  fmt::format_to(out, "num_leaves={}\n", num_leaves_);
+  fmt::format_to(out, "num_cat={}\n", num_cat_);
+  str_buf += "split_feature=";
+  AppendArrayToString(split_feature_, num_leaves_ - 1, &str_buf);
+  str_buf += "\nsplit_gain=";
+  AppendArrayToString(split_gain_, num_leaves_ - 1, &str_buf);
+  str_buf += "\nthreshold=";
+  AppendArrayToString<true>(threshold_, num_leaves_ - 1, &str_buf);
+  str_buf += "\ndecision_type=";
+  AppendArrayToString(Common::ArrayCast<int8_t, int>(decision_type_), num_leaves_ - 1, &str_buf);
+  str_buf += "\nleft_child=";
+  AppendArrayToString(left_child_, num_leaves_ - 1, &str_buf);
+  str_buf += "\nright_child=";
+  AppendArrayToString(right_child_, num_leaves_ - 1, &str_buf);
+  str_buf += "\nleaf_value=";
+  AppendArrayToString<true>(leaf_value_, num_leaves_, &str_buf);
+  str_buf += "\nleaf_weight=";
+  AppendArrayToString<true>(leaf_weight_, num_leaves_, &str_buf);
+  str_buf += "\nleaf_count=";
+  AppendArrayToString(leaf_count_, num_leaves_, &str_buf);
+  str_buf += "\ninternal_value=";
+  AppendArrayToString(internal_value_, num_leaves_ - 1, &str_buf);
+  str_buf += "\ninternal_weight=";
+  AppendArrayToString(internal_weight_, num_leaves_ - 1, &str_buf);
+  str_buf += "\ninternal_count=";
+  AppendArrayToString(internal_count_, num_leaves_ - 1, &str_buf);
+  str_buf += '\n';
   if (num_cat_ > 0) {
-    str_buf << "cat_boundaries="
-      << ArrayToString(cat_boundaries_, num_cat_ + 1) << '\n';
-    str_buf << "cat_threshold="
-      << ArrayToString(cat_threshold_, cat_threshold_.size()) << '\n';
+    str_buf += "cat_boundaries=";
+    AppendArrayToString(cat_boundaries_, num_cat_ + 1, &str_buf);
+    str_buf += "\ncat_threshold=";
+    AppendArrayToString(cat_threshold_, cat_threshold_.size(), &str_buf);
+    str_buf += '\n';
   }
-  str_buf << "is_linear=" << is_linear_ << '\n';
+  fmt::format_to(out, "is_linear={}\n", static_cast<int>(is_linear_));
 
   if (is_linear_) {
-    str_buf << "leaf_const="
-      << ArrayToString<true>(leaf_const_, num_leaves_) << '\n';
+    str_buf += "leaf_const=";
+    AppendArrayToString<true>(leaf_const_, num_leaves_, &str_buf);
     std::vector<int> num_feat(num_leaves_);
     for (int i = 0; i < num_leaves_; ++i) {
       num_feat[i] = static_cast<int>(leaf_coeff_[i].size());
     }
-    str_buf << "num_features="
-      << ArrayToString(num_feat, num_leaves_) << '\n';
-    str_buf << "leaf_features=";
+    str_buf += "\nnum_features=";
+    AppendArrayToString(num_feat, num_leaves_, &str_buf);
+    str_buf += "\nleaf_features=";
     for (int i = 0; i < num_leaves_; ++i) {
       if (num_feat[i] > 0) {
-        str_buf << ArrayToString(leaf_features_[i], leaf_features_[i].size()) << ' ';
+        AppendArrayToString(leaf_features_[i], leaf_features_[i].size(), &str_buf);
+        str_buf += ' ';
       }
-      str_buf << ' ';
+      str_buf += ' ';
     }
-    str_buf << '\n';
-    str_buf << "leaf_coeff=";
+    str_buf += "\nleaf_coeff=";
     for (int i = 0; i < num_leaves_; ++i) {
       if (num_feat[i] > 0) {
-        str_buf << ArrayToString<true>(leaf_coeff_[i], leaf_coeff_[i].size()) << ' ';
+        AppendArrayToString<true>(leaf_coeff_[i], leaf_coeff_[i].size(), &str_buf);
+        str_buf += ' ';
       }
-      str_buf << ' ';
+      str_buf += ' ';
     }
-    str_buf << '\n';
+    str_buf += '\n';
   }
-  str_buf << "shrinkage=" << shrinkage_ << '\n';
-  str_buf << '\n';
+  fmt::format_to(out, "shrinkage={:g}\n\n", shrinkage_);
 
-  return str_buf.str();
+  return str_buf;
 }
 
 std::string Tree::ToJSON() const {
@@ -1040,6 +1047,361 @@ void Tree::TreeSHAPByMap(const std::unordered_map<int, double>& feature_values,
   }
 }
 
+int64_t Tree::InitSHAPPaths() {
+  shap_leaf_begin_.assign(1, 0);
+  shap_features_.clear();
+  shap_zero_fractions_.clear();
+  shap_node_begin_.assign(1, 0);
+  shap_nodes_.clear();
+  shap_node_masks_.clear();
+  shap_node_right_.clear();
+  shap_table_begin_.assign(1, 0);
+  shap_tables_.clear();
+  shap_interaction_tables_.clear();
+  if (num_leaves_ <= 1) {
+    return 0;
+  }
+  // leaf_parent_ is not stored in model files
+  std::vector<int> node_parent(num_leaves_ - 1, -1);
+  std::vector<int> leaf_parent(num_leaves_, -1);
+  for (int node = 0; node < num_leaves_ - 1; ++node) {
+    for (int child : {left_child_[node], right_child_[node]}) {
+      if (child >= 0) {
+        node_parent[child] = node;
+      } else {
+        leaf_parent[~child] = node;
+      }
+    }
+  }
+  // (node, child) pairs from the leaf up to the root
+  std::vector<std::pair<int, int>> path;
+  for (int leaf = 0; leaf < num_leaves_; ++leaf) {
+    path.clear();
+    for (int child = ~leaf, node = leaf_parent[leaf]; node >= 0; child = node, node = node_parent[node]) {
+      path.emplace_back(node, child);
+    }
+    const int first = shap_leaf_begin_.back();
+    for (auto it = path.rbegin(); it != path.rend(); ++it) {
+      const int node = it->first;
+      const int child = it->second;
+      int slot = 0;
+      while (first + slot < static_cast<int>(shap_features_.size())
+             && shap_features_[first + slot] != split_feature_[node]) {
+        ++slot;
+      }
+      if (slot >= kMaxSHAPPathFeatures) {
+        InitSHAPTables(false);
+        return -1;
+      }
+      if (first + slot == static_cast<int>(shap_features_.size())) {
+        shap_features_.push_back(split_feature_[node]);
+        shap_zero_fractions_.push_back(1.0);
+      }
+      // same order of products as TreeSHAP
+      shap_zero_fractions_[first + slot] *= data_count(child) / static_cast<double>(data_count(node));
+      shap_nodes_.push_back(node);
+      shap_node_masks_.push_back(1u << slot);
+      shap_node_right_.push_back(child == right_child_[node] ? 1 : 0);
+    }
+    const int num_features = static_cast<int>(shap_features_.size()) - first;
+    shap_leaf_begin_.push_back(static_cast<int>(shap_features_.size()));
+    shap_node_begin_.push_back(static_cast<int>(shap_nodes_.size()));
+    shap_table_begin_.push_back(shap_table_begin_.back() + (static_cast<int64_t>(1) << num_features));
+  }
+  return shap_table_begin_.back();
+}
+
+void Tree::InitSHAPTables(bool use_tables) {
+  if (!use_tables || shap_table_begin_.size() != static_cast<size_t>(num_leaves_) + 1) {
+    shap_leaf_begin_.clear();
+    shap_features_.clear();
+    shap_zero_fractions_.clear();
+    shap_node_begin_.clear();
+    shap_nodes_.clear();
+    shap_node_masks_.clear();
+    shap_node_right_.clear();
+    shap_table_begin_.clear();
+    shap_tables_.clear();
+    shap_interaction_tables_.clear();
+    return;
+  }
+  shap_tables_.resize(shap_table_begin_.back());
+  std::vector<double> weights(kMaxSHAPPathFeatures + 1);
+  std::vector<double> coef((kMaxSHAPPathFeatures + 1) * (kMaxSHAPPathFeatures + 1));
+  for (int leaf = 0; leaf < num_leaves_; ++leaf) {
+    const int first = shap_leaf_begin_[leaf];
+    const int num_features = shap_leaf_begin_[leaf + 1] - first;
+    // |S|!(d - |S| - 1)!/d! = 1 / (d * C(d - 1, |S|)), the full set is never used
+    double binomial = 1.0;
+    for (int k = 0; k < num_features; ++k) {
+      weights[k] = 1.0 / (num_features * binomial);
+      binomial = binomial * (num_features - 1 - k) / (k + 1);
+    }
+    weights[num_features] = 0.0;
+    coef[0] = 1.0;
+    FillSHAPTable(shap_zero_fractions_.data() + first, weights.data(), num_features, 0, 0, 0, coef.data(),
+                  shap_tables_.data() + shap_table_begin_[leaf]);
+  }
+  shap_interaction_tables_.clear();
+}
+
+void Tree::InitSHAPInteractionTables() {
+  if (shap_tables_.empty() || !shap_interaction_tables_.empty()) {
+    return;
+  }
+  std::vector<double> weights(kMaxSHAPPathFeatures + 1);
+  std::vector<double> coef((kMaxSHAPPathFeatures + 1) * (kMaxSHAPPathFeatures + 1));
+  shap_interaction_tables_.resize(shap_table_begin_.back());
+  for (int leaf = 0; leaf < num_leaves_; ++leaf) {
+    const int first = shap_leaf_begin_[leaf];
+    const int num_features = shap_leaf_begin_[leaf + 1] - first;
+    // one feature is known, the others play the game of num_features - 1 players
+    const int num_players = num_features - 1;
+    std::fill(weights.begin(), weights.end(), 0.0);
+    double binomial = 1.0;
+    for (int k = 0; k < num_players; ++k) {
+      weights[k] = 1.0 / (num_players * binomial);
+      binomial = binomial * (num_players - 1 - k) / (k + 1);
+    }
+    coef[0] = 1.0;
+    FillSHAPTable(shap_zero_fractions_.data() + first, weights.data(), num_features, 0, 0, 0, coef.data(),
+                  shap_interaction_tables_.data() + shap_table_begin_[leaf]);
+  }
+}
+
+void Tree::FillSHAPTable(const double* zero_fractions, const double* weights, int num_features, int next,
+                         uint32_t subset, int size, double* coef, double* table) {
+  // coefficients of prod_{j in subset} (x + z_j), the coefficient of x^k sums the subsets S of size k
+  const double* cur = coef + size * (kMaxSHAPPathFeatures + 1);
+  double value = 0.0;
+  for (int k = 0; k <= size; ++k) {
+    value += weights[k] * cur[k];
+  }
+  table[subset] = value;
+  double* extended = coef + (size + 1) * (kMaxSHAPPathFeatures + 1);
+  for (int j = next; j < num_features; ++j) {
+    extended[0] = cur[0] * zero_fractions[j];
+    for (int k = 1; k <= size; ++k) {
+      extended[k] = cur[k] * zero_fractions[j] + cur[k - 1];
+    }
+    extended[size + 1] = cur[size];
+    FillSHAPTable(zero_fractions, weights, num_features, j + 1, subset | (1u << j), size + 1, coef, table);
+  }
+}
+
+const int8_t* Tree::NodeDirections(const double* feature_values) const {
+  // reused by the rows and trees predicted on the same thread
+  static thread_local std::vector<int8_t> go_right;
+  go_right.resize(num_leaves_ - 1);
+  for (int node = 0; node < num_leaves_ - 1; ++node) {
+    go_right[node] = Decision(feature_values[split_feature_[node]], node) == right_child_[node] ? 1 : 0;
+  }
+  return go_right.data();
+}
+
+void Tree::FastTreeSHAP(const double *feature_values, double *phi) const {
+  const int8_t* go_right = NodeDirections(feature_values);
+  for (int leaf = 0; leaf < num_leaves_; ++leaf) {
+    const int first = shap_leaf_begin_[leaf];
+    const int num_features = shap_leaf_begin_[leaf + 1] - first;
+    const double* zero_fractions = shap_zero_fractions_.data() + first;
+    // features whose conditions on the path the row satisfies
+    uint32_t ones = (1u << num_features) - 1;
+    for (int i = shap_node_begin_[leaf]; i < shap_node_begin_[leaf + 1]; ++i) {
+      if (go_right[shap_nodes_[i]] != shap_node_right_[i]) {
+        ones &= ~shap_node_masks_[i];
+      }
+    }
+    // product of the zero fractions of the features not in ones
+    double zero_product = 1.0;
+    for (int j = 0; j < num_features; ++j) {
+      zero_product *= ((ones >> j) & 1) ? 1.0 : zero_fractions[j];
+    }
+    const double* table = shap_tables_.data() + shap_table_begin_[leaf];
+    const double in_weight = leaf_value_[leaf] * zero_product;
+    const double out_weight = in_weight * table[ones];
+    for (int j = 0; j < num_features; ++j) {
+      if ((ones >> j) & 1) {
+        phi[shap_features_[first + j]] += in_weight * (1.0 - zero_fractions[j]) * table[ones ^ (1u << j)];
+      } else {
+        phi[shap_features_[first + j]] -= out_weight;
+      }
+    }
+  }
+}
+
+template <typename ADD>
+void Tree::FastTreeSHAPInteraction(const double* feature_values, ADD add) const {
+  const int8_t* go_right = NodeDirections(feature_values);
+  double prefix[kMaxSHAPPathFeatures + 1];
+  double suffix[kMaxSHAPPathFeatures + 1];
+  for (int leaf = 0; leaf < num_leaves_; ++leaf) {
+    const int first = shap_leaf_begin_[leaf];
+    const int num_features = shap_leaf_begin_[leaf + 1] - first;
+    if (num_features < 2) {
+      continue;
+    }
+    const int* features = shap_features_.data() + first;
+    const double* zero_fractions = shap_zero_fractions_.data() + first;
+    uint32_t ones = (1u << num_features) - 1;
+    for (int i = shap_node_begin_[leaf]; i < shap_node_begin_[leaf + 1]; ++i) {
+      if (go_right[shap_nodes_[i]] != shap_node_right_[i]) {
+        ones &= ~shap_node_masks_[i];
+      }
+    }
+    // products of the zero fractions of the features not in ones, without feature j
+    prefix[0] = 1.0;
+    for (int j = 0; j < num_features; ++j) {
+      prefix[j + 1] = prefix[j] * (((ones >> j) & 1) ? 1.0 : zero_fractions[j]);
+    }
+    suffix[num_features] = 1.0;
+    for (int j = num_features - 1; j >= 0; --j) {
+      suffix[j] = suffix[j + 1] * (((ones >> j) & 1) ? 1.0 : zero_fractions[j]);
+    }
+    const double* table = shap_interaction_tables_.data() + shap_table_begin_[leaf];
+    for (int j = 0; j < num_features; ++j) {
+      const double one_fraction = ((ones >> j) & 1) ? 1.0 : 0.0;
+      const double in_weight = 0.5 * leaf_value_[leaf] * (one_fraction - zero_fractions[j]) * prefix[j] * suffix[j + 1];
+      if (in_weight == 0.0) {
+        continue;
+      }
+      const uint32_t others = ones & ~(1u << j);
+      const double out_weight = in_weight * table[others];
+      for (int i = 0; i < num_features; ++i) {
+        if (i == j) {
+          continue;
+        }
+        if ((others >> i) & 1) {
+          add(features[i], features[j], in_weight * (1.0 - zero_fractions[i]) * table[others ^ (1u << i)]);
+        } else {
+          add(features[i], features[j], -out_weight);
+        }
+      }
+    }
+  }
+}
+
+template <typename ADD>
+void Tree::ConditionalTreeSHAPInteraction(const double* feature_values, int num_features, ADD add) const {
+  std::vector<int> features(split_feature_.begin(), split_feature_.begin() + num_leaves_ - 1);
+  std::sort(features.begin(), features.end());
+  features.erase(std::unique(features.begin(), features.end()), features.end());
+  // only the entries of the split features are written, and reset after each condition
+  std::vector<double> phi_on(num_features + 1, 0.0);
+  std::vector<double> phi_off(num_features + 1, 0.0);
+  CHECK_GE(max_depth_, 0);
+  const int max_path_len = max_depth_ + 2;
+  std::vector<PathElement> unique_path_data(max_path_len * (max_path_len + 1) / 2);
+  for (int j : features) {
+    ConditionalTreeSHAP(feature_values, phi_on.data(), 0, 0, unique_path_data.data(), 1, 1, -1, 1, j, 1);
+    ConditionalTreeSHAP(feature_values, phi_off.data(), 0, 0, unique_path_data.data(), 1, 1, -1, -1, j, 1);
+    for (int i : features) {
+      if (i != j) {
+        add(i, j, 0.5 * (phi_on[i] - phi_off[i]));
+      }
+      phi_on[i] = 0.0;
+      phi_off[i] = 0.0;
+    }
+  }
+}
+
+void Tree::ConditionalTreeSHAP(const double* feature_values, double* phi, int node, int unique_depth,
+                               PathElement* parent_unique_path, double parent_zero_fraction,
+                               double parent_one_fraction, int parent_feature_index, int condition,
+                               int condition_feature, double condition_fraction) const {
+  // stop if no weight comes down to this node
+  if (condition_fraction == 0) {
+    return;
+  }
+  PathElement* unique_path = parent_unique_path + unique_depth + 1;
+  std::copy(parent_unique_path, parent_unique_path + unique_depth + 1, unique_path);
+  // the known or unknown feature is not a player
+  if (condition == 0 || condition_feature != parent_feature_index) {
+    ExtendPath(unique_path, unique_depth, parent_zero_fraction, parent_one_fraction, parent_feature_index);
+  }
+
+  // leaf node
+  if (node < 0) {
+    for (int i = 1; i <= unique_depth; ++i) {
+      const double w = UnwoundPathSum(unique_path, unique_depth, i);
+      const PathElement &el = unique_path[i];
+      phi[el.feature_index] += w * (el.one_fraction - el.zero_fraction) * leaf_value_[~node] * condition_fraction;
+    }
+
+  // internal node
+  } else {
+    const int hot_index = Decision(feature_values[split_feature_[node]], node);
+    const int cold_index = (hot_index == left_child_[node] ? right_child_[node] : left_child_[node]);
+    const double w = data_count(node);
+    const double hot_zero_fraction = data_count(hot_index) / w;
+    const double cold_zero_fraction = data_count(cold_index) / w;
+    double incoming_zero_fraction = 1;
+    double incoming_one_fraction = 1;
+
+    int path_index = 0;
+    for (; path_index <= unique_depth; ++path_index) {
+      if (unique_path[path_index].feature_index == split_feature_[node]) break;
+    }
+    if (path_index != unique_depth + 1) {
+      incoming_zero_fraction = unique_path[path_index].zero_fraction;
+      incoming_one_fraction = unique_path[path_index].one_fraction;
+      UnwindPath(unique_path, unique_depth, path_index);
+      unique_depth -= 1;
+    }
+
+    // a known feature follows the record, an unknown one splits the weight like the data
+    double hot_condition_fraction = condition_fraction;
+    double cold_condition_fraction = condition_fraction;
+    if (condition > 0 && split_feature_[node] == condition_feature) {
+      cold_condition_fraction = 0;
+      unique_depth -= 1;
+    } else if (condition < 0 && split_feature_[node] == condition_feature) {
+      hot_condition_fraction *= hot_zero_fraction;
+      cold_condition_fraction *= cold_zero_fraction;
+      unique_depth -= 1;
+    }
+
+    ConditionalTreeSHAP(feature_values, phi, hot_index, unique_depth + 1, unique_path,
+                        hot_zero_fraction * incoming_zero_fraction, incoming_one_fraction, split_feature_[node],
+                        condition, condition_feature, hot_condition_fraction);
+
+    ConditionalTreeSHAP(feature_values, phi, cold_index, unique_depth + 1, unique_path,
+                        cold_zero_fraction * incoming_zero_fraction, 0, split_feature_[node],
+                        condition, condition_feature, cold_condition_fraction);
+  }
+}
+
+void Tree::PredictInteraction(const double* feature_values, int num_features, double* output) const {
+  if (num_leaves_ <= 1) {
+    return;
+  }
+  const int64_t num_cols = num_features + 1;
+  auto add = [output, num_cols](int i, int j, double value) {
+    output[i * num_cols + j] += value;
+  };
+  if (!shap_interaction_tables_.empty()) {
+    FastTreeSHAPInteraction(feature_values, add);
+  } else {
+    ConditionalTreeSHAPInteraction(feature_values, num_features, add);
+  }
+}
+
+void Tree::PredictInteractionSparse(const double* feature_values, int num_features,
+                                    std::unordered_map<int, double>* output) const {
+  if (num_leaves_ <= 1) {
+    return;
+  }
+  const int num_cols = num_features + 1;
+  auto add = [output, num_cols](int i, int j, double value) {
+    (*output)[i * num_cols + j] += value;
+  };
+  if (!shap_interaction_tables_.empty()) {
+    FastTreeSHAPInteraction(feature_values, add);
+  } else {
+    ConditionalTreeSHAPInteraction(feature_values, num_features, add);
+  }
+}
+
 double Tree::ExpectedValue() const {
   if (num_leaves_ == 1) return LeafOutput(0);
   const double total_count = internal_count_[0];
@@ -1050,6 +1412,59 @@ double Tree::ExpectedValue() const {
   return exp_value;
 }
 
+bool Tree::HasSameSplits(const Tree& other) const {
+  if (num_leaves_ != other.num_leaves_ || is_linear_ || other.is_linear_) {
+    return false;
+  }
+  for (int i = 0; i < num_leaves_ - 1; ++i) {
+    if (left_child_[i] != other.left_child_[i] || right_child_[i] != other.right_child_[i]
+        || split_feature_[i] != other.split_feature_[i] || decision_type_[i] != other.decision_type_[i]) {
+      return false;
+    }
+    if (GetDecisionType(decision_type_[i], kCategoricalMask)) {
+      const int cat_idx = static_cast<int>(threshold_[i]);
+      const int other_cat_idx = static_cast<int>(other.threshold_[i]);
+      const int num_words = cat_boundaries_[cat_idx + 1] - cat_boundaries_[cat_idx];
+      if (num_words != other.cat_boundaries_[other_cat_idx + 1] - other.cat_boundaries_[other_cat_idx]
+          || !std::equal(cat_threshold_.begin() + cat_boundaries_[cat_idx],
+                         cat_threshold_.begin() + cat_boundaries_[cat_idx + 1],
+                         other.cat_threshold_.begin() + other.cat_boundaries_[other_cat_idx])) {
+        return false;
+      }
+    } else if (threshold_[i] != other.threshold_[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void Tree::AddLeafOutputs(const Tree& other) {
+  for (int i = 0; i < num_leaves_ - 1; ++i) {
+    leaf_value_[i] = MaybeRoundToZero(leaf_value_[i] + other.leaf_value_[i]);
+    internal_value_[i] = MaybeRoundToZero(internal_value_[i] + other.internal_value_[i]);
+  }
+  leaf_value_[num_leaves_ - 1] = MaybeRoundToZero(leaf_value_[num_leaves_ - 1] + other.leaf_value_[num_leaves_ - 1]);
+  shrinkage_ = 1.0f;
+}
+
+double Tree::MeanAbsOutput() const {
+  double total_count = 0.0;
+  double sum = 0.0;
+  for (int i = 0; i < num_leaves_; ++i) {
+    total_count += leaf_count_[i];
+    sum += leaf_count_[i] * std::fabs(leaf_value_[i]);
+  }
+  if (total_count > 0.0) {
+    return sum / total_count;
+  }
+  // no data counts, e.g. a constant tree, every leaf counts the same
+  sum = 0.0;
+  for (int i = 0; i < num_leaves_; ++i) {
+    sum += std::fabs(leaf_value_[i]);
+  }
+  return sum / num_leaves_;
+}
+
 void Tree::RecomputeMaxDepth() {
   if (num_leaves_ == 1) {
     max_depth_ = 0;
@@ -8,9 +8,14 @@
 #include <LightGBM/metric.h>
 #include <LightGBM/utils/common.h>
 #include <LightGBM/utils/log.h>
+#include <LightGBM/utils/openmp_wrapper.h>
+#include <LightGBM/utils/threading.h>
 
 #include <string>
 #include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
 #include <sstream>
 #include <vector>
 
@@ -96,6 +101,26 @@ class BinaryMetric: public Metric {
     return std::vector<double>(1, loss);
   }
 
+  bool IsPointwise() const override { return true; }
+
+  double SumPointLoss(const double* converted_score, data_size_t start, data_size_t count) const override {
+    double sum_loss = 0.0f;
+    if (weights_ == nullptr) {
+      for (data_size_t i = 0; i < count; ++i) {
+        sum_loss += PointWiseLossCalculator::LossOnPoint(label_[start + i], converted_score[i]);
+      }
+    } else {
+      for (data_size_t i = 0; i < count; ++i) {
+        sum_loss += PointWiseLossCalculator::LossOnPoint(label_[start + i], converted_score[i]) * weights_[start + i];
+      }
+    }
+    return sum_loss;
+  }
+
+  std::vector<double> FinishPointLoss(double sum_loss) const override {
+    return std::vector<double>(1, sum_loss / sum_weights_);
+  }
+
  protected:
   /*! \brief Number of data */
   data_size_t num_data_;
@@ -153,6 +178,115 @@ class BinaryErrorMetric: public BinaryMetric<BinaryErrorMetric> {
   }
 };
 
+/*!
+* \brief Orders rows by descending score, like Common::ParallelSort on all indices, with a parallel bucket sort.
+*        Scores are mapped by value to fine-grained buckets, so only the rows of a bucket holding distinct scores
+*        need to be sorted, each bucket on its own. Ties end up in the same bucket. Small or non-finite inputs, and
+*        score ranges too narrow to be scaled to buckets, fall back to the exact sort.
+*        An instance holds the output and its buffers, which are reused by the next call.
+*/
+class DescendingScoreOrder {
+ public:
+  /*!
+  * \brief Sort the rows by descending score
+  * \return Indices of the rows, valid until the next call
+  */
+  const std::vector<data_size_t>& Sort(const double* score, data_size_t num_data) {
+    order_.resize(num_data);
+    int num_blocks = 1;
+    data_size_t block_size = num_data;
+    Threading::BlockInfo<data_size_t>(num_data, kMinBlockSize, &num_blocks, &block_size);
+    std::vector<double> block_min(num_blocks, std::numeric_limits<double>::infinity());
+    std::vector<double> block_max(num_blocks, -std::numeric_limits<double>::infinity());
+    std::vector<int> block_finite(num_blocks, 1);
+    #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static, 1)
+    for (int block = 0; block < num_blocks; ++block) {
+      const data_size_t start = block * block_size;
+      const data_size_t end = std::min(num_data, start + block_size);
+      for (data_size_t i = start; i < end; ++i) {
+        order_[i] = i;
+        block_finite[block] &= std::isfinite(score[i]);
+        block_min[block] = std::min(block_min[block], score[i]);
+        block_max[block] = std::max(block_max[block], score[i]);
+      }
+    }
+    const double min_score = *std::min_element(block_min.begin(), block_min.end());
+    const double max_score = *std::max_element(block_max.begin(), block_max.end());
+    const bool is_finite = std::find(block_finite.begin(), block_finite.end(), 0) == block_finite.end();
+    const int num_buckets = std::min(num_data / kRowsPerBucket, static_cast<int>(kMaxNumBuckets));
+    // a denormal spread makes the scale infinite, and the keys NaN
+    const double scale = max_score > min_score ? (num_buckets - 1) / (max_score - min_score) : 0.0;
+    if (num_data < kMinBucketSortSize || !is_finite || !std::isfinite(max_score - min_score)
+        || !std::isfinite(scale)) {
+      Common::ParallelSort(order_.begin(), order_.end(), [score](data_size_t a, data_size_t b) {
+        return score[a] > score[b];
+      });
+      return order_;
+    }
+
+    // the key of a score is monotone, and small keys are the high scores
+    auto key = [=](double value) {
+      const int bucket = std::min(static_cast<int>((value - min_score) * scale), num_buckets - 1);
+      return num_buckets - 1 - bucket;
+    };
+    // counts of each (block, bucket), then the first output position of each (block, bucket)
+    block_offsets_.assign(static_cast<size_t>(num_blocks) * num_buckets, 0);
+    #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static, 1)
+    for (int block = 0; block < num_blocks; ++block) {
+      data_size_t* counts = block_offsets_.data() + static_cast<size_t>(block) * num_buckets;
+      const data_size_t end = std::min(num_data, block * block_size + block_size);
+      for (data_size_t i = block * block_size; i < end; ++i) {
+        ++counts[key(score[i])];
+      }
+    }
+    bucket_starts_.resize(num_buckets + 1);
+    data_size_t offset = 0;
+    for (int bucket = 0; bucket < num_buckets; ++bucket) {
+      bucket_starts_[bucket] = offset;
+      for (int block = 0; block < num_blocks; ++block) {
+        data_size_t* pos = block_offsets_.data() + static_cast<size_t>(block) * num_buckets + bucket;
+        const data_size_t cnt = *pos;
+        *pos = offset;
+        offset += cnt;
+      }
+    }
+    bucket_starts_[num_buckets] = offset;
+    #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static, 1)
+    for (int block = 0; block < num_blocks; ++block) {
+      data_size_t* pos = block_offsets_.data() + static_cast<size_t>(block) * num_buckets;
+      const data_size_t end = std::min(num_data, block * block_size + block_size);
+      for (data_size_t i = block * block_size; i < end; ++i) {
+        order_[pos[key(score[i])]++] = i;
+      }
+    }
+    // resolve the order within the buckets that got distinct scores
+    #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(dynamic, 256)
+    for (int bucket = 0; bucket < num_buckets; ++bucket) {
+      auto first = order_.begin() + bucket_starts_[bucket];
+      auto last = order_.begin() + bucket_starts_[bucket + 1];
+      if (first == last) {
+        continue;
+      }
+      const double bucket_score = score[*first];
+      if (std::any_of(first, last, [score, bucket_score](data_size_t i) { return score[i] != bucket_score; })) {
+        std::sort(first, last, [score](data_size_t a, data_size_t b) { return score[a] > score[b]; });
+      }
+    }
+    return order_;
+  }
+
+ private:
+  /*! \brief Below this number of rows, the rows are sorted directly */
+  static const data_size_t kMinBucketSortSize = 4096;
+  static const data_size_t kMinBlockSize = 65536;
+  static const data_size_t kRowsPerBucket = 16;
+  static const int kMaxNumBuckets = 1 << 18;
+
+  std::vector<data_size_t> order_;
+  std::vector<data_size_t> block_offsets_;
+  std::vector<data_size_t> bucket_starts_;
+};
+
 /*!
 * \brief Auc Metric for binary classification task.
 */
@@ -192,12 +326,11 @@ class AUCMetric: public Metric {
   }
 
   std::vector<double> Eval(const double* score, const ObjectiveFunction*) const override {
-    // get indices sorted by score, descent order
-    std::vector<data_size_t> sorted_idx;
-    for (data_size_t i = 0; i < num_data_; ++i) {
-      sorted_idx.emplace_back(i);
-    }
-    Common::ParallelSort(sorted_idx.begin(), sorted_idx.end(), [score](data_size_t a, data_size_t b) {return score[a] > score[b]; });
+    // get indices sorted by score, descent order, an evaluation running concurrently uses its own buffers
+    std::unique_lock<std::mutex> lock(score_order_mutex_, std::try_to_lock);
+    DescendingScoreOrder concurrent_order;
+    DescendingScoreOrder& score_order = lock.owns_lock() ? score_order_ : concurrent_order;
+    const std::vector<data_size_t>& sorted_idx = score_order.Sort(score, num_data_);
     // temp sum of positive label
     double cur_pos = 0.0f;
     // total sum of positive label
@@ -261,6 +394,9 @@ class AUCMetric: public Metric {
   double sum_weights_;
   /*! \brief Name of test set */
   std::vector<std::string> name_;
+  /*! \brief Order of the rows by score, its buffers are kept across evaluations */
+  mutable DescendingScoreOrder score_order_;
+  mutable std::mutex score_order_mutex_;
 };
 
 
@@ -303,12 +439,11 @@ class AveragePrecisionMetric: public Metric {
   }
 
   std::vector<double> Eval(const double* score, const ObjectiveFunction*) const override {
-    // get indices sorted by score, descending order
-    std::vector<data_size_t> sorted_idx;
-    for (data_size_t i = 0; i < num_data_; ++i) {
-      sorted_idx.emplace_back(i);
-    }
-    Common::ParallelSort(sorted_idx.begin(), sorted_idx.end(), [score](data_size_t a, data_size_t b) {return score[a] > score[b]; });
+    // get indices sorted by score, descending order, an evaluation running concurrently uses its own buffers
+    std::unique_lock<std::mutex> lock(score_order_mutex_, std::try_to_lock);
+    DescendingScoreOrder concurrent_order;
+    DescendingScoreOrder& score_order = lock.owns_lock() ? score_order_ : concurrent_order;
+    const std::vector<data_size_t>& sorted_idx = score_order.Sort(score, num_data_);
     // temp sum of positive label
     double cur_actual_pos = 0.0f;
     // total sum of positive label
@@ -382,6 +517,9 @@ class AveragePrecisionMetric: public Metric {
   double sum_weights_;
   /*! \brief Name of test set */
   std::vector<std::string> name_;
+  /*! \brief Order of the rows by score, its buffers are kept across evaluations */
+  mutable DescendingScoreOrder score_order_;
+  mutable std::mutex score_order_mutex_;
 };
 
 }  // namespace LightGBM
@@ -106,15 +106,48 @@ void DCGCalculator::CalMaxDCG(const std::vector<data_size_t>& ks,
   }
 }
 
-void DCGCalculator::CalDCG(const std::vector<data_size_t>& ks, const label_t* label,
-                           const double * score, data_size_t num_data, std::vector<double>* out) {
-  // get sorted indices by score
-  std::vector<data_size_t> sorted_idx(num_data);
+void DCGCalculator::SortTopK(data_size_t k, const double* score, data_size_t num_data,
+                             std::vector<data_size_t>* sorted_idx) {
+  sorted_idx->resize(num_data);
   for (data_size_t i = 0; i < num_data; ++i) {
-    sorted_idx[i] = i;
+    (*sorted_idx)[i] = i;
   }
-  std::stable_sort(sorted_idx.begin(), sorted_idx.end(),
-                   [score](data_size_t a, data_size_t b) {return score[a] > score[b]; });
+  // ties are broken by index, which is the order of a stable sort
+  auto greater = [score](data_size_t a, data_size_t b) {
+    return score[a] > score[b] || (score[a] == score[b] && a < b);
+  };
+  if (k >= num_data) {
+    std::sort(sorted_idx->begin(), sorted_idx->end(), greater);
+  } else if (k > 0) {
+    std::nth_element(sorted_idx->begin(), sorted_idx->begin() + k - 1, sorted_idx->end(), greater);
+    std::sort(sorted_idx->begin(), sorted_idx->begin() + k - 1, greater);
+  }
+}
+
+std::vector<data_size_t> DCGCalculator::QueriesBySize(const data_size_t* query_boundaries,
+                                                      data_size_t num_queries) {
+  std::vector<data_size_t> queries(num_queries);
+  for (data_size_t i = 0; i < num_queries; ++i) {
+    queries[i] = i;
+  }
+  std::stable_sort(queries.begin(), queries.end(), [query_boundaries](data_size_t a, data_size_t b) {
+    return query_boundaries[a + 1] - query_boundaries[a] > query_boundaries[b + 1] - query_boundaries[b];
+  });
+  return queries;
+}
+
+void DCGCalculator::CalDCG(const std::vector<data_size_t>& ks, const label_t* label,
+                           const double * score, data_size_t num_data, std::vector<double>* out) {
+  std::vector<data_size_t> sorted_idx;
+  CalDCG(ks, label, score, num_data, out, &sorted_idx);
+}
+
+void DCGCalculator::CalDCG(const std::vector<data_size_t>& ks, const label_t* label,
+                           const double * score, data_size_t num_data, std::vector<double>* out,
+                           std::vector<data_size_t>* sorted_idx_buffer) {
+  // get sorted indices by score, only the top max(ks) are needed
+  SortTopK(*std::max_element(ks.begin(), ks.end()), score, num_data, sorted_idx_buffer);
+  const std::vector<data_size_t>& sorted_idx = *sorted_idx_buffer;
 
   double cur_result = 0.0f;
   data_size_t cur_left = 0;
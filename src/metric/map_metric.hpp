@@ -10,6 +10,7 @@
 #include <LightGBM/utils/log.h>
 #include <LightGBM/utils/openmp_wrapper.h>
 
+#include <mutex>
 #include <string>
 #include <algorithm>
 #include <sstream>
@@ -53,6 +54,9 @@ class MapMetric:public Metric {
       }
     }
 
+    query_order_ = DCGCalculator::QueriesBySize(query_boundaries_, num_queries_);
+    query_results_.resize(static_cast<size_t>(num_queries_) * eval_at_.size());
+    sorted_idx_buffers_.resize(OMP_NUM_THREADS());
     npos_per_query_.resize(num_queries_, 0);
     for (data_size_t i = 0; i < num_queries_; ++i) {
       for (data_size_t j = query_boundaries_[i]; j < query_boundaries_[i + 1]; ++j) {
@@ -71,15 +75,12 @@ class MapMetric:public Metric {
     return 1.0f;
   }
 
-  void CalMapAtK(std::vector<int> ks, data_size_t npos, const label_t* label,
-                 const double* score, data_size_t num_data, std::vector<double>* out) const {
-    // get sorted indices by score
-    std::vector<data_size_t> sorted_idx;
-    for (data_size_t i = 0; i < num_data; ++i) {
-      sorted_idx.emplace_back(i);
-    }
-    std::stable_sort(sorted_idx.begin(), sorted_idx.end(),
-                     [score](data_size_t a, data_size_t b) {return score[a] > score[b]; });
+  void CalMapAtK(const std::vector<int>& ks, data_size_t npos, const label_t* label,
+                 const double* score, data_size_t num_data, std::vector<double>* out,
+                 std::vector<data_size_t>* sorted_idx_buffer) const {
+    // get sorted indices by score, only the top max(ks) are needed
+    DCGCalculator::SortTopK(*std::max_element(ks.begin(), ks.end()), score, num_data, sorted_idx_buffer);
+    const std::vector<data_size_t>& sorted_idx = *sorted_idx_buffer;
 
     int num_hit = 0;
     double sum_ap = 0.0f;
@@ -103,40 +104,39 @@ class MapMetric:public Metric {
     }
   }
   std::vector<double> Eval(const double* score, const ObjectiveFunction*) const override {
-    // some buffers for multi-threading sum up
-    int num_threads = OMP_NUM_THREADS();
-    std::vector<std::vector<double>> result_buffer_;
-    for (int i = 0; i < num_threads; ++i) {
-      result_buffer_.emplace_back(eval_at_.size(), 0.0f);
+    const size_t num_eval = eval_at_.size();
+    // the buffers of the metric are reused, an evaluation running concurrently allocates its own
+    std::unique_lock<std::mutex> lock(buffers_mutex_, std::try_to_lock);
+    std::vector<double> concurrent_results;
+    std::vector<std::vector<data_size_t>> concurrent_sorted_idx;
+    if (!lock.owns_lock()) {
+      concurrent_results.resize(static_cast<size_t>(num_queries_) * num_eval);
     }
-    std::vector<double> tmp_map(eval_at_.size(), 0.0f);
-    if (query_weights_ == nullptr) {
-      #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(guided) firstprivate(tmp_map)
-      for (data_size_t i = 0; i < num_queries_; ++i) {
-        const int tid = omp_get_thread_num();
-        CalMapAtK(eval_at_, npos_per_query_[i], label_ + query_boundaries_[i],
-                  score + query_boundaries_[i], query_boundaries_[i + 1] - query_boundaries_[i], &tmp_map);
-        for (size_t j = 0; j < eval_at_.size(); ++j) {
-          result_buffer_[tid][j] += tmp_map[j];
-        }
-      }
-    } else {
-      #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(guided) firstprivate(tmp_map)
-      for (data_size_t i = 0; i < num_queries_; ++i) {
-        const int tid = omp_get_thread_num();
-        CalMapAtK(eval_at_, npos_per_query_[i], label_ + query_boundaries_[i],
-                  score + query_boundaries_[i], query_boundaries_[i + 1] - query_boundaries_[i], &tmp_map);
-        for (size_t j = 0; j < eval_at_.size(); ++j) {
-          result_buffer_[tid][j] += tmp_map[j] * query_weights_[i];
-        }
-      }
+    std::vector<double>& query_results = lock.owns_lock() ? query_results_ : concurrent_results;
+    std::vector<std::vector<data_size_t>>& sorted_idx_buffers =
+        lock.owns_lock() ? sorted_idx_buffers_ : concurrent_sorted_idx;
+    if (sorted_idx_buffers.size() < static_cast<size_t>(OMP_NUM_THREADS())) {
+      sorted_idx_buffers.resize(OMP_NUM_THREADS());
     }
-    // Get final average MAP
-    std::vector<double> result(eval_at_.size(), 0.0f);
-    for (size_t j = 0; j < result.size(); ++j) {
-      for (int i = 0; i < num_threads; ++i) {
-        result[j] += result_buffer_[i][j];
+    std::vector<double> tmp_map(num_eval, 0.0f);
+    // large queries first, so the dynamic schedule ends with the small ones
+    #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(dynamic, 16) firstprivate(tmp_map)
+    for (data_size_t q = 0; q < num_queries_; ++q) {
+      const data_size_t i = query_order_[q];
+      CalMapAtK(eval_at_, npos_per_query_[i], label_ + query_boundaries_[i],
+                score + query_boundaries_[i], query_boundaries_[i + 1] - query_boundaries_[i], &tmp_map,
+                &sorted_idx_buffers[omp_get_thread_num()]);
+      std::copy(tmp_map.begin(), tmp_map.end(), query_results.begin() + static_cast<size_t>(i) * num_eval);
+    }
+    // Get final average MAP, summed in query order so that the result does not depend on the schedule
+    std::vector<double> result(num_eval, 0.0f);
+    for (data_size_t i = 0; i < num_queries_; ++i) {
+      const double query_weight = query_weights_ == nullptr ? 1.0f : query_weights_[i];
+      for (size_t j = 0; j < num_eval; ++j) {
+        result[j] += query_results[static_cast<size_t>(i) * num_eval + j] * query_weight;
       }
+    }
+    for (size_t j = 0; j < num_eval; ++j) {
       result[j] /= sum_query_weights_;
     }
     return result;
@@ -159,6 +159,12 @@ class MapMetric:public Metric {
   std::vector<data_size_t> eval_at_;
   std::vector<std::string> name_;
   std::vector<data_size_t> npos_per_query_;
+  /*! \brief Queries by descending number of rows */
+  std::vector<data_size_t> query_order_;
+  /*! \brief Results of each query, then per-thread buffers of the sorted indices, kept across evaluations */
+  mutable std::vector<double> query_results_;
+  mutable std::vector<std::vector<data_size_t>> sorted_idx_buffers_;
+  mutable std::mutex buffers_mutex_;
 };
 
 }  // namespace LightGBM
@@ -3,6 +3,11 @@
  * Licensed under the MIT License. See LICENSE file in the project root for license information.
  */
 #include <LightGBM/metric.h>
+#include <LightGBM/utils/openmp_wrapper.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
 
 #include "binary_metric.hpp"
 #include "map_metric.hpp"
@@ -16,6 +21,41 @@
 
 namespace LightGBM {
 
+std::vector<std::vector<double>> Metric::EvalPointwise(const std::vector<const Metric*>& metrics,
+                                                       const double* score, data_size_t num_data,
+                                                       const ObjectiveFunction* objective) {
+  // the sums of the blocks are added in block order, so the results do not depend on the number of threads
+  const data_size_t block_size = 1024;
+  const int num_blocks = (num_data + block_size - 1) / block_size;
+  const size_t num_metrics = metrics.size();
+  std::vector<double> block_sums(static_cast<size_t>(num_blocks) * num_metrics);
+  std::vector<double> converted(block_size);
+  #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static) firstprivate(converted)
+  for (int block = 0; block < num_blocks; ++block) {
+    const data_size_t start = block * block_size;
+    const data_size_t count = std::min(block_size, num_data - start);
+    const double* block_score = score + start;
+    if (objective != nullptr) {
+      for (data_size_t i = 0; i < count; ++i) {
+        objective->ConvertOutput(block_score + i, converted.data() + i);
+      }
+      block_score = converted.data();
+    }
+    for (size_t j = 0; j < num_metrics; ++j) {
+      block_sums[block * num_metrics + j] = metrics[j]->SumPointLoss(block_score, start, count);
+    }
+  }
+  std::vector<std::vector<double>> results(num_metrics);
+  for (size_t j = 0; j < num_metrics; ++j) {
+    double sum_loss = 0.0;
+    for (int block = 0; block < num_blocks; ++block) {
+      sum_loss += block_sums[block * num_metrics + j];
+    }
+    results[j] = metrics[j]->FinishPointLoss(sum_loss);
+  }
+  return results;
+}
+
 Metric* Metric::CreateMetric(const std::string& type, const Config& config) {
   #ifdef USE_CUDA
   if (config.device_type == std::string("cuda") && config.boosting == std::string("gbdt")) {
@@ -10,6 +10,7 @@
 #include <LightGBM/utils/log.h>
 #include <LightGBM/utils/openmp_wrapper.h>
 
+#include <mutex>
 #include <string>
 #include <sstream>
 #include <vector>
@@ -55,6 +56,9 @@ class NDCGMetric:public Metric {
         sum_query_weights_ += query_weights_[i];
       }
     }
+    query_order_ = DCGCalculator::QueriesBySize(query_boundaries_, num_queries_);
+    query_results_.resize(static_cast<size_t>(num_queries_) * eval_at_.size());
+    sorted_idx_buffers_.resize(OMP_NUM_THREADS());
     inverse_max_dcgs_.resize(num_queries_);
     // cache the inverse max DCG for all queries, used to calculate NDCG
     #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static)
@@ -84,60 +88,52 @@ class NDCGMetric:public Metric {
   }
 
   std::vector<double> Eval(const double* score, const ObjectiveFunction*) const override {
-    int num_threads = OMP_NUM_THREADS();
-    // some buffers for multi-threading sum up
-    std::vector<std::vector<double>> result_buffer_;
-    for (int i = 0; i < num_threads; ++i) {
-      result_buffer_.emplace_back(eval_at_.size(), 0.0f);
+    const size_t num_eval = eval_at_.size();
+    // the buffers of the metric are reused, an evaluation running concurrently allocates its own
+    std::unique_lock<std::mutex> lock(buffers_mutex_, std::try_to_lock);
+    std::vector<double> concurrent_results;
+    std::vector<std::vector<data_size_t>> concurrent_sorted_idx;
+    if (!lock.owns_lock()) {
+      concurrent_results.resize(static_cast<size_t>(num_queries_) * num_eval);
     }
-    std::vector<double> tmp_dcg(eval_at_.size(), 0.0f);
-    if (query_weights_ == nullptr) {
-      #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static) firstprivate(tmp_dcg)
-      for (data_size_t i = 0; i < num_queries_; ++i) {
-        const int tid = omp_get_thread_num();
-        // if all doc in this query are all negative, let its NDCG=1
-        if (inverse_max_dcgs_[i][0] <= 0.0f) {
-          for (size_t j = 0; j < eval_at_.size(); ++j) {
-            result_buffer_[tid][j] += 1.0f;
-          }
-        } else {
-          // calculate DCG
-          DCGCalculator::CalDCG(eval_at_, label_ + query_boundaries_[i],
-                                score + query_boundaries_[i],
-                                query_boundaries_[i + 1] - query_boundaries_[i], &tmp_dcg);
-          // calculate NDCG
-          for (size_t j = 0; j < eval_at_.size(); ++j) {
-            result_buffer_[tid][j] += tmp_dcg[j] * inverse_max_dcgs_[i][j];
-          }
+    std::vector<double>& query_results = lock.owns_lock() ? query_results_ : concurrent_results;
+    std::vector<std::vector<data_size_t>>& sorted_idx_buffers =
+        lock.owns_lock() ? sorted_idx_buffers_ : concurrent_sorted_idx;
+    if (sorted_idx_buffers.size() < static_cast<size_t>(OMP_NUM_THREADS())) {
+      sorted_idx_buffers.resize(OMP_NUM_THREADS());
+    }
+    std::vector<double> tmp_dcg(num_eval, 0.0f);
+    // large queries first, so the dynamic schedule ends with the small ones
+    #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(dynamic, 16) firstprivate(tmp_dcg)
+    for (data_size_t q = 0; q < num_queries_; ++q) {
+      const data_size_t i = query_order_[q];
+      double* result = query_results.data() + static_cast<size_t>(i) * num_eval;
+      // if all doc in this query are all negative, let its NDCG=1
+      if (inverse_max_dcgs_[i][0] <= 0.0f) {
+        for (size_t j = 0; j < num_eval; ++j) {
+          result[j] = 1.0f;
         }
-      }
-    } else {
-      #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static) firstprivate(tmp_dcg)
-      for (data_size_t i = 0; i < num_queries_; ++i) {
-        const int tid = omp_get_thread_num();
-        // if all doc in this query are all negative, let its NDCG=1
-        if (inverse_max_dcgs_[i][0] <= 0.0f) {
-          for (size_t j = 0; j < eval_at_.size(); ++j) {
-            result_buffer_[tid][j] += 1.0f;
-          }
-        } else {
-          // calculate DCG
-          DCGCalculator::CalDCG(eval_at_, label_ + query_boundaries_[i],
-                                score + query_boundaries_[i],
-                                query_boundaries_[i + 1] - query_boundaries_[i], &tmp_dcg);
-          // calculate NDCG
-          for (size_t j = 0; j < eval_at_.size(); ++j) {
-            result_buffer_[tid][j] += tmp_dcg[j] * inverse_max_dcgs_[i][j] * query_weights_[i];
-          }
+      } else {
+        // calculate DCG
+        DCGCalculator::CalDCG(eval_at_, label_ + query_boundaries_[i],
+                              score + query_boundaries_[i],
+                              query_boundaries_[i + 1] - query_boundaries_[i], &tmp_dcg,
+                              &sorted_idx_buffers[omp_get_thread_num()]);
+        // calculate NDCG
+        for (size_t j = 0; j < num_eval; ++j) {
+          result[j] = tmp_dcg[j] * inverse_max_dcgs_[i][j];
         }
       }
     }
-    // Get final average NDCG
-    std::vector<double> result(eval_at_.size(), 0.0f);
-    for (size_t j = 0; j < result.size(); ++j) {
-      for (int i = 0; i < num_threads; ++i) {
-        result[j] += result_buffer_[i][j];
+    // Get final average NDCG, summed in query order so that the result does not depend on the schedule
+    std::vector<double> result(num_eval, 0.0f);
+    for (data_size_t i = 0; i < num_queries_; ++i) {
+      const double query_weight = query_weights_ == nullptr ? 1.0f : query_weights_[i];
+      for (size_t j = 0; j < num_eval; ++j) {
+        result[j] += query_results[static_cast<size_t>(i) * num_eval + j] * query_weight;
       }
+    }
+    for (size_t j = 0; j < num_eval; ++j) {
       result[j] /= sum_query_weights_;
     }
     return result;
@@ -162,6 +158,12 @@ class NDCGMetric:public Metric {
   std::vector<data_size_t> eval_at_;
   /*! \brief Cache the inverse max dcg for all queries */
   std::vector<std::vector<double>> inverse_max_dcgs_;
+  /*! \brief Queries by descending number of rows */
+  std::vector<data_size_t> query_order_;
+  /*! \brief Results of each query, then per-thread buffers of the sorted indices, kept across evaluations */
+  mutable std::vector<double> query_results_;
+  mutable std::vector<std::vector<data_size_t>> sorted_idx_buffers_;
+  mutable std::mutex buffers_mutex_;
 };
 
 }  // namespace LightGBM
@@ -94,6 +94,27 @@ class RegressionMetric: public Metric {
     return std::vector<double>(1, loss);
   }
 
+  bool IsPointwise() const override { return true; }
+
+  double SumPointLoss(const double* converted_score, data_size_t start, data_size_t count) const override {
+    double sum_loss = 0.0f;
+    if (weights_ == nullptr) {
+      for (data_size_t i = 0; i < count; ++i) {
+        sum_loss += PointWiseLossCalculator::LossOnPoint(label_[start + i], converted_score[i], config_);
+      }
+    } else {
+      for (data_size_t i = 0; i < count; ++i) {
+        sum_loss += PointWiseLossCalculator::LossOnPoint(label_[start + i], converted_score[i], config_)
+                    * weights_[start + i];
+      }
+    }
+    return sum_loss;
+  }
+
+  std::vector<double> FinishPointLoss(double sum_loss) const override {
+    return std::vector<double>(1, PointWiseLossCalculator::AverageLoss(sum_loss, sum_weights_));
+  }
+
   inline static double AverageLoss(double sum_loss, double sum_weights) {
     return sum_loss / sum_weights;
   }
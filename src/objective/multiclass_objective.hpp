@@ -29,6 +29,7 @@ class MulticlassSoftmax: public ObjectiveFunction {
     // In the traditional settings of K-classification, there is one redundant class, whose output is set to 0 (like the class 0 in binary classification).
     // This is from the Friedman GBDT paper.
     factor_ = static_cast<double>(num_class_) / (num_class_ - 1.0f);
+    fast_math_ = config.objective_fast_math;
   }
 
   explicit MulticlassSoftmax(const std::vector<std::string>& strs) {
@@ -45,6 +46,7 @@ class MulticlassSoftmax: public ObjectiveFunction {
       Log::Fatal("Objective should contain num_class field");
     }
     factor_ = static_cast<double>(num_class_) / (num_class_ - 1.0f);
+    fast_math_ = false;
   }
 
   ~MulticlassSoftmax() {
@@ -84,48 +86,10 @@ class MulticlassSoftmax: public ObjectiveFunction {
   }
 
   void GetGradients(const double* score, score_t* gradients, score_t* hessians) const override {
-    if (weights_ == nullptr) {
-      std::vector<double> rec;
-      #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static) private(rec)
-      for (data_size_t i = 0; i < num_data_; ++i) {
-        rec.resize(num_class_);
-        for (int k = 0; k < num_class_; ++k) {
-          size_t idx = static_cast<size_t>(num_data_) * k + i;
-          rec[k] = static_cast<double>(score[idx]);
-        }
-        Common::Softmax(&rec);
-        for (int k = 0; k < num_class_; ++k) {
-          auto p = rec[k];
-          size_t idx = static_cast<size_t>(num_data_) * k + i;
-          if (label_int_[i] == k) {
-            gradients[idx] = static_cast<score_t>(p - 1.0f);
-          } else {
-            gradients[idx] = static_cast<score_t>(p);
-          }
-          hessians[idx] = static_cast<score_t>(factor_ * p * (1.0f - p));
-        }
-      }
+    if (fast_math_) {
+      GetGradientsInBlocks<float>(score, gradients, hessians);
     } else {
-      std::vector<double> rec;
-      #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static) private(rec)
-      for (data_size_t i = 0; i < num_data_; ++i) {
-        rec.resize(num_class_);
-        for (int k = 0; k < num_class_; ++k) {
-          size_t idx = static_cast<size_t>(num_data_) * k + i;
-          rec[k] = static_cast<double>(score[idx]);
-        }
-        Common::Softmax(&rec);
-        for (int k = 0; k < num_class_; ++k) {
-          auto p = rec[k];
-          size_t idx = static_cast<size_t>(num_data_) * k + i;
-          if (label_int_[i] == k) {
-            gradients[idx] = static_cast<score_t>((p - 1.0f) * weights_[i]);
-          } else {
-            gradients[idx] = static_cast<score_t>(p * weights_[i]);
-          }
-          hessians[idx] = static_cast<score_t>((factor_ * p * (1.0f - p))* weights_[i]);
-        }
-      }
+      GetGradientsInBlocks<double>(score, gradients, hessians);
     }
   }
 
@@ -152,6 +116,8 @@ class MulticlassSoftmax: public ObjectiveFunction {
 
   bool NeedAccuratePrediction() const override { return false; }
 
+  bool IsClassification() const override { return true; }
+
   double BoostFromScore(int class_id) const override {
     return std::log(std::max<double>(kEpsilon, class_init_probs_[class_id]));
   }
@@ -166,6 +132,67 @@ class MulticlassSoftmax: public ObjectiveFunction {
   }
 
  protected:
+  static inline void ExpInPlace(double* values, int len) {
+    for (int i = 0; i < len; ++i) {
+      values[i] = std::exp(values[i]);
+    }
+  }
+
+  static inline void ExpInPlace(float* values, int len) {
+    Common::FastExp(values, len);
+  }
+
+  /*!
+  * \brief Softmax gradients of blocks of rows. The scores of each class are contiguous, so every step runs over
+  *        the rows of a block for one class at a time, without per-row buffers. With T = double, the results are
+  *        the same as with Common::Softmax on each row
+  */
+  template <typename T>
+  void GetGradientsInBlocks(const double* score, score_t* gradients, score_t* hessians) const {
+    const int kBlockSize = 256;
+    const int num_blocks = (num_data_ + kBlockSize - 1) / kBlockSize;
+    const T factor = static_cast<T>(factor_);
+    std::vector<T> exp_buffer(static_cast<size_t>(num_class_) * kBlockSize);
+    #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static) firstprivate(exp_buffer)
+    for (int block = 0; block < num_blocks; ++block) {
+      T row_max[kBlockSize];
+      T row_sum[kBlockSize];
+      const data_size_t start = block * kBlockSize;
+      const int cnt = static_cast<int>(std::min<data_size_t>(kBlockSize, num_data_ - start));
+      for (int i = 0; i < cnt; ++i) {
+        row_max[i] = static_cast<T>(score[start + i]);
+        row_sum[i] = 0.0f;
+      }
+      for (int k = 1; k < num_class_; ++k) {
+        const double* class_score = score + static_cast<size_t>(num_data_) * k + start;
+        for (int i = 0; i < cnt; ++i) {
+          row_max[i] = std::max(static_cast<T>(class_score[i]), row_max[i]);
+        }
+      }
+      for (int k = 0; k < num_class_; ++k) {
+        const double* class_score = score + static_cast<size_t>(num_data_) * k + start;
+        T* class_exp = exp_buffer.data() + static_cast<size_t>(k) * kBlockSize;
+        for (int i = 0; i < cnt; ++i) {
+          class_exp[i] = static_cast<T>(class_score[i]) - row_max[i];
+        }
+        ExpInPlace(class_exp, cnt);
+        for (int i = 0; i < cnt; ++i) {
+          row_sum[i] += class_exp[i];
+        }
+      }
+      for (int k = 0; k < num_class_; ++k) {
+        const T* class_exp = exp_buffer.data() + static_cast<size_t>(k) * kBlockSize;
+        const size_t offset = static_cast<size_t>(num_data_) * k + start;
+        for (int i = 0; i < cnt; ++i) {
+          const T p = class_exp[i] / row_sum[i];
+          const T w = weights_ == nullptr ? 1.0f : static_cast<T>(weights_[start + i]);
+          gradients[offset + i] = static_cast<score_t>((label_int_[start + i] == k ? p - 1.0f : p) * w);
+          hessians[offset + i] = static_cast<score_t>((factor * p * (1.0f - p)) * w);
+        }
+      }
+    }
+  }
+
   double factor_;
   /*! \brief Number of data */
   data_size_t num_data_;
@@ -178,6 +205,8 @@ class MulticlassSoftmax: public ObjectiveFunction {
   /*! \brief Weights for data */
   const label_t* weights_;
   std::vector<double> class_init_probs_;
+  /*! \brief Compute gradients in single precision with Common::FastExp */
+  bool fast_math_;
 };
 
 /*!
@@ -258,6 +287,8 @@ class MulticlassOVA: public ObjectiveFunction {
 
   bool NeedAccuratePrediction() const override { return false; }
 
+  bool IsClassification() const override { return true; }
+
   double BoostFromScore(int class_id) const override {
     return binary_loss_[class_id]->BoostFromScore(0);
   }
@@ -44,10 +44,10 @@ namespace LightGBM {
 class CrossEntropy: public ObjectiveFunction {
  public:
   explicit CrossEntropy(const Config& config)
-      : deterministic_(config.deterministic) {}
+      : deterministic_(config.deterministic), fast_math_(config.objective_fast_math) {}
 
   explicit CrossEntropy(const std::vector<std::string>&)
-      : deterministic_(false) {
+      : deterministic_(false), fast_math_(false) {
   }
 
   ~CrossEntropy() {}
@@ -96,6 +96,10 @@ class CrossEntropy: public ObjectiveFunction {
     // As branching criteria, we use the same cutoff as in log1pexp, see link above.
     // Note that the maximal value to get gradient = -1 with label = 1 is -37.439198610162731
     // (based on mpmath), and scipy.special.logit(np.finfo(float).eps) ~ -36.04365.
+    if (fast_math_) {
+      GetGradientsFastMath(score, gradients, hessians);
+      return;
+    }
     if (weights_ == nullptr) {
       // compute pointwise gradients and Hessians with implied unit weights
       #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static)
@@ -127,6 +131,34 @@ class CrossEntropy: public ObjectiveFunction {
     }
   }
 
+  /*!
+  * \brief Same as GetGradients in single precision. Rows are processed in blocks, so that exp runs over
+  *        contiguous arrays with Common::FastExp
+  */
+  void GetGradientsFastMath(const double* score, score_t* gradients, score_t* hessians) const {
+    const int kBlockSize = 1024;
+    const int num_blocks = (num_data_ + kBlockSize - 1) / kBlockSize;
+    #pragma omp parallel for num_threads(OMP_NUM_THREADS()) schedule(static)
+    for (int block = 0; block < num_blocks; ++block) {
+      float exp_tmp[kBlockSize];
+      const data_size_t start = block * kBlockSize;
+      const int cnt = static_cast<int>(std::min<data_size_t>(kBlockSize, num_data_ - start));
+      for (int i = 0; i < cnt; ++i) {
+        exp_tmp[i] = -static_cast<float>(score[start + i]);
+      }
+      Common::FastExp(exp_tmp, cnt);
+      for (int i = 0; i < cnt; ++i) {
+        // z = expit(score), and 1 - z = exp(-score) * z is computed without cancellation, so that
+        // the gradients and Hessians of saturated scores do not round to 0
+        const float z = 1.0f / (1.0f + exp_tmp[i]);
+        const float w = weights_ == nullptr ? 1.0f : static_cast<float>(weights_[start + i]);
+        const float label = label_[start + i];
+        gradients[start + i] = static_cast<score_t>(((1.0f - label) - label * exp_tmp[i]) * z * w);
+        hessians[start + i] = static_cast<score_t>(exp_tmp[i] * z * z * w);
+      }
+    }
+  }
+
   const char* GetName() const override {
     return "cross_entropy";
   }
@@ -177,6 +209,8 @@ class CrossEntropy: public ObjectiveFunction {
   /*! \brief Weights for data */
   const label_t* weights_;
   const bool deterministic_;
+  /*! \brief Compute gradients in single precision with Common::FastExp */
+  const bool fast_math_;
 };
 
 /*!
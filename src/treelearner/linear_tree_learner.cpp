@@ -10,6 +10,77 @@
 
 namespace LightGBM {
 
+void AccumulateLinearBlock(const double* x, const double* hx, const double* g, int cnt, int num_cols,
+                           double* XTHX, double* XTg) {
+  // 2x2 tiles of the matrix keep four independent sums per loaded pair of columns
+  for (int f1 = 0; f1 < num_cols; f1 += 2) {
+    const double* h0 = hx + f1 * kLinearBlockSize;
+    const double* h1 = h0 + kLinearBlockSize;
+    // offset of row f1 in the packed upper triangle
+    const int row0 = f1 * num_cols - f1 * (f1 - 1) / 2 - f1;
+    const int row1 = row0 + num_cols - f1 - 1;
+    for (int f2 = f1; f2 < num_cols; f2 += 2) {
+      const double* x0 = x + f2 * kLinearBlockSize;
+      const double* x1 = x0 + kLinearBlockSize;
+      double s00 = 0.0, s01 = 0.0, s10 = 0.0, s11 = 0.0;
+      for (int i = 0; i < cnt; ++i) {
+        s00 += h0[i] * x0[i];
+        s01 += h0[i] * x1[i];
+        s10 += h1[i] * x0[i];
+        s11 += h1[i] * x1[i];
+      }
+      // the sums that fall on the padding column or below the diagonal are dropped
+      XTHX[row0 + f2] += s00;
+      if (f2 + 1 < num_cols) {
+        XTHX[row0 + f2 + 1] += s01;
+      }
+      if (f1 + 1 < num_cols) {
+        if (f2 != f1) {
+          XTHX[row1 + f2] += s10;
+        }
+        if (f2 + 1 < num_cols) {
+          XTHX[row1 + f2 + 1] += s11;
+        }
+      }
+    }
+  }
+  for (int f = 0; f < num_cols; ++f) {
+    const double* x0 = x + f * kLinearBlockSize;
+    double sum = 0.0;
+    for (int i = 0; i < cnt; ++i) {
+      sum += x0[i] * g[i];
+    }
+    XTg[f] += sum;
+  }
+}
+
+std::vector<double> SolveLinearLeaf(const double* XTHX, const double* XTg, int num_cols, double lambda) {
+  Eigen::MatrixXd XTHX_mat(num_cols, num_cols);
+  Eigen::MatrixXd XTg_mat(num_cols, 1);
+  int j = 0;
+  for (int feat1 = 0; feat1 < num_cols; ++feat1) {
+    for (int feat2 = feat1; feat2 < num_cols; ++feat2) {
+      XTHX_mat(feat1, feat2) = XTHX[j];
+      XTHX_mat(feat2, feat1) = XTHX_mat(feat1, feat2);
+      if ((feat1 == feat2) && (feat1 < num_cols - 1)) {
+        XTHX_mat(feat1, feat2) += lambda;
+      }
+      ++j;
+    }
+    XTg_mat(feat1) = XTg[feat1];
+  }
+  // X_T * H * X is symmetric and positive semi-definite, fall back to full pivoting only when LDLT fails
+  Eigen::LDLT<Eigen::MatrixXd> ldlt(XTHX_mat);
+  Eigen::MatrixXd coeffs;
+  if (ldlt.info() == Eigen::Success) {
+    coeffs = -ldlt.solve(XTg_mat);
+  }
+  if (ldlt.info() != Eigen::Success || !coeffs.allFinite()) {
+    coeffs = -XTHX_mat.fullPivLu().solve(XTg_mat);
+  }
+  return std::vector<double>(coeffs.data(), coeffs.data() + num_cols);
+}
+
 template <typename TREE_LEARNER_TYPE>
 void LinearTreeLearner<TREE_LEARNER_TYPE>::Init(const Dataset* train_data, bool is_constant_hessian) {
   TREE_LEARNER_TYPE::Init(train_data, is_constant_hessian);
@@ -25,12 +96,8 @@ void LinearTreeLearner<TREE_LEARNER_TYPE>::InitLinear(const Dataset* train_data,
   for (int feat = 0; feat < train_data->num_features(); ++feat) {
     auto bin_mapper = this->train_data_->FeatureBinMapper(feat);
     if (bin_mapper->bin_type() == BinType::NumericalBin) {
-      const float* feat_ptr = this->train_data_->raw_index(feat);
-      for (int i = 0; i < train_data->num_data(); ++i) {
-        if (std::isnan(feat_ptr[i])) {
-          contains_nan_[feat] = 1;
-          break;
-        }
+      if (this->train_data_->raw_column(feat)->ContainsNaN()) {
+        contains_nan_[feat] = 1;
       }
     }
   }
@@ -201,7 +268,7 @@ void LinearTreeLearner<TREE_LEARNER_TYPE>::CalculateLinear(Tree* tree, bool is_r
   // create array of pointers to raw data, and coefficient matrices, for each leaf
   std::vector<std::vector<int>> leaf_features;
   std::vector<int> leaf_num_features;
-  std::vector<std::vector<const float*>> raw_data_ptr;
+  std::vector<std::vector<const RawColumn*>> raw_data_ptr;
   size_t max_num_features = 0;
   for (int i = 0; i < num_leaves; ++i) {
     std::vector<int> raw_features;
@@ -214,13 +281,13 @@ void LinearTreeLearner<TREE_LEARNER_TYPE>::CalculateLinear(Tree* tree, bool is_r
     auto new_end = std::unique(raw_features.begin(), raw_features.end());
     raw_features.erase(new_end, raw_features.end());
     std::vector<int> numerical_features;
-    std::vector<const float*> data_ptr;
+    std::vector<const RawColumn*> data_ptr;
     for (size_t j = 0; j < raw_features.size(); ++j) {
       int feat = this->train_data_->InnerFeatureIndex(raw_features[j]);
       auto bin_mapper = this->train_data_->FeatureBinMapper(feat);
       if (bin_mapper->bin_type() == BinType::NumericalBin) {
         numerical_features.push_back(feat);
-        data_ptr.push_back(this->train_data_->raw_index(feat));
+        data_ptr.push_back(this->train_data_->raw_column(feat));
       }
     }
     leaf_features.push_back(numerical_features);
@@ -251,51 +318,70 @@ void LinearTreeLearner<TREE_LEARNER_TYPE>::CalculateLinear(Tree* tree, bool is_r
       num_nonzero.push_back(std::vector<int>(num_leaves, 0));
     }
   }
+  // the rows of each leaf are processed in blocks, copied column-wise so the normal equations
+  // can be accumulated with dot products over the block instead of a rank-one update per row
+  std::vector<std::pair<int, data_size_t>> blocks;
+  for (int leaf_num = 0; leaf_num < num_leaves; ++leaf_num) {
+    const data_size_t leaf_cnt = this->data_partition_->leaf_count(leaf_num);
+    for (data_size_t start = 0; start < leaf_cnt; start += kLinearBlockSize) {
+      blocks.emplace_back(leaf_num, start);
+    }
+  }
+  const int num_blocks = static_cast<int>(blocks.size());
+  const data_size_t* indices = this->data_partition_->indices();
+  // the number of columns is rounded up to even, the padding columns stay zero
+  const size_t max_num_cols = (max_num_features + 2) & ~static_cast<size_t>(1);
   OMP_INIT_EX();
 #pragma omp parallel num_threads(OMP_NUM_THREADS()) if (this->num_data_ > 1024)
   {
-    std::vector<float> curr_row(max_num_features + 1);
+    std::vector<double> x_block(max_num_cols * kLinearBlockSize, 0.0);
+    std::vector<double> hx_block(max_num_cols * kLinearBlockSize, 0.0);
+    std::vector<double> g_block(kLinearBlockSize);
     int tid = omp_get_thread_num();
 #pragma omp for schedule(static)
-    for (int i = 0; i < this->num_data_; ++i) {
+    for (int block = 0; block < num_blocks; ++block) {
       OMP_LOOP_EX_BEGIN();
-      int leaf_num = leaf_map_[i];
-      if (leaf_num < 0) {
-        continue;
-      }
-      bool nan_found = false;
-      int num_feat = leaf_num_features[leaf_num];
+      const int leaf_num = blocks[block].first;
+      const int num_feat = leaf_num_features[leaf_num];
+      const data_size_t leaf_begin = this->data_partition_->leaf_begin(leaf_num) + blocks[block].second;
+      const data_size_t leaf_end = this->data_partition_->leaf_begin(leaf_num) +
+        std::min(blocks[block].second + kLinearBlockSize, this->data_partition_->leaf_count(leaf_num));
+      const RawColumn* const* leaf_data = raw_data_ptr[leaf_num].data();
+      const data_size_t* rows = indices + leaf_begin;
+      const int block_cnt = static_cast<int>(leaf_end - leaf_begin);
       for (int feat = 0; feat < num_feat; ++feat) {
+        leaf_data[feat]->Gather(rows, block_cnt, x_block.data() + feat * kLinearBlockSize);
+      }
+      // rows with a NaN are dropped, the kept rows are moved to the front of the block
+      int cnt = 0;
+      for (int r = 0; r < block_cnt; ++r) {
+        const data_size_t i = rows[r];
         if (HAS_NAN) {
-          float val = raw_data_ptr[leaf_num][feat][i];
-          if (std::isnan(val)) {
-            nan_found = true;
-            break;
+          bool nan_found = false;
+          for (int feat = 0; feat < num_feat; ++feat) {
+            if (std::isnan(x_block[feat * kLinearBlockSize + r])) {
+              nan_found = true;
+              break;
+            }
+            num_nonzero[tid][leaf_num] += 1;
+          }
+          if (nan_found) {
+            continue;
           }
-          num_nonzero[tid][leaf_num] += 1;
-          curr_row[feat] = val;
-        } else {
-          curr_row[feat] = raw_data_ptr[leaf_num][feat][i];
-        }
-      }
-      if (HAS_NAN) {
-        if (nan_found) {
-          continue;
         }
-      }
-      curr_row[num_feat] = 1.0;
-      float h = static_cast<float>(hessians[i]);
-      float g = static_cast<float>(gradients[i]);
-      int j = 0;
-      for (int feat1 = 0; feat1 < num_feat + 1; ++feat1) {
-        double f1_val = static_cast<double>(curr_row[feat1]);
-        XTg_by_thread_[tid][leaf_num][feat1] += f1_val * g;
-        f1_val *= h;
-        for (int feat2 = feat1; feat2 < num_feat + 1; ++feat2) {
-          XTHX_by_thread_[tid][leaf_num][j] += f1_val * curr_row[feat2];
-          ++j;
+        const double h = static_cast<float>(hessians[i]);
+        for (int feat = 0; feat < num_feat; ++feat) {
+          const double val = x_block[feat * kLinearBlockSize + r];
+          x_block[feat * kLinearBlockSize + cnt] = val;
+          hx_block[feat * kLinearBlockSize + cnt] = val * h;
         }
+        x_block[num_feat * kLinearBlockSize + cnt] = 1.0;
+        hx_block[num_feat * kLinearBlockSize + cnt] = h;
+        g_block[cnt] = static_cast<float>(gradients[i]);
+        ++cnt;
       }
+      AccumulateLinearBlock(x_block.data(), hx_block.data(), g_block.data(), cnt, num_feat + 1,
+                            XTHX_by_thread_[tid][leaf_num].data(), XTg_by_thread_[tid][leaf_num].data());
       OMP_LOOP_EX_END();
     }
   }
@@ -339,31 +425,18 @@ void LinearTreeLearner<TREE_LEARNER_TYPE>::CalculateLinear(Tree* tree, bool is_r
       continue;
     }
     size_t num_feat = leaf_features[leaf_num].size();
-    Eigen::MatrixXd XTHX_mat(num_feat + 1, num_feat + 1);
-    Eigen::MatrixXd XTg_mat(num_feat + 1, 1);
-    size_t j = 0;
-    for (size_t feat1 = 0; feat1 < num_feat + 1; ++feat1) {
-      for (size_t feat2 = feat1; feat2 < num_feat + 1; ++feat2) {
-        XTHX_mat(feat1, feat2) = XTHX_[leaf_num][j];
-        XTHX_mat(feat2, feat1) = XTHX_mat(feat1, feat2);
-        if ((feat1 == feat2) && (feat1 < num_feat)) {
-          XTHX_mat(feat1, feat2) += this->config_->linear_lambda;
-        }
-        ++j;
-      }
-      XTg_mat(feat1) = XTg_[leaf_num][feat1];
-    }
-    Eigen::MatrixXd coeffs = - XTHX_mat.fullPivLu().inverse() * XTg_mat;
+    const std::vector<double> coeffs = SolveLinearLeaf(XTHX_[leaf_num].data(), XTg_[leaf_num].data(),
+                                                       static_cast<int>(num_feat) + 1, this->config_->linear_lambda);
     std::vector<double> coeffs_vec;
     std::vector<int> features_new;
     std::vector<double> old_coeffs = tree->LeafCoeffs(leaf_num);
     for (size_t i = 0; i < leaf_features[leaf_num].size(); ++i) {
       if (is_refit) {
         features_new.push_back(leaf_features[leaf_num][i]);
-        coeffs_vec.push_back(decay_rate * old_coeffs[i] + (1.0 - decay_rate) * coeffs(i) * shrinkage);
+        coeffs_vec.push_back(decay_rate * old_coeffs[i] + (1.0 - decay_rate) * coeffs[i] * shrinkage);
       } else {
-        if (coeffs(i) < -kZeroThreshold || coeffs(i) > kZeroThreshold) {
-          coeffs_vec.push_back(coeffs(i));
+        if (coeffs[i] < -kZeroThreshold || coeffs[i] > kZeroThreshold) {
+          coeffs_vec.push_back(coeffs[i]);
           int feat = leaf_features[leaf_num][i];
           features_new.push_back(feat);
         }
@@ -379,9 +452,9 @@ void LinearTreeLearner<TREE_LEARNER_TYPE>::CalculateLinear(Tree* tree, bool is_r
     tree->SetLeafCoeffs(leaf_num, coeffs_vec);
     if (is_refit) {
       double old_const = tree->LeafConst(leaf_num);
-      tree->SetLeafConst(leaf_num, decay_rate * old_const + (1.0 - decay_rate) * coeffs(num_feat) * shrinkage);
+      tree->SetLeafConst(leaf_num, decay_rate * old_const + (1.0 - decay_rate) * coeffs[num_feat] * shrinkage);
     } else {
-      tree->SetLeafConst(leaf_num, coeffs(num_feat));
+      tree->SetLeafConst(leaf_num, coeffs[num_feat]);
     }
   }
 }
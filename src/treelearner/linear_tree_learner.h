@@ -16,6 +16,33 @@
 
 namespace LightGBM {
 
+/*! \brief Number of rows of a leaf processed together when accumulating the linear models */
+const int kLinearBlockSize = 256;
+
+/*!
+ * \brief Add the rows of a block to the upper triangle of X_T * H * X (packed row-major) and to X_T * g
+ * \param x Block values, column-wise with a stride of kLinearBlockSize, the last used column is the constant term
+ * \param hx Block values multiplied by the hessians, in the same layout as x
+ * \param g Gradients of the block rows
+ * \param cnt Number of rows in the block
+ * \param num_cols Number of used columns, x and hx must have room for one more column when it is odd
+ * \param XTHX Output, upper triangle of X_T * H * X
+ * \param XTg Output, X_T * g
+ */
+void AccumulateLinearBlock(const double* x, const double* hx, const double* g, int cnt, int num_cols,
+                           double* XTHX, double* XTg);
+
+/*!
+ * \brief Solve (X_T * H * X + lambda * I) * coeffs = -X_T * g for the coefficients of a leaf, the constant term is not
+ *        regularized; LDLT is used first, full pivoting LU when LDLT fails or gives non-finite coefficients
+ * \param XTHX Upper triangle of X_T * H * X (packed row-major)
+ * \param XTg X_T * g
+ * \param num_cols Number of columns, the last one is the constant term
+ * \param lambda Regularization of the feature coefficients
+ * \return Coefficients of the features, followed by the constant term
+ */
+std::vector<double> SolveLinearLeaf(const double* XTHX, const double* XTg, int num_cols, double lambda);
+
 template <typename TREE_LEARNER_TYPE>
 class LinearTreeLearner: public TREE_LEARNER_TYPE {
  public:
@@ -63,7 +90,7 @@ class LinearTreeLearner: public TREE_LEARNER_TYPE {
     int num_leaves = tree->num_leaves();
     std::vector<double> leaf_const(num_leaves);
     std::vector<std::vector<double>> leaf_coeff(num_leaves);
-    std::vector<std::vector<const float*>> feat_ptr(num_leaves);
+    std::vector<std::vector<const RawColumn*>> feat_ptr(num_leaves);
     std::vector<double> leaf_output(num_leaves);
     std::vector<int> leaf_num_features(num_leaves);
     for (int leaf_num = 0; leaf_num < num_leaves; ++leaf_num) {
@@ -71,7 +98,7 @@ class LinearTreeLearner: public TREE_LEARNER_TYPE {
       leaf_coeff[leaf_num] = tree->LeafCoeffs(leaf_num);
       leaf_output[leaf_num] = tree->LeafOutput(leaf_num);
       for (int feat : tree->LeafFeaturesInner(leaf_num)) {
-        feat_ptr[leaf_num].push_back(this->train_data_->raw_index(feat));
+        feat_ptr[leaf_num].push_back(this->train_data_->raw_column(feat));
       }
       leaf_num_features[leaf_num] = static_cast<int>(feat_ptr[leaf_num].size());
     }
@@ -88,7 +115,7 @@ class LinearTreeLearner: public TREE_LEARNER_TYPE {
       if (HAS_NAN) {
         bool nan_found = false;
         for (int feat_ind = 0; feat_ind < num_feat; ++feat_ind) {
-          float val = feat_ptr[leaf_num][feat_ind][i];
+          float val = feat_ptr[leaf_num][feat_ind]->Get(i);
           if (std::isnan(val)) {
             nan_found = true;
             break;
@@ -102,7 +129,7 @@ class LinearTreeLearner: public TREE_LEARNER_TYPE {
         }
       } else {
         for (int feat_ind = 0; feat_ind < num_feat; ++feat_ind) {
-          output += feat_ptr[leaf_num][feat_ind][i] * leaf_coeff[leaf_num][feat_ind];
+          output += feat_ptr[leaf_num][feat_ind]->Get(i) * leaf_coeff[leaf_num][feat_ind];
         }
         out_score[i] += output;
       }
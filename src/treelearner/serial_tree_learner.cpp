@@ -443,6 +443,7 @@ void SerialTreeLearner::ConstructHistograms(
       train_data_->ConstructHistograms<true, 32>(SMALLER_LEAF_ARGS);
     }
     #undef SMALLER_LEAF_ARGS
+    // quantized gradients have no merged pass for two siblings, the larger leaf is built on its own
     if (larger_leaf_histogram_array_ && !use_subtract) {
       const uint8_t larger_leaf_num_bits = gradient_discretizer_->GetHistBitsInLeaf<false>(larger_leaf_splits_->leaf_index());
       hist_t* ptr_larger_leaf_hist_data =
@@ -468,20 +469,28 @@ void SerialTreeLearner::ConstructHistograms(
   } else {
     hist_t* ptr_smaller_leaf_hist_data =
         smaller_leaf_histogram_array_[0].RawData() - kHistOffset;
-    train_data_->ConstructHistograms<false, 0>(
-        is_feature_used, smaller_leaf_splits_->data_indices(),
-        smaller_leaf_splits_->num_data_in_leaf(), gradients_, hessians_,
-        ordered_gradients_.data(), ordered_hessians_.data(), share_state_.get(),
-        ptr_smaller_leaf_hist_data);
+    // Both leaves are only built when the parent histogram was evicted, i.e. histogram_pool_size is too small to
+    // keep all the leaves. With a cached parent, the larger leaf is the parent minus the smaller leaf, which is
+    // cheaper than any pass over its rows. So the two siblings are then built in one pass over the parent's rows.
     if (larger_leaf_histogram_array_ != nullptr && !use_subtract) {
-      // construct larger leaf
       hist_t* ptr_larger_leaf_hist_data =
           larger_leaf_histogram_array_[0].RawData() - kHistOffset;
+      if (sibling_indices_.size() < static_cast<size_t>(num_data_)) {
+        sibling_indices_.resize(num_data_);
+        sibling_leaf_of_.resize(num_data_);
+      }
+      train_data_->ConstructSiblingHistograms(
+          is_feature_used, smaller_leaf_splits_->data_indices(), smaller_leaf_splits_->num_data_in_leaf(),
+          larger_leaf_splits_->data_indices(), larger_leaf_splits_->num_data_in_leaf(),
+          gradients_, hessians_, sibling_indices_.data(), sibling_leaf_of_.data(),
+          ordered_gradients_.data(), ordered_hessians_.data(), share_state_.get(),
+          ptr_smaller_leaf_hist_data, ptr_larger_leaf_hist_data);
+    } else {
       train_data_->ConstructHistograms<false, 0>(
-          is_feature_used, larger_leaf_splits_->data_indices(),
-          larger_leaf_splits_->num_data_in_leaf(), gradients_, hessians_,
+          is_feature_used, smaller_leaf_splits_->data_indices(),
+          smaller_leaf_splits_->num_data_in_leaf(), gradients_, hessians_,
           ordered_gradients_.data(), ordered_hessians_.data(), share_state_.get(),
-          ptr_larger_leaf_hist_data);
+          ptr_smaller_leaf_hist_data);
     }
   }
 }
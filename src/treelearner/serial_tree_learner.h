@@ -227,6 +227,10 @@ class SerialTreeLearner: public TreeLearner {
   /*! \brief hessians of current iteration, ordered for cache optimized */
   std::vector<score_t, Common::AlignmentAllocator<score_t, kAlignedSize>> ordered_hessians_;
 #endif
+  /*! \brief rows of two sibling leaves merged in increasing order, when their parent histogram is not cached */
+  std::vector<data_size_t> sibling_indices_;
+  /*! \brief leaf of each row in sibling_indices_, 0 for the smaller leaf and 1 for the larger leaf */
+  std::vector<uint8_t> sibling_leaf_of_;
   /*! \brief used to cache historical histogram to speed up*/
   HistogramPool histogram_pool_;
   /*! \brief config of tree learner*/
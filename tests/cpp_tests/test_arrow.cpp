@@ -339,3 +339,61 @@ TEST_F(ArrowChunkedArrayTest, OffsetAndValidity) {
 
   arr.release(&arr);
 }
+
+TEST_F(ArrowChunkedArrayTest, CopyToAndGather) {
+  std::vector<float> dat1 = {0, 1, 2, 3, 4, 5, 6};
+  auto arr1 = create_primitive_array(dat1, 2, {2, 3});
+  std::vector<float> dat2 = {7, 8, 9};
+  auto arr2 = create_primitive_array(dat2, 0, {1});
+  auto schema = create_primitive_schema<float>();
+  ArrowArray arrs[2] = {arr1, arr2};
+  ArrowChunkedArray ca(2, arrs, &schema);
+
+  // Values converted per chunk must match the values of the iterator, including nulls
+  std::vector<double> expected;
+  for (auto it = ca.begin<double>(), end = ca.end<double>(); it != end; ++it) {
+    expected.push_back(*it);
+  }
+  ASSERT_EQ(expected.size(), 8);
+  for (int64_t start = 0; start < ca.get_length(); ++start) {
+    std::vector<double> copied(ca.get_length() - start);
+    ca.copy_to(start, static_cast<int64_t>(copied.size()), copied.data());
+    for (size_t i = 0; i < copied.size(); ++i) {
+      if (std::isnan(expected[start + i])) {
+        ASSERT_TRUE(std::isnan(copied[i]));
+      } else {
+        ASSERT_EQ(copied[i], expected[start + i]);
+      }
+    }
+  }
+
+  std::vector<int> indices = {1, 3, 4, 5, 7};
+  std::vector<double> gathered(indices.size());
+  ca.gather(indices.data(), static_cast<int64_t>(indices.size()), gathered.data());
+  ASSERT_TRUE(std::isnan(gathered[0]));
+  ASSERT_EQ(gathered[1], 5);
+  ASSERT_EQ(gathered[2], 6);
+  ASSERT_EQ(gathered[3], 7);
+  ASSERT_EQ(gathered[4], 9);
+}
+
+TEST_F(ArrowChunkedArrayTest, BooleanCopyTo) {
+  std::vector<bool> dat1 = {false, true, false};
+  auto arr1 = create_primitive_array(dat1, 0, {2});
+  std::vector<bool> dat2 = {false, false, false, false, true, true, true, true, false, true};
+  auto arr2 = create_primitive_array(dat2, 1);
+  auto schema = create_primitive_schema<bool>();
+  ArrowArray arrs[2] = {arr1, arr2};
+  ArrowChunkedArray ca(2, arrs, &schema);
+
+  std::vector<float> copied(ca.get_length());
+  ca.copy_to(0, ca.get_length(), copied.data());
+  auto it = ca.begin<float>();
+  for (size_t i = 0; i < copied.size(); ++i, ++it) {
+    if (std::isnan(*it)) {
+      ASSERT_TRUE(std::isnan(copied[i]));
+    } else {
+      ASSERT_EQ(copied[i], *it);
+    }
+  }
+}
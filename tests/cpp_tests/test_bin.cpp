@@ -0,0 +1,207 @@
+/*!
+ * Copyright (c) 2024 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+#include <gtest/gtest.h>
+#include <LightGBM/bin.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+
+using LightGBM::Bin;
+using LightGBM::BinIterator;
+using LightGBM::BinMapper;
+using LightGBM::BinType;
+using LightGBM::data_size_t;
+
+namespace {
+
+// Batched binning must give exactly the bins of the scalar ValueToBin
+void CheckBatchValueToBin(const BinMapper& mapper, const std::vector<double>& values) {
+  std::vector<uint32_t> bins(values.size());
+  mapper.ValueToBin(values.data(), static_cast<data_size_t>(values.size()), bins.data());
+  for (size_t i = 0; i < values.size(); ++i) {
+    EXPECT_EQ(bins[i], mapper.ValueToBin(values[i])) << "value " << values[i];
+  }
+}
+
+std::vector<double> ProbeValues(const BinMapper& mapper, std::mt19937* rng) {
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  const double inf = std::numeric_limits<double>::infinity();
+  std::vector<double> values = {nan, 0.0, -0.0, 1e-40, -1e-40, inf, -inf, 3.0, -1.0, 1e300};
+  for (int i = 0; i < mapper.num_bin(); ++i) {
+    const double bound = mapper.BinToValue(i);
+    values.push_back(bound);
+    values.push_back(std::nextafter(bound, inf));
+    values.push_back(std::nextafter(bound, -inf));
+  }
+  std::normal_distribution<double> dist(0.0, 10.0);
+  for (int i = 0; i < 1000; ++i) {
+    values.push_back(dist(*rng));
+  }
+  return values;
+}
+
+}  // namespace
+
+TEST(BinMapper, BatchValueToBin) {
+  std::mt19937 rng(7);
+  std::normal_distribution<double> dist(0.0, 10.0);
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  const int max_bins[] = {2, 3, 15, 63, 255, 1024};
+  for (int max_bin : max_bins) {
+    for (int with_nan = 0; with_nan < 2; ++with_nan) {
+      for (int zero_as_missing = 0; zero_as_missing < 2; ++zero_as_missing) {
+        std::vector<double> sample;
+        for (int i = 0; i < 5000; ++i) {
+          const double value = dist(rng);
+          // the sampled values passed to FindBin are the non-zero ones
+          if (std::fabs(value) > 1.0) {
+            sample.push_back(with_nan && i % 7 == 0 ? nan : value);
+          }
+        }
+        BinMapper mapper;
+        mapper.FindBin(sample.data(), static_cast<int>(sample.size()), 10000, max_bin, 3, 3, false,
+                       BinType::NumericalBin, true, zero_as_missing != 0, std::vector<double>());
+        CheckBatchValueToBin(mapper, ProbeValues(mapper, &rng));
+      }
+    }
+  }
+}
+
+TEST(BinMapper, BatchValueToBinCategorical) {
+  std::mt19937 rng(11);
+  std::vector<double> sample;
+  for (int i = 0; i < 5000; ++i) {
+    sample.push_back(static_cast<double>(1 + rng() % 40));
+  }
+  BinMapper mapper;
+  mapper.FindBin(sample.data(), static_cast<int>(sample.size()), 6000, 255, 3, 3, false,
+                 BinType::CategoricalBin, true, false, std::vector<double>());
+  std::vector<double> values = ProbeValues(mapper, &rng);
+  for (int i = -2; i < 45; ++i) {
+    values.push_back(static_cast<double>(i));
+  }
+  CheckBatchValueToBin(mapper, values);
+}
+
+TEST(BinMapper, BatchValueToBinTrivial) {
+  std::mt19937 rng(13);
+  std::vector<double> sample(100, 2.5);
+  BinMapper mapper;
+  mapper.FindBin(sample.data(), static_cast<int>(sample.size()), 100, 255, 3, 3, false,
+                 BinType::NumericalBin, true, false, std::vector<double>());
+  CheckBatchValueToBin(mapper, ProbeValues(mapper, &rng));
+}
+
+TEST(Bin, CopySubrowRange) {
+  std::mt19937 rng(17);
+  const data_size_t num_data = 2001;
+  std::vector<data_size_t> used_indices;
+  for (data_size_t i = 0; i < num_data; ++i) {
+    if (rng() % 3 == 0) {
+      used_indices.push_back(i);
+    }
+  }
+  // odd number of rows for the last half byte of 4-bit bins
+  if (used_indices.size() % 2 == 0) {
+    used_indices.pop_back();
+  }
+  const data_size_t num_used = static_cast<data_size_t>(used_indices.size());
+  // 4-bit and 8-bit dense bins
+  for (int num_bin : {10, 200}) {
+    std::unique_ptr<Bin> full(Bin::CreateDenseBin(num_data, num_bin));
+    for (data_size_t i = 0; i < num_data; ++i) {
+      full->Push(0, i, rng() % num_bin);
+    }
+    full->FinishLoad();
+    std::unique_ptr<Bin> expected(Bin::CreateDenseBin(num_used, num_bin));
+    expected->CopySubrow(full.get(), used_indices.data(), num_used);
+    std::unique_ptr<Bin> blocked(Bin::CreateDenseBin(num_used, num_bin));
+    for (data_size_t start = 0; start < num_used; start += 64) {
+      blocked->CopySubrowRange(full.get(), used_indices.data(), start, std::min(start + 64, num_used));
+    }
+    EXPECT_FALSE(blocked->IsSparse());
+    std::unique_ptr<BinIterator> full_iter(full->GetIterator(1, num_bin - 1, 0));
+    std::unique_ptr<BinIterator> expected_iter(expected->GetIterator(1, num_bin - 1, 0));
+    std::unique_ptr<BinIterator> blocked_iter(blocked->GetIterator(1, num_bin - 1, 0));
+    for (data_size_t i = 0; i < num_used; ++i) {
+      EXPECT_EQ(full_iter->RawGet(used_indices[i]), expected_iter->RawGet(i)) << "row " << i;
+      EXPECT_EQ(expected_iter->RawGet(i), blocked_iter->RawGet(i)) << "row " << i;
+    }
+  }
+}
+
+TEST(Bin, ConstructSiblingHistograms) {
+  std::mt19937 rng(29);
+  std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+  const data_size_t num_data = 3001;
+  std::vector<LightGBM::score_t> gradients(num_data), hessians(num_data);
+  for (data_size_t i = 0; i < num_data; ++i) {
+    gradients[i] = static_cast<LightGBM::score_t>(uniform(rng));
+    hessians[i] = static_cast<LightGBM::score_t>(uniform(rng) + 1.5);
+  }
+  // two sibling leaves over two thirds of the rows, and their merge
+  std::vector<data_size_t> leaf_indices[2], merged;
+  std::vector<uint8_t> leaf_of;
+  for (data_size_t i = 0; i < num_data; ++i) {
+    const uint8_t leaf = static_cast<uint8_t>(rng() % 3);
+    if (leaf < 2) {
+      leaf_indices[leaf].push_back(i);
+      merged.push_back(i);
+      leaf_of.push_back(leaf);
+    }
+  }
+  const data_size_t num_merged = static_cast<data_size_t>(merged.size());
+  std::vector<LightGBM::score_t> ordered_gradients, ordered_hessians;
+  for (data_size_t row : merged) {
+    ordered_gradients.push_back(gradients[row]);
+    ordered_hessians.push_back(hessians[row]);
+  }
+  for (int num_bin : {10, 200}) {
+    for (int is_sparse = 0; is_sparse < 2; ++is_sparse) {
+      std::unique_ptr<Bin> bin(is_sparse ? Bin::CreateSparseBin(num_data, num_bin)
+                                         : Bin::CreateDenseBin(num_data, num_bin));
+      for (data_size_t i = 0; i < num_data; ++i) {
+        bin->Push(0, i, rng() % 4 == 0 ? rng() % num_bin : 0);
+      }
+      bin->FinishLoad();
+      for (int use_hessian = 0; use_hessian < 2; ++use_hessian) {
+        std::vector<LightGBM::hist_t> expected[2], output[2];
+        for (int leaf = 0; leaf < 2; ++leaf) {
+          expected[leaf].assign(num_bin * 2, 0.0);
+          output[leaf].assign(num_bin * 2, 0.0);
+          const std::vector<data_size_t>& indices = leaf_indices[leaf];
+          std::vector<LightGBM::score_t> leaf_gradients, leaf_hessians;
+          for (data_size_t row : indices) {
+            leaf_gradients.push_back(gradients[row]);
+            leaf_hessians.push_back(hessians[row]);
+          }
+          const data_size_t cnt = static_cast<data_size_t>(indices.size());
+          if (use_hessian) {
+            bin->ConstructHistogram(indices.data(), 0, cnt, leaf_gradients.data(), leaf_hessians.data(),
+                                    expected[leaf].data());
+          } else {
+            bin->ConstructHistogram(indices.data(), 0, cnt, leaf_gradients.data(), expected[leaf].data());
+          }
+        }
+        LightGBM::hist_t* const out[2] = {output[0].data(), output[1].data()};
+        if (use_hessian) {
+          bin->ConstructSiblingHistograms(merged.data(), leaf_of.data(), 0, num_merged, ordered_gradients.data(),
+                                          ordered_hessians.data(), out);
+        } else {
+          bin->ConstructSiblingHistograms(merged.data(), leaf_of.data(), 0, num_merged, ordered_gradients.data(),
+                                          out);
+        }
+        for (int leaf = 0; leaf < 2; ++leaf) {
+          // same rows in the same order, so the sums are bit-identical
+          EXPECT_EQ(expected[leaf], output[leaf]) << num_bin << " bins, sparse " << is_sparse << ", leaf " << leaf;
+        }
+      }
+    }
+  }
+}
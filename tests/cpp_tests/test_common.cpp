@@ -5,6 +5,8 @@
 #include <gtest/gtest.h>
 
 #include <limits>
+#include <string>
+#include <vector>
 
 #include "../include/LightGBM/utils/common.h"
 
@@ -151,3 +153,22 @@ TEST_F(AtofPreciseTest, Inf) {
               << "parsed infinite is not the same for every bit: " << test.data;
   }
 }
+
+TEST(ArrayToStringTest, RoundTrip) {
+  std::vector<double> values = {0.1, -1.0 / 3.0, 1e-300, 12345678.901234567, 0.0, -2.5e17};
+  std::string str = LightGBM::CommonC::ArrayToString<true>(values, values.size());
+  std::vector<double> parsed = LightGBM::CommonC::StringToArray<double>(str, static_cast<int>(values.size()));
+  ASSERT_EQ(values.size(), parsed.size());
+  for (size_t i = 0; i < values.size(); ++i) {
+    EXPECT_EQ(values[i], parsed[i]) << "value " << i << " in: " << str;
+  }
+
+  std::vector<int> ints = {3, -7, 0, 2147483647};
+  EXPECT_EQ("3 -7 0 2147483647", LightGBM::CommonC::ArrayToString(ints, ints.size()));
+  EXPECT_EQ("3 -7", LightGBM::CommonC::ArrayToString(ints, 2));
+  EXPECT_EQ("0.5 0.333333", LightGBM::CommonC::ArrayToString(std::vector<double>{0.5, 1.0 / 3.0}, 2));
+
+  // runs of delimiters do not produce empty values
+  std::vector<int> parsed_ints = LightGBM::CommonC::StringToArray<int>("  1 -2   3 ", ' ');
+  EXPECT_EQ((std::vector<int>{1, -2, 3}), parsed_ints);
+}
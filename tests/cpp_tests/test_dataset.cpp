@@ -0,0 +1,424 @@
+/*!
+ * Copyright (c) 2024 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+#include <gtest/gtest.h>
+#include <LightGBM/c_api.h>
+#include <LightGBM/config.h>
+#include <LightGBM/dataset.h>
+#include <LightGBM/raw_column.h>
+#include <LightGBM/tree.h>
+#include <LightGBM/utils/json11.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../src/treelearner/serial_tree_learner.h"
+
+using json11_internal_lightgbm::Json;
+using LightGBM::BinIterator;
+using LightGBM::Config;
+using LightGBM::data_size_t;
+using LightGBM::Dataset;
+using LightGBM::hist_t;
+using LightGBM::score_t;
+using LightGBM::SerialTreeLearner;
+using LightGBM::Tree;
+using LightGBM::TrainingShareStates;
+using LightGBM::RawColumn;
+using LightGBM::RawType;
+
+namespace {
+
+// CSR rows over columns of different densities, so that EFB finds bundles
+DatasetHandle CreateSparseDataset(const std::string& params, int num_row = 2000, DatasetHandle reference = nullptr) {
+  const int num_col = 300;
+  std::mt19937 rng(31);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  std::vector<int32_t> indptr(1, 0);
+  std::vector<int32_t> indices;
+  std::vector<double> values;
+  for (int row = 0; row < num_row; ++row) {
+    for (int col = 0; col < num_col; ++col) {
+      const double density = col < 10 ? 0.5 : (col < 100 ? 0.05 : 0.005);
+      if (uniform(rng) < density) {
+        indices.push_back(col);
+        values.push_back(uniform(rng) + 0.1);
+      }
+    }
+    indptr.push_back(static_cast<int32_t>(indices.size()));
+  }
+  DatasetHandle handle = nullptr;
+  EXPECT_EQ(0, LGBM_DatasetCreateFromCSR(indptr.data(), C_API_DTYPE_INT32, indices.data(), values.data(),
+                                         C_API_DTYPE_FLOAT64, static_cast<int64_t>(indptr.size()),
+                                         static_cast<int64_t>(values.size()), num_col, params.c_str(), reference,
+                                         &handle));
+  return handle;
+}
+
+// feature f is non-zero on the rows of block f / 5 only, so that the features of different blocks can share a bundle
+int CreateBlockDataset(const std::string& params, DatasetHandle* handle) {
+  const int num_col = 100;
+  const int num_row = 2000;
+  const int rows_per_block = num_row / (num_col / 5);
+  std::vector<int32_t> indptr(1, 0);
+  std::vector<int32_t> indices;
+  std::vector<double> values;
+  for (int row = 0; row < num_row; ++row) {
+    const int block = row / rows_per_block;
+    for (int col = block * 5; col < block * 5 + 5; ++col) {
+      indices.push_back(col);
+      values.push_back(1.0 + (row * 7 + col) % 11);
+    }
+    indptr.push_back(static_cast<int32_t>(indices.size()));
+  }
+  return LGBM_DatasetCreateFromCSR(indptr.data(), C_API_DTYPE_INT32, indices.data(), values.data(),
+                                   C_API_DTYPE_FLOAT64, static_cast<int64_t>(indptr.size()),
+                                   static_cast<int64_t>(values.size()), num_col, params.c_str(), nullptr, handle);
+}
+
+// tells whether the histograms of two siblings were ever built together
+class SiblingHistogramLearner : public SerialTreeLearner {
+ public:
+  explicit SiblingHistogramLearner(const Config* config) : SerialTreeLearner(config) {}
+
+  bool built_siblings() const { return !sibling_indices_.empty(); }
+};
+
+}  // namespace
+
+TEST(Dataset, BundlePlanRoundTrip) {
+  const std::string plan_file = "bundle_plan_test.json";
+  const std::string params = "min_data_in_bin=1 min_data_in_leaf=1 verbose=-1";
+  DatasetHandle plain = CreateSparseDataset(params);
+  DatasetHandle found = CreateSparseDataset(params + " output_bundle_plan=" + plan_file);
+  DatasetHandle planned = CreateSparseDataset(params + " input_bundle_plan=" + plan_file);
+  std::ifstream plan_stream(plan_file);
+  const std::string plan_str((std::istreambuf_iterator<char>(plan_stream)), std::istreambuf_iterator<char>());
+  plan_stream.close();
+  std::remove(plan_file.c_str());
+  const Dataset* expected = static_cast<const Dataset*>(plain);
+  EXPECT_LT(expected->num_feature_groups(), expected->num_features());
+  // the saved plan lists the bundles found by FindGroups
+  std::string err;
+  const Json plan = Json::parse(plan_str, &err);
+  ASSERT_TRUE(err.empty()) << err;
+  ASSERT_EQ(static_cast<size_t>(expected->num_feature_groups()), plan["bundles"].array_items().size());
+  for (int i = 0; i < expected->num_feature_groups(); ++i) {
+    const Json& bundle = plan["bundles"][i];
+    std::vector<int> features;
+    for (const Json& feature : bundle["features"].array_items()) {
+      features.push_back(feature.int_value());
+    }
+    EXPECT_EQ(expected->FeatureGroupColumns(i), features) << "bundle " << i;
+    EXPECT_EQ(expected->IsMultiGroup(i), bundle["multi_val"].bool_value()) << "bundle " << i;
+  }
+  // and the Datasets built with and from the plan have the same bundles
+  for (DatasetHandle handle : {found, planned}) {
+    const Dataset* output = static_cast<const Dataset*>(handle);
+    ASSERT_EQ(expected->num_features(), output->num_features());
+    ASSERT_EQ(expected->num_feature_groups(), output->num_feature_groups());
+    for (int i = 0; i < expected->num_features(); ++i) {
+      EXPECT_EQ(expected->RealFeatureIndex(i), output->RealFeatureIndex(i));
+      EXPECT_EQ(expected->Feature2Group(i), output->Feature2Group(i));
+    }
+    for (int i = 0; i < expected->num_feature_groups(); ++i) {
+      EXPECT_EQ(expected->FeatureGroupColumns(i), output->FeatureGroupColumns(i));
+      EXPECT_EQ(expected->IsMultiGroup(i), output->IsMultiGroup(i));
+      EXPECT_EQ(expected->FeatureGroupNumBin(i), output->FeatureGroupNumBin(i));
+    }
+  }
+  EXPECT_EQ(0, LGBM_DatasetFree(plain));
+  EXPECT_EQ(0, LGBM_DatasetFree(found));
+  EXPECT_EQ(0, LGBM_DatasetFree(planned));
+}
+
+TEST(Dataset, InvalidBundlePlan) {
+  const std::string plan_file = "invalid_bundle_plan_test.json";
+  const std::string params = "min_data_in_bin=1 verbose=-1 input_bundle_plan=" + plan_file;
+  // two multi-val bundles
+  {
+    std::ofstream plan(plan_file);
+    plan << "{\"num_total_features\":100,\"bundles\":["
+         << "{\"features\":[0,5],\"multi_val\":true},{\"features\":[1,6],\"multi_val\":true}]}";
+  }
+  DatasetHandle handle = nullptr;
+  EXPECT_EQ(-1, CreateBlockDataset(params, &handle));
+  EXPECT_NE(std::string::npos, std::string(LGBM_GetLastError()).find("more than one multi_val bundle"))
+      << LGBM_GetLastError();
+  // two columns of about 255 bins each can share a bundle on the CPU, but not on the GPU
+  {
+    std::ofstream plan(plan_file);
+    plan << "{\"num_total_features\":300,\"bundles\":[{\"features\":[0,1],\"multi_val\":false}]}";
+  }
+  DatasetHandle cpu = CreateSparseDataset(params);
+  EXPECT_NE(nullptr, cpu);
+  EXPECT_EQ(0, LGBM_DatasetFree(cpu));
+  DatasetHandle gpu = nullptr;
+  const int num_col = 300;
+  const int num_row = 2000;
+  std::mt19937 rng(31);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  std::vector<double> dense(static_cast<size_t>(num_row) * num_col, 0.0);
+  for (int row = 0; row < num_row; ++row) {
+    dense[static_cast<size_t>(row) * num_col] = uniform(rng);
+    dense[static_cast<size_t>(row) * num_col + 1] = uniform(rng);
+  }
+  EXPECT_EQ(-1, LGBM_DatasetCreateFromMat(dense.data(), C_API_DTYPE_FLOAT64, num_row, num_col, 1,
+                                          (params + " device_type=gpu").c_str(), nullptr, &gpu));
+  EXPECT_NE(std::string::npos, std::string(LGBM_GetLastError()).find("at most 256 bins")) << LGBM_GetLastError();
+  std::remove(plan_file.c_str());
+}
+
+TEST(Dataset, MaxBundleSearchGroups) {
+  const std::string params = "min_data_in_bin=1 verbose=-1 is_enable_sparse=false max_bundle_search_groups=";
+  int num_groups[3];
+  const int max_search_groups[3] = {1, 100, 10000};
+  for (int i = 0; i < 3; ++i) {
+    DatasetHandle handle = nullptr;
+    ASSERT_EQ(0, CreateBlockDataset(params + std::to_string(max_search_groups[i]), &handle));
+    num_groups[i] = static_cast<const Dataset*>(handle)->num_feature_groups();
+    EXPECT_EQ(0, LGBM_DatasetFree(handle));
+  }
+  // the five features of a block go to five bundles, which a search of all the bundles finds
+  EXPECT_EQ(5, num_groups[1]);
+  EXPECT_EQ(5, num_groups[2]);
+  // trying only the last bundle puts one feature of each block in it and opens new bundles for the others
+  EXPECT_EQ(5 + 19 * 4, num_groups[0]);
+}
+
+TEST(Dataset, SchemaRoundTrip) {
+  const std::string schema_file = "dataset_schema_test.bin";
+  const std::string params = "min_data_in_bin=1 min_data_in_leaf=1 verbose=-1";
+  DatasetHandle found = CreateSparseDataset(params + " output_dataset_schema=" + schema_file);
+  // the bins come from the schema, so max_bin should not matter
+  DatasetHandle loaded = CreateSparseDataset(params + " max_bin=7 input_dataset_schema=" + schema_file);
+  std::remove(schema_file.c_str());
+  Dataset* expected = static_cast<Dataset*>(found);
+  Dataset* output = static_cast<Dataset*>(loaded);
+  ASSERT_EQ(expected->num_data(), output->num_data());
+  ASSERT_EQ(expected->num_features(), output->num_features());
+  EXPECT_EQ(expected->num_feature_groups(), output->num_feature_groups());
+  for (int i = 0; i < expected->num_features(); ++i) {
+    EXPECT_EQ(expected->RealFeatureIndex(i), output->RealFeatureIndex(i));
+    EXPECT_EQ(expected->Feature2Group(i), output->Feature2Group(i));
+    EXPECT_TRUE(expected->FeatureBinMapper(i)->CheckAlign(*output->FeatureBinMapper(i)));
+  }
+  for (int i = 0; i < expected->num_feature_groups(); ++i) {
+    EXPECT_EQ(expected->IsMultiGroup(i), output->IsMultiGroup(i));
+  }
+  // the binned data should be the same too
+  const std::string expected_dump = "dataset_schema_expected.txt";
+  const std::string output_dump = "dataset_schema_output.txt";
+  expected->DumpTextFile(expected_dump.c_str());
+  output->DumpTextFile(output_dump.c_str());
+  std::ifstream expected_stream(expected_dump);
+  std::ifstream output_stream(output_dump);
+  const std::string expected_text((std::istreambuf_iterator<char>(expected_stream)), std::istreambuf_iterator<char>());
+  const std::string output_text((std::istreambuf_iterator<char>(output_stream)), std::istreambuf_iterator<char>());
+  std::remove(expected_dump.c_str());
+  std::remove(output_dump.c_str());
+  EXPECT_FALSE(expected_text.empty());
+  EXPECT_EQ(expected_text, output_text);
+  EXPECT_EQ(0, LGBM_DatasetFree(found));
+  EXPECT_EQ(0, LGBM_DatasetFree(loaded));
+}
+
+TEST(Dataset, RawColumnEncodings) {
+  // values exactly representable in half precision and bfloat16 come back unchanged
+  const std::vector<float> exact = {0.0f, -0.0f, 1.0f, -2.5f, 0.375f, 1024.0f, 65504.0f, 6.103515625e-05f,
+                                    5.9604644775390625e-08f, INFINITY, -INFINITY};
+  for (float value : exact) {
+    EXPECT_EQ(value, RawColumn::HalfToFloat(RawColumn::FloatToHalf(value)));
+  }
+  EXPECT_TRUE(std::isnan(RawColumn::HalfToFloat(RawColumn::FloatToHalf(NAN))));
+  EXPECT_TRUE(std::isnan(RawColumn::BFloat16ToFloat(RawColumn::FloatToBFloat16(NAN))));
+  // round to nearest, ties to even
+  EXPECT_EQ(1.0f, RawColumn::HalfToFloat(RawColumn::FloatToHalf(1.0f + 1.0f / 4096.0f)));
+  EXPECT_EQ(1.0f + 1.0f / 512.0f, RawColumn::HalfToFloat(RawColumn::FloatToHalf(1.0f + 3.0f / 2048.0f)));
+  EXPECT_EQ(INFINITY, RawColumn::HalfToFloat(RawColumn::FloatToHalf(65520.0f)));
+  EXPECT_EQ(0.0f, RawColumn::HalfToFloat(RawColumn::FloatToHalf(2.9e-08f)));
+  EXPECT_EQ(1.0f, RawColumn::BFloat16ToFloat(RawColumn::FloatToBFloat16(1.0f + 1.0f / 256.0f)));
+  EXPECT_EQ(1.0f + 1.0f / 64.0f, RawColumn::BFloat16ToFloat(RawColumn::FloatToBFloat16(1.0f + 3.0f / 256.0f)));
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> uniform(-100.0f, 100.0f);
+  for (int i = 0; i < 1000; ++i) {
+    const float value = uniform(rng);
+    EXPECT_NEAR(value, RawColumn::HalfToFloat(RawColumn::FloatToHalf(value)), std::fabs(value) / 2048.0f);
+    EXPECT_NEAR(value, RawColumn::BFloat16ToFloat(RawColumn::FloatToBFloat16(value)), std::fabs(value) / 256.0f);
+  }
+
+  // dictionary codes keep the values, and can be pushed to again after expanding
+  const int num_data = 1000;
+  for (RawType type : {RawType::Float32, RawType::Float16, RawType::BFloat16}) {
+    RawColumn column(type);
+    RawColumn reference(type);
+    column.Resize(num_data);
+    reference.Resize(num_data);
+    for (int i = 0; i < num_data; ++i) {
+      const double value = (i % 7 == 0) ? NAN : (i % 100) * 0.37;
+      column.Set(i, value);
+      reference.Set(i, value);
+    }
+    const size_t size = column.SizesInByte();
+    column.Compress();
+    EXPECT_TRUE(column.is_dictionary());
+    EXPECT_LT(column.SizesInByte(), size);
+    EXPECT_TRUE(column.ContainsNaN());
+    std::vector<int> rows = {999, 3, 0, 500};
+    std::vector<double> gathered(rows.size());
+    column.Gather(rows.data(), static_cast<int>(rows.size()), gathered.data());
+    for (size_t i = 0; i < rows.size(); ++i) {
+      const float expected = reference.Get(rows[i]);
+      if (std::isnan(expected)) {
+        EXPECT_TRUE(std::isnan(gathered[i]));
+      } else {
+        EXPECT_EQ(expected, gathered[i]);
+      }
+    }
+    for (int i = 0; i < num_data; ++i) {
+      const float expected = reference.Get(i);
+      if (std::isnan(expected)) {
+        EXPECT_TRUE(std::isnan(column.Get(i)));
+      } else {
+        EXPECT_EQ(expected, column.Get(i));
+      }
+    }
+    column.Resize(num_data + 1);
+    EXPECT_FALSE(column.is_dictionary());
+    column.Set(num_data, 1.5);
+    EXPECT_EQ(1.5f, column.Get(num_data));
+    EXPECT_EQ(reference.Get(1), column.Get(1));
+  }
+  RawColumn unique_values(RawType::Float32);
+  unique_values.Resize(num_data);
+  for (int i = 0; i < num_data; ++i) {
+    unique_values.Set(i, i * 0.5);
+  }
+  unique_values.Compress();
+  EXPECT_FALSE(unique_values.is_dictionary());
+  EXPECT_EQ(499.5f, unique_values.Get(num_data - 1));
+}
+
+TEST(Dataset, ConstructSiblingHistograms) {
+  // EFB gives the training data dense and multi-val groups, a validation set keeps one column per group, with
+  // sparse bins for the sparse columns
+  const std::string params = "min_data_in_bin=1 verbose=-1";
+  DatasetHandle train = CreateSparseDataset(params, 12000);
+  DatasetHandle valid = CreateSparseDataset(params, 12000, train);
+  int num_dense = 0, num_sparse = 0, num_multi_val = 0;
+  for (DatasetHandle handle : {train, valid}) {
+    const Dataset* dataset = static_cast<const Dataset*>(handle);
+    for (int group = 0; group < dataset->num_feature_groups(); ++group) {
+      if (dataset->IsMultiGroup(group)) {
+        ++num_multi_val;
+        continue;
+      }
+      uint8_t bit_type = 0;
+      bool is_sparse = false;
+      BinIterator* iterator = nullptr;
+      dataset->FeatureGroupBin(group)->GetColWiseData(&bit_type, &is_sparse, &iterator);
+      delete iterator;
+      ++(is_sparse ? num_sparse : num_dense);
+    }
+  }
+  EXPECT_GT(num_dense, 0);
+  EXPECT_GT(num_sparse, 0);
+  EXPECT_EQ(1, num_multi_val);
+
+  std::mt19937 rng(37);
+  std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+  const data_size_t num_data = static_cast<const Dataset*>(train)->num_data();
+  std::vector<score_t> gradients(num_data), hessians(num_data);
+  for (data_size_t i = 0; i < num_data; ++i) {
+    gradients[i] = uniform(rng);
+    hessians[i] = uniform(rng) + 1.5f;
+  }
+  // two sibling leaves over most of the rows, merged they span several blocks of 4096 rows
+  std::vector<data_size_t> leaf_indices[2];
+  for (data_size_t i = 0; i < num_data; ++i) {
+    const int leaf = static_cast<int>(rng() % 5);
+    if (leaf < 4) {
+      leaf_indices[leaf % 2].push_back(i);
+    }
+  }
+  const data_size_t left_cnt = static_cast<data_size_t>(leaf_indices[0].size());
+  const data_size_t right_cnt = static_cast<data_size_t>(leaf_indices[1].size());
+  ASSERT_GT(left_cnt + right_cnt, 2 * 4096);
+  for (DatasetHandle handle : {train, valid}) {
+    const Dataset* dataset = static_cast<const Dataset*>(handle);
+    const std::vector<int8_t> is_feature_used(dataset->num_features(), 1);
+    for (int is_constant_hessian = 0; is_constant_hessian < 2; ++is_constant_hessian) {
+      std::vector<score_t> cur_hessians(is_constant_hessian ? std::vector<score_t>(num_data, 1.0f) : hessians);
+      std::unique_ptr<TrainingShareStates> share_state(dataset->GetShareStates<false, 0>(
+          gradients.data(), cur_hessians.data(), is_feature_used, is_constant_hessian != 0, true, false, 0));
+      const size_t num_hist = static_cast<size_t>(share_state->num_hist_total_bin()) * 2;
+      std::vector<score_t> ordered_gradients(num_data), ordered_hessians(num_data);
+      std::vector<hist_t> expected_left(num_hist, 0.0), expected_right(num_hist, 0.0);
+      dataset->ConstructHistograms<false, 0>(is_feature_used, leaf_indices[0].data(), left_cnt, gradients.data(),
+                                             cur_hessians.data(), ordered_gradients.data(), ordered_hessians.data(),
+                                             share_state.get(), expected_left.data());
+      dataset->ConstructHistograms<false, 0>(is_feature_used, leaf_indices[1].data(), right_cnt, gradients.data(),
+                                             cur_hessians.data(), ordered_gradients.data(), ordered_hessians.data(),
+                                             share_state.get(), expected_right.data());
+      std::vector<data_size_t> data_indices(num_data);
+      std::vector<uint8_t> leaf_of(num_data);
+      std::vector<hist_t> left(num_hist, 0.0), right(num_hist, 0.0);
+      dataset->ConstructSiblingHistograms(is_feature_used, leaf_indices[0].data(), left_cnt, leaf_indices[1].data(),
+                                          right_cnt, gradients.data(), cur_hessians.data(), data_indices.data(),
+                                          leaf_of.data(), ordered_gradients.data(), ordered_hessians.data(),
+                                          share_state.get(), left.data(), right.data());
+      for (size_t i = 0; i < num_hist; ++i) {
+        EXPECT_NEAR(expected_left[i], left[i], 1e-9) << "constant hessian " << is_constant_hessian << ", entry " << i;
+        EXPECT_NEAR(expected_right[i], right[i], 1e-9) << "constant hessian " << is_constant_hessian << ", entry " << i;
+      }
+    }
+  }
+  EXPECT_EQ(0, LGBM_DatasetFree(valid));
+  EXPECT_EQ(0, LGBM_DatasetFree(train));
+}
+
+TEST(Dataset, ConstructSiblingHistogramsInTraining) {
+  DatasetHandle handle = CreateSparseDataset("min_data_in_bin=1 verbose=-1", 12000);
+  const Dataset* dataset = static_cast<const Dataset*>(handle);
+  const data_size_t num_data = dataset->num_data();
+  std::mt19937 rng(43);
+  std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+  std::vector<score_t> gradients(num_data), hessians(num_data);
+  for (data_size_t i = 0; i < num_data; ++i) {
+    gradients[i] = uniform(rng);
+    hessians[i] = uniform(rng) + 1.5f;
+  }
+  // a pool of two histograms evicts the parents, the default pool keeps them and subtracts the smaller leaf
+  std::unique_ptr<Tree> trees[2];
+  for (int limit_pool = 0; limit_pool < 2; ++limit_pool) {
+    Config config;
+    config.num_leaves = 31;
+    config.min_data_in_leaf = 20;
+    config.force_col_wise = true;
+    config.histogram_pool_size = limit_pool ? 1e-6 : -1.0;
+    config.verbosity = -1;
+    SiblingHistogramLearner learner(&config);
+    learner.Init(dataset, false);
+    learner.SetForcedSplit(nullptr);
+    trees[limit_pool].reset(learner.Train(gradients.data(), hessians.data(), false));
+    EXPECT_EQ(limit_pool != 0, learner.built_siblings());
+  }
+  ASSERT_EQ(trees[0]->num_leaves(), trees[1]->num_leaves());
+  EXPECT_EQ(31, trees[1]->num_leaves());
+  for (int i = 0; i < trees[0]->num_leaves() - 1; ++i) {
+    EXPECT_EQ(trees[0]->split_feature(i), trees[1]->split_feature(i)) << "split " << i;
+    EXPECT_EQ(trees[0]->threshold(i), trees[1]->threshold(i)) << "split " << i;
+  }
+  for (int i = 0; i < trees[0]->num_leaves(); ++i) {
+    EXPECT_NEAR(trees[0]->LeafOutput(i), trees[1]->LeafOutput(i), 1e-9) << "leaf " << i;
+  }
+  EXPECT_EQ(0, LGBM_DatasetFree(handle));
+}
@@ -0,0 +1,130 @@
+/*!
+ * Copyright (c) 2024 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+#include <gtest/gtest.h>
+
+#include <Eigen/Dense>
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "../src/treelearner/linear_tree_learner.h"
+
+using LightGBM::AccumulateLinearBlock;
+using LightGBM::kLinearBlockSize;
+using LightGBM::SolveLinearLeaf;
+
+namespace {
+
+// packed upper triangle of X_T * H * X and X_T * g of the rows of x, one row-major row of num_cols values per row
+void AccumulateRows(const std::vector<double>& x, const std::vector<double>& h, const std::vector<double>& g,
+                    int num_cols, std::vector<double>* XTHX, std::vector<double>* XTg) {
+  std::vector<double> x_block((num_cols + 1) * kLinearBlockSize), hx_block((num_cols + 1) * kLinearBlockSize);
+  const int cnt = static_cast<int>(g.size());
+  for (int i = 0; i < cnt; ++i) {
+    for (int f = 0; f < num_cols; ++f) {
+      x_block[f * kLinearBlockSize + i] = x[i * num_cols + f];
+      hx_block[f * kLinearBlockSize + i] = x[i * num_cols + f] * h[i];
+    }
+  }
+  XTHX->assign(num_cols * (num_cols + 1) / 2, 0.0);
+  XTg->assign(num_cols, 0.0);
+  AccumulateLinearBlock(x_block.data(), hx_block.data(), g.data(), cnt, num_cols, XTHX->data(), XTg->data());
+}
+
+}  // namespace
+
+TEST(LinearTree, AccumulateLinearBlock) {
+  std::mt19937 rng(53);
+  std::normal_distribution<double> normal(0.0, 1.0);
+  std::uniform_real_distribution<double> uniform(0.1, 2.0);
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  for (int num_cols = 1; num_cols <= 8; ++num_cols) {
+    for (int cnt : {0, 1, 7, kLinearBlockSize}) {
+      // the padding column and the rows past cnt are never read
+      const int num_block_cols = num_cols + num_cols % 2;
+      std::vector<double> x(num_block_cols * kLinearBlockSize, nan), hx(x), g(kLinearBlockSize, nan);
+      std::vector<double> h(cnt);
+      for (int i = 0; i < cnt; ++i) {
+        h[i] = uniform(rng);
+        g[i] = normal(rng);
+        for (int f = 0; f < num_cols; ++f) {
+          x[f * kLinearBlockSize + i] = f + 1 == num_cols ? 1.0 : normal(rng);
+          hx[f * kLinearBlockSize + i] = x[f * kLinearBlockSize + i] * h[i];
+        }
+      }
+      // the block is added to what was accumulated before
+      std::vector<double> XTHX(num_cols * (num_cols + 1) / 2), XTg(num_cols);
+      for (auto& value : XTHX) {
+        value = normal(rng);
+      }
+      for (auto& value : XTg) {
+        value = normal(rng);
+      }
+      std::vector<double> expected_XTHX(XTHX), expected_XTg(XTg);
+      // one rank-one update per row
+      for (int i = 0; i < cnt; ++i) {
+        int j = 0;
+        for (int f1 = 0; f1 < num_cols; ++f1) {
+          for (int f2 = f1; f2 < num_cols; ++f2) {
+            expected_XTHX[j++] += h[i] * x[f1 * kLinearBlockSize + i] * x[f2 * kLinearBlockSize + i];
+          }
+          expected_XTg[f1] += x[f1 * kLinearBlockSize + i] * g[i];
+        }
+      }
+      AccumulateLinearBlock(x.data(), hx.data(), g.data(), cnt, num_cols, XTHX.data(), XTg.data());
+      for (size_t j = 0; j < XTHX.size(); ++j) {
+        EXPECT_NEAR(expected_XTHX[j], XTHX[j], 1e-12 * (1.0 + std::fabs(expected_XTHX[j])))
+            << "num_cols " << num_cols << " cnt " << cnt << " entry " << j;
+      }
+      for (int f = 0; f < num_cols; ++f) {
+        EXPECT_NEAR(expected_XTg[f], XTg[f], 1e-12 * (1.0 + std::fabs(expected_XTg[f])))
+            << "num_cols " << num_cols << " cnt " << cnt << " column " << f;
+      }
+    }
+  }
+}
+
+TEST(LinearTree, SolveSingularLeaf) {
+  // a leaf where the second feature repeats the first one, the constant term is the last column
+  const int num_row = 6;
+  const std::vector<double> values = {3, 2, 1, 1, 1, 1};
+  const std::vector<double> h = {3, 3, 1, 1, 1, 1};
+  const std::vector<double> g = {0.5, -1.0, 0.25, 2.0, -0.75, 1.5};
+  std::vector<double> x, x_unique;
+  for (int i = 0; i < num_row; ++i) {
+    x.insert(x.end(), {values[i], values[i], 1.0});
+    x_unique.insert(x_unique.end(), {values[i], 1.0});
+  }
+  std::vector<double> XTHX, XTg;
+  AccumulateRows(x, h, g, 3, &XTHX, &XTg);
+  // LDLT fails on this matrix, so that the coefficients come from the full pivoting LU
+  Eigen::MatrixXd XTHX_mat(3, 3);
+  for (int f1 = 0, j = 0; f1 < 3; ++f1) {
+    for (int f2 = f1; f2 < 3; ++f2, ++j) {
+      XTHX_mat(f1, f2) = XTHX_mat(f2, f1) = XTHX[j];
+    }
+  }
+  ASSERT_NE(Eigen::Success, Eigen::LDLT<Eigen::MatrixXd>(XTHX_mat).info());
+  const std::vector<double> coeffs = SolveLinearLeaf(XTHX.data(), XTg.data(), 3, 0.0);
+  ASSERT_EQ(3u, coeffs.size());
+  for (int f1 = 0; f1 < 3; ++f1) {
+    EXPECT_TRUE(std::isfinite(coeffs[f1]));
+    double lhs = 0.0;
+    for (int f2 = 0; f2 < 3; ++f2) {
+      lhs += XTHX_mat(f1, f2) * coeffs[f2];
+    }
+    EXPECT_NEAR(-XTg[f1], lhs, 1e-9);
+  }
+  // the outputs are those of the leaf without the repeated feature
+  std::vector<double> XTHX_unique, XTg_unique;
+  AccumulateRows(x_unique, h, g, 2, &XTHX_unique, &XTg_unique);
+  const std::vector<double> coeffs_unique = SolveLinearLeaf(XTHX_unique.data(), XTg_unique.data(), 2, 0.0);
+  for (int i = 0; i < num_row; ++i) {
+    EXPECT_NEAR(values[i] * coeffs_unique[0] + coeffs_unique[1],
+                values[i] * (coeffs[0] + coeffs[1]) + coeffs[2], 1e-9);
+  }
+}
@@ -0,0 +1,284 @@
+/*!
+ * Copyright (c) 2024 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+#include <gtest/gtest.h>
+#include <LightGBM/config.h>
+#include <LightGBM/dataset.h>
+#include <LightGBM/metric.h>
+#include <LightGBM/objective_function.h>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using LightGBM::Config;
+using LightGBM::data_size_t;
+using LightGBM::label_t;
+using LightGBM::Metadata;
+using LightGBM::Metric;
+using LightGBM::ObjectiveFunction;
+
+namespace {
+
+// AUC and average precision over a full sort of the rows, accumulated per group of equal scores
+void ReferenceAUCAndAP(const std::vector<double>& score, const std::vector<label_t>& label,
+                       const std::vector<label_t>& weights, double* auc, double* ap) {
+  std::vector<data_size_t> order(score.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = static_cast<data_size_t>(i);
+  }
+  std::sort(order.begin(), order.end(), [&score](data_size_t a, data_size_t b) { return score[a] > score[b]; });
+  double sum_pos = 0.0, sum_neg = 0.0, accum_auc = 0.0, sum_pred_pos = 0.0, accum_ap = 0.0;
+  for (size_t start = 0; start < order.size();) {
+    double cur_pos = 0.0, cur_neg = 0.0;
+    size_t end = start;
+    for (; end < order.size() && score[order[end]] == score[order[start]]; ++end) {
+      const double weight = weights.empty() ? 1.0 : weights[order[end]];
+      cur_pos += (label[order[end]] > 0) * weight;
+      cur_neg += (label[order[end]] <= 0) * weight;
+    }
+    accum_auc += cur_neg * (cur_pos * 0.5 + sum_pos);
+    sum_pos += cur_pos;
+    sum_neg += cur_neg;
+    sum_pred_pos += cur_pos + cur_neg;
+    accum_ap += cur_pos * (sum_pos / sum_pred_pos);
+    start = end;
+  }
+  *auc = accum_auc / (sum_pos * sum_neg);
+  *ap = accum_ap / sum_pos;
+}
+
+void CheckAUCAndAP(const std::vector<double>& score, const std::vector<label_t>& label,
+                   const std::vector<label_t>& weights) {
+  const data_size_t num_data = static_cast<data_size_t>(score.size());
+  Metadata metadata;
+  metadata.Init(num_data, weights.empty() ? -1 : 0, -1);
+  metadata.SetLabel(label.data(), num_data);
+  if (!weights.empty()) {
+    metadata.SetWeights(weights.data(), num_data);
+  }
+  double expected_auc = 0.0, expected_ap = 0.0;
+  ReferenceAUCAndAP(score, label, weights, &expected_auc, &expected_ap);
+  Config config;
+  std::unique_ptr<Metric> auc(Metric::CreateMetric("auc", config));
+  std::unique_ptr<Metric> ap(Metric::CreateMetric("average_precision", config));
+  auc->Init(metadata, num_data);
+  ap->Init(metadata, num_data);
+  // the same metrics are evaluated from several threads at once
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 3; ++i) {
+    threads.emplace_back([&]() {
+      if (weights.empty()) {
+        EXPECT_EQ(expected_auc, auc->Eval(score.data(), nullptr)[0]);
+        EXPECT_EQ(expected_ap, ap->Eval(score.data(), nullptr)[0]);
+      } else {
+        EXPECT_NEAR(expected_auc, auc->Eval(score.data(), nullptr)[0], 1e-12);
+        EXPECT_NEAR(expected_ap, ap->Eval(score.data(), nullptr)[0], 1e-12);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+}  // namespace
+
+TEST(Metric, BucketedAUCAndAveragePrecision) {
+  std::mt19937 rng(17);
+  std::normal_distribution<double> normal(0.0, 1.0);
+  std::uniform_real_distribution<float> uniform(0.1f, 2.0f);
+  const data_size_t num_data = 200001;
+  std::vector<double> continuous(num_data), ties(num_data), skewed(num_data);
+  std::vector<label_t> label(num_data), weights(num_data);
+  for (data_size_t i = 0; i < num_data; ++i) {
+    continuous[i] = normal(rng);
+    label[i] = continuous[i] + normal(rng) > 0.5 ? 1.0f : 0.0f;
+    weights[i] = uniform(rng);
+    ties[i] = std::round(continuous[i] * 20.0) / 20.0;
+    // almost all scores in the first bucket
+    skewed[i] = i % 1000 == 0 ? 1e6 * continuous[i] : continuous[i];
+  }
+  const std::vector<label_t> no_weights;
+  for (const std::vector<double>* score : {&continuous, &ties, &skewed}) {
+    CheckAUCAndAP(*score, label, no_weights);
+    CheckAUCAndAP(*score, label, weights);
+  }
+  // one metric evaluated again and again reuses its buffers
+  {
+    Metadata metadata;
+    metadata.Init(num_data, -1, -1);
+    metadata.SetLabel(label.data(), num_data);
+    Config config;
+    std::unique_ptr<Metric> auc(Metric::CreateMetric("auc", config));
+    std::unique_ptr<Metric> ap(Metric::CreateMetric("average_precision", config));
+    auc->Init(metadata, num_data);
+    ap->Init(metadata, num_data);
+    for (const std::vector<double>* score : {&continuous, &ties, &skewed, &continuous}) {
+      double expected_auc = 0.0, expected_ap = 0.0;
+      ReferenceAUCAndAP(*score, label, no_weights, &expected_auc, &expected_ap);
+      EXPECT_EQ(expected_auc, auc->Eval(score->data(), nullptr)[0]);
+      EXPECT_EQ(expected_ap, ap->Eval(score->data(), nullptr)[0]);
+    }
+  }
+  // small inputs use the direct sort
+  const std::vector<double> small_score(continuous.begin(), continuous.begin() + 1000);
+  const std::vector<label_t> small_label(label.begin(), label.begin() + 1000);
+  CheckAUCAndAP(small_score, small_label, no_weights);
+  // non-finite scores use the direct sort
+  std::vector<double> infinite(ties);
+  infinite[3] = std::numeric_limits<double>::infinity();
+  infinite[5] = -std::numeric_limits<double>::infinity();
+  CheckAUCAndAP(infinite, label, no_weights);
+  // a denormal spread of the scores cannot be scaled to buckets
+  std::vector<double> denormal(num_data);
+  for (data_size_t i = 0; i < num_data; ++i) {
+    denormal[i] = std::round(continuous[i] * 8.0) * 1e-310;
+  }
+  CheckAUCAndAP(denormal, label, no_weights);
+}
+
+TEST(Metric, FusedPointwiseMetrics) {
+  std::mt19937 rng(23);
+  std::normal_distribution<double> normal(0.0, 1.0);
+  std::uniform_real_distribution<float> uniform(0.1f, 2.0f);
+  const data_size_t num_data = 10001;
+  std::vector<double> score(num_data);
+  std::vector<label_t> label(num_data), weights(num_data);
+  for (data_size_t i = 0; i < num_data; ++i) {
+    score[i] = normal(rng);
+    label[i] = score[i] + normal(rng) > 0.5 ? 1.0f : 0.0f;
+    weights[i] = uniform(rng);
+  }
+  Config config;
+  const std::vector<std::string> binary_metrics = {"binary_logloss", "binary_error", "l2", "l1"};
+  const std::vector<std::string> raw_metrics = {"l2", "rmse", "l1", "huber", "binary_error"};
+  for (int use_weights = 0; use_weights < 2; ++use_weights) {
+    Metadata metadata;
+    metadata.Init(num_data, use_weights ? 0 : -1, -1);
+    metadata.SetLabel(label.data(), num_data);
+    if (use_weights) {
+      metadata.SetWeights(weights.data(), num_data);
+    }
+    std::unique_ptr<ObjectiveFunction> binary(ObjectiveFunction::CreateObjectiveFunction("binary", config));
+    binary->Init(metadata, num_data);
+    for (const ObjectiveFunction* objective : {static_cast<const ObjectiveFunction*>(binary.get()),
+                                               static_cast<const ObjectiveFunction*>(nullptr)}) {
+      std::vector<std::unique_ptr<Metric>> metrics;
+      std::vector<const Metric*> metric_ptrs;
+      for (const auto& type : objective != nullptr ? binary_metrics : raw_metrics) {
+        metrics.emplace_back(Metric::CreateMetric(type, config));
+        metrics.back()->Init(metadata, num_data);
+        ASSERT_TRUE(metrics.back()->IsPointwise()) << type;
+        metric_ptrs.push_back(metrics.back().get());
+      }
+      const auto results = Metric::EvalPointwise(metric_ptrs, score.data(), num_data, objective);
+      ASSERT_EQ(metrics.size(), results.size());
+      for (size_t j = 0; j < metrics.size(); ++j) {
+        const double expected = metrics[j]->Eval(score.data(), objective)[0];
+        ASSERT_EQ(1u, results[j].size());
+        EXPECT_NEAR(expected, results[j][0], 1e-12 * std::fabs(expected)) << metrics[j]->GetName()[0];
+      }
+    }
+  }
+  std::unique_ptr<Metric> auc(Metric::CreateMetric("auc", config));
+  EXPECT_FALSE(auc->IsPointwise());
+}
+
+TEST(Metric, TopKRankingMetrics) {
+  std::mt19937 rng(29);
+  std::normal_distribution<double> normal(0.0, 1.0);
+  std::uniform_int_distribution<int> label_dist(0, 3);
+  // skewed query sizes, including queries shorter than the positions
+  std::vector<data_size_t> query_sizes;
+  data_size_t num_data = 0;
+  for (int q = 0; q < 300; ++q) {
+    const data_size_t size = q % 50 == 0 ? 2000 : 1 + static_cast<data_size_t>(rng() % 30);
+    query_sizes.push_back(size);
+    num_data += size;
+  }
+  std::vector<double> score(num_data);
+  std::vector<label_t> label(num_data);
+  for (data_size_t i = 0; i < num_data; ++i) {
+    label[i] = static_cast<label_t>(label_dist(rng));
+    // rounded scores have many ties, which keep the order of a stable sort
+    score[i] = std::round((label[i] + normal(rng)) * 4.0) / 4.0;
+  }
+  Metadata metadata;
+  metadata.Init(num_data, -1, -1);
+  metadata.SetLabel(label.data(), num_data);
+  metadata.SetQuery(query_sizes.data(), static_cast<data_size_t>(query_sizes.size()));
+
+  const std::vector<int> eval_at = {1, 3, 5, 10};
+  std::vector<double> expected_ndcg(eval_at.size(), 0.0), expected_map(eval_at.size(), 0.0);
+  data_size_t start = 0;
+  for (data_size_t size : query_sizes) {
+    std::vector<data_size_t> order(size);
+    for (data_size_t i = 0; i < size; ++i) {
+      order[i] = start + i;
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&score](data_size_t a, data_size_t b) { return score[a] > score[b]; });
+    std::vector<label_t> ideal(label.begin() + start, label.begin() + start + size);
+    std::sort(ideal.begin(), ideal.end(), std::greater<label_t>());
+    data_size_t num_pos = 0;
+    for (label_t l : ideal) {
+      num_pos += l > 0.5f;
+    }
+    for (size_t j = 0; j < eval_at.size(); ++j) {
+      const data_size_t k = std::min<data_size_t>(eval_at[j], size);
+      double dcg = 0.0, max_dcg = 0.0, sum_ap = 0.0;
+      int num_hit = 0;
+      for (data_size_t pos = 0; pos < k; ++pos) {
+        const double discount = 1.0 / std::log2(2.0 + pos);
+        dcg += ((1 << static_cast<int>(label[order[pos]])) - 1) * discount;
+        max_dcg += ((1 << static_cast<int>(ideal[pos])) - 1) * discount;
+        if (label[order[pos]] > 0.5f) {
+          ++num_hit;
+          sum_ap += num_hit / (pos + 1.0);
+        }
+      }
+      expected_ndcg[j] += ideal[0] > 0 ? dcg / max_dcg : 1.0;
+      expected_map[j] += num_pos > 0 ? sum_ap / std::min(num_pos, k) : 1.0;
+    }
+    start += size;
+  }
+
+  Config config;
+  config.eval_at = eval_at;
+  std::unique_ptr<Metric> ndcg(Metric::CreateMetric("ndcg", config));
+  std::unique_ptr<Metric> map(Metric::CreateMetric("map", config));
+  ndcg->Init(metadata, num_data);
+  map->Init(metadata, num_data);
+  // the same metrics are evaluated from several threads at once
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 3; ++i) {
+    threads.emplace_back([&]() {
+      const auto ndcg_results = ndcg->Eval(score.data(), nullptr);
+      const auto map_results = map->Eval(score.data(), nullptr);
+      for (size_t j = 0; j < eval_at.size(); ++j) {
+        EXPECT_NEAR(expected_ndcg[j] / query_sizes.size(), ndcg_results[j], 1e-12) << "ndcg@" << eval_at[j];
+        EXPECT_NEAR(expected_map[j] / query_sizes.size(), map_results[j], 1e-12) << "map@" << eval_at[j];
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  // later evaluations reuse the buffers of the metrics
+  for (int i = 0; i < 2; ++i) {
+    const auto ndcg_results = ndcg->Eval(score.data(), nullptr);
+    const auto map_results = map->Eval(score.data(), nullptr);
+    for (size_t j = 0; j < eval_at.size(); ++j) {
+      EXPECT_NEAR(expected_ndcg[j] / query_sizes.size(), ndcg_results[j], 1e-12) << "ndcg@" << eval_at[j];
+      EXPECT_NEAR(expected_map[j] / query_sizes.size(), map_results[j], 1e-12) << "map@" << eval_at[j];
+    }
+  }
+}
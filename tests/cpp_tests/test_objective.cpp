@@ -0,0 +1,164 @@
+/*!
+ * Copyright (c) 2024 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+#include <gtest/gtest.h>
+#include <LightGBM/config.h>
+#include <LightGBM/dataset.h>
+#include <LightGBM/objective_function.h>
+#include <LightGBM/utils/common.h>
+
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using LightGBM::Config;
+using LightGBM::data_size_t;
+using LightGBM::label_t;
+using LightGBM::Metadata;
+using LightGBM::ObjectiveFunction;
+using LightGBM::score_t;
+
+namespace {
+
+void GetGradients(const std::string& type, const Config& config, const Metadata& metadata, data_size_t num_data,
+                  const std::vector<double>& score, std::vector<score_t>* gradients, std::vector<score_t>* hessians) {
+  std::unique_ptr<ObjectiveFunction> objective(ObjectiveFunction::CreateObjectiveFunction(type, config));
+  objective->Init(metadata, num_data);
+  gradients->assign(score.size(), 0.0f);
+  hessians->assign(score.size(), 0.0f);
+  objective->GetGradients(score.data(), gradients->data(), hessians->data());
+}
+
+}  // namespace
+
+TEST(Objective, FastExp) {
+  std::vector<float> values;
+  for (float x = -87.0f; x <= 88.0f; x += 0.01f) {
+    values.push_back(x);
+  }
+  std::vector<float> results(values);
+  LightGBM::Common::FastExp(results.data(), static_cast<int>(results.size()));
+  for (size_t i = 0; i < values.size(); ++i) {
+    const double expected = std::exp(static_cast<double>(values[i]));
+    EXPECT_NEAR(1.0, results[i] / expected, 5e-7) << "exp(" << values[i] << ")";
+  }
+  // clamped to normal floats
+  float extremes[] = {-1000.0f, 1000.0f};
+  LightGBM::Common::FastExp(extremes, 2);
+  EXPECT_GT(extremes[0], 0.0f);
+  EXPECT_TRUE(std::isfinite(extremes[1]));
+}
+
+TEST(Objective, SoftmaxGradientsInBlocks) {
+  std::mt19937 rng(31);
+  std::normal_distribution<double> normal(0.0, 2.0);
+  std::uniform_real_distribution<float> uniform(0.1f, 2.0f);
+  const int num_class = 7;
+  // not a multiple of the block size
+  const data_size_t num_data = 1000;
+  std::vector<double> score(static_cast<size_t>(num_data) * num_class);
+  std::vector<label_t> label(num_data), weights(num_data);
+  for (auto& s : score) {
+    s = normal(rng);
+  }
+  for (data_size_t i = 0; i < num_data; ++i) {
+    label[i] = static_cast<label_t>(rng() % num_class);
+    weights[i] = uniform(rng);
+  }
+  Config config;
+  config.num_class = num_class;
+  for (int use_weights = 0; use_weights < 2; ++use_weights) {
+    Metadata metadata;
+    metadata.Init(num_data, use_weights ? 0 : -1, -1);
+    metadata.SetLabel(label.data(), num_data);
+    if (use_weights) {
+      metadata.SetWeights(weights.data(), num_data);
+    }
+    config.objective_fast_math = false;
+    std::vector<score_t> gradients, hessians;
+    GetGradients("multiclass", config, metadata, num_data, score, &gradients, &hessians);
+    // same as the softmax of each row
+    const double factor = num_class / (num_class - 1.0);
+    std::vector<double> rec(num_class);
+    for (data_size_t i = 0; i < num_data; ++i) {
+      for (int k = 0; k < num_class; ++k) {
+        rec[k] = score[static_cast<size_t>(num_data) * k + i];
+      }
+      LightGBM::Common::Softmax(&rec);
+      const double w = use_weights ? weights[i] : 1.0;
+      for (int k = 0; k < num_class; ++k) {
+        const size_t idx = static_cast<size_t>(num_data) * k + i;
+        const double p = rec[k];
+        EXPECT_EQ(static_cast<score_t>((static_cast<int>(label[i]) == k ? p - 1.0f : p) * w), gradients[idx]);
+        EXPECT_EQ(static_cast<score_t>((factor * p * (1.0f - p)) * w), hessians[idx]);
+      }
+    }
+    config.objective_fast_math = true;
+    std::vector<score_t> fast_gradients, fast_hessians;
+    GetGradients("multiclass", config, metadata, num_data, score, &fast_gradients, &fast_hessians);
+    for (size_t i = 0; i < score.size(); ++i) {
+      // the probabilities are within a few units in the last place of single precision
+      EXPECT_NEAR(gradients[i], fast_gradients[i], 1e-6);
+      EXPECT_NEAR(hessians[i], fast_hessians[i], 1e-6);
+    }
+  }
+}
+
+TEST(Objective, FastMathBinaryGradients) {
+  std::mt19937 rng(37);
+  std::normal_distribution<double> normal(0.0, 4.0);
+  std::uniform_real_distribution<float> uniform(0.1f, 2.0f);
+  const data_size_t num_data = 3001;
+  std::vector<double> score(num_data);
+  std::vector<label_t> label(num_data), weights(num_data);
+  for (data_size_t i = 0; i < num_data; ++i) {
+    score[i] = normal(rng);
+    label[i] = rng() % 2 == 0 ? 1.0f : 0.0f;
+    weights[i] = uniform(rng);
+  }
+  // far in the tails, where the Hessians are tiny but not zero
+  const std::vector<double> tails = {-60.0, 60.0, -40.0, 40.0, -25.0, 25.0, -15.0, 15.0, -12.0, 12.0};
+  for (size_t i = 0; i < tails.size(); ++i) {
+    score[2 * i] = tails[i];
+    score[2 * i + 1] = tails[i];
+  }
+  const std::vector<std::string> objectives = {"binary", "cross_entropy", "multiclassova"};
+  for (const auto& type : objectives) {
+    for (int use_weights = 0; use_weights < 2; ++use_weights) {
+      Metadata metadata;
+      metadata.Init(num_data, use_weights ? 0 : -1, -1);
+      metadata.SetLabel(label.data(), num_data);
+      if (use_weights) {
+        metadata.SetWeights(weights.data(), num_data);
+      }
+      Config config;
+      config.sigmoid = 1.5;
+      config.is_unbalance = true;
+      if (type == "multiclassova") {
+        config.num_class = 2;
+      }
+      std::vector<double> class_score(score);
+      if (type == "multiclassova") {
+        class_score.insert(class_score.end(), score.rbegin(), score.rend());
+      }
+      std::vector<score_t> gradients, hessians, fast_gradients, fast_hessians;
+      GetGradients(type, config, metadata, num_data, class_score, &gradients, &hessians);
+      config.objective_fast_math = true;
+      GetGradients(type, config, metadata, num_data, class_score, &fast_gradients, &fast_hessians);
+      for (size_t i = 0; i < class_score.size(); ++i) {
+        // relative to the double precision results, which round to 0 themselves below about exp(-37). Rounding
+        // the score to single precision changes exp(score) by up to |score| units in the last place
+        const double rel_tol = (8.0 + 2.0 * std::fabs(class_score[i])) * std::numeric_limits<float>::epsilon();
+        EXPECT_NEAR(gradients[i], fast_gradients[i], rel_tol * std::fabs(gradients[i]) + 1e-15) << type << " " << i;
+        EXPECT_NEAR(hessians[i], fast_hessians[i], rel_tol * std::fabs(hessians[i]) + 1e-15) << type << " " << i;
+        if (std::fabs(class_score[i]) <= 40.0) {
+          EXPECT_GT(fast_hessians[i], 0.0f) << type << " " << i;
+        }
+      }
+    }
+  }
+}
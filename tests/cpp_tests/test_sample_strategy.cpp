@@ -0,0 +1,217 @@
+/*!
+ * Copyright (c) 2024 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+#include <gtest/gtest.h>
+#include <LightGBM/c_api.h>
+#include <LightGBM/config.h>
+#include <LightGBM/dataset.h>
+#include <LightGBM/sample_strategy.h>
+#include <LightGBM/tree_learner.h>
+#include <LightGBM/utils/openmp_wrapper.h>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <random>
+#include <vector>
+
+using LightGBM::Config;
+using LightGBM::data_size_t;
+using LightGBM::Dataset;
+using LightGBM::SampleStrategy;
+using LightGBM::score_t;
+using LightGBM::TreeLearner;
+
+namespace {
+
+// a few random dense features, more rows than one block of the radix select
+DatasetHandle CreateGOSSDataset(data_size_t num_data) {
+  const int num_col = 4;
+  std::mt19937 rng(41);
+  std::normal_distribution<double> normal(0.0, 1.0);
+  std::vector<double> features(static_cast<size_t>(num_data) * num_col);
+  for (auto& value : features) {
+    value = normal(rng);
+  }
+  DatasetHandle handle = nullptr;
+  EXPECT_EQ(0, LGBM_DatasetCreateFromMat(features.data(), C_API_DTYPE_FLOAT64, num_data, num_col, 1, "verbose=-1",
+                                         nullptr, &handle));
+  return handle;
+}
+
+// one GOSS sample of the rows, returns the sampled rows; the gradients and Hessians are updated in place
+std::vector<data_size_t> SampleGOSS(const Config& config, const Dataset* dataset, std::vector<score_t>* gradients,
+                                    std::vector<score_t>* hessians) {
+  std::unique_ptr<TreeLearner> learner(TreeLearner::CreateTreeLearner(config.tree_learner, config.device_type,
+                                                                      &config, false));
+  learner->Init(dataset, false);
+  std::unique_ptr<SampleStrategy> strategy(SampleStrategy::CreateSampleStrategy(&config, dataset, nullptr, 1));
+  strategy->ResetSampleConfig(&config, true);
+  strategy->Bagging(1, learner.get(), gradients->data(), hessians->data());
+  std::vector<data_size_t> rows(strategy->bag_data_indices().begin(),
+                                strategy->bag_data_indices().begin() + strategy->bag_data_cnt());
+  std::sort(rows.begin(), rows.end());
+  return rows;
+}
+
+Config GOSSConfig(double top_rate, double other_rate) {
+  Config config;
+  config.data_sample_strategy = "goss";
+  // samples from the first iteration on
+  config.learning_rate = 1.0;
+  config.top_rate = top_rate;
+  config.other_rate = other_rate;
+  config.verbosity = -1;
+  return config;
+}
+
+// exposes the cost model of the sample strategies, without data
+class CostModelStrategy : public SampleStrategy {
+ public:
+  CostModelStrategy(const Config* config, data_size_t num_data, int num_tree_per_iteration) {
+    config_ = config;
+    num_data_ = num_data;
+    num_tree_per_iteration_ = num_tree_per_iteration;
+  }
+
+  void Bagging(int, TreeLearner*, score_t*, score_t*) override {}
+
+  void ResetSampleConfig(const Config*, bool) override {}
+
+  bool IsHessianChange() const override { return false; }
+
+  using SampleStrategy::IsSubsetCheaper;
+};
+
+}  // namespace
+
+TEST(SampleStrategy, SubsetCostModel) {
+  const data_size_t num_data = 100000;
+  Config config;
+  config.num_leaves = 31;
+  const CostModelStrategy one_tree(&config, num_data, 1);
+  // all rows or more are never copied
+  EXPECT_FALSE(one_tree.IsSubsetCheaper(num_data, 1));
+  EXPECT_FALSE(one_tree.IsSubsetCheaper(num_data + 1, 1));
+  EXPECT_FALSE(one_tree.IsSubsetCheaper(num_data - 1, 100));
+  // a few rows are gathered
+  EXPECT_TRUE(one_tree.IsSubsetCheaper(1, 1));
+  // the switch points, where the copy stops being cheaper
+  EXPECT_TRUE(one_tree.IsSubsetCheaper(45226, 1));
+  EXPECT_FALSE(one_tree.IsSubsetCheaper(45227, 1));
+  // a bag reused for several iterations amortizes its copy
+  EXPECT_TRUE(one_tree.IsSubsetCheaper(84524, 5));
+  EXPECT_FALSE(one_tree.IsSubsetCheaper(84525, 5));
+  // as does a bag shared by the trees of an iteration
+  const CostModelStrategy three_trees(&config, num_data, 3);
+  EXPECT_TRUE(three_trees.IsSubsetCheaper(75867, 1));
+  EXPECT_FALSE(three_trees.IsSubsetCheaper(75868, 1));
+  // stumps make a single pass over the rows
+  config.num_leaves = 2;
+  EXPECT_TRUE(one_tree.IsSubsetCheaper(14284, 1));
+  EXPECT_FALSE(one_tree.IsSubsetCheaper(14285, 1));
+}
+
+TEST(SampleStrategy, GOSSTopKThreshold) {
+  const data_size_t num_data = 50001;
+  DatasetHandle handle = CreateGOSSDataset(num_data);
+  const Dataset* dataset = static_cast<const Dataset*>(handle);
+  // too few other rows to sample any, so that exactly the rows not below the threshold are kept
+  const Config config = GOSSConfig(0.1, 1e-9);
+  const data_size_t top_k = static_cast<data_size_t>(num_data * config.top_rate);
+  std::mt19937 rng(43);
+  std::normal_distribution<float> normal(0.0f, 1.0f);
+  std::vector<score_t> random(num_data), tied(num_data), equal(num_data, 0.25f);
+  for (data_size_t i = 0; i < num_data; ++i) {
+    random[i] = normal(rng);
+    tied[i] = std::round(normal(rng) * 4.0f) / 4.0f;
+  }
+  for (const std::vector<score_t>* gradients : {&random, &tied, &equal}) {
+    std::vector<score_t> grad(*gradients), hess(num_data, 1.0f);
+    const std::vector<data_size_t> rows = SampleGOSS(config, dataset, &grad, &hess);
+    std::vector<score_t> keys(num_data);
+    for (data_size_t i = 0; i < num_data; ++i) {
+      keys[i] = std::fabs((*gradients)[i]);
+    }
+    std::vector<score_t> sorted_keys(keys);
+    std::nth_element(sorted_keys.begin(), sorted_keys.begin() + top_k - 1, sorted_keys.end(),
+                     std::greater<score_t>());
+    const score_t threshold = sorted_keys[top_k - 1];
+    std::vector<data_size_t> expected;
+    for (data_size_t i = 0; i < num_data; ++i) {
+      if (keys[i] >= threshold) {
+        expected.push_back(i);
+      }
+    }
+    EXPECT_EQ(expected, rows);
+    EXPECT_EQ(*gradients, grad);
+  }
+  EXPECT_EQ(0, LGBM_DatasetFree(handle));
+}
+
+TEST(SampleStrategy, GOSSSampleIndependentOfThreads) {
+  const data_size_t num_data = 50001;
+  DatasetHandle handle = CreateGOSSDataset(num_data);
+  const Dataset* dataset = static_cast<const Dataset*>(handle);
+  const Config config = GOSSConfig(0.1, 0.2);
+  std::mt19937 rng(47);
+  std::normal_distribution<float> normal(0.0f, 1.0f);
+  std::uniform_real_distribution<float> uniform(0.1f, 1.0f);
+  std::vector<score_t> gradients(num_data), hessians(num_data);
+  for (data_size_t i = 0; i < num_data; ++i) {
+    gradients[i] = normal(rng);
+    hessians[i] = uniform(rng);
+  }
+  std::vector<score_t> single_grad(gradients), single_hess(hessians);
+  OMP_SET_NUM_THREADS(1);
+  const std::vector<data_size_t> single_rows = SampleGOSS(config, dataset, &single_grad, &single_hess);
+  std::vector<score_t> multi_grad(gradients), multi_hess(hessians);
+  OMP_SET_NUM_THREADS(4);
+  const std::vector<data_size_t> multi_rows = SampleGOSS(config, dataset, &multi_grad, &multi_hess);
+  OMP_SET_NUM_THREADS(0);
+  EXPECT_GT(single_rows.size(), static_cast<size_t>(num_data * config.top_rate));
+  EXPECT_EQ(single_rows, multi_rows);
+  EXPECT_EQ(single_grad, multi_grad);
+  EXPECT_EQ(single_hess, multi_hess);
+  EXPECT_EQ(0, LGBM_DatasetFree(handle));
+}
+
+TEST(SampleStrategy, GOSSOtherRowsCount) {
+  const data_size_t num_data = 50001;
+  DatasetHandle handle = CreateGOSSDataset(num_data);
+  const Dataset* dataset = static_cast<const Dataset*>(handle);
+  Config config = GOSSConfig(0.1, 0.2);
+  const data_size_t top_k = static_cast<data_size_t>(num_data * config.top_rate);
+  const data_size_t other_k = static_cast<data_size_t>(num_data * config.other_rate);
+  std::mt19937 rng(59);
+  std::normal_distribution<float> normal(0.0f, 1.0f);
+  std::vector<score_t> gradients(num_data);
+  for (data_size_t i = 0; i < num_data; ++i) {
+    gradients[i] = normal(rng);
+  }
+  // each other row is kept with probability other_k / (num_data - top_k), and weighted by its inverse
+  const score_t multiply = static_cast<score_t>((num_data - top_k) / static_cast<double>(other_k));
+  const int num_seeds = 50;
+  double sum_other = 0.0;
+  for (int seed = 0; seed < num_seeds; ++seed) {
+    // the blocks of 1024 rows use the generators of consecutive seeds, so the seeds are spread apart
+    config.bagging_seed = seed * 1000;
+    std::vector<score_t> grad(gradients), hess(num_data, 1.0f);
+    const std::vector<data_size_t> rows = SampleGOSS(config, dataset, &grad, &hess);
+    data_size_t num_other = 0;
+    for (data_size_t i : rows) {
+      if (hess[i] != 1.0f) {
+        ++num_other;
+        EXPECT_FLOAT_EQ(multiply, hess[i]);
+        EXPECT_FLOAT_EQ(gradients[i] * multiply, grad[i]);
+      }
+    }
+    EXPECT_EQ(top_k, static_cast<data_size_t>(rows.size()) - num_other);
+    sum_other += num_other;
+  }
+  // the count of one sample has a standard deviation of about 90 rows, that of the mean about 13
+  EXPECT_NEAR(other_k, sum_other / num_seeds, 50.0);
+  EXPECT_EQ(0, LGBM_DatasetFree(handle));
+}
@@ -10,7 +10,14 @@
 #include <LightGBM/c_api.h>
 #include <LightGBM/dataset.h>
 
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <string>
+#include <vector>
 
 using LightGBM::ByteBuffer;
 using LightGBM::Dataset;
@@ -82,3 +89,261 @@ TEST(Serialization, JustWorks) {
     FAIL() << "Test Serialization failed with exception: " << exceptionText;
   }
 }
+
+TEST(Serialization, ModelTextRoundTrip) {
+  const int32_t nrows = 1000;
+  const int32_t ncols = 5;
+  LightGBM::Random rand(42);
+  std::vector<double> features(static_cast<size_t>(nrows) * ncols);
+  std::vector<float> labels(nrows);
+  for (int32_t row = 0; row < nrows; ++row) {
+    double sum = 0.0;
+    for (int32_t col = 0; col < ncols; ++col) {
+      features[static_cast<size_t>(row) * ncols + col] = rand.NextFloat();
+      sum += features[static_cast<size_t>(row) * ncols + col];
+    }
+    labels[row] = sum > 2.5 ? 1.0f : 0.0f;
+  }
+
+  // plain and linear trees, saving a loaded model gives the same text and the same predictions
+  const char* params[] = {"objective=binary num_leaves=15 min_data_in_leaf=5 verbose=-1",
+                          "objective=regression num_leaves=7 linear_tree=true verbose=-1"};
+  for (const char* param : params) {
+    DatasetHandle dataset_handle = nullptr;
+    int result = LGBM_DatasetCreateFromMat(features.data(), C_API_DTYPE_FLOAT64, nrows, ncols, 1, param, nullptr,
+                                           &dataset_handle);
+    EXPECT_EQ(0, result) << "LGBM_DatasetCreateFromMat result code: " << result;
+    result = LGBM_DatasetSetField(dataset_handle, "label", labels.data(), nrows, C_API_DTYPE_FLOAT32);
+    EXPECT_EQ(0, result) << "LGBM_DatasetSetField result code: " << result;
+    BoosterHandle booster_handle = nullptr;
+    result = LGBM_BoosterCreate(dataset_handle, param, &booster_handle);
+    EXPECT_EQ(0, result) << "LGBM_BoosterCreate result code: " << result;
+    int is_finished = 0;
+    for (int i = 0; i < 10; ++i) {
+      result = LGBM_BoosterUpdateOneIter(booster_handle, &is_finished);
+      EXPECT_EQ(0, result) << "LGBM_BoosterUpdateOneIter result code: " << result;
+    }
+
+    int64_t out_len = 0;
+    result = LGBM_BoosterSaveModelToString(booster_handle, 0, -1, 0, 0, &out_len, nullptr);
+    EXPECT_EQ(0, result) << "LGBM_BoosterSaveModelToString result code: " << result;
+    std::vector<char> model_str(out_len);
+    result = LGBM_BoosterSaveModelToString(booster_handle, 0, -1, 0, out_len, &out_len, model_str.data());
+    EXPECT_EQ(0, result) << "LGBM_BoosterSaveModelToString result code: " << result;
+
+    int num_iterations = 0;
+    BoosterHandle loaded_handle = nullptr;
+    result = LGBM_BoosterLoadModelFromString(model_str.data(), &num_iterations, &loaded_handle);
+    EXPECT_EQ(0, result) << "LGBM_BoosterLoadModelFromString result code: " << result;
+    EXPECT_EQ(10, num_iterations);
+    std::vector<char> loaded_model_str(out_len);
+    int64_t loaded_out_len = 0;
+    result = LGBM_BoosterSaveModelToString(loaded_handle, 0, -1, 0, out_len, &loaded_out_len, loaded_model_str.data());
+    EXPECT_EQ(0, result) << "LGBM_BoosterSaveModelToString result code: " << result;
+    ASSERT_EQ(out_len, loaded_out_len);
+    EXPECT_EQ(std::string(model_str.data()), std::string(loaded_model_str.data()));
+
+    std::vector<double> preds(nrows);
+    std::vector<double> loaded_preds(nrows);
+    result = LGBM_BoosterPredictForMat(booster_handle, features.data(), C_API_DTYPE_FLOAT64, nrows, ncols, 1,
+                                       C_API_PREDICT_NORMAL, 0, -1, "", &out_len, preds.data());
+    EXPECT_EQ(0, result) << "LGBM_BoosterPredictForMat result code: " << result;
+    result = LGBM_BoosterPredictForMat(loaded_handle, features.data(), C_API_DTYPE_FLOAT64, nrows, ncols, 1,
+                                       C_API_PREDICT_NORMAL, 0, -1, "", &out_len, loaded_preds.data());
+    EXPECT_EQ(0, result) << "LGBM_BoosterPredictForMat result code: " << result;
+    for (int32_t row = 0; row < nrows; ++row) {
+      EXPECT_EQ(preds[row], loaded_preds[row]) << "row " << row;
+    }
+
+    EXPECT_EQ(0, LGBM_BoosterFree(loaded_handle));
+    EXPECT_EQ(0, LGBM_BoosterFree(booster_handle));
+    EXPECT_EQ(0, LGBM_DatasetFree(dataset_handle));
+  }
+}
+
+TEST(Serialization, ModelToCParity) {
+#ifdef _WIN32
+  GTEST_SKIP() << "the parity harness compiles the generated code with the system C compiler";
+#else
+  if (std::system("cc --version > /dev/null 2>&1") != 0) {
+    GTEST_SKIP() << "no C compiler to build the generated code";
+  }
+  const int32_t nrows = 2000;
+  const int32_t ncols = 4;
+  LightGBM::Random rand(7);
+  std::vector<double> features(static_cast<size_t>(nrows) * ncols);
+  std::vector<float> labels(nrows);
+  for (int32_t row = 0; row < nrows; ++row) {
+    double* values = features.data() + static_cast<size_t>(row) * ncols;
+    values[0] = rand.NextFloat() < 0.1f ? NAN : rand.NextFloat() * 10.0 - 5.0;
+    values[1] = rand.NextFloat() < 0.3f ? 0.0 : rand.NextFloat();
+    values[2] = std::floor(rand.NextFloat() * 10.0);
+    values[3] = rand.NextFloat();
+    labels[row] = static_cast<float>((values[2] > 4 ? 1 : 0) + (values[0] > 0.0 || values[1] > 0.5 ? 1 : 0));
+  }
+  // rows outside of the training distribution: missing, negative and unseen categories, out of range values
+  std::vector<double> pred_features(features);
+  const double special[] = {NAN, 0.0, -0.0, -1.0, -0.5, 1e-40, 50.0, 1e30, -1e30};
+  for (double value : special) {
+    for (int32_t col = 0; col < ncols; ++col) {
+      std::vector<double> row(features.begin(), features.begin() + ncols);
+      row[col] = value;
+      pred_features.insert(pred_features.end(), row.begin(), row.end());
+    }
+  }
+  const int64_t pred_nrows = static_cast<int64_t>(pred_features.size() / ncols);
+
+  const char* params[] = {
+    "objective=binary num_leaves=15 min_data_in_leaf=5 zero_as_missing=true verbose=-1",
+    "objective=multiclass num_class=3 num_leaves=15 min_data_in_leaf=5 categorical_feature=2 verbose=-1"};
+  for (const char* param : params) {
+    DatasetHandle dataset_handle = nullptr;
+    int result = LGBM_DatasetCreateFromMat(features.data(), C_API_DTYPE_FLOAT64, nrows, ncols, 1, param, nullptr,
+                                           &dataset_handle);
+    EXPECT_EQ(0, result) << "LGBM_DatasetCreateFromMat result code: " << result;
+    std::vector<float> param_labels(labels);
+    if (std::string(param).find("binary") != std::string::npos) {
+      for (float& label : param_labels) {
+        label = label > 0.0f ? 1.0f : 0.0f;
+      }
+    }
+    result = LGBM_DatasetSetField(dataset_handle, "label", param_labels.data(), nrows, C_API_DTYPE_FLOAT32);
+    EXPECT_EQ(0, result) << "LGBM_DatasetSetField result code: " << result;
+    BoosterHandle booster_handle = nullptr;
+    result = LGBM_BoosterCreate(dataset_handle, param, &booster_handle);
+    EXPECT_EQ(0, result) << "LGBM_BoosterCreate result code: " << result;
+    int is_finished = 0;
+    for (int i = 0; i < 20; ++i) {
+      result = LGBM_BoosterUpdateOneIter(booster_handle, &is_finished);
+      EXPECT_EQ(0, result) << "LGBM_BoosterUpdateOneIter result code: " << result;
+    }
+    int num_outputs = 0;
+    result = LGBM_BoosterGetNumClasses(booster_handle, &num_outputs);
+    EXPECT_EQ(0, result) << "LGBM_BoosterGetNumClasses result code: " << result;
+
+    result = LGBM_BoosterSaveModelToC(booster_handle, 0, -1, "codegen_model.c");
+    EXPECT_EQ(0, result) << "LGBM_BoosterSaveModelToC result code: " << result;
+    {
+      std::ofstream driver("codegen_driver.c");
+      driver << "#include <stdint.h>\n#include <stdio.h>\n#include <stdlib.h>\n"
+             << "int lgbm_model_num_features(void);\nint lgbm_model_num_outputs(void);\n"
+             << "void lgbm_model_predict_raw(const double* row, double* out);\n"
+             << "void lgbm_model_predict_raw_batch(const double* data, int64_t nrow, double* out);\n"
+             << "int main(int argc, char** argv) {\n"
+             << "  int64_t nrow;\n"
+             << "  FILE* in = fopen(argv[1], \"rb\");\n"
+             << "  if (argc != 3 || !in || fread(&nrow, sizeof(nrow), 1, in) != 1) return 1;\n"
+             << "  const int64_t ncol = lgbm_model_num_features(), nout = lgbm_model_num_outputs();\n"
+             << "  double* data = (double*)malloc(sizeof(double) * nrow * ncol);\n"
+             << "  double* out = (double*)malloc(sizeof(double) * nrow * nout * 2);\n"
+             << "  if (fread(data, sizeof(double), nrow * ncol, in) != (size_t)(nrow * ncol)) return 1;\n"
+             << "  lgbm_model_predict_raw_batch(data, nrow, out);\n"
+             << "  for (int64_t i = 0; i < nrow; ++i) {\n"
+             << "    lgbm_model_predict_raw(data + i * ncol, out + (nrow + i) * nout);\n"
+             << "  }\n"
+             << "  FILE* res = fopen(argv[2], \"wb\");\n"
+             << "  fwrite(out, sizeof(double), nrow * nout * 2, res);\n"
+             << "  fclose(res);\n"
+             << "  return 0;\n"
+             << "}\n";
+      std::ofstream input("codegen_input.bin", std::ios::binary);
+      input.write(reinterpret_cast<const char*>(&pred_nrows), sizeof(pred_nrows));
+      input.write(reinterpret_cast<const char*>(pred_features.data()), sizeof(double) * pred_features.size());
+    }
+    ASSERT_EQ(0, std::system("cc -std=c99 -O2 -Wall -Werror codegen_model.c codegen_driver.c -o codegen_parity"));
+    ASSERT_EQ(0, std::system("./codegen_parity codegen_input.bin codegen_output.bin"));
+
+    std::vector<double> expected(pred_nrows * num_outputs);
+    int64_t out_len = 0;
+    result = LGBM_BoosterPredictForMat(booster_handle, pred_features.data(), C_API_DTYPE_FLOAT64,
+                                       static_cast<int32_t>(pred_nrows), ncols, 1, C_API_PREDICT_RAW_SCORE, 0, -1, "",
+                                       &out_len, expected.data());
+    EXPECT_EQ(0, result) << "LGBM_BoosterPredictForMat result code: " << result;
+    std::vector<double> generated(expected.size() * 2);
+    std::ifstream output("codegen_output.bin", std::ios::binary);
+    output.read(reinterpret_cast<char*>(generated.data()), sizeof(double) * generated.size());
+    ASSERT_TRUE(static_cast<bool>(output));
+    for (size_t i = 0; i < expected.size(); ++i) {
+      // bit-exact, both for the batch and the single row entry point
+      EXPECT_EQ(0, std::memcmp(&expected[i], &generated[i], sizeof(double))) << "output " << i;
+      EXPECT_EQ(0, std::memcmp(&expected[i], &generated[expected.size() + i], sizeof(double))) << "output " << i;
+    }
+
+    EXPECT_EQ(0, LGBM_BoosterFree(booster_handle));
+    EXPECT_EQ(0, LGBM_DatasetFree(dataset_handle));
+  }
+  std::remove("codegen_model.c");
+  std::remove("codegen_driver.c");
+  std::remove("codegen_input.bin");
+  std::remove("codegen_output.bin");
+  std::remove("codegen_parity");
+#endif
+}
+
+TEST(Serialization, OptimizedModelParity) {
+  const int32_t nrows = 600;
+  const int32_t ncols = 2;
+  const int num_class = 3;
+  LightGBM::Random rand(7);
+  std::vector<double> features(static_cast<size_t>(nrows) * ncols);
+  std::vector<float> labels(nrows);
+  for (int32_t row = 0; row < nrows; ++row) {
+    // few distinct values, so that many stumps share the same split
+    features[static_cast<size_t>(row) * ncols] = static_cast<double>(rand.NextShort(0, 4));
+    features[static_cast<size_t>(row) * ncols + 1] = static_cast<double>(rand.NextShort(0, 2));
+    labels[row] = static_cast<float>((static_cast<int>(features[static_cast<size_t>(row) * ncols]) +
+                                      rand.NextShort(0, 2)) % num_class);
+  }
+  const char* param = "objective=multiclass num_class=3 num_leaves=2 min_data_in_leaf=5 verbose=-1";
+  DatasetHandle dataset_handle = nullptr;
+  int result = LGBM_DatasetCreateFromMat(features.data(), C_API_DTYPE_FLOAT64, nrows, ncols, 1, param, nullptr,
+                                         &dataset_handle);
+  EXPECT_EQ(0, result) << "LGBM_DatasetCreateFromMat result code: " << result;
+  EXPECT_EQ(0, LGBM_DatasetSetField(dataset_handle, "label", labels.data(), nrows, C_API_DTYPE_FLOAT32));
+  BoosterHandle booster_handle = nullptr;
+  EXPECT_EQ(0, LGBM_BoosterCreate(dataset_handle, param, &booster_handle));
+  const int num_iterations = 30;
+  int is_finished = 0;
+  for (int i = 0; i < num_iterations; ++i) {
+    EXPECT_EQ(0, LGBM_BoosterUpdateOneIter(booster_handle, &is_finished));
+  }
+
+  const size_t num_preds = static_cast<size_t>(nrows) * num_class;
+  std::vector<double> preds(num_preds);
+  int64_t out_len = 0;
+  EXPECT_EQ(0, LGBM_BoosterPredictForMat(booster_handle, features.data(), C_API_DTYPE_FLOAT64, nrows, ncols, 1,
+                                         C_API_PREDICT_RAW_SCORE, 0, -1, "", &out_len, preds.data()));
+
+  // trees with the same splits are merged, the raw scores only change by rounding
+  result = LGBM_BoosterOptimizeModels(booster_handle, 0, -1, 0.0);
+  EXPECT_EQ(0, result) << "LGBM_BoosterOptimizeModels result code: " << result;
+  int optimized_iterations = 0;
+  EXPECT_EQ(0, LGBM_BoosterGetCurrentIteration(booster_handle, &optimized_iterations));
+  EXPECT_LT(optimized_iterations, num_iterations);
+  std::vector<double> optimized_preds(num_preds);
+  EXPECT_EQ(0, LGBM_BoosterPredictForMat(booster_handle, features.data(), C_API_DTYPE_FLOAT64, nrows, ncols, 1,
+                                         C_API_PREDICT_RAW_SCORE, 0, -1, "", &out_len, optimized_preds.data()));
+  for (size_t i = 0; i < num_preds; ++i) {
+    EXPECT_NEAR(preds[i], optimized_preds[i], 1e-9) << "output " << i;
+  }
+
+  // the optimized model is saved and loaded as a regular one
+  result = LGBM_BoosterSaveModelToString(booster_handle, 0, -1, 0, 0, &out_len, nullptr);
+  EXPECT_EQ(0, result) << "LGBM_BoosterSaveModelToString result code: " << result;
+  std::vector<char> model_str(out_len);
+  EXPECT_EQ(0, LGBM_BoosterSaveModelToString(booster_handle, 0, -1, 0, out_len, &out_len, model_str.data()));
+  int loaded_iterations = 0;
+  BoosterHandle loaded_handle = nullptr;
+  EXPECT_EQ(0, LGBM_BoosterLoadModelFromString(model_str.data(), &loaded_iterations, &loaded_handle));
+  EXPECT_EQ(optimized_iterations, loaded_iterations);
+  std::vector<double> loaded_preds(num_preds);
+  EXPECT_EQ(0, LGBM_BoosterPredictForMat(loaded_handle, features.data(), C_API_DTYPE_FLOAT64, nrows, ncols, 1,
+                                         C_API_PREDICT_RAW_SCORE, 0, -1, "", &out_len, loaded_preds.data()));
+  for (size_t i = 0; i < num_preds; ++i) {
+    EXPECT_EQ(optimized_preds[i], loaded_preds[i]) << "output " << i;
+  }
+
+  EXPECT_EQ(0, LGBM_BoosterFree(loaded_handle));
+  EXPECT_EQ(0, LGBM_BoosterFree(booster_handle));
+  EXPECT_EQ(0, LGBM_DatasetFree(dataset_handle));
+}
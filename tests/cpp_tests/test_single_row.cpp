@@ -5,10 +5,21 @@
 
 #include <gtest/gtest.h>
 #include <testutils.h>
+#include <LightGBM/boosting.h>
 #include <LightGBM/c_api.h>
+#include <LightGBM/prediction_early_stop.h>
+#include <LightGBM/utils/random.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
 #include <iostream>
 #include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 
 using LightGBM::TestUtils;
 
@@ -185,3 +196,556 @@ TEST(SingleRow, Normal) {
 TEST(SingleRow, Contrib) {
     test_predict_type(C_API_PREDICT_CONTRIB, 29);
 }
+
+TEST(SingleRow, QuantizedThresholds) {
+    const int32_t nrows = 2000;
+    const int32_t ncols = 4;
+    LightGBM::Random rand(11);
+    std::vector<double> features(static_cast<size_t>(nrows) * ncols);
+    std::vector<float> labels(nrows);
+    for (int32_t row = 0; row < nrows; ++row) {
+        double* values = features.data() + static_cast<size_t>(row) * ncols;
+        values[0] = rand.NextFloat() < 0.1f ? NAN : rand.NextFloat() * 10.0 - 5.0;
+        values[1] = rand.NextFloat() < 0.3f ? 0.0 : rand.NextFloat();
+        values[2] = std::floor(rand.NextFloat() * 10.0);
+        values[3] = rand.NextFloat() < 0.05f ? -1.0 : rand.NextFloat();
+        labels[row] = static_cast<float>((values[2] > 4 ? 1 : 0) + (values[0] > 0.0 || values[1] > 0.5 ? 1 : 0));
+    }
+    // mix in special values never seen in training
+    const double special[] = {NAN, 0.0, -0.0, -1.0, -0.5, 1e-40, 50.0, 1e30, -1e30};
+    for (int32_t row = 0; row < 200; ++row) {
+        features[static_cast<size_t>(row) * ncols + row % ncols] = special[row % 9];
+    }
+
+    const char* params[] = {
+        "objective=multiclass num_class=3 num_leaves=15 min_data_in_leaf=5 categorical_feature=2 verbose=-1",
+        "objective=regression num_leaves=31 min_data_in_leaf=5 zero_as_missing=true verbose=-1"};
+    for (const char* param : params) {
+        DatasetHandle dataset_handle = nullptr;
+        int result = LGBM_DatasetCreateFromMat(features.data(), C_API_DTYPE_FLOAT64, nrows, ncols, 1, param, nullptr,
+                                               &dataset_handle);
+        EXPECT_EQ(0, result) << "LGBM_DatasetCreateFromMat result code: " << result;
+        result = LGBM_DatasetSetField(dataset_handle, "label", labels.data(), nrows, C_API_DTYPE_FLOAT32);
+        EXPECT_EQ(0, result) << "LGBM_DatasetSetField result code: " << result;
+        BoosterHandle booster_handle = nullptr;
+        result = LGBM_BoosterCreate(dataset_handle, param, &booster_handle);
+        EXPECT_EQ(0, result) << "LGBM_BoosterCreate result code: " << result;
+        int is_finished = 0;
+        for (int i = 0; i < 20; ++i) {
+            result = LGBM_BoosterUpdateOneIter(booster_handle, &is_finished);
+            EXPECT_EQ(0, result) << "LGBM_BoosterUpdateOneIter result code: " << result;
+        }
+        int num_classes = 0;
+        result = LGBM_BoosterGetNumClasses(booster_handle, &num_classes);
+        EXPECT_EQ(0, result) << "LGBM_BoosterGetNumClasses result code: " << result;
+
+        const int predict_types[] = {C_API_PREDICT_NORMAL, C_API_PREDICT_RAW_SCORE, C_API_PREDICT_LEAF_INDEX};
+        for (int predict_type : predict_types) {
+            const size_t num_outputs = predict_type == C_API_PREDICT_LEAF_INDEX ? 20 * num_classes : num_classes;
+            std::vector<double> expected(nrows * num_outputs);
+            std::vector<double> quantized(nrows * num_outputs);
+            int64_t out_len = 0;
+            result = LGBM_BoosterPredictForMat(booster_handle, features.data(), C_API_DTYPE_FLOAT64, nrows, ncols, 1,
+                                               predict_type, 0, -1, "", &out_len, expected.data());
+            EXPECT_EQ(0, result) << "LGBM_BoosterPredictForMat result code: " << result;
+            result = LGBM_BoosterPredictForMat(booster_handle, features.data(), C_API_DTYPE_FLOAT64, nrows, ncols, 1,
+                                               predict_type, 0, -1, "pred_quantized_thresholds=true", &out_len,
+                                               quantized.data());
+            EXPECT_EQ(0, result) << "LGBM_BoosterPredictForMat result code: " << result;
+            for (size_t i = 0; i < expected.size(); ++i) {
+                EXPECT_EQ(expected[i], quantized[i]) << "predict type " << predict_type << ", output " << i;
+            }
+
+            // the single row path caches its predictor, switching the parameter must rebuild it
+            for (int32_t row = 0; row < 50; ++row) {
+                std::vector<double> single(num_outputs);
+                result = LGBM_BoosterPredictForMatSingleRow(booster_handle, features.data() + row * ncols,
+                                                            C_API_DTYPE_FLOAT64, ncols, 1, predict_type, 0, -1,
+                                                            row % 2 ? "pred_quantized_thresholds=true" : "",
+                                                            &out_len, single.data());
+                EXPECT_EQ(0, result) << "LGBM_BoosterPredictForMatSingleRow result code: " << result;
+                for (size_t i = 0; i < num_outputs; ++i) {
+                    EXPECT_EQ(expected[row * num_outputs + i], single[i]) << "row " << row << ", output " << i;
+                }
+            }
+        }
+
+        EXPECT_EQ(0, LGBM_BoosterFree(booster_handle));
+        EXPECT_EQ(0, LGBM_DatasetFree(dataset_handle));
+    }
+}
+
+TEST(SingleRow, QuantizedWideThresholds) {
+    // a stump trained on one feature is repeated with more distinct thresholds than 16-bit indices can address
+    const int32_t nrows = 100;
+    std::vector<double> features(nrows);
+    std::vector<float> labels(nrows);
+    for (int32_t row = 0; row < nrows; ++row) {
+        features[row] = row;
+        labels[row] = static_cast<float>(row >= nrows / 2);
+    }
+    const char* param = "objective=regression num_leaves=2 min_data_in_leaf=5 verbose=-1";
+    DatasetHandle dataset_handle = nullptr;
+    int result = LGBM_DatasetCreateFromMat(features.data(), C_API_DTYPE_FLOAT64, nrows, 1, 1, param, nullptr,
+                                           &dataset_handle);
+    EXPECT_EQ(0, result) << "LGBM_DatasetCreateFromMat result code: " << result;
+    EXPECT_EQ(0, LGBM_DatasetSetField(dataset_handle, "label", labels.data(), nrows, C_API_DTYPE_FLOAT32));
+    BoosterHandle booster_handle = nullptr;
+    EXPECT_EQ(0, LGBM_BoosterCreate(dataset_handle, param, &booster_handle));
+    int is_finished = 0;
+    EXPECT_EQ(0, LGBM_BoosterUpdateOneIter(booster_handle, &is_finished));
+    int64_t out_len = 0;
+    EXPECT_EQ(0, LGBM_BoosterSaveModelToString(booster_handle, 0, -1, 0, 0, &out_len, nullptr));
+    std::vector<char> model_buf(out_len);
+    EXPECT_EQ(0, LGBM_BoosterSaveModelToString(booster_handle, 0, -1, 0, out_len, &out_len, model_buf.data()));
+    EXPECT_EQ(0, LGBM_BoosterFree(booster_handle));
+    EXPECT_EQ(0, LGBM_DatasetFree(dataset_handle));
+
+    const std::string model(model_buf.data());
+    const size_t tree_begin = model.find("Tree=0\n");
+    const size_t tree_end = model.find("end of trees");
+    ASSERT_NE(std::string::npos, tree_begin);
+    ASSERT_NE(std::string::npos, tree_end);
+    const std::string tree = model.substr(tree_begin, tree_end - tree_begin);
+    const size_t threshold_begin = tree.find("\nthreshold=") + 11;
+    const size_t threshold_end = tree.find('\n', threshold_begin);
+    std::string header = model.substr(0, tree_begin);
+    const size_t sizes_begin = header.find("tree_sizes=");
+    header.erase(sizes_begin, header.find('\n', sizes_begin) + 1 - sizes_begin);
+    const int num_trees = 70000;
+    std::string wide_model = header;
+    for (int i = 0; i < num_trees; ++i) {
+        wide_model += "Tree=" + std::to_string(i) + tree.substr(6, threshold_begin - 6)
+                      + std::to_string(i / 700.0) + tree.substr(threshold_end);
+    }
+    wide_model += model.substr(tree_end);
+    int num_iterations = 0;
+    EXPECT_EQ(0, LGBM_BoosterLoadModelFromString(wide_model.c_str(), &num_iterations, &booster_handle));
+    EXPECT_EQ(num_trees, num_iterations);
+
+    std::vector<double> rows(nrows);
+    for (int32_t row = 0; row < nrows; ++row) {
+        rows[row] = row * 1.003 - 0.2;
+    }
+    std::vector<double> expected(nrows);
+    std::vector<double> quantized(nrows);
+    EXPECT_EQ(0, LGBM_BoosterPredictForMat(booster_handle, rows.data(), C_API_DTYPE_FLOAT64, nrows, 1, 1,
+                                           C_API_PREDICT_RAW_SCORE, 0, -1, "", &out_len, expected.data()));
+    EXPECT_EQ(0, LGBM_BoosterPredictForMat(booster_handle, rows.data(), C_API_DTYPE_FLOAT64, nrows, 1, 1,
+                                           C_API_PREDICT_RAW_SCORE, 0, -1, "pred_quantized_thresholds=true",
+                                           &out_len, quantized.data()));
+    for (int32_t row = 0; row < nrows; ++row) {
+        EXPECT_EQ(expected[row], quantized[row]) << "row " << row;
+    }
+
+    // the C code generator switches to 32-bit threshold indices
+    EXPECT_EQ(0, LGBM_BoosterSaveModelToC(booster_handle, 0, -1, "wide_thresholds_model.c"));
+    std::ifstream code_file("wide_thresholds_model.c");
+    const std::string code((std::istreambuf_iterator<char>(code_file)), std::istreambuf_iterator<char>());
+    EXPECT_NE(std::string::npos, code.find("typedef uint32_t lgbm_bin_t;"));
+    code_file.close();
+    std::remove("wide_thresholds_model.c");
+    EXPECT_EQ(0, LGBM_BoosterFree(booster_handle));
+}
+
+TEST(SingleRow, QuantizedTreesSnapshot) {
+    const int32_t nrows = 500;
+    const int32_t ncols = 3;
+    LightGBM::Random rand(17);
+    std::vector<double> features(static_cast<size_t>(nrows) * ncols);
+    std::vector<float> labels(nrows);
+    for (int32_t row = 0; row < nrows; ++row) {
+        double* values = features.data() + static_cast<size_t>(row) * ncols;
+        for (int32_t col = 0; col < ncols; ++col) {
+            values[col] = rand.NextFloat() * 2.0 - 1.0;
+        }
+        labels[row] = static_cast<float>(values[0] > 0.0 ? values[1] : values[2]);
+        values[row % ncols] = row % 10 == 0 ? NAN : values[row % ncols];
+    }
+    const char* param = "objective=regression num_leaves=15 min_data_in_leaf=5 verbose=-1";
+    DatasetHandle dataset = nullptr;
+    EXPECT_EQ(0, LGBM_DatasetCreateFromMat(features.data(), C_API_DTYPE_FLOAT64, nrows, ncols, 1, param, nullptr,
+                                           &dataset));
+    EXPECT_EQ(0, LGBM_DatasetSetField(dataset, "label", labels.data(), nrows, C_API_DTYPE_FLOAT32));
+    BoosterHandle booster = nullptr;
+    EXPECT_EQ(0, LGBM_BoosterCreate(dataset, param, &booster));
+    int is_finished = 0;
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(0, LGBM_BoosterUpdateOneIter(booster, &is_finished));
+    }
+    int64_t out_len = 0;
+    EXPECT_EQ(0, LGBM_BoosterSaveModelToString(booster, 0, -1, 0, 0, &out_len, nullptr));
+    std::vector<char> model_buf(out_len);
+    EXPECT_EQ(0, LGBM_BoosterSaveModelToString(booster, 0, -1, 0, out_len, &out_len, model_buf.data()));
+    EXPECT_EQ(0, LGBM_BoosterFree(booster));
+    EXPECT_EQ(0, LGBM_DatasetFree(dataset));
+
+    const std::string model(model_buf.data());
+    std::unique_ptr<LightGBM::Boosting> boosting(LightGBM::Boosting::CreateBoosting("gbdt", nullptr));
+    ASSERT_TRUE(boosting->LoadModelFromString(model.c_str(), model.size()));
+    boosting->InitPredict(0, -1, false, false);
+
+    // the snapshot is built once and shared by all the readers until the model changes
+    const std::shared_ptr<const LightGBM::QuantizedTrees> trees = boosting->GetQuantizedTrees();
+    ASSERT_NE(nullptr, trees);
+    std::vector<const LightGBM::QuantizedTrees*> read_trees(4);
+    std::vector<std::thread> readers;
+    for (size_t i = 0; i < read_trees.size(); ++i) {
+        readers.emplace_back([&boosting, &read_trees, i]() { read_trees[i] = boosting->GetQuantizedTrees().get(); });
+    }
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    for (const LightGBM::QuantizedTrees* read : read_trees) {
+        EXPECT_EQ(trees.get(), read);
+    }
+
+    // the signatures without the snapshot predict on raw values, with the same result
+    LightGBM::PredictionEarlyStopConfig early_stop_config{};
+    const LightGBM::PredictionEarlyStopInstance early_stop =
+        LightGBM::CreatePredictionEarlyStopInstance("none", early_stop_config);
+    const int num_leaf_outputs = 10;
+    std::vector<double> raw(1), quantized(1), leaf(num_leaf_outputs), quantized_leaf(num_leaf_outputs);
+    for (int32_t row = 0; row < nrows; ++row) {
+        const double* values = features.data() + static_cast<size_t>(row) * ncols;
+        boosting->PredictRaw(values, raw.data(), &early_stop);
+        boosting->PredictRaw(values, quantized.data(), &early_stop, trees.get());
+        EXPECT_EQ(raw[0], quantized[0]) << "row " << row;
+        boosting->Predict(values, raw.data(), &early_stop);
+        boosting->Predict(values, quantized.data(), &early_stop, trees.get());
+        EXPECT_EQ(raw[0], quantized[0]) << "row " << row;
+        boosting->PredictLeafIndex(values, leaf.data());
+        boosting->PredictLeafIndex(values, quantized_leaf.data(), trees.get());
+        EXPECT_EQ(leaf, quantized_leaf) << "row " << row;
+    }
+    std::vector<double> batch(nrows), quantized_batch(nrows);
+    boosting->PredictRawBatch(features.data(), nrows, batch.data(), &early_stop);
+    boosting->PredictRawBatch(features.data(), nrows, quantized_batch.data(), &early_stop, trees.get());
+    EXPECT_EQ(batch, quantized_batch);
+    boosting->PredictBatch(features.data(), nrows, batch.data(), &early_stop);
+    boosting->PredictBatch(features.data(), nrows, quantized_batch.data(), &early_stop, trees.get());
+    EXPECT_EQ(batch, quantized_batch);
+
+    // reloading the trees publishes a new snapshot, the old one stays valid for its holders
+    ASSERT_TRUE(boosting->LoadModelFromString(model.c_str(), model.size()));
+    const std::shared_ptr<const LightGBM::QuantizedTrees> reloaded = boosting->GetQuantizedTrees();
+    ASSERT_NE(nullptr, reloaded);
+    EXPECT_NE(trees.get(), reloaded.get());
+    EXPECT_EQ(reloaded.get(), boosting->GetQuantizedTrees().get());
+}
+
+TEST(SingleRow, RowLayoutParity) {
+    const int32_t nrows = 1000;
+    const int32_t ncols = 5;
+    LightGBM::Random rand(5);
+    // values exactly representable as float, so that every dtype sees the same row
+    std::vector<double> features(static_cast<size_t>(nrows) * ncols);
+    std::vector<float> labels(nrows);
+    for (int32_t row = 0; row < nrows; ++row) {
+        double* values = features.data() + static_cast<size_t>(row) * ncols;
+        for (int32_t col = 0; col < ncols; ++col) {
+            const float r = rand.NextFloat();
+            values[col] = r < 0.4f ? 0.0 : (r < 0.45f ? NAN : std::floor(rand.NextFloat() * 64.0) / 4.0 - 8.0);
+        }
+        labels[row] = static_cast<float>(values[0] + 2.0 * values[3] > 0.0 ? 1 : 0);
+    }
+    std::vector<float> features_f32(features.begin(), features.end());
+    std::vector<float> features_f32_col_major(features.size());
+    std::vector<const void*> row_ptrs(nrows);
+    std::vector<int32_t> indptr(1, 0);
+    std::vector<int64_t> indptr_i64(1, 0);
+    std::vector<int32_t> indices;
+    std::vector<float> values_f32;
+    std::vector<double> values_f64;
+    for (int32_t row = 0; row < nrows; ++row) {
+        row_ptrs[row] = features_f32.data() + static_cast<size_t>(row) * ncols;
+        for (int32_t col = 0; col < ncols; ++col) {
+            const double value = features[static_cast<size_t>(row) * ncols + col];
+            features_f32_col_major[static_cast<size_t>(col) * nrows + row] = static_cast<float>(value);
+            if (value != 0.0) {
+                indices.push_back(col);
+                values_f32.push_back(static_cast<float>(value));
+                values_f64.push_back(value);
+            }
+        }
+        indptr.push_back(static_cast<int32_t>(indices.size()));
+        indptr_i64.push_back(static_cast<int64_t>(indices.size()));
+    }
+    const int64_t nelem = static_cast<int64_t>(indices.size());
+    const char* param = "objective=binary num_leaves=15 min_data_in_leaf=5 verbose=-1";
+
+    // the same Dataset is built from dense and from CSR rows
+    BoosterHandle boosters[2] = {nullptr, nullptr};
+    DatasetHandle datasets[2] = {nullptr, nullptr};
+    int result = LGBM_DatasetCreateFromMat(features_f32_col_major.data(), C_API_DTYPE_FLOAT32, nrows, ncols, 0,
+                                           param, nullptr, &datasets[0]);
+    EXPECT_EQ(0, result) << "LGBM_DatasetCreateFromMat result code: " << result;
+    result = LGBM_DatasetCreateFromCSR(indptr_i64.data(), C_API_DTYPE_INT64, indices.data(), values_f64.data(),
+                                       C_API_DTYPE_FLOAT64, nrows + 1, nelem, ncols, param, nullptr, &datasets[1]);
+    EXPECT_EQ(0, result) << "LGBM_DatasetCreateFromCSR result code: " << result;
+    for (int i = 0; i < 2; ++i) {
+        result = LGBM_DatasetSetField(datasets[i], "label", labels.data(), nrows, C_API_DTYPE_FLOAT32);
+        EXPECT_EQ(0, result) << "LGBM_DatasetSetField result code: " << result;
+        result = LGBM_BoosterCreate(datasets[i], param, &boosters[i]);
+        EXPECT_EQ(0, result) << "LGBM_BoosterCreate result code: " << result;
+        int is_finished = 0;
+        for (int iter = 0; iter < 10; ++iter) {
+            result = LGBM_BoosterUpdateOneIter(boosters[i], &is_finished);
+            EXPECT_EQ(0, result) << "LGBM_BoosterUpdateOneIter result code: " << result;
+        }
+    }
+
+    const int predict_types[] = {C_API_PREDICT_RAW_SCORE, C_API_PREDICT_LEAF_INDEX, C_API_PREDICT_CONTRIB};
+    for (int predict_type : predict_types) {
+        const size_t num_outputs = predict_type == C_API_PREDICT_LEAF_INDEX ? 10
+                                 : (predict_type == C_API_PREDICT_CONTRIB ? ncols + 1 : 1);
+        std::vector<double> expected(nrows * num_outputs);
+        int64_t out_len = 0;
+        result = LGBM_BoosterPredictForMat(boosters[0], features.data(), C_API_DTYPE_FLOAT64, nrows, ncols, 1,
+                                           predict_type, 0, -1, "", &out_len, expected.data());
+        EXPECT_EQ(0, result) << "LGBM_BoosterPredictForMat result code: " << result;
+        EXPECT_EQ(static_cast<int64_t>(expected.size()), out_len);
+
+        std::vector<std::vector<double>> outputs(6, std::vector<double>(expected.size()));
+        EXPECT_EQ(0, LGBM_BoosterPredictForMat(boosters[0], features_f32_col_major.data(), C_API_DTYPE_FLOAT32, nrows,
+                                               ncols, 0, predict_type, 0, -1, "", &out_len, outputs[0].data()));
+        EXPECT_EQ(0, LGBM_BoosterPredictForMats(boosters[0], row_ptrs.data(), C_API_DTYPE_FLOAT32, nrows, ncols,
+                                                predict_type, 0, -1, "", &out_len, outputs[1].data()));
+        EXPECT_EQ(0, LGBM_BoosterPredictForCSR(boosters[0], indptr.data(), C_API_DTYPE_INT32, indices.data(),
+                                               values_f32.data(), C_API_DTYPE_FLOAT32, nrows + 1, nelem, ncols,
+                                               predict_type, 0, -1, "", &out_len, outputs[2].data()));
+        EXPECT_EQ(0, LGBM_BoosterPredictForCSR(boosters[1], indptr_i64.data(), C_API_DTYPE_INT64, indices.data(),
+                                               values_f64.data(), C_API_DTYPE_FLOAT64, nrows + 1, nelem, ncols,
+                                               predict_type, 0, -1, "", &out_len, outputs[3].data()));
+        FastConfigHandle fast_config = nullptr;
+        EXPECT_EQ(0, LGBM_BoosterPredictForMatSingleRowFastInit(boosters[1], predict_type, 0, -1, C_API_DTYPE_FLOAT32,
+                                                                ncols, "", &fast_config));
+        for (int32_t row = 0; row < nrows; ++row) {
+            EXPECT_EQ(0, LGBM_BoosterPredictForMatSingleRowFast(fast_config, row_ptrs[row], &out_len,
+                                                                outputs[4].data() + row * num_outputs));
+            EXPECT_EQ(0, LGBM_BoosterPredictForCSRSingleRow(boosters[0], indptr.data() + row, C_API_DTYPE_INT32,
+                                                            indices.data(), values_f64.data(), C_API_DTYPE_FLOAT64,
+                                                            2, nelem, ncols, predict_type, 0, -1, "", &out_len,
+                                                            outputs[5].data() + row * num_outputs));
+        }
+        EXPECT_EQ(0, LGBM_FastConfigFree(fast_config));
+        for (size_t k = 0; k < outputs.size(); ++k) {
+            for (size_t i = 0; i < expected.size(); ++i) {
+                EXPECT_EQ(expected[i], outputs[k][i]) << "predict type " << predict_type << ", layout " << k
+                                                      << ", output " << i;
+            }
+        }
+    }
+
+    for (int i = 0; i < 2; ++i) {
+        EXPECT_EQ(0, LGBM_BoosterFree(boosters[i]));
+        EXPECT_EQ(0, LGBM_DatasetFree(datasets[i]));
+    }
+}
+
+TEST(SingleRow, BatchedEarlyStopping) {
+    const int32_t nrows = 200;
+    const int32_t ncols = 4;
+    LightGBM::Random rand(11);
+    std::vector<double> features(static_cast<size_t>(nrows) * ncols);
+    std::vector<float> labels(nrows);
+    for (int32_t row = 0; row < nrows; ++row) {
+        double* values = features.data() + static_cast<size_t>(row) * ncols;
+        for (int32_t col = 0; col < ncols; ++col) {
+            values[col] = rand.NextFloat() * 4.0 - 2.0;
+        }
+        labels[row] = static_cast<float>(values[0] - values[1] + 0.5 * rand.NextFloat() > 0.0 ? 1 : 0);
+    }
+    const char* param = "objective=binary num_leaves=7 min_data_in_leaf=5 verbose=-1";
+    DatasetHandle dataset = nullptr;
+    int result = LGBM_DatasetCreateFromMat(features.data(), C_API_DTYPE_FLOAT64, nrows, ncols, 1, param, nullptr,
+                                           &dataset);
+    EXPECT_EQ(0, result) << "LGBM_DatasetCreateFromMat result code: " << result;
+    EXPECT_EQ(0, LGBM_DatasetSetField(dataset, "label", labels.data(), nrows, C_API_DTYPE_FLOAT32));
+    BoosterHandle booster = nullptr;
+    EXPECT_EQ(0, LGBM_BoosterCreate(dataset, param, &booster));
+    int is_finished = 0;
+    for (int iter = 0; iter < 40; ++iter) {
+        EXPECT_EQ(0, LGBM_BoosterUpdateOneIter(booster, &is_finished));
+    }
+
+    // the batched margin criterion stops the same rows at the same iteration as the per-row one
+    const char* margin_param = "pred_early_stop=true pred_early_stop_freq=5 pred_early_stop_margin=1.5";
+    std::vector<double> batched(nrows);
+    std::vector<double> single(nrows);
+    int64_t out_len = 0;
+    EXPECT_EQ(0, LGBM_BoosterPredictForMat(booster, features.data(), C_API_DTYPE_FLOAT64, nrows, ncols, 1,
+                                           C_API_PREDICT_RAW_SCORE, 0, -1, margin_param, &out_len, batched.data()));
+    EXPECT_EQ(nrows, out_len);
+    FastConfigHandle fast_config = nullptr;
+    EXPECT_EQ(0, LGBM_BoosterPredictForMatSingleRowFastInit(booster, C_API_PREDICT_RAW_SCORE, 0, -1,
+                                                            C_API_DTYPE_FLOAT64, ncols, margin_param, &fast_config));
+    for (int32_t row = 0; row < nrows; ++row) {
+        EXPECT_EQ(0, LGBM_BoosterPredictForMatSingleRowFast(fast_config, features.data() + row * ncols, &out_len,
+                                                            single.data() + row));
+        EXPECT_EQ(single[row], batched[row]) << "row " << row;
+    }
+    EXPECT_EQ(0, LGBM_FastConfigFree(fast_config));
+
+    // top_k keeps the exact scores of the k best rows, all the rows here form a single batch
+    const int top_k = 10;
+    std::vector<double> full(nrows);
+    std::vector<double> pruned(nrows);
+    EXPECT_EQ(0, LGBM_BoosterPredictForMat(booster, features.data(), C_API_DTYPE_FLOAT64, nrows, ncols, 1,
+                                           C_API_PREDICT_RAW_SCORE, 0, -1, "", &out_len, full.data()));
+    EXPECT_EQ(0, LGBM_BoosterPredictForMat(booster, features.data(), C_API_DTYPE_FLOAT64, nrows, ncols, 1,
+                                           C_API_PREDICT_RAW_SCORE, 0, -1,
+                                           "pred_early_stop=true pred_early_stop_type=top_k pred_early_stop_top_k=10 "
+                                           "pred_early_stop_freq=5", &out_len, pruned.data()));
+    std::vector<double> full_sorted(full);
+    std::vector<double> pruned_sorted(pruned);
+    std::sort(full_sorted.rbegin(), full_sorted.rend());
+    std::sort(pruned_sorted.rbegin(), pruned_sorted.rend());
+    for (int i = 0; i < top_k; ++i) {
+        EXPECT_DOUBLE_EQ(full_sorted[i], pruned_sorted[i]) << "rank " << i;
+    }
+
+    // smaller batches keep the k best rows of each batch
+    const int batch_size = 50;
+    EXPECT_EQ(0, LGBM_BoosterPredictForMat(booster, features.data(), C_API_DTYPE_FLOAT64, nrows, ncols, 1,
+                                           C_API_PREDICT_RAW_SCORE, 0, -1,
+                                           "pred_early_stop=true pred_early_stop_type=top_k pred_early_stop_top_k=10 "
+                                           "pred_early_stop_freq=5 pred_early_stop_batch_size=50", &out_len,
+                                           pruned.data()));
+    int num_stopped = 0;
+    for (int32_t start = 0; start < nrows; start += batch_size) {
+        std::vector<double> batch_full(full.begin() + start, full.begin() + start + batch_size);
+        std::vector<double> batch_pruned(pruned.begin() + start, pruned.begin() + start + batch_size);
+        for (int i = 0; i < batch_size; ++i) {
+            num_stopped += batch_full[i] != batch_pruned[i];
+        }
+        std::sort(batch_full.rbegin(), batch_full.rend());
+        std::sort(batch_pruned.rbegin(), batch_pruned.rend());
+        for (int i = 0; i < top_k; ++i) {
+            EXPECT_DOUBLE_EQ(batch_full[i], batch_pruned[i]) << "batch " << start / batch_size << " rank " << i;
+        }
+    }
+    EXPECT_GT(num_stopped, 0);
+    // and no row stops in batches of at most k rows
+    EXPECT_EQ(0, LGBM_BoosterPredictForMat(booster, features.data(), C_API_DTYPE_FLOAT64, nrows, ncols, 1,
+                                           C_API_PREDICT_RAW_SCORE, 0, -1,
+                                           "pred_early_stop=true pred_early_stop_type=top_k pred_early_stop_top_k=10 "
+                                           "pred_early_stop_freq=5 pred_early_stop_batch_size=10", &out_len,
+                                           pruned.data()));
+    EXPECT_EQ(full, pruned);
+
+    // confidence stops the rows whose probability is far enough from 0.5
+    const char* confidence_param = "pred_early_stop=true pred_early_stop_type=confidence pred_early_stop_freq=5 "
+                                   "pred_early_stop_confidence=0.8";
+    std::vector<double> prob(nrows);
+    EXPECT_EQ(0, LGBM_BoosterPredictForMat(booster, features.data(), C_API_DTYPE_FLOAT64, nrows, ncols, 1,
+                                           C_API_PREDICT_NORMAL, 0, -1, confidence_param, &out_len, prob.data()));
+    EXPECT_EQ(0, LGBM_BoosterPredictForMat(booster, features.data(), C_API_DTYPE_FLOAT64, nrows, ncols, 1,
+                                           C_API_PREDICT_NORMAL, 0, -1, "", &out_len, full.data()));
+    for (int32_t row = 0; row < nrows; ++row) {
+        if (prob[row] != full[row]) {
+            EXPECT_GE(std::max(prob[row], 1.0 - prob[row]), 0.8) << "row " << row;
+        }
+    }
+
+    // a ranking model has no class probabilities to stop on
+    std::vector<int32_t> query_sizes(nrows / 20, 20);
+    const char* rank_param = "objective=lambdarank num_leaves=7 min_data_in_leaf=5 verbose=-1";
+    DatasetHandle rank_dataset = nullptr;
+    EXPECT_EQ(0, LGBM_DatasetCreateFromMat(features.data(), C_API_DTYPE_FLOAT64, nrows, ncols, 1, rank_param,
+                                           nullptr, &rank_dataset));
+    EXPECT_EQ(0, LGBM_DatasetSetField(rank_dataset, "label", labels.data(), nrows, C_API_DTYPE_FLOAT32));
+    EXPECT_EQ(0, LGBM_DatasetSetField(rank_dataset, "group", query_sizes.data(),
+                                      static_cast<int>(query_sizes.size()), C_API_DTYPE_INT32));
+    BoosterHandle rank_booster = nullptr;
+    EXPECT_EQ(0, LGBM_BoosterCreate(rank_dataset, rank_param, &rank_booster));
+    EXPECT_EQ(0, LGBM_BoosterUpdateOneIter(rank_booster, &is_finished));
+    EXPECT_EQ(-1, LGBM_BoosterPredictForMat(rank_booster, features.data(), C_API_DTYPE_FLOAT64, nrows, ncols, 1,
+                                            C_API_PREDICT_NORMAL, 0, -1, confidence_param, &out_len, prob.data()));
+    EXPECT_NE(std::string::npos, std::string(LGBM_GetLastError()).find("classification")) << LGBM_GetLastError();
+
+    EXPECT_EQ(0, LGBM_BoosterFree(rank_booster));
+    EXPECT_EQ(0, LGBM_DatasetFree(rank_dataset));
+    EXPECT_EQ(0, LGBM_BoosterFree(booster));
+    EXPECT_EQ(0, LGBM_DatasetFree(dataset));
+}
+
+TEST(SingleRow, InteractionAfterContrib) {
+    const int32_t nrows = 300;
+    const int32_t ncols = 5;
+    LightGBM::Random rand(13);
+    std::vector<double> features(static_cast<size_t>(nrows) * ncols);
+    std::vector<float> labels(nrows);
+    for (int32_t row = 0; row < nrows; ++row) {
+        double* values = features.data() + static_cast<size_t>(row) * ncols;
+        for (int32_t col = 0; col < ncols; ++col) {
+            values[col] = rand.NextFloat() * 4.0 - 2.0;
+        }
+        labels[row] = static_cast<float>(values[0] * values[1] - values[2] + 0.5 * rand.NextFloat() > 0.0 ? 1 : 0);
+    }
+    const char* param = "objective=binary num_leaves=15 min_data_in_leaf=5 verbose=-1";
+    DatasetHandle dataset = nullptr;
+    EXPECT_EQ(0, LGBM_DatasetCreateFromMat(features.data(), C_API_DTYPE_FLOAT64, nrows, ncols, 1, param, nullptr,
+                                           &dataset));
+    EXPECT_EQ(0, LGBM_DatasetSetField(dataset, "label", labels.data(), nrows, C_API_DTYPE_FLOAT32));
+    BoosterHandle booster = nullptr;
+    EXPECT_EQ(0, LGBM_BoosterCreate(dataset, param, &booster));
+    int is_finished = 0;
+    for (int iter = 0; iter < 20; ++iter) {
+        EXPECT_EQ(0, LGBM_BoosterUpdateOneIter(booster, &is_finished));
+    }
+    // a copy of the model whose first predictions are interaction values
+    int64_t model_len = 0;
+    EXPECT_EQ(0, LGBM_BoosterSaveModelToString(booster, 0, -1, C_API_FEATURE_IMPORTANCE_SPLIT, 0, &model_len,
+                                               nullptr));
+    std::vector<char> model_str(model_len);
+    EXPECT_EQ(0, LGBM_BoosterSaveModelToString(booster, 0, -1, C_API_FEATURE_IMPORTANCE_SPLIT, model_len, &model_len,
+                                               model_str.data()));
+    BoosterHandle interaction_first = nullptr;
+    int num_iterations = 0;
+    EXPECT_EQ(0, LGBM_BoosterLoadModelFromString(model_str.data(), &num_iterations, &interaction_first));
+
+    const size_t num_contrib = static_cast<size_t>(nrows) * (ncols + 1);
+    const size_t num_interaction = num_contrib * (ncols + 1);
+    int64_t out_len = 0;
+    std::vector<double> expected_interaction(num_interaction);
+    EXPECT_EQ(0, LGBM_BoosterPredictForMat(interaction_first, features.data(), C_API_DTYPE_FLOAT64, nrows, ncols, 1,
+                                           C_API_PREDICT_INTERACTION, 0, -1, "", &out_len,
+                                           expected_interaction.data()));
+    std::vector<double> expected_contrib(num_contrib);
+    EXPECT_EQ(0, LGBM_BoosterPredictForMat(booster, features.data(), C_API_DTYPE_FLOAT64, nrows, ncols, 1,
+                                           C_API_PREDICT_CONTRIB, 0, -1, "", &out_len, expected_contrib.data()));
+
+    // the interaction tables are added while other threads keep predicting contributions
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 2; ++t) {
+        threads.emplace_back([&]() {
+            std::vector<double> contrib(num_contrib);
+            int64_t len = 0;
+            for (int i = 0; i < 20; ++i) {
+                EXPECT_EQ(0, LGBM_BoosterPredictForMat(booster, features.data(), C_API_DTYPE_FLOAT64, nrows, ncols,
+                                                       1, C_API_PREDICT_CONTRIB, 0, -1, "", &len, contrib.data()));
+                EXPECT_EQ(expected_contrib, contrib);
+            }
+        });
+    }
+    std::vector<double> interaction(num_interaction);
+    EXPECT_EQ(0, LGBM_BoosterPredictForMat(booster, features.data(), C_API_DTYPE_FLOAT64, nrows, ncols, 1,
+                                           C_API_PREDICT_INTERACTION, 0, -1, "", &out_len, interaction.data()));
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(expected_interaction, interaction);
+    // the rows of the interaction matrix sum to the contributions
+    for (size_t i = 0; i < num_contrib; ++i) {
+        double sum = 0.0;
+        for (int32_t j = 0; j <= ncols; ++j) {
+            sum += interaction[i * (ncols + 1) + j];
+        }
+        EXPECT_NEAR(expected_contrib[i], sum, 1e-9) << "entry " << i;
+    }
+
+    EXPECT_EQ(0, LGBM_BoosterFree(interaction_first));
+    EXPECT_EQ(0, LGBM_BoosterFree(booster));
+    EXPECT_EQ(0, LGBM_DatasetFree(dataset));
+}
@@ -9,12 +9,36 @@
 #include <LightGBM/c_api.h>
 #include <LightGBM/dataset.h>
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <memory>
+#include <vector>
 
 using LightGBM::Dataset;
 using LightGBM::Log;
 using LightGBM::TestUtils;
 
+namespace {
+
+void ExpectSameBins(DatasetHandle expected_handle, DatasetHandle dataset_handle) {
+  Dataset* expected = static_cast<Dataset*>(expected_handle);
+  Dataset* dataset = static_cast<Dataset*>(dataset_handle);
+  ASSERT_EQ(expected->num_data(), dataset->num_data());
+  ASSERT_EQ(expected->num_features(), dataset->num_features());
+  for (int i = 0; i < dataset->num_features(); ++i) {
+    std::unique_ptr<LightGBM::BinIterator> iter(dataset->FeatureIterator(i));
+    std::unique_ptr<LightGBM::BinIterator> expected_iter(expected->FeatureIterator(i));
+    iter->Reset(0);
+    expected_iter->Reset(0);
+    for (int32_t row = 0; row < dataset->num_data(); ++row) {
+      ASSERT_EQ(expected_iter->Get(row), iter->Get(row)) << "feature " << i << ", row " << row;
+    }
+  }
+}
+
+}  // namespace
+
 void test_stream_dense(
   int8_t creation_type,
   DatasetHandle ref_dataset_handle,
@@ -351,3 +375,294 @@ TEST(Stream, PushSparseRowsWithMetadata) {
   result = LGBM_DatasetFree(ref_dataset_handle);
   EXPECT_EQ(0, result) << "LGBM_DatasetFree result code: " << result;
 }
+
+TEST(Stream, AppendRowsToFinishedDataset) {
+  // odd row counts exercise the 4-bit dense bins across the append boundary
+  const int32_t nrows = 2001;
+  const int32_t nappend = 999;
+  const int32_t ntotal = nrows + nappend;
+  const int32_t ncols = 6;
+  const char* params = "max_bin=15 min_data_in_leaf=5 min_data_in_bin=1 verbose=-1";
+
+  // half of the columns are mostly zero, so they end up in sparse bins
+  LightGBM::Random rand(42);
+  std::vector<double> features(static_cast<size_t>(ntotal) * ncols);
+  std::vector<float> labels(ntotal);
+  std::vector<float> weights(ntotal);
+  for (int32_t row = 0; row < ntotal; ++row) {
+    double sum = 0.0;
+    for (int32_t col = 0; col < ncols; ++col) {
+      double value = rand.NextFloat();
+      if (col % 2 == 1 && rand.NextFloat() < 0.9f) {
+        value = 0.0;
+      }
+      features[static_cast<size_t>(row) * ncols + col] = value;
+      sum += value;
+    }
+    labels[row] = sum > 1.5 ? 1.0f : 0.0f;
+    weights[row] = 0.5f + rand.NextFloat();
+  }
+
+  DatasetHandle dataset_handle = nullptr;
+  int result = LGBM_DatasetCreateFromMat(features.data(), C_API_DTYPE_FLOAT64, nrows, ncols, 1, params, nullptr, &dataset_handle);
+  EXPECT_EQ(0, result) << "LGBM_DatasetCreateFromMat result code: " << result;
+  result = LGBM_DatasetSetField(dataset_handle, "label", labels.data(), nrows, C_API_DTYPE_FLOAT32);
+  EXPECT_EQ(0, result) << "LGBM_DatasetSetField label result code: " << result;
+  result = LGBM_DatasetSetField(dataset_handle, "weight", weights.data(), nrows, C_API_DTYPE_FLOAT32);
+  EXPECT_EQ(0, result) << "LGBM_DatasetSetField weight result code: " << result;
+
+  // the same rows binned in one pass with the same bin mappers
+  DatasetHandle expected_handle = nullptr;
+  result = LGBM_DatasetCreateByReference(dataset_handle, ntotal, &expected_handle);
+  EXPECT_EQ(0, result) << "LGBM_DatasetCreateByReference result code: " << result;
+  result = LGBM_DatasetPushRows(expected_handle, features.data(), C_API_DTYPE_FLOAT64, ntotal, ncols, 0);
+  EXPECT_EQ(0, result) << "LGBM_DatasetPushRows result code: " << result;
+
+  BoosterHandle booster_handle = nullptr;
+  result = LGBM_BoosterCreate(dataset_handle, "objective=binary num_leaves=7 min_data_in_leaf=5 verbose=-1", &booster_handle);
+  EXPECT_EQ(0, result) << "LGBM_BoosterCreate result code: " << result;
+  int is_finished = 0;
+  for (int i = 0; i < 5; ++i) {
+    result = LGBM_BoosterUpdateOneIter(booster_handle, &is_finished);
+    EXPECT_EQ(0, result) << "LGBM_BoosterUpdateOneIter result code: " << result;
+  }
+
+  const double* appended_features = features.data() + static_cast<size_t>(nrows) * ncols;
+  result = LGBM_DatasetAppendRows(dataset_handle, appended_features, C_API_DTYPE_FLOAT64, nappend, ncols,
+                                  labels.data() + nrows, weights.data() + nrows, nullptr, nullptr);
+  EXPECT_EQ(0, result) << "LGBM_DatasetAppendRows result code: " << result;
+  // weights are present in the Dataset, so they are required
+  result = LGBM_DatasetAppendRows(dataset_handle, appended_features, C_API_DTYPE_FLOAT64, nappend, ncols,
+                                  labels.data() + nrows, nullptr, nullptr, nullptr);
+  EXPECT_EQ(-1, result) << "LGBM_DatasetAppendRows without weights result code: " << result;
+
+  Dataset* dataset = static_cast<Dataset*>(dataset_handle);
+  ASSERT_EQ(ntotal, dataset->num_data());
+  ExpectSameBins(expected_handle, dataset_handle);
+  for (int32_t row = 0; row < ntotal; ++row) {
+    EXPECT_EQ(labels[row], dataset->metadata().label()[row]);
+    EXPECT_EQ(weights[row], dataset->metadata().weights()[row]);
+  }
+
+  // continue boosting on the enlarged data, training scores of appended rows must be in sync with the model
+  result = LGBM_BoosterResetTrainingData(booster_handle, dataset_handle);
+  EXPECT_EQ(0, result) << "LGBM_BoosterResetTrainingData result code: " << result;
+  int64_t out_len = 0;
+  std::vector<double> train_preds(ntotal);
+  result = LGBM_BoosterGetPredict(booster_handle, 0, &out_len, train_preds.data());
+  EXPECT_EQ(0, result) << "LGBM_BoosterGetPredict result code: " << result;
+  ASSERT_EQ(ntotal, out_len);
+  std::vector<double> preds(ntotal);
+  result = LGBM_BoosterPredictForMat(booster_handle, features.data(), C_API_DTYPE_FLOAT64, ntotal, ncols, 1,
+                                     C_API_PREDICT_NORMAL, 0, -1, "", &out_len, preds.data());
+  EXPECT_EQ(0, result) << "LGBM_BoosterPredictForMat result code: " << result;
+  for (int32_t row = 0; row < ntotal; ++row) {
+    EXPECT_NEAR(preds[row], train_preds[row], 1e-9) << "row " << row;
+  }
+  for (int i = 0; i < 3; ++i) {
+    result = LGBM_BoosterUpdateOneIter(booster_handle, &is_finished);
+    EXPECT_EQ(0, result) << "LGBM_BoosterUpdateOneIter result code: " << result;
+  }
+
+  EXPECT_EQ(0, LGBM_BoosterFree(booster_handle));
+  EXPECT_EQ(0, LGBM_DatasetFree(expected_handle));
+  EXPECT_EQ(0, LGBM_DatasetFree(dataset_handle));
+}
+
+TEST(Stream, SlideWindowOverFinishedDataset) {
+  const int32_t nrows = 2001;
+  const int32_t nslide = 701;
+  const int32_t ncols = 6;
+  const double half_life = 500.0;
+  const char* params = "max_bin=15 min_data_in_leaf=5 min_data_in_bin=1 verbose=-1";
+
+  // half of the columns are mostly zero, so they end up in sparse bins
+  LightGBM::Random rand(42);
+  const int32_t ntotal = nrows + nslide;
+  std::vector<double> features(static_cast<size_t>(ntotal) * ncols);
+  std::vector<float> labels(ntotal);
+  std::vector<float> weights(ntotal);
+  for (int32_t row = 0; row < ntotal; ++row) {
+    double sum = 0.0;
+    for (int32_t col = 0; col < ncols; ++col) {
+      double value = rand.NextFloat();
+      if (col % 2 == 1 && rand.NextFloat() < 0.9f) {
+        value = 0.0;
+      }
+      features[static_cast<size_t>(row) * ncols + col] = value;
+      sum += value;
+    }
+    labels[row] = sum > 1.5 ? 1.0f : 0.0f;
+    weights[row] = 0.5f + rand.NextFloat();
+  }
+  // existing rows are not stored in timestamp order, new rows arrive in reverse timestamp order
+  std::vector<double> timestamps(ntotal);
+  for (int32_t row = 0; row < nrows; ++row) {
+    timestamps[row] = static_cast<double>((row * 7) % nrows);
+  }
+  for (int32_t i = 0; i < nslide; ++i) {
+    timestamps[nrows + i] = static_cast<double>(ntotal - 1 - i);
+  }
+
+  DatasetHandle dataset_handle = nullptr;
+  int result = LGBM_DatasetCreateFromMat(features.data(), C_API_DTYPE_FLOAT64, nrows, ncols, 1, params, nullptr, &dataset_handle);
+  EXPECT_EQ(0, result) << "LGBM_DatasetCreateFromMat result code: " << result;
+  result = LGBM_DatasetSetField(dataset_handle, "label", labels.data(), nrows, C_API_DTYPE_FLOAT32);
+  EXPECT_EQ(0, result) << "LGBM_DatasetSetField label result code: " << result;
+  result = LGBM_DatasetSetField(dataset_handle, "weight", weights.data(), nrows, C_API_DTYPE_FLOAT32);
+  EXPECT_EQ(0, result) << "LGBM_DatasetSetField weight result code: " << result;
+  const double* new_features = features.data() + static_cast<size_t>(nrows) * ncols;
+  result = LGBM_DatasetSlideWindow(dataset_handle, new_features, C_API_DTYPE_FLOAT64, nslide, ncols,
+                                   labels.data() + nrows, weights.data() + nrows, nullptr,
+                                   timestamps.data() + nrows, half_life);
+  EXPECT_EQ(-1, result) << "LGBM_DatasetSlideWindow without timestamps result code: " << result;
+  result = LGBM_DatasetSetField(dataset_handle, "timestamp", timestamps.data(), nrows, C_API_DTYPE_FLOAT64);
+  EXPECT_EQ(0, result) << "LGBM_DatasetSetField timestamp result code: " << result;
+
+  BoosterHandle booster_handle = nullptr;
+  result = LGBM_BoosterCreate(dataset_handle, "objective=binary num_leaves=7 min_data_in_leaf=5 verbose=-1", &booster_handle);
+  EXPECT_EQ(0, result) << "LGBM_BoosterCreate result code: " << result;
+  int is_finished = 0;
+  for (int i = 0; i < 5; ++i) {
+    result = LGBM_BoosterUpdateOneIter(booster_handle, &is_finished);
+    EXPECT_EQ(0, result) << "LGBM_BoosterUpdateOneIter result code: " << result;
+  }
+
+  result = LGBM_DatasetSlideWindow(dataset_handle, new_features, C_API_DTYPE_FLOAT64, nslide, ncols,
+                                   labels.data() + nrows, weights.data() + nrows, nullptr,
+                                   timestamps.data() + nrows, half_life);
+  EXPECT_EQ(0, result) << "LGBM_DatasetSlideWindow result code: " << result;
+
+  // the slot of the k-th oldest row now holds the k-th oldest new row
+  std::vector<int32_t> source_rows(nrows);
+  for (int32_t row = 0; row < nrows; ++row) {
+    const int32_t age_rank = static_cast<int32_t>(timestamps[row]);
+    source_rows[row] = age_rank < nslide ? nrows + nslide - 1 - age_rank : row;
+  }
+  std::vector<double> window_features(static_cast<size_t>(nrows) * ncols);
+  for (int32_t row = 0; row < nrows; ++row) {
+    std::copy(features.begin() + static_cast<size_t>(source_rows[row]) * ncols,
+              features.begin() + static_cast<size_t>(source_rows[row] + 1) * ncols,
+              window_features.begin() + static_cast<size_t>(row) * ncols);
+  }
+  DatasetHandle expected_handle = nullptr;
+  result = LGBM_DatasetCreateByReference(dataset_handle, nrows, &expected_handle);
+  EXPECT_EQ(0, result) << "LGBM_DatasetCreateByReference result code: " << result;
+  result = LGBM_DatasetPushRows(expected_handle, window_features.data(), C_API_DTYPE_FLOAT64, nrows, ncols, 0);
+  EXPECT_EQ(0, result) << "LGBM_DatasetPushRows result code: " << result;
+
+  Dataset* dataset = static_cast<Dataset*>(dataset_handle);
+  ASSERT_EQ(nrows, dataset->num_data());
+  ExpectSameBins(expected_handle, dataset_handle);
+  const double newest = static_cast<double>(ntotal - 1);
+  for (int32_t row = 0; row < nrows; ++row) {
+    const int32_t source = source_rows[row];
+    EXPECT_EQ(labels[source], dataset->metadata().label()[row]);
+    EXPECT_EQ(timestamps[source], dataset->metadata().timestamps()[row]);
+    const double decayed = weights[source] * std::exp2(-(newest - timestamps[source]) / half_life);
+    EXPECT_NEAR(decayed, dataset->metadata().weights()[row], 1e-6) << "row " << row;
+  }
+
+  // continue boosting on the new window, training scores of recycled rows must be in sync with the model
+  result = LGBM_BoosterResetTrainingData(booster_handle, dataset_handle);
+  EXPECT_EQ(0, result) << "LGBM_BoosterResetTrainingData result code: " << result;
+  int64_t out_len = 0;
+  std::vector<double> train_preds(nrows);
+  result = LGBM_BoosterGetPredict(booster_handle, 0, &out_len, train_preds.data());
+  EXPECT_EQ(0, result) << "LGBM_BoosterGetPredict result code: " << result;
+  ASSERT_EQ(nrows, out_len);
+  std::vector<double> preds(nrows);
+  result = LGBM_BoosterPredictForMat(booster_handle, window_features.data(), C_API_DTYPE_FLOAT64, nrows, ncols, 1,
+                                     C_API_PREDICT_NORMAL, 0, -1, "", &out_len, preds.data());
+  EXPECT_EQ(0, result) << "LGBM_BoosterPredictForMat result code: " << result;
+  for (int32_t row = 0; row < nrows; ++row) {
+    EXPECT_NEAR(preds[row], train_preds[row], 1e-9) << "row " << row;
+  }
+  for (int i = 0; i < 3; ++i) {
+    result = LGBM_BoosterUpdateOneIter(booster_handle, &is_finished);
+    EXPECT_EQ(0, result) << "LGBM_BoosterUpdateOneIter result code: " << result;
+  }
+
+  // rows older than the window are still recycled first, and the next slide evicts them again
+  std::vector<double> late_timestamps(10, -1.0);
+  result = LGBM_DatasetSlideWindow(dataset_handle, features.data(), C_API_DTYPE_FLOAT64, 10, ncols,
+                                   labels.data(), nullptr, nullptr, late_timestamps.data(), half_life);
+  EXPECT_EQ(0, result) << "LGBM_DatasetSlideWindow result code: " << result;
+  std::vector<double> next_timestamps(10, newest + 1.0);
+  result = LGBM_DatasetSlideWindow(dataset_handle, features.data(), C_API_DTYPE_FLOAT64, 10, ncols,
+                                   labels.data(), nullptr, nullptr, next_timestamps.data(), half_life);
+  EXPECT_EQ(0, result) << "LGBM_DatasetSlideWindow result code: " << result;
+  const double* window_timestamps = dataset->metadata().timestamps();
+  EXPECT_EQ(static_cast<double>(nslide + 10), *std::min_element(window_timestamps, window_timestamps + nrows));
+  result = LGBM_BoosterResetTrainingData(booster_handle, dataset_handle);
+  EXPECT_EQ(0, result) << "LGBM_BoosterResetTrainingData result code: " << result;
+  result = LGBM_BoosterUpdateOneIter(booster_handle, &is_finished);
+  EXPECT_EQ(0, result) << "LGBM_BoosterUpdateOneIter result code: " << result;
+
+  EXPECT_EQ(0, LGBM_BoosterFree(booster_handle));
+  EXPECT_EQ(0, LGBM_DatasetFree(expected_handle));
+  EXPECT_EQ(0, LGBM_DatasetFree(dataset_handle));
+}
+
+TEST(Stream, ColumnMajorMatMatchesRowMajor) {
+  // odd row count for the 4-bit dense bins, mutually exclusive sparse columns to get a bundled group
+  const int32_t nrows = 3001;
+  const int32_t ncols = 7;
+  const char* params = "max_bin=15 min_data_in_bin=1 verbose=-1 linear_tree=true";
+  LightGBM::Random rand(7);
+  std::vector<double> row_major(static_cast<size_t>(nrows) * ncols);
+  std::vector<double> col_major(row_major.size());
+  std::vector<float> row_major_f32(row_major.size());
+  std::vector<float> col_major_f32(row_major.size());
+  for (int32_t row = 0; row < nrows; ++row) {
+    for (int32_t col = 0; col < ncols; ++col) {
+      double value = static_cast<double>(rand.NextFloat()) * 10.0 - 5.0;
+      if (col >= 3 && row % 4 != col - 3) {
+        value = 0.0;
+      } else if (col == 2 && rand.NextFloat() < 0.1f) {
+        value = std::nan("");
+      }
+      const size_t row_idx = static_cast<size_t>(row) * ncols + col;
+      const size_t col_idx = static_cast<size_t>(col) * nrows + row;
+      row_major[row_idx] = col_major[col_idx] = value;
+      row_major_f32[row_idx] = col_major_f32[col_idx] = static_cast<float>(value);
+    }
+  }
+
+  DatasetHandle expected = nullptr;
+  ASSERT_EQ(0, LGBM_DatasetCreateFromMat(row_major.data(), C_API_DTYPE_FLOAT64, nrows, ncols, 1, params,
+                                         nullptr, &expected));
+  DatasetHandle dataset = nullptr;
+  ASSERT_EQ(0, LGBM_DatasetCreateFromMat(col_major.data(), C_API_DTYPE_FLOAT64, nrows, ncols, 0, params,
+                                         nullptr, &dataset));
+  ExpectSameBins(expected, dataset);
+  EXPECT_EQ(0, LGBM_DatasetFree(dataset));
+
+  // validation data binned with the bin mappers of a reference
+  DatasetHandle expected_f32 = nullptr;
+  ASSERT_EQ(0, LGBM_DatasetCreateFromMat(row_major_f32.data(), C_API_DTYPE_FLOAT32, nrows, ncols, 1, params,
+                                         expected, &expected_f32));
+  ASSERT_EQ(0, LGBM_DatasetCreateFromMat(col_major_f32.data(), C_API_DTYPE_FLOAT32, nrows, ncols, 0, params,
+                                         expected, &dataset));
+  ExpectSameBins(expected_f32, dataset);
+  EXPECT_EQ(0, LGBM_DatasetFree(dataset));
+
+  // matrices with different layouts, the second one starts in the middle of the rows
+  const int32_t nrows_first = 1000;
+  const void* mats[] = {row_major.data(), col_major.data()};
+  std::vector<double> col_major_rest;
+  for (int32_t col = 0; col < ncols; ++col) {
+    col_major_rest.insert(col_major_rest.end(), col_major.begin() + static_cast<size_t>(col) * nrows + nrows_first,
+                          col_major.begin() + static_cast<size_t>(col + 1) * nrows);
+  }
+  mats[1] = col_major_rest.data();
+  int32_t mat_rows[] = {nrows_first, nrows - nrows_first};
+  int is_row_major[] = {1, 0};
+  ASSERT_EQ(0, LGBM_DatasetCreateFromMats(2, mats, C_API_DTYPE_FLOAT64, mat_rows, ncols, is_row_major, params,
+                                          nullptr, &dataset));
+  ExpectSameBins(expected, dataset);
+  EXPECT_EQ(0, LGBM_DatasetFree(dataset));
+
+  EXPECT_EQ(0, LGBM_DatasetFree(expected_f32));
+  EXPECT_EQ(0, LGBM_DatasetFree(expected));
+}
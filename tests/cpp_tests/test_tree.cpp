@@ -0,0 +1,157 @@
+/*!
+ * Copyright (c) 2024 Microsoft Corporation. All rights reserved.
+ * Licensed under the MIT License. See LICENSE file in the project root for license information.
+ */
+#include <gtest/gtest.h>
+#include <LightGBM/tree.h>
+
+#include <cmath>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+using LightGBM::MissingType;
+using LightGBM::Tree;
+
+namespace {
+
+// Random numerical splits over few features, so that features repeat on the paths
+void GrowRandomTree(Tree* tree, int num_leaves, int num_features, std::mt19937* rng) {
+  std::vector<int> leaf_count(num_leaves, 0);
+  leaf_count[0] = 100000;
+  std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+  for (int num_split = 0; num_split < num_leaves - 1; ++num_split) {
+    int leaf = static_cast<int>((*rng)() % (num_split + 1));
+    while (leaf_count[leaf] < 2) {
+      leaf = (leaf + 1) % (num_split + 1);
+    }
+    const int feature = static_cast<int>((*rng)() % num_features);
+    const int left_cnt = 1 + static_cast<int>((*rng)() % (leaf_count[leaf] - 1));
+    const int right_cnt = leaf_count[leaf] - left_cnt;
+    const MissingType missing_type = (num_split % 3 == 0) ? MissingType::NaN : MissingType::None;
+    const int new_leaf = tree->Split(leaf, feature, feature, 0, uniform(*rng), uniform(*rng), uniform(*rng),
+                                     left_cnt, right_cnt, left_cnt, right_cnt, 1.0f, missing_type, num_split % 2 == 0);
+    leaf_count[leaf] = left_cnt;
+    leaf_count[new_leaf] = right_cnt;
+  }
+}
+
+std::vector<double> Contrib(Tree* tree, const std::vector<double>& row) {
+  std::vector<double> output(row.size() + 1, 0.0);
+  tree->PredictContrib(row.data(), static_cast<int>(row.size()), output.data());
+  return output;
+}
+
+std::vector<double> Interaction(const Tree& tree, const std::vector<double>& row) {
+  const size_t num_cols = row.size() + 1;
+  std::vector<double> output(num_cols * num_cols, 0.0);
+  tree.PredictInteraction(row.data(), static_cast<int>(row.size()), output.data());
+  return output;
+}
+
+}  // namespace
+
+TEST(Tree, FastTreeSHAPMatchesRecursion) {
+  std::mt19937 rng(19);
+  std::uniform_real_distribution<double> uniform(-1.2, 1.2);
+  const int num_features = 6;
+  for (int num_leaves : {2, 7, 63}) {
+    Tree tree(num_leaves, false, false);
+    GrowRandomTree(&tree, num_leaves, num_features, &rng);
+    tree.RecomputeMaxDepth();
+    std::vector<std::vector<double>> rows(50, std::vector<double>(num_features));
+    std::vector<std::vector<double>> expected;
+    for (size_t i = 0; i < rows.size(); ++i) {
+      for (auto& value : rows[i]) {
+        value = uniform(rng);
+      }
+      if (i % 5 == 0) {
+        rows[i][0] = NAN;
+      }
+      expected.push_back(Contrib(&tree, rows[i]));
+    }
+    ASSERT_GT(tree.InitSHAPPaths(), 0);
+    tree.InitSHAPTables(true);
+    for (size_t i = 0; i < rows.size(); ++i) {
+      const std::vector<double> output = Contrib(&tree, rows[i]);
+      double sum = 0.0;
+      for (size_t j = 0; j < output.size(); ++j) {
+        EXPECT_NEAR(expected[i][j], output[j], 1e-12) << num_leaves << " leaves, row " << i << ", feature " << j;
+        sum += output[j];
+      }
+      EXPECT_NEAR(tree.Predict(rows[i].data()), sum, 1e-12);
+    }
+    // fall back to the recursion
+    tree.InitSHAPTables(false);
+    EXPECT_EQ(expected[1], Contrib(&tree, rows[1]));
+  }
+}
+
+TEST(Tree, SHAPInteractionTablesMatchConditionedRecursion) {
+  std::mt19937 rng(23);
+  std::uniform_real_distribution<double> uniform(-1.2, 1.2);
+  const int num_features = 5;
+  const int num_cols = num_features + 1;
+  for (int num_leaves : {2, 9, 40}) {
+    Tree tree(num_leaves, false, false);
+    GrowRandomTree(&tree, num_leaves, num_features, &rng);
+    tree.RecomputeMaxDepth();
+    std::vector<std::vector<double>> rows(30, std::vector<double>(num_features));
+    std::vector<std::vector<double>> expected;
+    for (size_t i = 0; i < rows.size(); ++i) {
+      for (auto& value : rows[i]) {
+        value = uniform(rng);
+      }
+      if (i % 4 == 0) {
+        rows[i][1] = NAN;
+      }
+      expected.push_back(Interaction(tree, rows[i]));
+      // the conditioned recursion is symmetric and leaves the diagonal to the caller
+      for (int f = 0; f < num_cols; ++f) {
+        EXPECT_EQ(0.0, expected[i][f * num_cols + f]);
+        for (int g = 0; g < f; ++g) {
+          EXPECT_NEAR(expected[i][f * num_cols + g], expected[i][g * num_cols + f], 1e-12);
+        }
+      }
+    }
+    ASSERT_GT(tree.InitSHAPPaths(), 0);
+    tree.InitSHAPTables(true);
+    tree.InitSHAPInteractionTables();
+    for (size_t i = 0; i < rows.size(); ++i) {
+      const std::vector<double> output = Interaction(tree, rows[i]);
+      for (size_t j = 0; j < output.size(); ++j) {
+        EXPECT_NEAR(expected[i][j], output[j], 1e-12) << num_leaves << " leaves, row " << i << ", entry " << j;
+      }
+      std::unordered_map<int, double> sparse;
+      tree.PredictInteractionSparse(rows[i].data(), num_features, &sparse);
+      for (const auto& entry : sparse) {
+        EXPECT_EQ(output[entry.first], entry.second);
+      }
+    }
+    // contribution tables alone fall back to the recursion
+    tree.InitSHAPTables(true);
+    EXPECT_EQ(expected[1], Interaction(tree, rows[1]));
+  }
+}
+
+TEST(Tree, FastTreeSHAPPathTooLong) {
+  // a chain whose deepest leaf has one more distinct feature on its path than the tables allow
+  const int num_features = Tree::kMaxSHAPPathFeatures + 1;
+  Tree tree(num_features + 1, false, false);
+  int leaf = 0;
+  for (int feature = 0; feature < num_features; ++feature) {
+    const int count = 1 << (num_features - feature);
+    leaf = tree.Split(leaf, feature, feature, 0, 0.0, -1.0, 1.0, count / 2, count / 2, count / 2, count / 2, 1.0f,
+                      MissingType::None, false);
+  }
+  tree.RecomputeMaxDepth();
+  EXPECT_EQ(-1, tree.InitSHAPPaths());
+  tree.InitSHAPTables(true);
+  std::vector<double> row(num_features, 1.0);
+  const std::vector<double> output = Contrib(&tree, row);
+  double sum = 0.0;
+  for (double value : output) {
+    sum += value;
+  }
+  EXPECT_NEAR(tree.Predict(row.data()), sum, 1e-12);
+}